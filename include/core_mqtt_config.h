@@ -38,6 +38,23 @@
 #ifndef CORE_MQTT_CONFIG_H_
 #define CORE_MQTT_CONFIG_H_
 
+/**
+ * @brief Upper bound of the inflight window of outgoing PUBLISHes of an MQTT
+ * instance, set using cy_mqtt_set_max_inflight_publishes.
+ *
+ * MQTT_STATE_ARRAY_MAX_COUNT is derived from this value, so that the state
+ * records of the MQTT core library can track every message of the largest
+ * window. Raise it to several hundred for high-throughput QoS1 and QoS2
+ * publishing; each unit adds two MQTTPubAckInfo_t state records to every
+ * MQTT context.
+ *
+ * <b>Possible values:</b> Any positive 16 bit integer. <br>
+ * <b>Default value:</b> `10`
+ */
+#ifndef CY_MQTT_MAX_INFLIGHT_WINDOW
+#define CY_MQTT_MAX_INFLIGHT_WINDOW    ( 10U )
+#endif
+
 /**
  * @brief Determines the maximum number of MQTT PUBLISH messages, pending
  * acknowledgment at a time, that are supported for incoming and outgoing
@@ -54,11 +71,14 @@
  * and incoming PUBLISHes, and thus, 2 * MQTT_STATE_ARRAY_MAX_COUNT amount
  * of memory is statically allocated for the state records.
  *
+ * @note This value defaults to CY_MQTT_MAX_INFLIGHT_WINDOW, and must not be
+ * smaller than it.
+ *
  * <b>Possible values:</b> Any positive 32 bit integer. <br>
- * <b>Default value:</b> `10`
+ * <b>Default value:</b> `CY_MQTT_MAX_INFLIGHT_WINDOW`
  */
 #ifndef MQTT_STATE_ARRAY_MAX_COUNT
-#define MQTT_STATE_ARRAY_MAX_COUNT    ( 10U )
+#define MQTT_STATE_ARRAY_MAX_COUNT    CY_MQTT_MAX_INFLIGHT_WINDOW
 #endif
 
 /**
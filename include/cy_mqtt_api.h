@@ -47,6 +47,7 @@
 #include "cy_result_mw.h"
 #include "cy_nw_helper.h"
 #include "cy_log.h"
+#include "cyabs_rtos.h"
 
 /* MQTT API headers. */
 #include "core_mqtt.h"
@@ -167,6 +168,10 @@ extern "C" {
 #define CY_RSLT_MODULE_MQTT_VCM_ERROR                              ( CY_RSLT_MQTT_ERR_BASE + 21 )
 /** MQTT library not initialized. */
 #define CY_RSLT_MODULE_MQTT_NOT_INITIALIZED                        ( CY_RSLT_MQTT_ERR_BASE + 22 )
+/** MQTT publish rate limit exceeded. */
+#define CY_RSLT_MODULE_MQTT_RATE_LIMITED                           ( CY_RSLT_MQTT_ERR_BASE + 23 )
+/** MQTT instance busy; the operation can be retried later. */
+#define CY_RSLT_MODULE_MQTT_BUSY                                   ( CY_RSLT_MQTT_ERR_BASE + 24 )
 
 /**
  * MQTT event type for subscribed message receive event.
@@ -217,6 +222,96 @@ extern "C" {
 #define CY_MQTT_MESSAGE_RECEIVE_TIMEOUT_MS       ( 500U )
 #endif
 
+/**
+ * Tick period in milliseconds of the timing wheel that handles the keepalive, ping response, and asynchronous acknowledgment
+ * timers of all the MQTT instances. The timers are driven by a dedicated timer thread, independently of the event loops, and
+ * the timers of all the MQTT instances that expire within the same tick are handled in one wakeup.
+ * \note
+ *    A timer expires up to one tick after its timeout. This value can be modified by defining macro in application makefile.
+ *
+ */
+#ifndef CY_MQTT_TIMER_WHEEL_TICK_MS
+#define CY_MQTT_TIMER_WHEEL_TICK_MS              ( 100U )
+#endif
+
+/**
+ * Size in bytes of the read-ahead buffer of the MQTT network receive function. Reads smaller than this size read
+ * whatever data is available in the network socket into this buffer, and the following reads are served from it, so that
+ * a burst of small MQTT packets is received with one socket read instead of one read per packet header and body.
+ * \note
+ *    The buffer is part of each MQTT instance. This value can be modified by defining macro in application makefile; it must be between 5 and 65535.
+ *
+ */
+#ifndef CY_MQTT_RECEIVE_READ_AHEAD_SIZE
+#define CY_MQTT_RECEIVE_READ_AHEAD_SIZE          ( 512U )
+#endif
+
+/**
+ * Size in bytes of the transmit buffer of an MQTT instance. Outgoing PUBLISH packets are serialized in this buffer instead of
+ * the network buffer, so that a packet is written to the socket while received packets are processed. The payload is copied
+ * with the header if the packet fits, and sent directly from the application memory otherwise.
+ * \note
+ *    The buffer is part of each MQTT instance. The topic name of a PUBLISH packet whose header does not fit in the buffer is sent
+ *    directly from the memory of the message, after the fixed header. This value can be modified by defining macro in application makefile;
+ *    it must be at least 64.
+ *
+ */
+#ifndef CY_MQTT_TX_BUFFER_SIZE
+#define CY_MQTT_TX_BUFFER_SIZE                   ( 512U )
+#endif
+
+/**
+ * Maximum size in bytes of the TLS session state cached by an MQTT instance for TLS session resumption.
+ * The cache is allocated from heap when the TLS session hooks are set. Refer \ref cy_mqtt_set_tls_session_hooks.
+ * \note
+ *    This value can be modified by defining macro in application makefile.
+ *
+ */
+#ifndef CY_MQTT_TLS_SESSION_MAX_SIZE
+#define CY_MQTT_TLS_SESSION_MAX_SIZE             ( 256U )
+#endif
+
+/**
+ * Default backoff in milliseconds before the first attempt of the automatic reconnection. Refer \ref cy_mqtt_enable_auto_reconnect.
+ * \note
+ *    This value can be modified by defining macro in application makefile.
+ *
+ */
+#ifndef CY_MQTT_RECONNECT_INITIAL_BACKOFF_MS
+#define CY_MQTT_RECONNECT_INITIAL_BACKOFF_MS     ( 1000U )
+#endif
+
+/**
+ * Default maximum backoff in milliseconds between the attempts of the automatic reconnection. Refer \ref cy_mqtt_enable_auto_reconnect.
+ * \note
+ *    This value can be modified by defining macro in application makefile.
+ *
+ */
+#ifndef CY_MQTT_RECONNECT_MAX_BACKOFF_MS
+#define CY_MQTT_RECONNECT_MAX_BACKOFF_MS         ( 60000U )
+#endif
+
+/**
+ * Maximum number of broker endpoints of an MQTT instance. Refer \ref cy_mqtt_set_broker_endpoints.
+ * \note
+ *    This value can be modified by defining macro in application makefile.
+ *
+ */
+#ifndef CY_MQTT_MAX_BROKER_ENDPOINTS
+#define CY_MQTT_MAX_BROKER_ENDPOINTS             ( 4U )
+#endif
+
+/**
+ * Time in milliseconds for which a broker endpoint is tried after the healthy endpoints, once a connection to it fails.
+ * Refer \ref cy_mqtt_set_broker_endpoints.
+ * \note
+ *    This value can be modified by defining macro in application makefile.
+ *
+ */
+#ifndef CY_MQTT_BROKER_FAILURE_HOLDDOWN_MS
+#define CY_MQTT_BROKER_FAILURE_HOLDDOWN_MS       ( 300000U )
+#endif
+
 /**
  * Maximum number of retry for MQTT publish/subscribe/unsubcribe message send.
  *
@@ -229,13 +324,73 @@ extern "C" {
 #endif
 
 /**
- * Maximum number of MQTT instances supported.
+ * Maximum wait time in milliseconds to receive the acknowledgment (PUBACK for QoS1, PUBCOMP for QoS2) for a message
+ * published using \ref cy_mqtt_publish_async. If the acknowledgment is not received within this time, the completion callback
+ * is invoked with \ref CY_MQTT_PUBLISH_STATUS_TIMEOUT, and the message is not resent on a resumed session.
+ * \note
+ *    The timeout is monitored only while the MQTT session is established. This value can be modified by defining macro in application makefile.
+ *
+ */
+#ifndef CY_MQTT_ASYNC_PUBLISH_ACK_TIMEOUT_MS
+#define CY_MQTT_ASYNC_PUBLISH_ACK_TIMEOUT_MS     ( CY_MQTT_ACK_RECEIVE_TIMEOUT_MS * CY_MQTT_MAX_RETRY_VALUE )
+#endif
+
+/**
+ * Size in bytes of the group commit buffer of the publish spool. Messages spooled while the MQTT session is not
+ * established are collected in this buffer and written to the spool storage together, when the buffer is full or
+ * \ref cy_mqtt_flush_spool is called. Messages larger than this buffer are written to the storage directly.
+ * \note
+ *    This value can be modified by defining macro in application makefile.
+ *
+ */
+#ifndef CY_MQTT_SPOOL_COMMIT_BUFFER_SIZE
+#define CY_MQTT_SPOOL_COMMIT_BUFFER_SIZE         ( 1024U )
+#endif
+
+/**
+ * Number of spooled messages acknowledged by the MQTT broker after which the acknowledged offset of the spool is
+ * persisted. After a reboot, at most this many acknowledged messages are sent again.
+ * \note
+ *    This value can be modified by defining macro in application makefile.
+ *
+ */
+#ifndef CY_MQTT_SPOOL_ACK_PERSIST_INTERVAL
+#define CY_MQTT_SPOOL_ACK_PERSIST_INTERVAL       ( 8U )
+#endif
+
+/**
+ * Maximum length in bytes of a received payload after decompression by the payload codec. Compressed payloads that
+ * decompress to a larger length are delivered to the application as received.
+ * \note
+ *    This value can be modified by defining macro in application makefile.
+ *
+ */
+#ifndef CY_MQTT_MAX_DECOMPRESSED_PAYLOAD_SIZE
+#define CY_MQTT_MAX_DECOMPRESSED_PAYLOAD_SIZE    ( 16384U )
+#endif
+
+/**
+ * Codec ID of the built-in LZ4 block format payload codec. Refer \ref cy_mqtt_lz4_compress and \ref cy_mqtt_lz4_decompress.
+ */
+#define CY_MQTT_CODEC_ID_LZ4                     ( 1U )
+
+/**
+ * Default maximum number of MQTT instances supported. The limit can be changed at runtime using \ref cy_mqtt_set_max_handles.
+ * \note
+ *    The handle table is allocated with the first MQTT instance and grows with the number of instances created, so the memory used does not depend on this value.
+ *    Each MQTT instance created allocates its read-ahead buffer of \ref CY_MQTT_RECEIVE_READ_AHEAD_SIZE bytes and its transmit buffer of
+ *    \ref CY_MQTT_TX_BUFFER_SIZE bytes from heap, in addition to the network buffer passed to \ref cy_mqtt_create.
+ *    This value can be modified by defining macro in application makefile.
+ *
  */
+#ifndef CY_MQTT_MAX_HANDLE
 #define CY_MQTT_MAX_HANDLE                       ( 2U )
+#endif
 
 /**
  * Configure value of maximum number of outgoing publishes maintained in MQTT library
- * until an ack is received from the broker.
+ * until an ack is received from the broker. This is the default size of the inflight window of an MQTT
+ * instance; it can be changed per instance using \ref cy_mqtt_set_max_inflight_publishes.
  */
 #ifndef CY_MQTT_MAX_OUTGOING_PUBLISHES
 #define CY_MQTT_MAX_OUTGOING_PUBLISHES           ( 1U )
@@ -248,6 +403,31 @@ extern "C" {
 #define CY_MQTT_MAX_OUTGOING_SUBSCRIBES          ( 5U )
 #endif
 
+/**
+ * Stack size for the worker threads of the dispatch pool. Refer \ref cy_mqtt_set_dispatch_pool.
+ * \note
+ *    The callbacks of the received messages run in these threads when the dispatch pool is enabled.
+ *    This value can be modified by defining macro in application makefile.
+ *
+ */
+#ifndef CY_MQTT_DISPATCH_THREAD_STACK_SIZE
+#define CY_MQTT_DISPATCH_THREAD_STACK_SIZE       ( 1024 * 4 )
+#endif
+
+/**
+ * Stack size for the timer thread that drives the timing wheel. Refer \ref CY_MQTT_TIMER_WHEEL_TICK_MS.
+ * \note
+ *    The timer thread only queues the timer events to the event loops. This value can be modified by defining macro in application makefile.
+ *
+ */
+#ifndef CY_MQTT_TIMER_THREAD_STACK_SIZE
+    #ifdef ENABLE_MQTT_LOGS
+        #define CY_MQTT_TIMER_THREAD_STACK_SIZE  ( 1024 * 4 )
+    #else
+        #define CY_MQTT_TIMER_THREAD_STACK_SIZE  ( 1024 * 2 )
+    #endif
+#endif
+
 /**
  * Maximum length of descriptor supported.
  */
@@ -273,6 +453,16 @@ extern "C" {
         #endif
     #endif
 #endif
+
+/**
+ * Stack size for the thread making the attempts of the automatic reconnection. Refer \ref cy_mqtt_enable_auto_reconnect.
+ * \note
+ *    The reconnect thread opens the network connection, including the TLS handshake, so it defaults to the stack size of the event processing thread. This value can be modified by defining macro in application makefile.
+ *
+ */
+#ifndef CY_MQTT_RECONNECT_THREAD_STACK_SIZE
+    #define CY_MQTT_RECONNECT_THREAD_STACK_SIZE  ( CY_MQTT_EVENT_THREAD_STACK_SIZE )
+#endif
 /**
  * @}
  */
@@ -306,7 +496,9 @@ typedef enum cy_mqtt_event_type
 {
     CY_MQTT_EVENT_TYPE_SUBSCRIPTION_MESSAGE_RECEIVE = 0, /**< Message from the subscribed topic. */
     CY_MQTT_EVENT_TYPE_DISCONNECT                   = 1, /**< Disconnected from MQTT broker. */
-    CY_MQTT_EVENT_TYPE_PINGRESP                     = 2  /** Ping response packet */
+    CY_MQTT_EVENT_TYPE_PINGRESP                     = 2, /** Ping response packet */
+    CY_MQTT_EVENT_TYPE_PUBLISH_FRAGMENT_RECEIVE     = 3, /**< Fragment of a message from the subscribed topic that is larger than the network buffer. Refer \ref cy_mqtt_enable_fragmented_receive. */
+    CY_MQTT_EVENT_TYPE_RECONNECT                    = 4  /**< Outcome of the automatic reconnection after the MQTT session was lost. Refer \ref cy_mqtt_enable_auto_reconnect. */
 } cy_mqtt_event_type_t;
 
 /**
@@ -320,6 +512,16 @@ typedef enum cy_mqtt_disconn_type
     CY_MQTT_DISCONN_TYPE_SND_RCV_FAIL  = 3   /**< MQTT packet send or receive operation failed due to network latency (or) send/receive related timeouts */
 } cy_mqtt_disconn_type_t;
 
+/**
+ * Completion status of a message published using \ref cy_mqtt_publish_async.
+ */
+typedef enum cy_mqtt_publish_status
+{
+    CY_MQTT_PUBLISH_STATUS_ACKED        = 0,  /**< Message acknowledged by the broker. PUBACK received for QoS1; PUBCOMP received for QoS2. */
+    CY_MQTT_PUBLISH_STATUS_TIMEOUT      = 1,  /**< Acknowledgment not received within \ref CY_MQTT_ASYNC_PUBLISH_ACK_TIMEOUT_MS. */
+    CY_MQTT_PUBLISH_STATUS_SESSION_LOST = 2   /**< Message discarded because a clean MQTT session was established before the acknowledgment was received. */
+} cy_mqtt_publish_status_t;
+
 /**
  * @}
  */
@@ -333,6 +535,25 @@ typedef enum cy_mqtt_disconn_type
  */
 typedef void * cy_mqtt_t;
 
+/**
+ * @var cy_mqtt_topic_t
+ * Handle to a topic registered using \ref cy_mqtt_topic_register
+ */
+typedef void * cy_mqtt_topic_t;
+
+/**
+ * @var cy_mqtt_event_loop_t
+ * Handle to an event loop created using \ref cy_mqtt_event_loop_create
+ */
+typedef void * cy_mqtt_event_loop_t;
+
+/**
+ * @var cy_mqtt_publish_token_t
+ * Token identifying a message published using \ref cy_mqtt_publish_async. The token is the MQTT packet ID of the
+ * PUBLISH packet and is unique among the messages awaiting an acknowledgment on an MQTT handle.
+ */
+typedef uint16_t cy_mqtt_publish_token_t;
+
 /******************************************************
  *                    Structures
  ******************************************************/
@@ -370,6 +591,16 @@ typedef struct cy_mqtt_publish_info
     size_t         payload_len;  /**< Message payload length. */
 } cy_mqtt_publish_info_t;
 
+/**
+ * MQTT payload segment structure.
+ * Used with \ref cy_mqtt_publish_vectored to publish a payload made of several buffers.
+ */
+typedef struct cy_mqtt_payload_segment
+{
+    const char     *data;        /**< Segment data. */
+    size_t         data_len;     /**< Segment data length. */
+} cy_mqtt_payload_segment_t;
+
 /**
  * MQTT broker information structure.
  */
@@ -380,6 +611,15 @@ typedef struct cy_mqtt_broker_info
     uint16_t                     port;           /**< Server port in host-order. */
 } cy_mqtt_broker_info_t;
 
+/**
+ * MQTT broker endpoint structure. Refer \ref cy_mqtt_set_broker_endpoints.
+ */
+typedef struct cy_mqtt_broker_endpoint
+{
+    cy_mqtt_broker_info_t        broker_info;    /**< Broker information of the endpoint. The host name memory needs to be maintained until MQTT object is deleted. */
+    uint8_t                      priority;       /**< Priority of the endpoint. Endpoints with a lower value are tried first. */
+} cy_mqtt_broker_endpoint_t;
+
 /**
  * MQTT connect information structure.
  */
@@ -392,7 +632,7 @@ typedef struct cy_mqtt_connect_info
     const char                   *password;      /**< MQTT password. Set to NULL if not used. This memory needs to be maintained until MQTT object is deleted.*/
     uint16_t                     password_len;   /**< Length of MQTT password. Set to 0 if not used. */
     bool                         clean_session;  /**< Whether to establish a new, clean session or resume a previous session.*/
-    uint16_t                     keep_alive_sec; /**< MQTT keep alive period.*/
+    uint16_t                     keep_alive_sec; /**< MQTT keep alive period. It is measured from the last packet sent to the broker, so a PINGREQ is sent only when no other packet is sent for the whole period.*/
     cy_mqtt_publish_info_t       *will_info;     /**< MQTT will message. This will info can be NULL. */
  } cy_mqtt_connect_info_t;
 
@@ -411,6 +651,31 @@ typedef struct cy_mqtt_message
     cy_mqtt_received_msg_info_t received_message;  /**< Received MQTT message from the subscribed topic. */
 } cy_mqtt_message_t;
 
+/**
+ * Fragment of a received MQTT publish message that is larger than the network buffer.
+ */
+typedef struct cy_mqtt_message_fragment
+{
+    uint16_t                    packet_id;         /**< Packet ID of the MQTT message. */
+    cy_mqtt_received_msg_info_t received_message;  /**< Received MQTT message from the subscribed topic. The payload and payload_len refer to the fragment. */
+    size_t                      offset;            /**< Offset of the fragment in the payload of the message. */
+    size_t                      total_len;         /**< Length of the payload of the message. */
+    bool                        first;             /**< True for the first fragment of the message. */
+    bool                        last;              /**< True for the last fragment of the message. */
+} cy_mqtt_message_fragment_t;
+
+/**
+ * Outcome of the automatic reconnection, reported with event type \ref CY_MQTT_EVENT_TYPE_RECONNECT.
+ */
+typedef struct cy_mqtt_reconnect_status
+{
+    cy_rslt_t                   result;            /**< CY_RSLT_SUCCESS if the MQTT session is established again; CY_RSLT_MODULE_MQTT_CONNECT_FAIL if all the attempts failed. */
+    uint32_t                    attempts;          /**< Number of connection attempts made. */
+    uint32_t                    latency_ms;        /**< Time in milliseconds from the loss of the MQTT session to the outcome. */
+    bool                        session_present;   /**< True if the broker resumed the previous MQTT session; the subscriptions are then kept by the broker. */
+    uint32_t                    rejected_filters;  /**< Number of recorded topic filters the broker rejected when they were subscribed again. */
+} cy_mqtt_reconnect_status_t;
+
 /**
  * MQTT event information structure.
  */
@@ -421,6 +686,8 @@ typedef struct cy_mqtt_event
     {
         cy_mqtt_disconn_type_t   reason;   /**< Disconnection reason for event type \ref CY_MQTT_EVENT_TYPE_DISCONNECT */
         cy_mqtt_message_t        pub_msg;  /**< Received MQTT message for event type \ref CY_MQTT_EVENT_TYPE_SUBSCRIPTION_MESSAGE_RECEIVE */
+        cy_mqtt_message_fragment_t fragment; /**< Fragment of a received MQTT message for event type \ref CY_MQTT_EVENT_TYPE_PUBLISH_FRAGMENT_RECEIVE */
+        cy_mqtt_reconnect_status_t reconnect; /**< Outcome of the automatic reconnection for event type \ref CY_MQTT_EVENT_TYPE_RECONNECT */
     } data;                                /**< Event data */
 } cy_mqtt_event_t;
 
@@ -429,6 +696,101 @@ typedef struct cy_mqtt_event
  */
 typedef cy_mqtt_subscribe_info_t cy_mqtt_unsubscribe_info_t;
 
+/**
+ * Publish rate limit of an MQTT handle. The messages and bytes published are limited by two token buckets,
+ * each refilled at its rate up to its burst size. A rate of 0 disables the corresponding bucket.
+ * The bytes of a message are counted as the length of its topic and payload. Refer \ref cy_mqtt_set_publish_rate_limit.
+ */
+typedef struct cy_mqtt_publish_rate_limit
+{
+    uint32_t       messages_per_sec;  /**< Sustained number of messages per second. */
+    uint32_t       message_burst;     /**< Maximum number of messages published back to back. */
+    uint32_t       bytes_per_sec;     /**< Sustained number of bytes per second. */
+    uint32_t       byte_burst;        /**< Maximum number of bytes published back to back. */
+    uint32_t       max_wait_ms;       /**< Maximum time in milliseconds a synchronous publish waits for the budget. 0 returns immediately. */
+} cy_mqtt_publish_rate_limit_t;
+
+/**
+ * Payload codec function. Compresses or decompresses src_len bytes of src into dst.
+ *
+ * @param src [in]           : Input data.
+ * @param src_len [in]       : Length of the input data.
+ * @param dst [out]          : Output buffer.
+ * @param dst_len [in]       : Size of the output buffer. For decompression, it is the original payload length.
+ * @param user_data [in]     : User data of the codec.
+ *
+ * @return size_t            : Number of bytes written to dst; 0 if the output does not fit in dst or the input is invalid.
+ */
+typedef size_t (*cy_mqtt_codec_fn_t)( const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len, void *user_data );
+
+/**
+ * Payload codec of an MQTT handle. Refer \ref cy_mqtt_set_payload_codec.
+ */
+typedef struct cy_mqtt_payload_codec
+{
+    uint8_t              codec_id;    /**< Codec identifier carried in the header of the compressed payloads. */
+    size_t               threshold;   /**< Minimum payload length in bytes of the messages to compress. */
+    cy_mqtt_codec_fn_t   compress;    /**< Compression function. */
+    cy_mqtt_codec_fn_t   decompress;  /**< Decompression function. */
+    void                 *user_data;  /**< User data passed to the codec functions. */
+} cy_mqtt_payload_codec_t;
+
+/**
+ * Event loop configuration. Refer \ref cy_mqtt_event_loop_create.
+ */
+typedef struct cy_mqtt_event_loop_config
+{
+    uint32_t                stack_size;   /**< Stack size in bytes of the event loop thread. */
+    cy_thread_priority_t    priority;     /**< Priority of the event loop thread. */
+    uint16_t                queue_size;   /**< Maximum number of pending events of the event loop. 0 selects the size of the queue of the default event loop. */
+} cy_mqtt_event_loop_config_t;
+
+/**
+ * Dispatch pool configuration of an MQTT handle. Refer \ref cy_mqtt_set_dispatch_pool.
+ */
+typedef struct cy_mqtt_dispatch_config
+{
+    uint8_t        worker_count;  /**< Number of worker threads. The messages of a topic are always handed to the callbacks by the same worker. */
+    uint16_t       buffer_count;  /**< Number of message buffers shared by the workers. Messages received while all of them are in use are copied to memory allocated from heap. */
+    uint32_t       buffer_size;   /**< Size in bytes of a message buffer, which holds the topic, the payload, and about 64 bytes of bookkeeping. Larger messages are copied to memory allocated from heap. */
+} cy_mqtt_dispatch_config_t;
+
+/**
+ * Storage backend of the publish spool. The storage is a byte-addressable region, for example a file or a flash
+ * partition, that is used as a ring journal of the messages published while the MQTT session is not established.
+ * Refer \ref cy_mqtt_enable_spool.
+ */
+typedef struct cy_mqtt_spool_storage
+{
+    cy_rslt_t    (*read)( void *storage_ctx, uint32_t offset, void *buffer, uint32_t length );        /**< Reads length bytes at offset of the storage. */
+    cy_rslt_t    (*write)( void *storage_ctx, uint32_t offset, const void *buffer, uint32_t length ); /**< Writes length bytes at offset of the storage. */
+    cy_rslt_t    (*sync)( void *storage_ctx );                                                         /**< Makes the data written so far persistent. Can be NULL if the data is persistent when write returns. */
+    uint32_t     size;                                                                                 /**< Size of the storage in bytes. */
+    void         *storage_ctx;                                                                         /**< Storage context passed to the callback functions. */
+} cy_mqtt_spool_storage_t;
+
+/**
+ * TLS session hooks of an MQTT handle. The TLS context of a connection is owned by the secure sockets layer, so the
+ * hooks export the TLS session (session ID or session ticket) of a connection from its socket, and import it into
+ * the socket of the next connection. Refer \ref cy_mqtt_set_tls_session_hooks.
+ */
+typedef struct cy_mqtt_tls_session_hooks
+{
+    cy_rslt_t    (*save)( cy_socket_t socket, uint8_t *session, size_t *session_len, bool *resumed, void *user_data ); /**< Called once the TLS handshake is complete. Exports the TLS session into session, whose size is passed in *session_len, sets *session_len to the length of the session, and *resumed to true if the handshake resumed the offered session. */
+    cy_rslt_t    (*offer)( cy_socket_t socket, const uint8_t *session, size_t session_len, void *user_data );  /**< Called before the TLS handshake if a TLS session is cached. Sets the session to be offered to the MQTT broker for resumption. */
+    void         *user_data;                                                                                   /**< User data passed to the hook functions. */
+} cy_mqtt_tls_session_hooks_t;
+
+/**
+ * Automatic reconnection configuration of an MQTT handle. Refer \ref cy_mqtt_enable_auto_reconnect.
+ */
+typedef struct cy_mqtt_reconnect_config
+{
+    uint32_t       initial_backoff_ms;  /**< Backoff in milliseconds before the first attempt. 0 selects \ref CY_MQTT_RECONNECT_INITIAL_BACKOFF_MS. */
+    uint32_t       max_backoff_ms;      /**< Maximum backoff in milliseconds; the backoff is doubled after each failed attempt up to this value. 0 selects \ref CY_MQTT_RECONNECT_MAX_BACKOFF_MS. */
+    uint32_t       max_attempts;        /**< Maximum number of attempts before the automatic reconnection gives up. 0 retries until the MQTT session is established again. */
+} cy_mqtt_reconnect_config_t;
+
 
 /**
  * @}
@@ -463,6 +825,22 @@ typedef cy_mqtt_subscribe_info_t cy_mqtt_unsubscribe_info_t;
  */
 typedef void ( *cy_mqtt_callback_t )( cy_mqtt_t mqtt_handle, cy_mqtt_event_t event, void *user_data );
 
+/**
+ * Completion callback function type for messages published using \ref cy_mqtt_publish_async.
+ * The callback is invoked from the MQTT event processing thread once the final status of the message is known.
+ *
+ * \note
+ *    Only \ref cy_mqtt_publish_async may be invoked from this callback function. Other MQTT library functions should not be invoked from this callback function.
+ *
+ * @param mqtt_handle [in]     : MQTT handle.
+ * @param token [in]           : Token returned by \ref cy_mqtt_publish_async for the message.
+ * @param status [in]          : Completion status of the message. Refer \ref cy_mqtt_publish_status_t for details.
+ * @param user_data [in]       : Pointer to user data provided in \ref cy_mqtt_publish_async.
+ *
+ * @return                     : void
+ */
+typedef void ( *cy_mqtt_publish_complete_cb_t )( cy_mqtt_t mqtt_handle, cy_mqtt_publish_token_t token, cy_mqtt_publish_status_t status, void *user_data );
+
 /**
  * Performs network sockets initialization required for the MQTT library.
  * <b>It must be called once (and only once) before calling any other function in this library.</b>
@@ -477,6 +855,19 @@ typedef void ( *cy_mqtt_callback_t )( cy_mqtt_t mqtt_handle, cy_mqtt_event_t eve
  */
 cy_rslt_t cy_mqtt_init( void );
 
+/**
+ * Sets the maximum number of MQTT instances that can be created. The default limit is \ref CY_MQTT_MAX_HANDLE.
+ *
+ * \note
+ *    1. The handle table grows with the number of MQTT instances created up to this limit, and the MQTT handle of a descriptor is found using a hash of the descriptor.
+ *    2. The limit cannot be set below the number of MQTT instances already created.
+ *
+ * @param max_handles [in]   : Maximum number of MQTT instances. Must be between 1 and 65534.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_set_max_handles( uint16_t max_handles );
+
 /**
  * Creates an MQTT instance and initializes its members based on the supplied arguments.
  * Initializes the core AWS MQTT library and its components.
@@ -548,6 +939,464 @@ cy_rslt_t cy_mqtt_get_handle( cy_mqtt_t *mqtt_handle, char *descriptor );
  */
 cy_rslt_t cy_mqtt_publish( cy_mqtt_t mqtt_handle, cy_mqtt_publish_info_t *pub_msg );
 
+/**
+ * Publishes the MQTT message on given MQTT topic without waiting for the acknowledgment from the MQTT broker.
+ * The PUBLISH packet is sent and the function returns immediately with a token identifying the message.
+ * For QoS1 and QoS2 messages, the acknowledgment, timeout, or session loss is reported through the completion callback.
+ *
+ * \note
+ *       1. The topic and payload memory referred by pub_msg must be maintained until the completion callback is invoked,
+ *          because the message may need to be resent when the MQTT session is resumed. If the retransmit arena is enabled using
+ *          \ref cy_mqtt_set_retransmit_buffer_size, the message is copied and the memory can be reused as soon as the function returns.
+ *       2. For QoS0 messages, the completion callback is not invoked and the token is set to 0.
+ *       3. The number of messages awaiting an acknowledgment is limited by the inflight window of the MQTT instance, which is
+ *          \ref CY_MQTT_MAX_OUTGOING_PUBLISHES by default and can be changed using \ref cy_mqtt_set_max_inflight_publishes. The function
+ *          returns \ref CY_RSLT_MODULE_MQTT_PUBLISH_FAIL if there is no free slot for a new message.
+ *       4. If the MQTT handle is deleted while messages are awaiting an acknowledgment, their completion callbacks are not invoked.
+ *       5. If the payload is compressed by the payload codec set using \ref cy_mqtt_set_payload_codec, the compressed copy is kept by
+ *          the library until the completion callback is invoked.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param pub_msg [in]       : MQTT publish message information. Refer \ref cy_mqtt_publish_info_t for details.
+ * @param complete_cb [in]   : Completion callback for QoS1/QoS2 messages. Can be NULL if the application is not interested in the completion status.
+ * @param user_data [in]     : Pointer to user data to be passed in the completion callback.
+ * @param token [out]        : Pointer to store the token identifying the message.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_publish_async( cy_mqtt_t mqtt_handle, cy_mqtt_publish_info_t *pub_msg,
+                                 cy_mqtt_publish_complete_cb_t complete_cb, void *user_data,
+                                 cy_mqtt_publish_token_t *token );
+
+/**
+ * Publishes a batch of MQTT messages and waits for the acknowledgment of all the QoS1 and QoS2 messages of the batch.
+ * The PUBLISH packets are serialized back to back into the network buffer and sent with a single network write,
+ * so that many small messages share one TLS record, one lock cycle, and one keep-alive timer restart.
+ *
+ * \note
+ *       1. A batch with more QoS1 and QoS2 messages than the free entries of the inflight window is sent in slices; each slice
+ *          is acknowledged before the next one is sent. Raise the window with \ref cy_mqtt_set_max_inflight_publishes to send
+ *          larger batches in a single round trip. The API fails if no entry of the window is free.
+ *       2. If the serialized batch does not fit in the network buffer passed to \ref cy_mqtt_create, the batch is sent
+ *          with one network write per filled network buffer.
+ *       3. The messages not acknowledged within \ref CY_MQTT_ACK_RECEIVE_TIMEOUT_MS are resent up to \ref CY_MQTT_MAX_RETRY_VALUE
+ *          times. QoS0 messages are sent only once.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param pub_msgs [in]      : Array of MQTT publish message information. Refer \ref cy_mqtt_publish_info_t for details.
+ * @param count [in]         : Number of messages in the array.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS if all the messages are sent and all the QoS1 and QoS2 messages are acknowledged;
+ *                             error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_publish_batch( cy_mqtt_t mqtt_handle, cy_mqtt_publish_info_t *pub_msgs, uint16_t count );
+
+/**
+ * Publishes the MQTT message whose payload is made of several segments, such as a header, a data block and a trailer.
+ * The segments are sent one after the other directly from the application memory, so they do not need to be copied into a
+ * single buffer first. The payload received by the subscribers is the concatenation of the segments.
+ *
+ * \note
+ *       1. The payload and payload_len members of pub_msg are not used.
+ *       2. The segment array and the segment data must be maintained until the function returns.
+ *       3. The message is not stored in the publish spool enabled using \ref cy_mqtt_enable_spool; the function returns
+ *          \ref CY_RSLT_MODULE_MQTT_NOT_CONNECTED if the MQTT session is not established.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param pub_msg [in]       : MQTT publish message information. Refer \ref cy_mqtt_publish_info_t for details.
+ * @param segments [in]      : Array of payload segments. Refer \ref cy_mqtt_payload_segment_t for details.
+ * @param segment_count [in] : Number of segments in the array.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_publish_vectored( cy_mqtt_t mqtt_handle, cy_mqtt_publish_info_t *pub_msg,
+                                    const cy_mqtt_payload_segment_t *segments, uint16_t segment_count );
+
+/**
+ * Registers a topic on which messages are published repeatedly. The topic name is validated and encoded once, together with
+ * the fixed header flags of the given QoS and retain flag, so that \ref cy_mqtt_publish_topic only fills in the remaining length,
+ * packet ID and payload of each PUBLISH packet.
+ *
+ * \note The topic name is copied; the memory referred by topic can be reused when the function returns.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param topic [in]         : Topic name. It must be valid UTF-8 and must not contain wildcard characters.
+ * @param topic_len [in]     : Length of the topic name.
+ * @param qos [in]           : Quality of Service of the messages published on the topic.
+ * @param retain [in]        : Whether the messages published on the topic are retained messages.
+ * @param topic_handle [out] : Pointer to store the handle of the registered topic.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_topic_register( cy_mqtt_t mqtt_handle, const char *topic, uint16_t topic_len,
+                                  cy_mqtt_qos_t qos, bool retain, cy_mqtt_topic_t *topic_handle );
+
+/**
+ * Deregisters a topic registered using \ref cy_mqtt_topic_register. The topics that are not deregistered are freed by \ref cy_mqtt_delete.
+ *
+ * \note The topic must not be deregistered while \ref cy_mqtt_publish_topic is in progress on it.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param topic_handle [in]  : Handle of the registered topic.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_topic_deregister( cy_mqtt_t mqtt_handle, cy_mqtt_topic_t topic_handle );
+
+/**
+ * Publishes the MQTT message on a topic registered using \ref cy_mqtt_topic_register, with the QoS and retain flag of the topic.
+ * The behavior is the same as \ref cy_mqtt_publish, but the topic name is not validated and encoded again for every message.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param topic_handle [in]  : Handle of the registered topic.
+ * @param payload [in]       : Message payload.
+ * @param payload_len [in]   : Message payload length.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_publish_topic( cy_mqtt_t mqtt_handle, cy_mqtt_topic_t topic_handle, const char *payload, size_t payload_len );
+
+/**
+ * Enables the publish spool of the MQTT instance. While the MQTT session is not established, \ref cy_mqtt_publish
+ * appends the message to the spool storage and returns CY_RSLT_SUCCESS instead of \ref CY_RSLT_MODULE_MQTT_NOT_CONNECTED.
+ * Once \ref cy_mqtt_connect succeeds, the spooled messages are published in order by the MQTT event processing thread,
+ * with as many messages awaiting an acknowledgment as the inflight window allows. The offset of the acknowledged
+ * messages is persisted in the storage, so that the spool is resumed after a reboot by enabling it with the same storage.
+ *
+ * \note
+ *       1. The spooled messages are appended with group commit. Refer \ref CY_MQTT_SPOOL_COMMIT_BUFFER_SIZE. Call \ref cy_mqtt_flush_spool
+ *          to make the messages spooled so far persistent.
+ *       2. Spooled messages are delivered at least once. A message may be sent again after a reboot or a session loss.
+ *       3. Messages published while the spool is being drained are not ordered with respect to the spooled messages.
+ *       4. The storage must be maintained until the MQTT instance is deleted.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param storage [in]       : Storage backend of the spool. Refer \ref cy_mqtt_spool_storage_t for details.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_enable_spool( cy_mqtt_t mqtt_handle, const cy_mqtt_spool_storage_t *storage );
+
+/**
+ * Writes the messages collected in the group commit buffer of the publish spool to the storage, and persists the
+ * offset of the acknowledged spooled messages.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_flush_spool( cy_mqtt_t mqtt_handle );
+
+/**
+ * Sets the size of the inflight window, i.e. the maximum number of outgoing QoS1 and QoS2 messages of the MQTT
+ * instance that can await an acknowledgment from the MQTT broker at the same time. Messages published from
+ * several threads using \ref cy_mqtt_publish, and messages published using \ref cy_mqtt_publish_async, share this window.
+ *
+ * \note
+ *       1. This API must be called before \ref cy_mqtt_connect, or after \ref cy_mqtt_disconnect when no messages are pending.
+ *       2. The window size cannot exceed CY_MQTT_MAX_INFLIGHT_WINDOW (10 by default). Define CY_MQTT_MAX_INFLIGHT_WINDOW in the build
+ *          to allow windows of several hundred messages; the state records of the MQTT core library are sized from it.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param max_inflight [in]  : Size of the inflight window. Valid range is 1 to CY_MQTT_MAX_INFLIGHT_WINDOW.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_set_max_inflight_publishes( cy_mqtt_t mqtt_handle, uint16_t max_inflight );
+
+/**
+ * Enables the retransmit arena of the MQTT instance. The arena has one slot of slot_size bytes per entry of the inflight window.
+ * The topic and payload of each QoS1 and QoS2 message published using \ref cy_mqtt_publish_async are copied to the slot of the
+ * message, and the slot is released when the message is acknowledged. A resend after the MQTT session is resumed uses the copy,
+ * so that the application does not need to keep its buffers until the completion callback is invoked.
+ *
+ * \note
+ *       1. This API must be called before \ref cy_mqtt_connect, or after \ref cy_mqtt_disconnect when no messages are pending.
+ *       2. \ref cy_mqtt_publish_async returns \ref CY_RSLT_MODULE_MQTT_PUBLISH_FAIL for a message whose topic and payload length
+ *          together exceed slot_size.
+ *       3. The arena takes slot_size times the inflight window size of heap memory, and is resized by \ref cy_mqtt_set_max_inflight_publishes.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param slot_size [in]     : Size of the retransmit slot in bytes. 0 disables the retransmit arena.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_set_retransmit_buffer_size( cy_mqtt_t mqtt_handle, uint32_t slot_size );
+
+/**
+ * Sets the publish rate limit of the MQTT instance, so that a burst of publishes does not saturate the network
+ * and starve the keep-alive PINGREQ packets of the connection.
+ *
+ * \note
+ *       1. \ref cy_mqtt_publish, \ref cy_mqtt_publish_vectored, and \ref cy_mqtt_publish_batch wait up to max_wait_ms of the rate limit
+ *          for the budget, and return \ref CY_RSLT_MODULE_MQTT_RATE_LIMITED if it is still exceeded.
+ *       2. \ref cy_mqtt_publish_async does not wait; it returns \ref CY_RSLT_MODULE_MQTT_RATE_LIMITED immediately if the budget is exceeded.
+ *       3. Messages of the publish spool are published at the rate limit once the MQTT session is established.
+ *       4. A message larger than the burst size waits for a full bucket and is charged in full; the messages after it wait
+ *          until the excess is repaid at the configured rate.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param rate_limit [in]    : Publish rate limit. Refer \ref cy_mqtt_publish_rate_limit_t for details. NULL disables the rate limit.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_set_publish_rate_limit( cy_mqtt_t mqtt_handle, const cy_mqtt_publish_rate_limit_t *rate_limit );
+
+/**
+ * Creates an event loop: a thread with its own event queue, which processes the received data, the keepalive, and the
+ * asynchronous publish completions of the MQTT instances assigned to it using \ref cy_mqtt_set_event_loop. By default, all
+ * MQTT instances share the event loop started by \ref cy_mqtt_init, so a slow network read or a blocking callback of one
+ * broker connection delays the others; a connection, or a group of connections, can be isolated on its own event loop.
+ *
+ * \note
+ *       1. The event loops must be deleted using \ref cy_mqtt_event_loop_delete before \ref cy_mqtt_deinit is called.
+ *
+ * @param config [in]        : Stack size, priority, and queue size of the event loop. Refer \ref cy_mqtt_event_loop_config_t for details.
+ * @param event_loop [out]   : Handle to the created event loop.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_event_loop_create( const cy_mqtt_event_loop_config_t *config, cy_mqtt_event_loop_t *event_loop );
+
+/**
+ * Deletes an event loop created using \ref cy_mqtt_event_loop_create, after it has processed the pending events.
+ *
+ * \note
+ *       1. The MQTT instances assigned to the event loop must be deleted, or assigned to another event loop, before
+ *          the event loop is deleted; \ref CY_RSLT_MODULE_MQTT_ERROR is returned otherwise.
+ *
+ * @param event_loop [in]    : Handle to the event loop.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_event_loop_delete( cy_mqtt_event_loop_t event_loop );
+
+/**
+ * Assigns the MQTT instance to an event loop created using \ref cy_mqtt_event_loop_create, or to the default event loop
+ * if event_loop is NULL. Several MQTT instances may be assigned to the same event loop.
+ *
+ * \note
+ *       1. This function must be called when the MQTT instance is not connected; it returns \ref CY_RSLT_MODULE_MQTT_ALREADY_CONNECTED otherwise.
+ *       2. \ref CY_RSLT_MODULE_MQTT_BUSY is returned while the automatic reconnection is in progress, or while events of the
+ *          MQTT instance are still pending in its current event loop, e.g. right after a disconnection; retry once they are processed.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param event_loop [in]    : Handle to the event loop. NULL selects the default event loop.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_set_event_loop( cy_mqtt_t mqtt_handle, cy_mqtt_event_loop_t event_loop );
+
+/**
+ * Enables or disables tracking of the packet IDs of the received QoS2 messages in a bitmap of 8 KB, one bit per packet ID.
+ * By default, the state of a received QoS2 message is kept in the MQTT core library until its PUBREL is received, which supports
+ * at most MQTT_STATE_ARRAY_MAX_COUNT such messages at a time, and the connection fails when the broker sends more. With the bitmap,
+ * any number of received QoS2 messages may wait for their PUBREL, and each PUBLISH and PUBREL is handled in constant time.
+ *
+ * \note
+ *       1. This function must be called when the MQTT instance is not connected; it returns \ref CY_RSLT_MODULE_MQTT_ALREADY_CONNECTED otherwise.
+ *       2. The bitmap is cleared when a clean session is established, and kept when the broker resumes the session.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param enable [in]        : True to track the received QoS2 messages in the bitmap; false to leave them to the MQTT core library.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_enable_qos2_bitmap( cy_mqtt_t mqtt_handle, bool enable );
+
+/**
+ * Enables the dispatch pool of the MQTT instance, or disables it if config is NULL. When enabled, received messages are copied
+ * into the message buffers of the pool and handed to the subscription callbacks and the registered event callbacks by the worker
+ * threads of the pool, so that a slow callback does not delay the network processing and keepalive of the MQTT instances.
+ * Messages are assigned to a worker by the hash of their topic, so the messages of a topic are handed to the callbacks in the
+ * order of receipt.
+ *
+ * \note
+ *       1. Only the \ref CY_MQTT_EVENT_TYPE_PUBLISH_RECEIVE and \ref CY_MQTT_EVENT_TYPE_PUBLISH_FRAGMENT_RECEIVE events are handed
+ *          to the workers. Disconnect events are still delivered by the MQTT event processing thread.
+ *       2. The callbacks run in the worker threads without the MQTT library locks held, so they may call \ref cy_mqtt_publish and the
+ *          other MQTT library functions, except \ref cy_mqtt_set_dispatch_pool and \ref cy_mqtt_delete for the same MQTT handle.
+ *       3. Reception never waits for the workers. A message received while all the message buffers are in use is copied to memory
+ *          allocated from heap, and is dropped only if no memory is available to copy it.
+ *       4. Disabling the dispatch pool, or deleting the MQTT handle, waits until the queued messages are handed to the callbacks.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param config [in]        : Dispatch pool configuration. Refer \ref cy_mqtt_dispatch_config_t for details. NULL disables the dispatch pool.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_set_dispatch_pool( cy_mqtt_t mqtt_handle, const cy_mqtt_dispatch_config_t *config );
+
+/**
+ * Enables or disables fragmented receive of the messages larger than the network buffer passed to \ref cy_mqtt_create.
+ * When enabled, the payload of such a message is read from the network in fragments and delivered as a series of
+ * \ref CY_MQTT_EVENT_TYPE_PUBLISH_FRAGMENT_RECEIVE events. Refer \ref cy_mqtt_message_fragment_t for details. When disabled,
+ * such messages are discarded.
+ *
+ * \note
+ *       1. The network buffer holds the topic name and one fragment, so the fragments are at most the size of the network buffer
+ *          minus the topic length. The payload of a fragment is valid only in the event callback.
+ *       2. QoS1 and QoS2 messages are acknowledged after the last fragment is delivered.
+ *       3. Fragments are not decompressed by the payload codec set using \ref cy_mqtt_set_payload_codec.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param enable [in]        : true to enable fragmented receive; false to disable it.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_enable_fragmented_receive( cy_mqtt_t mqtt_handle, bool enable );
+
+/**
+ * Sets the payload codec of the MQTT instance. The payloads of the messages published using \ref cy_mqtt_publish,
+ * \ref cy_mqtt_publish_topic, and \ref cy_mqtt_publish_async, including the messages of the publish spool, that are at
+ * least the threshold of the codec long are compressed, and sent with an 8-byte header identifying the codec and the
+ * original payload length. Received messages whose payload starts with this header are
+ * decompressed before they are delivered to the registered event callbacks.
+ *
+ * \note
+ *       1. A payload is sent uncompressed if it does not get smaller, so the application on the receiving side must also
+ *          enable the codec, or understand the compressed payload header.
+ *       2. The payloads of \ref cy_mqtt_publish_batch and \ref cy_mqtt_publish_vectored are not compressed.
+ *       3. The built-in LZ4 block format codec is used by setting \ref cy_mqtt_lz4_compress and \ref cy_mqtt_lz4_decompress
+ *          as the codec functions, with codec ID \ref CY_MQTT_CODEC_ID_LZ4.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param codec [in]         : Payload codec. Refer \ref cy_mqtt_payload_codec_t for details. NULL disables the payload codec.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_set_payload_codec( cy_mqtt_t mqtt_handle, const cy_mqtt_payload_codec_t *codec );
+
+/**
+ * Compresses data in the LZ4 block format. Built-in compression function of type \ref cy_mqtt_codec_fn_t.
+ *
+ * @param src [in]           : Input data.
+ * @param src_len [in]       : Length of the input data.
+ * @param dst [out]          : Output buffer.
+ * @param dst_len [in]       : Size of the output buffer.
+ * @param user_data [in]     : Not used.
+ *
+ * @return size_t            : Length of the compressed data; 0 if it does not fit in dst.
+ */
+size_t cy_mqtt_lz4_compress( const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len, void *user_data );
+
+/**
+ * Decompresses data in the LZ4 block format. Built-in decompression function of type \ref cy_mqtt_codec_fn_t.
+ *
+ * @param src [in]           : Compressed data.
+ * @param src_len [in]       : Length of the compressed data.
+ * @param dst [out]          : Output buffer.
+ * @param dst_len [in]       : Size of the output buffer.
+ * @param user_data [in]     : Not used.
+ *
+ * @return size_t            : Length of the decompressed data; 0 if the compressed data is invalid or does not fit in dst.
+ */
+size_t cy_mqtt_lz4_decompress( const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len, void *user_data );
+
+/**
+ * Sets the TLS session hooks of the MQTT instance, to resume the TLS session of the last successful connection on
+ * the next call of \ref cy_mqtt_connect. A resumed session completes the TLS handshake in one round trip, without
+ * the public key operations of a full handshake.
+ *
+ * \note
+ *       1. The TLS session is exported through the save hook after each successful TLS handshake, and cached in the
+ *          MQTT instance, up to \ref CY_MQTT_TLS_SESSION_MAX_SIZE bytes. It is offered through the offer hook on the
+ *          next connection to the same MQTT broker.
+ *       2. If the TLS handshake fails after a session is offered, the cached session is discarded, so that the next
+ *          attempt performs a full handshake.
+ *       3. The hooks are used only for secure connections.
+ *       4. The cached session holds secret key material. It is cleared when the hooks are removed, and when the MQTT
+ *          instance is deleted.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param hooks [in]         : TLS session hooks. Refer \ref cy_mqtt_tls_session_hooks_t for details. NULL removes the hooks and clears the cached session.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_set_tls_session_hooks( cy_mqtt_t mqtt_handle, const cy_mqtt_tls_session_hooks_t *hooks );
+
+/**
+ * Gets whether the TLS handshake of the last successful \ref cy_mqtt_connect resumed a cached TLS session.
+ * Refer \ref cy_mqtt_set_tls_session_hooks.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param resumed [out]      : True if the TLS session was resumed; false if a full TLS handshake was performed.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_get_tls_session_resumed( cy_mqtt_t mqtt_handle, bool *resumed );
+
+/**
+ * Sets the list of broker endpoints of the MQTT instance, used instead of the broker passed to \ref cy_mqtt_create
+ * from the next \ref cy_mqtt_connect or automatic reconnection. The endpoints are tried one after the other, once each,
+ * in the following order:
+ *     - The endpoints whose last connection succeeded, or failed more than \ref CY_MQTT_BROKER_FAILURE_HOLDDOWN_MS ago.
+ *       The endpoints that failed recently follow, the fewest consecutive failures first.
+ *     - The endpoints with the lower priority value.
+ *     - The endpoints with the shorter measured connection time, among the endpoints of the same priority.
+ *
+ * The connection time and the failures of each endpoint are kept across connections and reconnections of the MQTT instance.
+ * If no endpoint can be connected, \ref cy_mqtt_connect retries the whole list with backoff and jitter.
+ *
+ * \note
+ *       1. The endpoints are tried sequentially over the network connection of the MQTT instance. The time to fail an
+ *          unreachable endpoint is bounded by the network stack connection timeout.
+ *       2. All the endpoints must accept the security credentials passed to \ref cy_mqtt_create.
+ *       3. A TLS session cached using \ref cy_mqtt_set_tls_session_hooks is only offered to the endpoint it was established with.
+ *       4. The list is copied; the health of the endpoints of a previous list is discarded.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param endpoints [in]     : Array of broker endpoints. Refer \ref cy_mqtt_broker_endpoint_t for details.
+ * @param count [in]         : Number of broker endpoints, up to \ref CY_MQTT_MAX_BROKER_ENDPOINTS. 0 restores the broker passed to \ref cy_mqtt_create.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_set_broker_endpoints( cy_mqtt_t mqtt_handle, const cy_mqtt_broker_endpoint_t *endpoints, uint8_t count );
+
+/**
+ * Gets the broker endpoint of the current connection of the MQTT instance.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param index [out]        : Index of the connected endpoint in the list set using \ref cy_mqtt_set_broker_endpoints.
+ *                             0 if no broker endpoints are set.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; CY_RSLT_MODULE_MQTT_NOT_CONNECTED if the MQTT instance is not connected;
+ *                             error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_get_broker_endpoint( cy_mqtt_t mqtt_handle, uint8_t *index );
+
+/**
+ * Enables the automatic reconnection of the MQTT instance. When the MQTT session established by \ref cy_mqtt_connect
+ * is lost, the \ref CY_MQTT_EVENT_TYPE_DISCONNECT event is reported, the connection is closed, and the dedicated MQTT
+ * reconnect thread reconnects with the connect information of the last successful \ref cy_mqtt_connect. The attempts
+ * are spaced with exponential backoff, each delay drawn at random between half and all of the current backoff, so that
+ * clients disconnected together, e.g. by a broker restart, do not reconnect together.
+ *
+ * Once reconnected, the unacknowledged QoS1 and QoS2 messages are resent if the broker resumed the MQTT session.
+ * Otherwise, the recorded topic filters are subscribed again, with back to back SUBSCRIBE packets that do not wait
+ * for each other's acknowledgment. The outcome is reported with the \ref CY_MQTT_EVENT_TYPE_RECONNECT event, with
+ * the number of attempts, the reconnection latency and the number of topic filters rejected by the broker. When topic
+ * filters are subscribed again, the event is reported once all their SUBACKs are received, or when the MQTT session is
+ * lost before; the topic filters whose SUBACK is not received are not counted as rejected.
+ *
+ * \note
+ *       1. The topic filters subscribed using \ref cy_mqtt_subscribe while the automatic reconnection is enabled are recorded,
+ *          until they are unsubscribed. Enable the automatic reconnection before subscribing.
+ *       2. The application must not call \ref cy_mqtt_disconnect and \ref cy_mqtt_connect on the \ref CY_MQTT_EVENT_TYPE_DISCONNECT event.
+ *          Calling either of them stops the reconnection in progress.
+ *       3. The will message topic and payload of the connect information must be maintained until the MQTT instance is deleted.
+ *       4. The attempts are made by a dedicated reconnect thread, started by the first call of this API. The event loops
+ *          and the API calls of the other MQTT instances are not held up during the TLS handshake. Refer \ref CY_MQTT_RECONNECT_THREAD_STACK_SIZE.
+ *          The delay of each attempt is drawn with a generator seeded per device from the client ID.
+ *       5. To resend the unacknowledged messages, connect with clean_session set to false.
+ *
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param config [in]        : Automatic reconnection configuration. Refer \ref cy_mqtt_reconnect_config_t for details. NULL disables the automatic reconnection, and discards the recorded topic filters.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_enable_auto_reconnect( cy_mqtt_t mqtt_handle, const cy_mqtt_reconnect_config_t *config );
+
 /**
  * Subscribes for MQTT message on the given MQTT topic or list of topics.
  *
@@ -567,6 +1416,27 @@ cy_rslt_t cy_mqtt_publish( cy_mqtt_t mqtt_handle, cy_mqtt_publish_info_t *pub_ms
  */
 cy_rslt_t cy_mqtt_subscribe( cy_mqtt_t mqtt_handle, cy_mqtt_subscribe_info_t *sub_info, uint8_t sub_count );
 
+/**
+ * Subscribes for MQTT message on the given MQTT topic or list of topics, and attaches a callback to the topic filters.
+ *
+ * \note
+ *       1. The subscription request and the 'allocated_qos' of the topic filters are handled as in \ref cy_mqtt_subscribe.
+ *       2. Messages received on a topic that matches the topic filter of one or more subscriptions with a callback are
+ *          delivered to the callbacks of those subscriptions only. Other messages are delivered to the event callbacks
+ *          registered using \ref cy_mqtt_register_event_callback. The subscription callbacks are kept until the topic filter
+ *          is unsubscribed using \ref cy_mqtt_unsubscribe, or the MQTT handle is deleted.
+ *       3. This API is not supported in multi-core environment from the secondary core application.
+ * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
+ * @param sub_info [in, out] : Pointer to array of MQTT subscription information structure. Refer \ref cy_mqtt_subscribe_info_t for details.
+ * @param sub_count [in]     : Number of subscription topics in the subscription array.
+ * @param callback [in]      : Callback for the messages received on topics matching the topic filters in 'sub_info'.
+ * @param user_data [in]     : Pointer to user data to be passed in the subscription callback.
+ *
+ * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
+ */
+cy_rslt_t cy_mqtt_subscribe_with_callback( cy_mqtt_t mqtt_handle, cy_mqtt_subscribe_info_t *sub_info, uint8_t sub_count,
+                                           cy_mqtt_callback_t callback, void *user_data );
+
 /**
  * Registers an event callback for the given MQTT handle.
  *
@@ -621,6 +1491,10 @@ cy_rslt_t cy_mqtt_disconnect( cy_mqtt_t mqtt_handle );
  * Deletes the given MQTT instance and frees the resources allocated for the instance by the \ref cy_mqtt_create function.
  * Before calling this API function, MQTT connection with broker must be disconnected. And the MQTT handle should not be used after delete.
  *
+ * \note The API calls in progress on the instance in other threads return once delete wakes them, and new calls fail with
+ *       CY_RSLT_MODULE_MQTT_INVALID_HANDLE. The memory of the instance is released when the last of these calls returns and
+ *       the events already queued for the instance are dropped by its event loop thread.
+ *
  * @param mqtt_handle [in]   : MQTT handle created using \ref cy_mqtt_create.
  *
  * @return cy_rslt_t         : CY_RSLT_SUCCESS on success; error codes in @ref mqtt_defines otherwise.
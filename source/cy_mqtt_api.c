@@ -37,6 +37,7 @@
  */
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include "cy_mqtt_api.h"
 #include "cyabs_rtos.h"
 /******************************************************
@@ -758,14 +759,128 @@ cy_rslt_t cy_mqtt_deinit( void )
 
 #define CY_MQTT_EVENT_THREAD_PRIORITY                        ( CY_RTOS_PRIORITY_NORMAL )
 
+#define CY_MQTT_DISPATCH_THREAD_PRIORITY                     ( CY_RTOS_PRIORITY_NORMAL )
+
+/* The timer thread only queues events, so it runs above the event loops to keep the timers on time. */
+#define CY_MQTT_TIMER_THREAD_PRIORITY                        ( CY_RTOS_PRIORITY_ABOVENORMAL )
+
+#define CY_MQTT_RECONNECT_THREAD_PRIORITY                    ( CY_RTOS_PRIORITY_NORMAL )
+
+/* Size in bytes of the bitmap of the incoming QoS2 packet IDs, one bit for each packet ID. */
+#define CY_MQTT_QOS2_BITMAP_SIZE                             ( 65536U / 8U )
+
 #define CY_MQTT_EVENT_QUEUE_SIZE                             ( 30U )
 
 #define CY_MQTT_EVENT_QUEUE_TIMEOUT_IN_MSEC                  ( 500UL )
 
+/**
+ * Timing wheel geometry: CY_MQTT_TIMER_WHEEL_LEVELS levels of CY_MQTT_TIMER_WHEEL_SLOTS slots each. A level covers
+ * CY_MQTT_TIMER_WHEEL_SLOTS times the range of the level below it, and its slots are moved down one level when the
+ * lower level wraps around. Timers beyond the range of the top level are moved down until they are due.
+ */
+#define CY_MQTT_TIMER_WHEEL_LEVELS                           ( 3U )
+#define CY_MQTT_TIMER_WHEEL_SLOT_BITS                        ( 6U )
+#define CY_MQTT_TIMER_WHEEL_SLOTS                            ( 1UL << CY_MQTT_TIMER_WHEEL_SLOT_BITS )
+#define CY_MQTT_TIMER_WHEEL_SLOT_MASK                        ( CY_MQTT_TIMER_WHEEL_SLOTS - 1UL )
+#define CY_MQTT_TIMER_WHEEL_RANGE                            ( 1UL << (CY_MQTT_TIMER_WHEEL_SLOT_BITS * CY_MQTT_TIMER_WHEEL_LEVELS) )
+
+/**
+ * Maximum number of MQTT_ProcessLoop passes for one receive event. If data is still available in the socket
+ * after these passes, the receive event is queued again so that the events of other MQTT objects are not delayed.
+ */
+#define CY_MQTT_RECEIVE_DRAIN_MAX_PASSES                     ( 16U )
+
 #define CY_MQTT_MAGIC_HEADER                                 ( 0xbdefacbd )
 #define CY_MQTT_MAGIC_FOOTER                                 ( 0xefbcdbfd )
+#define CY_MQTT_TOPIC_MAGIC                                  ( 0x544f5043 )
 
 #define CY_MQTT_MAX_EVENT_CALLBACKS                          (2)
+
+/**
+ * Invalid index in the inflight window of the outgoing PUBLISH packets.
+ */
+#define CY_MQTT_PUB_INDEX_INVALID                            ( 0xFFFFU )
+
+#if ( CY_MQTT_MAX_INFLIGHT_WINDOW > 65535U )
+#error "CY_MQTT_MAX_INFLIGHT_WINDOW cannot exceed 65535"
+#endif
+
+#if ( CY_MQTT_MAX_INFLIGHT_WINDOW > MQTT_STATE_ARRAY_MAX_COUNT )
+#error "CY_MQTT_MAX_INFLIGHT_WINDOW cannot exceed MQTT_STATE_ARRAY_MAX_COUNT, which sizes the outgoing state records of the MQTT core library"
+#endif
+
+#if ( CY_MQTT_MAX_OUTGOING_PUBLISHES > CY_MQTT_MAX_INFLIGHT_WINDOW )
+#error "CY_MQTT_MAX_OUTGOING_PUBLISHES cannot exceed CY_MQTT_MAX_INFLIGHT_WINDOW"
+#endif
+
+/**
+ * Invalid index in mqtt_handle_database.
+ */
+#define CY_MQTT_HANDLE_INDEX_INVALID                         ( 0xFFFFU )
+
+/**
+ * Number of entries allocated in mqtt_handle_database for the first MQTT object. The table is doubled when it is full.
+ */
+#define CY_MQTT_HANDLE_TABLE_INITIAL_SIZE                    ( 4U )
+
+/**
+ * Maximum number of asynchronous publish completions reported per mqtt_obj->process_mutex cycle.
+ */
+#define CY_MQTT_ASYNC_COMPLETION_BATCH_SIZE                  ( 8U )
+
+/**
+ * Time in milliseconds after which draining of the publish spool is retried when the publish rate limit is exceeded.
+ */
+#define CY_MQTT_RATE_LIMIT_RETRY_INTERVAL_MS                 ( 100U )
+
+/**
+ * First byte of the fixed header of an MQTT PUBLISH packet, and its flags.
+ */
+#define CY_MQTT_PUBLISH_PACKET_TYPE                          ( 0x30U )
+#define CY_MQTT_PUBLISH_FLAG_RETAIN                          ( 0x01U )
+#define CY_MQTT_PUBLISH_FLAG_DUP                             ( 0x08U )
+
+/**
+ * Maximum value of the remaining length field of an MQTT packet, and the maximum size of the fixed header.
+ */
+#define CY_MQTT_MAX_REMAINING_LENGTH                         ( 268435455UL )
+#define CY_MQTT_MAX_FIXED_HEADER_SIZE                        ( 5U )
+
+#if ( CY_MQTT_TX_BUFFER_SIZE < 64U )
+#error "CY_MQTT_TX_BUFFER_SIZE must be large enough to hold the header of an MQTT PUBLISH packet"
+#endif
+
+#if ( CY_MQTT_RECEIVE_READ_AHEAD_SIZE < CY_MQTT_MAX_FIXED_HEADER_SIZE )
+#error "CY_MQTT_RECEIVE_READ_AHEAD_SIZE must be large enough to hold the fixed header of an MQTT packet"
+#endif
+
+#if ( CY_MQTT_RECEIVE_READ_AHEAD_SIZE > 65535U )
+#error "CY_MQTT_RECEIVE_READ_AHEAD_SIZE cannot exceed 65535, as the read-ahead offset and length are 16-bit"
+#endif
+
+/**
+ * Header of a compressed payload: 3 magic bytes, the codec ID, and the 4-byte big-endian original payload length.
+ */
+#define CY_MQTT_CODEC_HEADER_SIZE                            ( 8U )
+#define CY_MQTT_CODEC_MAGIC_0                                ( 0x89U )
+#define CY_MQTT_CODEC_MAGIC_1                                ( 0x4DU )
+#define CY_MQTT_CODEC_MAGIC_2                                ( 0x5AU )
+
+/**
+ * Magic value of the journal header of the publish spool.
+ */
+#define CY_MQTT_SPOOL_HEADER_MAGIC                           ( 0x4c4f4f53UL )
+
+/**
+ * Magic value of a message record in the journal of the publish spool.
+ */
+#define CY_MQTT_SPOOL_RECORD_MAGIC                           ( 0x44524352UL )
+
+/**
+ * Offset of the journal data region in the spool storage. The region is preceded by two
+ * copies of the journal header, which are written alternately.
+ */
+#define CY_MQTT_SPOOL_DATA_OFFSET                            ( 2U * sizeof( cy_mqtt_spool_header_t ) )
 /******************************************************
  *                    Constants
  ******************************************************/
@@ -781,7 +896,8 @@ typedef enum cy_mqtt_socket_event
     CY_MQTT_SOCKET_EVENT_DATA_RECEIVE                  = 0, /**< Data receive event from socket */
     CY_MQTT_SOCKET_EVENT_DISCONNECT                    = 1, /**< Disconnection event from socket */
     CY_MQTT_SOCKET_EVENT_PING_REQ                      = 2, /**< MQTT ping timer event */
-    CY_MQTT_SOCKET_EVENT_EXIT_THREAD                   = 3  /**< Terminate mqtt_event_processing_thread event from mqtt_deinit */
+    CY_MQTT_SOCKET_EVENT_EXIT_THREAD                   = 3, /**< Terminate mqtt_event_processing_thread event from mqtt_deinit */
+    CY_MQTT_SOCKET_EVENT_ASYNC_PUBLISH                 = 4  /**< Asynchronous publish completion or acknowledgment timeout event */
 } cy_mqtt_socket_event_t;
 
 /******************************************************
@@ -792,25 +908,312 @@ typedef enum cy_mqtt_socket_event
  *                    Structures
  ******************************************************/
 
+/**
+ * Topic registered using cy_mqtt_topic_register. The topic name is validated and
+ * encoded once, so that the PUBLISH packets of the topic are serialized by copying it.
+ */
+typedef struct cy_mqtt_topic_object
+{
+    uint32_t                        magic;
+    void                            *owner;            /**< MQTT object with which the topic is registered. */
+    struct cy_mqtt_topic_object     *next;             /**< Next topic registered with the MQTT object. */
+    cy_mqtt_qos_t                   qos;
+    bool                            retain;
+    uint8_t                         header;            /**< First byte of the fixed header of the PUBLISH packets of the topic. */
+    uint16_t                        encoded_len;       /**< Length of the encoded topic name, including the 2-byte length prefix. */
+    uint8_t                         *encoded;          /**< Length-prefixed topic name, allocated after the structure. */
+} cy_mqtt_topic_object_t;
+
+/**
+ * Topic filter subscribed while the automatic reconnection is enabled. The recorded topic filters are
+ * subscribed again when the automatic reconnection establishes a new MQTT session.
+ */
+typedef struct cy_mqtt_subscription
+{
+    struct cy_mqtt_subscription     *next;             /**< Next recorded topic filter of the MQTT object. */
+    MQTTQoS_t                       qos;               /**< Requested QoS of the subscription. */
+    uint16_t                        topic_len;         /**< Length of the topic filter. */
+    char                            *topic;            /**< Topic filter, allocated after the structure. */
+} cy_mqtt_subscription_t;
+
+/**
+ * Broker endpoint set using cy_mqtt_set_broker_endpoints, with the health of its last connections.
+ * The health is kept across connections, and orders the endpoints tried by mqtt_network_open_endpoints.
+ */
+typedef struct cy_mqtt_endpoint_state
+{
+    cy_mqtt_broker_endpoint_t       endpoint;          /**< Broker endpoint information. */
+    uint32_t                        connect_time_ms;   /**< Smoothed time to establish a connection to the endpoint. 0 if not measured yet. */
+    uint32_t                        last_failure_ms;   /**< Time of the last failed connection to the endpoint. */
+    uint16_t                        failures;          /**< Number of consecutive failed connections to the endpoint. */
+} cy_mqtt_endpoint_state_t;
+
+/**
+ * Callback attached to a topic filter using cy_mqtt_subscribe.
+ */
+typedef struct cy_mqtt_route
+{
+    cy_mqtt_callback_t              callback;
+    void                            *user_data;
+    struct cy_mqtt_route            *next;             /**< Next callback of the same topic filter. */
+} cy_mqtt_route_t;
+
+/**
+ * Node of the topic filter trie. Each node is one level of a topic filter; the '+' and '#' levels are
+ * kept apart from the other child levels so that they are checked for every topic without a search.
+ */
+typedef struct cy_mqtt_route_node
+{
+    struct cy_mqtt_route_node       *parent;
+    struct cy_mqtt_route_node       *children;         /**< First child node of a topic level other than '+' and '#'. */
+    struct cy_mqtt_route_node       *sibling;          /**< Next child node of the parent node. */
+    struct cy_mqtt_route_node       *single_level;     /**< Child node of the '+' topic level. */
+    struct cy_mqtt_route_node       *multi_level;      /**< Child node of the '#' topic level. */
+    cy_mqtt_route_t                 *routes;           /**< Callbacks of the topic filter ending at this node. */
+    uint16_t                        level_len;
+    char                            *level;            /**< Topic level, allocated after the structure. */
+} cy_mqtt_route_node_t;
+
+/**
+ * Function called by mqtt_route_match for each callback of the topic filters matching a topic.
+ */
+typedef void ( *cy_mqtt_route_visit_t )( const cy_mqtt_route_t *route, void *arg );
+
+/**
+ * Event loop processing the socket, timer, and asynchronous publish events of the MQTT objects assigned to it.
+ */
+typedef struct cy_mqtt_event_loop_object
+{
+    cy_thread_t                     thread;            /**< Thread running mqtt_event_processing_thread. NULL if the event loop is not started. */
+    cy_queue_t                      queue;             /**< Events of type cy_mqtt_callback_event_t. */
+    uint16_t                        handle_count;      /**< Number of MQTT objects assigned to the event loop. Protected by mqtt_db_mutex. */
+} cy_mqtt_event_loop_object_t;
+
+/**
+ * Callback to which a message is handed by the dispatch pool.
+ */
+typedef struct cy_mqtt_dispatch_target
+{
+    cy_mqtt_callback_t              callback;
+    void                            *user_data;
+} cy_mqtt_dispatch_target_t;
+
+/**
+ * Received message copied for the dispatch pool. The targets, the topic, and the payload follow the structure.
+ */
+typedef struct cy_mqtt_dispatch_msg
+{
+    struct cy_mqtt_dispatch_msg     *next;             /**< Next free buffer of the pool, or next message queued to the same worker. */
+    bool                            pooled;            /**< True if the message is in a pool buffer; false if it is allocated from heap. */
+    uint16_t                        target_count;
+    cy_mqtt_dispatch_target_t       *targets;
+    cy_mqtt_event_t                 event;
+} cy_mqtt_dispatch_msg_t;
+
+struct cy_mqtt_dispatch_pool;
+
+/**
+ * Worker thread of the dispatch pool.
+ */
+typedef struct cy_mqtt_dispatch_worker
+{
+    struct cy_mqtt_dispatch_pool    *pool;
+    cy_thread_t                     thread;
+    cy_semaphore_t                  pending;           /**< Signalled when a message is queued to the worker, or the worker is stopped. */
+    cy_mqtt_dispatch_msg_t          *head;             /**< Messages to hand to the callbacks, in order of receipt. Protected by the pool mutex. */
+    cy_mqtt_dispatch_msg_t          *tail;             /**< Last message queued to the worker. Protected by the pool mutex. */
+    bool                            stop;              /**< Set to stop the worker once its messages are handed to the callbacks. Protected by the pool mutex. */
+} cy_mqtt_dispatch_worker_t;
+
+/**
+ * Dispatch pool of an MQTT handle. Received messages are copied into the pool buffers and handed to the callbacks
+ * by the worker threads; all the messages of a topic are handed by the same worker, so that they keep their order.
+ */
+typedef struct cy_mqtt_dispatch_pool
+{
+    void                            *mqtt_obj;
+    cy_mqtt_dispatch_config_t       config;
+    cy_mutex_t                      mutex;             /**< Mutex for synchronizing free_list and the message lists of the workers. */
+    cy_semaphore_t                  free_count;        /**< Number of buffers in free_list. */
+    cy_mqtt_dispatch_msg_t          *free_list;
+    uint8_t                         *buffers;
+    uint8_t                         worker_count;      /**< Number of workers started. */
+    cy_mqtt_dispatch_worker_t       *workers;
+} cy_mqtt_dispatch_pool_t;
+
+/**
+ * Argument of mqtt_route_call_visit.
+ */
+typedef struct cy_mqtt_route_call
+{
+    cy_mqtt_t                       handle;
+    cy_mqtt_event_t                 *event;
+} cy_mqtt_route_call_t;
+
 /**
  * Structure to keep the MQTT PUBLISH packets until an ACK is received
  * for QoS1 and QoS2 publishes.
  */
 typedef struct publishpackets
 {
-    uint16_t               packetid;
-    MQTTPublishInfo_t      pubinfo;
+    uint16_t                        packetid;
+    uint16_t                        next;              /**< Next entry in the packet ID hash chain, or in the free list if the entry is free. */
+    MQTTPublishInfo_t               pubinfo;
+    const cy_mqtt_payload_segment_t *segments;         /**< Payload segments of cy_mqtt_publish_vectored, or NULL if the payload of pubinfo is contiguous. */
+    uint16_t                        segment_count;     /**< Number of payload segments. */
+    const cy_mqtt_topic_object_t    *topic_obj;        /**< Registered topic of cy_mqtt_publish_topic, or NULL. */
+    uint8_t                         *compressed_payload; /**< Compressed payload of cy_mqtt_publish_async owned by the entry, or NULL. */
+    bool                            ack_received;      /**< True if PUBACK (QoS1) or PUBREC (QoS2) is received. */
+    bool                            ack_waiting;       /**< True if a cy_mqtt_publish or cy_mqtt_publish_batch caller waits for the acknowledgment on the semaphore of the entry. */
+    bool                            batched;           /**< True if the packet is serialized in the pending network write of cy_mqtt_publish_batch. */
+    bool                            release_on_send;   /**< True if mqtt_obj->process_mutex is released while the next send of the packet is written to the socket. */
+    bool                            async;             /**< True if the packet is published using cy_mqtt_publish_async. */
+    bool                            completed;         /**< True if the final status of the asynchronous publish is known. */
+    cy_mqtt_publish_status_t        status;            /**< Final status of the asynchronous publish. Valid only if completed is true. */
+    uint32_t                        ack_deadline_ms;   /**< Time in milliseconds at which the asynchronous publish times out. */
+    cy_mqtt_publish_complete_cb_t   complete_cb;       /**< Completion callback of the asynchronous publish. */
+    void                            *complete_cb_data; /**< User data for the completion callback. */
+    uint16_t                        next_completed;    /**< Next entry in the list of completed asynchronous publishes. */
 } cy_mqtt_pubpack_t;
 
 /**
- * Structure to keep the MQTT PUBLISH packet ACK information
- * for QoS1 and QoS2 publishes.
+ * Layout of an outgoing PUBLISH packet serialized in the transmit buffer of an MQTT object.
+ */
+typedef struct cy_mqtt_serialized_publish
+{
+    size_t                          length;            /**< Number of bytes serialized in tx_buffer. */
+    const uint8_t                   *topic;            /**< Topic name sent after the serialized bytes and before the packet ID, or NULL if it is serialized. */
+    size_t                          topic_len;         /**< Length of topic. */
+    bool                            payload_buffered;  /**< True if the payload is part of the serialized bytes. */
+} cy_mqtt_serialized_publish_t;
+
+/**
+ * Structure to keep the completion information of an asynchronous publish
+ * until the completion callback is invoked.
+ */
+typedef struct publishpacket_completion
+{
+    cy_mqtt_publish_complete_cb_t   complete_cb;
+    void                            *complete_cb_data;
+    cy_mqtt_publish_token_t         token;
+    cy_mqtt_publish_status_t        status;
+} cy_mqtt_pub_completion_t;
+
+/**
+ * Waiter of the synchronous subscribe or unsubscribe requests. Each request type has its own waiter,
+ * so that a SUBACK and an UNSUBACK never wake up the caller of the other request type.
+ */
+typedef struct cy_mqtt_ack_waiter
+{
+    cy_mutex_t                      req_mutex;     /**< Mutex serializing the requests of this type. */
+    cy_semaphore_t                  semaphore;     /**< Semaphore signalled when the acknowledgment of the outstanding request is received. */
+    uint16_t                        packet_id;     /**< Packet ID of the outstanding request. */
+    bool                            ack_received;  /**< Status of the acknowledgment of the outstanding request. */
+} cy_mqtt_ack_waiter_t;
+
+/**
+ * Journal header of the publish spool. The copy with the higher sequence number is valid.
+ */
+typedef struct cy_mqtt_spool_header
+{
+    uint32_t                        magic;
+    uint32_t                        sequence;
+    uint32_t                        head;              /**< Offset of the oldest unacknowledged record in the data region. */
+    uint32_t                        used;              /**< Number of bytes of committed records from head. */
+    uint32_t                        checksum;
+} cy_mqtt_spool_header_t;
+
+/**
+ * Header of a message record in the journal of the publish spool.
+ * The record header is followed by the topic and the payload of the message.
+ */
+typedef struct cy_mqtt_spool_record
+{
+    uint32_t                        magic;
+    uint32_t                        payload_len;
+    uint16_t                        topic_len;
+    uint8_t                         qos;
+    uint8_t                         retain;
+} cy_mqtt_spool_record_t;
+
+/**
+ * Spooled message being published from the spool, kept until its completion.
+ */
+typedef struct cy_mqtt_spool_inflight
+{
+    uint32_t                        length;            /**< Length of the record in the journal. */
+    cy_mqtt_publish_token_t         token;
+    bool                            done;              /**< True if the final status of the publish is known. */
+    bool                            acked;             /**< True if the message is acknowledged by the broker. */
+    bool                            resend;            /**< True if the message is to be published again after a failure. */
+    uint8_t                         *buffer;           /**< Topic and payload of the message. */
+} cy_mqtt_spool_inflight_t;
+
+/**
+ * Publish spool of an MQTT handle.
  */
-typedef struct publishpacket_ackstatus
+typedef struct cy_mqtt_spool
 {
-    uint16_t      packetid;
-    bool          puback_status;
-} cy_mqtt_pub_ack_status_t;
+    cy_mqtt_spool_storage_t         storage;
+    cy_mutex_t                      mutex;             /**< Mutex for synchronizing the spool members and the storage access. */
+    uint32_t                        data_size;         /**< Size of the journal data region. */
+    uint32_t                        head;              /**< Offset of the oldest unacknowledged record in the data region. */
+    uint32_t                        used;              /**< Number of bytes of committed records from head. */
+    uint32_t                        sequence;          /**< Sequence number of the last written journal header. */
+    uint32_t                        read_offset;       /**< Offset from head of the next record to publish. */
+    uint8_t                         *commit_buffer;    /**< Records appended since the last group commit. */
+    uint32_t                        commit_length;     /**< Number of bytes in commit_buffer. */
+    cy_mqtt_spool_inflight_t        inflight[ MQTT_STATE_ARRAY_MAX_COUNT ]; /**< Messages being published, in journal order. */
+    uint16_t                        inflight_head;
+    uint16_t                        inflight_count;
+    uint16_t                        inflight_pending;  /**< Number of inflight messages whose final status is not known. */
+    uint16_t                        acks_since_persist;
+    bool                            rewind;            /**< True if the unacknowledged records must be published again. */
+} cy_mqtt_spool_t;
+
+/**
+ * Token buckets of the publish rate limiter of an MQTT handle. The credits are kept in thousandths of
+ * a message or byte, so that they can be refilled at millisecond granularity. A credit is negative when
+ * a request larger than the burst size was charged in full; later requests wait until the debt is repaid.
+ */
+typedef struct cy_mqtt_rate_limiter
+{
+    cy_mqtt_publish_rate_limit_t    config;
+    int64_t                         message_credit;    /**< Available message credit, in thousandths of a message. */
+    int64_t                         byte_credit;       /**< Available byte credit, in thousandths of a byte. */
+    uint32_t                        last_refill_ms;    /**< Time in milliseconds at which the credits were last refilled. */
+} cy_mqtt_rate_limiter_t;
+
+struct mqtt_object;
+
+/*
+ * Timer expiry callback. Called by the timer thread with mqtt_timer_mutex held; it must not block.
+ * Returns false if the event for the expiry could not be queued, so that the timer is fired again on the next tick.
+ */
+typedef bool ( *cy_mqtt_timer_callback_t )( struct mqtt_object *mqtt_obj );
+
+/*
+ * Timer of an MQTT object in the timing wheel.
+ */
+typedef struct cy_mqtt_timer
+{
+    struct cy_mqtt_timer            *next;             /**< Next timer in the wheel slot. */
+    struct cy_mqtt_timer            **pprev;           /**< Link pointing to this timer in the wheel slot. NULL if the timer is not armed. */
+    uint32_t                        expiry;            /**< Wheel tick at which the timer expires. */
+    cy_mqtt_timer_callback_t        callback;
+    struct mqtt_object              *mqtt_obj;
+} cy_mqtt_timer_t;
+
+/*
+ * Library-wide hierarchical timing wheel of the keepalive, ping response, and asynchronous acknowledgment timers.
+ */
+typedef struct cy_mqtt_timer_wheel
+{
+    cy_mqtt_timer_t                 *slots[ CY_MQTT_TIMER_WHEEL_LEVELS ][ CY_MQTT_TIMER_WHEEL_SLOTS ];
+    uint32_t                        current;           /**< Last processed tick. */
+    uint32_t                        tick_time_ms;      /**< Time in milliseconds at which the current tick was processed. */
+    uint32_t                        armed_count;       /**< Number of armed timers. */
+} cy_mqtt_timer_wheel_t;
 
 /*
  * MQTT handle
@@ -822,7 +1225,13 @@ typedef struct mqtt_object
     bool                            mqtt_session_established;  /**< MQTT client session establishment status. */
     bool                            broker_session_present;    /**< Broker session status. */
     bool                            mqtt_conn_status;          /**< MQTT network connect status. */
-    uint8_t                         mqtt_obj_index;            /**< MQTT object index in mqtt_handle_database. */
+    uint16_t                        mqtt_obj_index;            /**< MQTT object index in mqtt_handle_database. */
+    bool                            deleted;                   /**< Set by cy_mqtt_delete under process_mutex and ref_mutex. The events queued for the object before are dropped,
+                                                                    and no new reference can be taken. */
+    uint32_t                        ref_count;                 /**< References to the object: one for the handle until cy_mqtt_delete, one per API call in progress and one per
+                                                                    queued event. The memory is released with the last reference. Protected by ref_mutex. */
+    uint16_t                        queued_events;             /**< Number of events of the object in the queue of its event loop. Protected by ref_mutex. */
+    cy_mutex_t                      ref_mutex;                 /**< Protects the reference count, the event count and the event loop of the object. No other lock is taken under it. */
     NetworkContext_t                network_context;           /**< MQTT Network context. */
     MQTTContext_t                   mqtt_context;              /**< MQTT context. */
     cy_awsport_server_info_t        server_info;               /**< MQTT broker info. */
@@ -830,13 +1239,71 @@ typedef struct mqtt_object
     cy_mqtt_callback_t              mqtt_event_cb[ CY_MQTT_MAX_EVENT_CALLBACKS]; /**< MQTT application callback for events. */
     MQTTSubAckStatus_t              sub_ack_status[ CY_MQTT_MAX_OUTGOING_SUBSCRIBES ]; /**< MQTT SUBSCRIBE command ACK status. */
     uint8_t                         num_of_subs_in_req;        /**< Number of subscription messages in outstanding MQTT subscribe request. */
-    bool                            unsub_ack_received;        /**< Status of unsubscribe acknowledgment. */
-    cy_mqtt_pub_ack_status_t        pub_ack_status;            /**< MQTT PUBLISH packetack received status. */
-    uint16_t                        sent_packet_id;            /**< MQTT packet ID. */
-    cy_mqtt_pubpack_t               outgoing_pub_packets[ CY_MQTT_MAX_OUTGOING_PUBLISHES ]; /**< MQTT PUBLISH packet. */
+    cy_mqtt_pubpack_t               *outgoing_pub_packets;     /**< Inflight window of MQTT PUBLISH packets. */
+    uint16_t                        *pub_hash_buckets;         /**< Packet ID hash buckets indexing outgoing_pub_packets. */
+    cy_semaphore_t                  *pub_ack_sems;             /**< Semaphore of each entry of outgoing_pub_packets, signalled when the acknowledgment of the entry is received. */
+    uint16_t                        pub_window_size;           /**< Number of entries in outgoing_pub_packets. */
+    uint16_t                        pub_hash_mask;             /**< Number of hash buckets minus one. */
+    uint16_t                        pub_free_head;             /**< First free entry in outgoing_pub_packets. */
+    uint16_t                        num_outgoing_pubs;         /**< Number of entries of outgoing_pub_packets in use. */
+    uint16_t                        async_completed_head;      /**< First entry in the list of completed asynchronous publishes. */
+    uint16_t                        async_completed_tail;      /**< Last entry in the list of completed asynchronous publishes. */
+    uint8_t                         *retransmit_arena;         /**< Retransmit arena holding a copy of the topic and payload of each asynchronous publish. NULL if not enabled. */
+    uint32_t                        retransmit_slot_size;      /**< Size of the slot of each outgoing_pub_packets entry in retransmit_arena. */
     cy_mutex_t                      process_mutex;             /**< Mutex for synchronizing MQTT object members. */
-    cy_timer_t                      mqtt_timer;                /**< RTOS timer to handle the MQTT ping request */
-    cy_timer_t                      mqtt_ping_resp_timer;      /**< RTOS timer to handle the MQTT ping response timeout */
+    cy_mutex_t                      tx_mutex;                  /**< Recursive mutex serializing the writes to the socket. Taken after process_mutex, never before it. */
+    uint8_t                         tx_buffer[ CY_MQTT_TX_BUFFER_SIZE ]; /**< Buffer in which outgoing PUBLISH packets are serialized, so that they can be written while the network buffer is used for receive. Protected by tx_mutex. */
+    cy_mqtt_ack_waiter_t            sub_waiter;                /**< Waiter of the synchronous subscribe requests. */
+    cy_mqtt_ack_waiter_t            unsub_waiter;              /**< Waiter of the synchronous unsubscribe requests. */
+    cy_mqtt_timer_t                 mqtt_timer;                /**< Timer to handle the MQTT ping request */
+    cy_mqtt_timer_t                 mqtt_ping_resp_timer;      /**< Timer to handle the MQTT ping response timeout */
+    cy_mqtt_timer_t                 mqtt_async_ack_timer;      /**< Timer to handle the acknowledgment timeout of asynchronous publishes */
+    cy_mqtt_timer_t                 reconnect_timer;           /**< Timer to schedule the attempts of the automatic reconnection */
+    cy_mqtt_connect_info_t          connect_info;              /**< Connect information of the last successful cy_mqtt_connect, used by the automatic reconnection. */
+    cy_mqtt_publish_info_t          will_info;                 /**< Will message of connect_info. */
+    bool                            reconnect_enabled;         /**< True if the automatic reconnection is enabled. */
+    cy_mqtt_reconnect_config_t      reconnect_config;          /**< Automatic reconnection configuration, with the defaults applied. */
+    bool                            reconnect_active;          /**< True from the loss of the MQTT session until the automatic reconnection succeeds or gives up. */
+    uint32_t                        reconnect_attempts;        /**< Number of attempts of the automatic reconnection in progress. */
+    uint32_t                        reconnect_start_ms;        /**< Time at which the MQTT session was found lost. */
+    uint32_t                        reconnect_backoff_ms;      /**< Backoff of the next attempt of the automatic reconnection. */
+    uint32_t                        reconnect_seed;            /**< State of the pseudo-random generator of the reconnect delays, seeded per device by mqtt_reconnect_seed. */
+    bool                            reconnect_connecting;      /**< True while the reconnect thread opens the connection without holding process_mutex. */
+    cy_mutex_t                      reconnect_mutex;           /**< Mutex held by the reconnect thread while reconnect_connecting is set. */
+    bool                            reconnect_report_pending;  /**< True until the SUBACKs of the subscriptions restored by the reconnection are received. */
+    bool                            reconnect_queued;          /**< True while the object is in the list of the reconnect thread. Protected by mqtt_timer_mutex. */
+    struct mqtt_object              *reconnect_next;           /**< Next object in the list of the reconnect thread. Protected by mqtt_timer_mutex. */
+    cy_mqtt_subscription_t          *subscriptions;            /**< Topic filters subscribed while the automatic reconnection is enabled. */
+    uint16_t                        resubscribe_pending;       /**< Number of SUBSCRIBE packets sent by mqtt_resubscribe awaiting their SUBACK. */
+    uint32_t                        resubscribe_rejected;      /**< Number of restored topic filters rejected by the broker. */
+    cy_awsport_server_info_t        default_server_info;       /**< MQTT broker info passed to cy_mqtt_create; used when no broker endpoints are set. */
+    cy_mqtt_endpoint_state_t        endpoints[ CY_MQTT_MAX_BROKER_ENDPOINTS ]; /**< Broker endpoints set using cy_mqtt_set_broker_endpoints. */
+    uint8_t                         endpoint_count;            /**< Number of entries of endpoints in use. */
+    uint8_t                         endpoint_current;          /**< Index of the endpoint of the current or last connection. */
+    cy_mqtt_event_loop_object_t     *event_loop;               /**< Event loop processing the events of the MQTT object. Changed under ref_mutex, and only while queued_events is 0. */
+    bool                            async_event_queued;        /**< True if an asynchronous publish event is pending in the event loop queue. Protected by mqtt_timer_mutex. */
+    volatile bool                   rx_event_queued;           /**< True if a receive event is pending in the event loop queue. */
+    bool                            rx_data_received;          /**< True if data is read from the socket since this flag was last cleared. */
+    uint8_t                         read_ahead[ CY_MQTT_RECEIVE_READ_AHEAD_SIZE ]; /**< Data read from the socket ahead of the reads of the MQTT core library. */
+    uint16_t                        read_ahead_offset;         /**< Offset of the first unread byte in read_ahead. */
+    uint16_t                        read_ahead_len;            /**< Number of unread bytes in read_ahead. */
+    size_t                          rx_packet_remaining;       /**< Number of bytes of the packet being read by the MQTT core library that are not read yet. */
+    bool                            fragmented_receive;        /**< True if the messages larger than the network buffer are received in fragments. */
+    uint8_t                         *qos2_received;            /**< Bitmap of the packet IDs of the received QoS2 messages whose PUBREL is not received yet. NULL if this state is kept by the MQTT core library. */
+    bool                            async_deadline_expired;    /**< True if the acknowledgment deadlines of asynchronous publishes need to be checked. Protected by mqtt_timer_mutex. */
+    cy_mqtt_spool_t                 *spool;                    /**< Publish spool. NULL if the spool is not enabled. */
+    bool                            rate_limit_enabled;        /**< True if the publish rate limiter is enabled. */
+    cy_mqtt_rate_limiter_t          rate_limiter;              /**< Publish rate limiter. */
+    cy_mqtt_topic_object_t          *topics;                   /**< Topics registered using cy_mqtt_topic_register. */
+    bool                            codec_enabled;             /**< True if the payload codec is enabled. */
+    cy_mqtt_payload_codec_t         codec;                     /**< Payload codec. */
+    bool                            tls_session_hooks_enabled; /**< True if the TLS session hooks are set. */
+    cy_mqtt_tls_session_hooks_t     tls_session_hooks;         /**< TLS session hooks. */
+    uint8_t                         *tls_session;              /**< TLS session of the last successful connection, of CY_MQTT_TLS_SESSION_MAX_SIZE bytes. NULL if the TLS session hooks are not set. */
+    size_t                          tls_session_len;           /**< Length of the cached TLS session. 0 if no session is cached. */
+    bool                            tls_session_resumed;       /**< True if the TLS handshake of the last successful connection resumed the cached session. */
+    cy_mqtt_route_node_t            *routes;                   /**< Root of the trie of the topic filters subscribed with a callback. */
+    cy_mqtt_dispatch_pool_t         *dispatch;                 /**< Dispatch pool. NULL if received messages are handed to the callbacks by mqtt_event_processing_thread. */
     void                            *user_data[ CY_MQTT_MAX_EVENT_CALLBACKS ];                /**< User data which needs to be sent while calling registered app callback. */
     uint16_t                        keepAliveSeconds;          /**< MQTT keep alive timeout in seconds. */
     uint32_t                        mqtt_magic_footer;         /**< Magic footer to verify the mqtt object */
@@ -849,7 +1316,8 @@ typedef struct mqtt_object
 typedef struct mqtt_data_base
 {
     cy_mqtt_t       *mqtt_handle;
-    MQTTContext_t   *mqtt_context;
+    uint32_t        descriptor_hash;   /**< Hash of the descriptor of the MQTT object. */
+    uint16_t        next;              /**< Next entry in the hash chain of the descriptor, or in the free list if mqtt_handle is NULL. */
 } mqtt_data_base_t ;
 
 /*
@@ -869,13 +1337,27 @@ typedef struct cy_mqtt_callback_event
 /******************************************************
  *                 Global Variables
  ******************************************************/
-static mqtt_data_base_t  mqtt_handle_database[ CY_MQTT_MAX_HANDLE ];
-static uint8_t           mqtt_handle_count = 0;
+static mqtt_data_base_t  *mqtt_handle_database = NULL;
+static uint16_t          *mqtt_handle_buckets = NULL;
+static uint16_t          mqtt_handle_capacity = 0;
+static uint16_t          mqtt_handle_bucket_mask = 0;
+static uint16_t          mqtt_handle_free_head = CY_MQTT_HANDLE_INDEX_INVALID;
+static uint16_t          mqtt_handle_count = 0;
+static uint16_t          mqtt_max_handles = CY_MQTT_MAX_HANDLE;
 static cy_mutex_t        mqtt_db_mutex;
 static bool              mqtt_lib_init_status = false;
 static bool              mqtt_db_mutex_init_status = false;
-static cy_thread_t       mqtt_event_process_thread = NULL;
-static cy_queue_t        mqtt_event_queue;
+static cy_mqtt_event_loop_object_t mqtt_default_event_loop;
+static cy_mqtt_timer_wheel_t       mqtt_timer_wheel;
+static cy_mutex_t                  mqtt_timer_mutex;
+static cy_thread_t                 mqtt_timer_thread;
+static cy_semaphore_t              mqtt_timer_wake;
+static bool                        mqtt_timer_thread_exit = false;
+static cy_thread_t                 mqtt_reconnect_thread;      /* Thread making the attempts of the automatic reconnection, started by cy_mqtt_enable_auto_reconnect. */
+static cy_semaphore_t              mqtt_reconnect_wake;
+static struct mqtt_object          *mqtt_reconnect_head = NULL; /* Objects whose reconnect timer expired. Protected by mqtt_timer_mutex. */
+static struct mqtt_object          *mqtt_reconnect_tail = NULL;
+static bool                        mqtt_reconnect_thread_exit = false;
 /******************************************************
  *               Function Definitions
  ******************************************************/
@@ -889,1192 +1371,8494 @@ static bool is_mqtt_obj_valid( cy_mqtt_object_t *mqtt_obj )
     return false;
 }
 
-/* stop_timer must be protected under mqtt_obj->process_mutex */
-static cy_rslt_t stop_timer( cy_mqtt_object_t *mqtt_obj )
+/*
+ * mqtt_obj_acquire
+ *
+ * Take a reference to a valid MQTT object, so that its memory is not released while the reference is held.
+ * Returns false if the handle is not valid or the object is being deleted. The reference is dropped by mqtt_obj_release.
+ */
+static bool mqtt_obj_acquire( cy_mqtt_object_t *mqtt_obj )
 {
-    cy_rslt_t result = CY_RSLT_SUCCESS;
-    bool      state = false;
+    bool acquired = false;
 
-    if( mqtt_obj == NULL )
+    /* The handle reference keeps the memory of the object, and so its ref_mutex, until cy_mqtt_delete clears the magic values. */
+    if( is_mqtt_obj_valid( mqtt_obj ) == false )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Bad arguments to stop_timer \n" );
-        return CY_RSLT_MODULE_MQTT_BADARG;
+        return false;
     }
-    if( mqtt_obj->keepAliveSeconds != 0 )
+
+    (void)cy_rtos_get_mutex( &(mqtt_obj->ref_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( (is_mqtt_obj_valid( mqtt_obj ) == true) && (mqtt_obj->deleted == false) )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nStopping the timer\n" );
-        result = cy_rtos_is_running_timer( &mqtt_obj->mqtt_timer, &state );
-        if( result != CY_RSLT_SUCCESS )
-        {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_rtos_is_running_timer failed\n" );
-            return result;
-        }
-        if( state == true )
-        {
-            /* Timer running */
-            result = cy_rtos_stop_timer( &mqtt_obj->mqtt_timer );
-            if( result != CY_RSLT_SUCCESS )
-            {
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_rtos_stop_timer failed\n" );
-            }
-        }
+        mqtt_obj->ref_count++;
+        acquired = true;
     }
-    return result;
+    (void)cy_rtos_set_mutex( &(mqtt_obj->ref_mutex) );
+
+    return acquired;
 }
 
-/* start_timer must be protected under mqtt_obj->process_mutex */
-static cy_rslt_t start_timer( cy_mqtt_object_t *mqtt_obj )
+/*
+ * mqtt_handle_hash
+ *
+ * FNV-1a hash of the descriptor of an MQTT object.
+ */
+static uint32_t mqtt_handle_hash( const char *descriptor )
 {
-    cy_rslt_t result = CY_RSLT_SUCCESS;
-    uint8_t   retry_count = 0;
+    uint32_t hash = 2166136261U;
 
-    if( mqtt_obj == NULL )
+    while( *descriptor != '\0' )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Bad arguments to start_timer \n" );
-        return CY_RSLT_MODULE_MQTT_BADARG;
+        hash = (hash ^ (uint8_t)*descriptor) * 16777619U;
+        descriptor++;
     }
-    if( mqtt_obj->keepAliveSeconds != 0 )
+    return hash;
+}
+
+/*
+ * mqtt_handle_table_find
+ *
+ * Find the entry of the MQTT object with the given descriptor in mqtt_handle_database.
+ */
+/* mqtt_handle_table_find must be protected under mqtt_db_mutex */
+static uint16_t mqtt_handle_table_find( const char *descriptor )
+{
+    uint32_t  hash;
+    uint16_t  index;
+
+    if( mqtt_handle_buckets == NULL )
     {
-        do
+        return CY_MQTT_HANDLE_INDEX_INVALID;
+    }
+
+    hash = mqtt_handle_hash( descriptor );
+    index = mqtt_handle_buckets[ hash & mqtt_handle_bucket_mask ];
+    while( index != CY_MQTT_HANDLE_INDEX_INVALID )
+    {
+        if( (mqtt_handle_database[ index ].descriptor_hash == hash) &&
+            (strcmp( ((cy_mqtt_object_t *)mqtt_handle_database[ index ].mqtt_handle)->mqtt_descriptor, descriptor ) == 0) )
         {
-            result = cy_rtos_start_timer( &mqtt_obj->mqtt_timer, mqtt_obj->keepAliveSeconds * CY_MQTT_SEC_TO_MSEC_CONVERTOR );
-            if( result == CY_RSLT_SUCCESS )
-            {
-                return result;
-            }
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_start_timer failed with Error : [0x%X] \n", (unsigned int)result );
-            cy_rtos_delay_milliseconds(10);
-            retry_count++;
+            break;
         }
-        while( retry_count < CY_MQTT_MAX_RETRY_VALUE );
+        index = mqtt_handle_database[ index ].next;
     }
-    return result;
+    return index;
 }
 
 /*
- * start_mqtt_ping_resp_timer
+ * mqtt_handle_table_free
  *
- * Start reponse timer for mqtt ping response.
+ * Release mqtt_handle_database, once the last MQTT object is deleted.
  */
-static cy_rslt_t start_mqtt_ping_resp_timer( cy_mqtt_object_t *mqtt_obj )
+/* mqtt_handle_table_free must be protected under mqtt_db_mutex */
+static void mqtt_handle_table_free( void )
 {
-    cy_rslt_t result = CY_RSLT_SUCCESS;
+    free( mqtt_handle_database );
+    free( mqtt_handle_buckets );
+    mqtt_handle_database = NULL;
+    mqtt_handle_buckets = NULL;
+    mqtt_handle_capacity = 0;
+    mqtt_handle_bucket_mask = 0;
+    mqtt_handle_free_head = CY_MQTT_HANDLE_INDEX_INVALID;
+}
 
-    if( mqtt_obj == NULL )
+/*
+ * mqtt_handle_table_grow
+ *
+ * Double the number of entries of mqtt_handle_database, up to mqtt_max_handles. The entries keep their index,
+ * and are hashed again into a power-of-two number of descriptor hash buckets.
+ */
+/* mqtt_handle_table_grow must be protected under mqtt_db_mutex */
+static cy_rslt_t mqtt_handle_table_grow( void )
+{
+    mqtt_data_base_t  *table;
+    uint16_t          *buckets;
+    uint32_t          capacity;
+    uint32_t          num_of_buckets = 1;
+    uint32_t          bucket;
+    uint16_t          index;
+
+    capacity = ( mqtt_handle_capacity == 0 ) ? CY_MQTT_HANDLE_TABLE_INITIAL_SIZE : ( (uint32_t)mqtt_handle_capacity * 2U );
+    if( capacity > mqtt_max_handles )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Bad arguments to start_mqtt_ping_resp_timer \n" );
-        return CY_RSLT_MODULE_MQTT_BADARG;
+        capacity = mqtt_max_handles;
+    }
+    while( num_of_buckets < capacity )
+    {
+        num_of_buckets = num_of_buckets << 1;
     }
 
-    result = cy_rtos_start_timer( &mqtt_obj->mqtt_ping_resp_timer, MQTT_PINGRESP_TIMEOUT_MS );
-    if( result != CY_RSLT_SUCCESS )
+    table = (mqtt_data_base_t *)realloc( mqtt_handle_database, sizeof( mqtt_data_base_t ) * capacity );
+    if( table == NULL )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR,
-                "\nMqtt ping resp timer start failed with Error : [0x%X] \n", (unsigned int)result );
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to grow the handle table to %u entries..!\n", (unsigned int)capacity );
+        return CY_RSLT_MODULE_MQTT_NOMEM;
     }
-    return result;
+    mqtt_handle_database = table;
+
+    buckets = (uint16_t *)malloc( sizeof( uint16_t ) * num_of_buckets );
+    if( buckets == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to grow the handle table to %u entries..!\n", (unsigned int)capacity );
+        return CY_RSLT_MODULE_MQTT_NOMEM;
+    }
+    free( mqtt_handle_buckets );
+    mqtt_handle_buckets = buckets;
+    mqtt_handle_bucket_mask = (uint16_t)( num_of_buckets - 1 );
+
+    for( bucket = 0; bucket < num_of_buckets; bucket++ )
+    {
+        mqtt_handle_buckets[ bucket ] = CY_MQTT_HANDLE_INDEX_INVALID;
+    }
+    for( index = 0; index < mqtt_handle_capacity; index++ )
+    {
+        if( table[ index ].mqtt_handle != NULL )
+        {
+            bucket = table[ index ].descriptor_hash & mqtt_handle_bucket_mask;
+            table[ index ].next = mqtt_handle_buckets[ bucket ];
+            mqtt_handle_buckets[ bucket ] = index;
+        }
+    }
+
+    /* The new entries are added to the free list. */
+    index = (uint16_t)capacity;
+    while( index > mqtt_handle_capacity )
+    {
+        index--;
+        table[ index ].mqtt_handle = NULL;
+        table[ index ].next = mqtt_handle_free_head;
+        mqtt_handle_free_head = index;
+    }
+    mqtt_handle_capacity = (uint16_t)capacity;
+
+    return CY_RSLT_SUCCESS;
 }
 
 /*
- * stop_mqtt_ping_resp_timer
+ * mqtt_handle_table_insert
  *
- * Stop mqtt ping reponse timer.
+ * Add an MQTT object to mqtt_handle_database. The table is grown if all the entries are used.
  */
-static cy_rslt_t stop_mqtt_ping_resp_timer( cy_mqtt_object_t *mqtt_obj )
+/* mqtt_handle_table_insert must be protected under mqtt_db_mutex */
+static cy_rslt_t mqtt_handle_table_insert( cy_mqtt_object_t *mqtt_obj )
 {
-    cy_rslt_t result = CY_RSLT_SUCCESS;
-    bool      state = false;
+    cy_rslt_t  result = CY_RSLT_SUCCESS;
+    uint32_t   bucket;
+    uint16_t   index;
 
-    if( mqtt_obj == NULL )
+    if( mqtt_handle_count >= mqtt_max_handles )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Bad arguments to stop_mqtt_ping_resp_timer \n" );
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nNumber of created mqtt object exceeds %d..!\n", mqtt_max_handles );
+        return CY_RSLT_MODULE_MQTT_CREATE_FAIL;
+    }
+
+    if( mqtt_handle_table_find( mqtt_obj->mqtt_descriptor ) != CY_MQTT_HANDLE_INDEX_INVALID )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nDescriptor is not unique. \n" );
         return CY_RSLT_MODULE_MQTT_BADARG;
     }
-    /* stop response timer */
-    result = cy_rtos_is_running_timer( &mqtt_obj->mqtt_ping_resp_timer, &state );
-    if( result == CY_RSLT_SUCCESS && state == true )
+
+    if( mqtt_handle_free_head == CY_MQTT_HANDLE_INDEX_INVALID )
     {
-        result = cy_rtos_stop_timer( &mqtt_obj->mqtt_ping_resp_timer );
+        result = mqtt_handle_table_grow();
         if( result != CY_RSLT_SUCCESS )
         {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nPing response timer stop failed\n" );
+            return result;
         }
     }
-    return result;
+
+    index = mqtt_handle_free_head;
+    mqtt_handle_free_head = mqtt_handle_database[ index ].next;
+
+    mqtt_handle_database[ index ].mqtt_handle = (cy_mqtt_t *)mqtt_obj;
+    mqtt_handle_database[ index ].descriptor_hash = mqtt_handle_hash( mqtt_obj->mqtt_descriptor );
+    bucket = mqtt_handle_database[ index ].descriptor_hash & mqtt_handle_bucket_mask;
+    mqtt_handle_database[ index ].next = mqtt_handle_buckets[ bucket ];
+    mqtt_handle_buckets[ bucket ] = index;
+
+    mqtt_obj->mqtt_obj_index = index;
+    mqtt_handle_count++;
+
+    return CY_RSLT_SUCCESS;
 }
 
 /*
- * mqtt_pingresp_timeout_callback
+ * mqtt_handle_table_remove
  *
- * Callback if no ping response received in time.
+ * Remove an MQTT object from mqtt_handle_database. The table is released with the last MQTT object.
  */
-static void mqtt_pingresp_timeout_callback( void *arg )
+/* mqtt_handle_table_remove must be protected under mqtt_db_mutex */
+static void mqtt_handle_table_remove( cy_mqtt_object_t *mqtt_obj )
 {
-    cy_rslt_t                res = CY_RSLT_SUCCESS;
-    cy_mqtt_callback_event_t event;
-    cy_mqtt_object_t         *mqtt_obj = NULL;
+    uint16_t  index = mqtt_obj->mqtt_obj_index;
+    uint16_t  *link;
 
-    if( arg == NULL )
+    link = &(mqtt_handle_buckets[ mqtt_handle_database[ index ].descriptor_hash & mqtt_handle_bucket_mask ]);
+    while( (*link != CY_MQTT_HANDLE_INDEX_INVALID) && (*link != index) )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO,
-                "\nInvalid handle to mqtt_awsport_network_receive_callback, so nothing to do..!\n" );
-        return;
+        link = &(mqtt_handle_database[ *link ].next);
     }
-
-    mqtt_obj = ( cy_mqtt_object_t * )arg;
-
-    /* The mqtt_event_processing_thread is responsible for sending the periodic ping request. If the application sends a
-     * publish message immediately after a ping request(before getting the ping response), the ping reponse will be processed in
-     * the application thread context as the mqtt publish will wait for the pub_ack. Here, ping response will come first followed by pub_ack.
-     * However, this timer is stopped only in the event processing thread context. So the timer callback is triggered after the timeout.
-     * But as part of the processing, Core Mqtt library will set waitingForPingResp to false once ping respnonse is received.
-     * So, check if we are still waiting for a ping response before queuing the disconnect event.
-     */
-    if( mqtt_obj->mqtt_context.waitingForPingResp == false )
+    if( *link == index )
     {
-        return;
+        *link = mqtt_handle_database[ index ].next;
     }
 
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO,
-                    "\nMQTT Keepalive Timeout\n" );
-
-    /* Queue Disconnect event */
-    event.socket_event = CY_MQTT_SOCKET_EVENT_DISCONNECT;
-    event.mqtt_obj = mqtt_obj;
+    mqtt_handle_database[ index ].mqtt_handle = NULL;
+    mqtt_handle_database[ index ].next = mqtt_handle_free_head;
+    mqtt_handle_free_head = index;
+    mqtt_handle_count--;
 
-    res = cy_rtos_put_queue( &mqtt_event_queue, (void *)&event, CY_MQTT_EVENT_QUEUE_TIMEOUT_IN_MSEC, false );
-    if( res != CY_RSLT_SUCCESS )
+    if( mqtt_handle_count == 0 )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nPushing to MQTT event to mqtt_event_queue failed with Error : [0x%X] \n",
-                        (unsigned int)res );
+        mqtt_handle_table_free();
     }
-    return;
 }
 
-static void mqtt_ping_request_callback( cy_mqtt_object_t *mqtt_obj )
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_timer_wheel_link
+ *
+ * Insert an armed timer in the wheel level that covers its remaining ticks. The slot is selected by the
+ * bits of the expiry tick for that level, so that the timer is moved down when the lower level wraps to it.
+ */
+/* mqtt_timer_wheel_link must be protected under mqtt_timer_mutex */
+static void mqtt_timer_wheel_link( cy_mqtt_timer_t *timer )
 {
-    cy_rslt_t                  result = CY_RSLT_SUCCESS;
-    cy_mqtt_callback_event_t   event;
+    uint32_t          delta = timer->expiry - mqtt_timer_wheel.current;
+    uint32_t          expiry = timer->expiry;
+    uint32_t          level = 0;
+    cy_mqtt_timer_t   **head;
 
-    if( mqtt_obj == NULL )
+    if( delta >= CY_MQTT_TIMER_WHEEL_RANGE )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Bad arguments to mqtt_ping_request_callback \n" );
-        return;
+        /* Parked in the last slot of the top level; it is linked again with its real expiry when it is moved down. */
+        delta = CY_MQTT_TIMER_WHEEL_RANGE - 1UL;
+        expiry = mqtt_timer_wheel.current + delta;
     }
-
-    event.socket_event = CY_MQTT_SOCKET_EVENT_PING_REQ;
-    event.mqtt_obj = mqtt_obj;
-
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nPushing mqtt_ping_request event to the mqtt_event_queue. \n" );
-
-    result = cy_rtos_put_queue( &mqtt_event_queue, (void *)&event, CY_MQTT_EVENT_QUEUE_TIMEOUT_IN_MSEC, false );
-    if( result != CY_RSLT_SUCCESS )
+    while( (level < (CY_MQTT_TIMER_WHEEL_LEVELS - 1U)) && (delta >= (1UL << (CY_MQTT_TIMER_WHEEL_SLOT_BITS * (level + 1U)))) )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nPushing mqtt_ping_request event to the mqtt_event_queue failed with Error : [0x%X] \n", (unsigned int)result );
+        level++;
     }
-    return;
-}
-
-/*----------------------------------------------------------------------------------------------------------*/
 
-static cy_rslt_t mqtt_cleanup_outgoing_publish( cy_mqtt_object_t *mqtt_obj, uint8_t index )
-{
-    if( index >= CY_MQTT_MAX_OUTGOING_PUBLISHES )
+    head = &(mqtt_timer_wheel.slots[ level ][ (expiry >> (CY_MQTT_TIMER_WHEEL_SLOT_BITS * level)) & CY_MQTT_TIMER_WHEEL_SLOT_MASK ]);
+    timer->next = *head;
+    if( timer->next != NULL )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Bad arguments to mqtt_cleanup_outgoing_publish.\n" );
-        return CY_RSLT_MODULE_MQTT_BADARG;
+        timer->next->pprev = &(timer->next);
     }
-    /* Clear the outgoing PUBLISH packet. */
-    ( void ) memset( &( mqtt_obj->outgoing_pub_packets[ index ] ), 0x00, sizeof( mqtt_obj->outgoing_pub_packets[ index ] ) );
-    return CY_RSLT_SUCCESS;
+    timer->pprev = head;
+    *head = timer;
 }
 
-/*----------------------------------------------------------------------------------------------------------*/
+/*
+ * mqtt_timer_wheel_take_slot
+ *
+ * Detach all the timers of a wheel slot, and return them as a list linked by the next member.
+ */
+/* mqtt_timer_wheel_take_slot must be protected under mqtt_timer_mutex */
+static cy_mqtt_timer_t *mqtt_timer_wheel_take_slot( uint32_t level, uint32_t slot )
+{
+    cy_mqtt_timer_t *list = mqtt_timer_wheel.slots[ level ][ slot ];
 
-static cy_rslt_t mqtt_cleanup_outgoing_publish_with_packet_id( cy_mqtt_object_t *mqtt_obj, uint16_t packetid )
+    mqtt_timer_wheel.slots[ level ][ slot ] = NULL;
+    return list;
+}
+
+/*
+ * mqtt_timer_wheel_advance
+ *
+ * Process the next tick of the timing wheel: move the timers of the upper levels down when a level wraps around,
+ * and fire the timers of the tick. All the timers due in the same tick are fired in one wakeup.
+ */
+/* mqtt_timer_wheel_advance must be protected under mqtt_timer_mutex */
+static void mqtt_timer_wheel_advance( void )
 {
-    cy_rslt_t  result = CY_RSLT_SUCCESS;
-    uint8_t    index;
+    cy_mqtt_timer_t  *list;
+    cy_mqtt_timer_t  *timer;
+    uint32_t         level;
+    uint32_t         slot;
 
-    if( (mqtt_obj == NULL) || (packetid == MQTT_PACKET_ID_INVALID) )
+    mqtt_timer_wheel.current++;
+
+    /* Cascade from the highest level that wraps on this tick, so that its timers can be moved down to the lowest level. */
+    level = 0;
+    while( (level < (CY_MQTT_TIMER_WHEEL_LEVELS - 1U)) &&
+           (((mqtt_timer_wheel.current >> (CY_MQTT_TIMER_WHEEL_SLOT_BITS * (level + 1U))) << (CY_MQTT_TIMER_WHEEL_SLOT_BITS * (level + 1U))) == mqtt_timer_wheel.current) )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Bad arguments to mqtt_cleanup_outgoing_publish_with_packet_id.\n" );
-        return CY_RSLT_MODULE_MQTT_BADARG;
+        level++;
+    }
+    while( level > 0 )
+    {
+        slot = (mqtt_timer_wheel.current >> (CY_MQTT_TIMER_WHEEL_SLOT_BITS * level)) & CY_MQTT_TIMER_WHEEL_SLOT_MASK;
+        list = mqtt_timer_wheel_take_slot( level, slot );
+        while( list != NULL )
+        {
+            timer = list;
+            list = timer->next;
+            mqtt_timer_wheel_link( timer );
+        }
+        level--;
     }
 
-    /* Clean up all saved outgoing PUBLISH packets. */
-    for( index = 0; index < CY_MQTT_MAX_OUTGOING_PUBLISHES; index++ )
+    list = mqtt_timer_wheel_take_slot( 0, mqtt_timer_wheel.current & CY_MQTT_TIMER_WHEEL_SLOT_MASK );
+    while( list != NULL )
     {
-        if( mqtt_obj->outgoing_pub_packets[ index ].packetid == packetid )
+        timer = list;
+        list = timer->next;
+        if( (int32_t)(timer->expiry - mqtt_timer_wheel.current) > 0 )
         {
-            result = mqtt_cleanup_outgoing_publish( mqtt_obj, index );
-            if( result != CY_RSLT_SUCCESS )
-            {
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_cleanup_outgoing_publish failed with Error : [0x%X] \n", (unsigned int)result );
-                break;
-            }
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nCleaned up outgoing PUBLISH packet with packet id %u.\n", packetid );
-            break;
+            mqtt_timer_wheel_link( timer );
+            continue;
+        }
+
+        timer->next = NULL;
+        timer->pprev = NULL;
+        mqtt_timer_wheel.armed_count--;
+        if( timer->callback( timer->mqtt_obj ) == false )
+        {
+            timer->expiry = mqtt_timer_wheel.current + 1U;
+            mqtt_timer_wheel_link( timer );
+            mqtt_timer_wheel.armed_count++;
         }
     }
-    return result;
 }
 
-/*----------------------------------------------------------------------------------------------------------*/
-
-static cy_rslt_t mqtt_update_suback_status( cy_mqtt_object_t *mqtt_obj, MQTTPacketInfo_t *packet_info )
+/*
+ * mqtt_timer_wheel_run
+ *
+ * Process the ticks of the timing wheel elapsed since the last call. Called by the timer thread before waiting
+ * for the next tick; returns the time in milliseconds to wait until the next tick.
+ */
+static uint32_t mqtt_timer_wheel_run( void )
 {
-    uint8_t        *payload = NULL, i = 0;
-    size_t         num_of_subscriptions = 0;
-    MQTTStatus_t   mqttStatus = MQTTSuccess;
+    uint32_t now;
+    uint32_t wait_ms = CY_RTOS_NEVER_TIMEOUT;
 
-    mqttStatus = MQTT_GetSubAckStatusCodes( packet_info, &payload, &num_of_subscriptions );
-    if( (mqttStatus != MQTTSuccess) || (num_of_subscriptions != mqtt_obj->num_of_subs_in_req) )
+    (void)cy_rtos_get_mutex( &mqtt_timer_mutex, CY_RTOS_NEVER_TIMEOUT );
+    now = Clock_GetTimeMs();
+    while( (mqtt_timer_wheel.armed_count > 0) && ((now - mqtt_timer_wheel.tick_time_ms) >= CY_MQTT_TIMER_WHEEL_TICK_MS) )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n MQTT_GetSubAckStatusCodes failed with status = %s.\n", MQTT_Status_strerror( mqttStatus ) );
-        /* SubAckStatusCodes are not available for outstanding subscription messages waiting for acknowledgment. So Setting num_of_subs_in_req to 0.*/
-        mqtt_obj->num_of_subs_in_req = 0;
-        return CY_RSLT_MODULE_MQTT_ERROR;
+        mqtt_timer_wheel.tick_time_ms += CY_MQTT_TIMER_WHEEL_TICK_MS;
+        mqtt_timer_wheel_advance();
     }
-    ( void ) mqttStatus;
-
-    for( i = 0; i < mqtt_obj->num_of_subs_in_req; i++ )
+    if( mqtt_timer_wheel.armed_count > 0 )
     {
-        mqtt_obj->sub_ack_status[i] = (MQTTSubAckStatus_t)payload[ i ];
+        wait_ms = CY_MQTT_TIMER_WHEEL_TICK_MS - (now - mqtt_timer_wheel.tick_time_ms);
     }
-    /* All outstanding subscription message acknowledgment status is updated. So Setting num_of_subs_in_req to 0. */
-    mqtt_obj->num_of_subs_in_req = 0;
-    return CY_RSLT_SUCCESS;
-}
+    (void)cy_rtos_set_mutex( &mqtt_timer_mutex );
 
-/*----------------------------------------------------------------------------------------------------------*/
+    return wait_ms;
+}
 
-static cy_rslt_t mqtt_get_next_free_index_for_publish( cy_mqtt_object_t *mqtt_obj, uint8_t *pindex )
+/*
+ * mqtt_timer_init
+ *
+ * Initialize the timer of an MQTT object. The timer is not armed.
+ */
+static void mqtt_timer_init( cy_mqtt_timer_t *timer, cy_mqtt_timer_callback_t callback, cy_mqtt_object_t *mqtt_obj )
 {
-    cy_rslt_t result = CY_RSLT_SUCCESS;
-    uint8_t   index  = 0;
+    timer->next = NULL;
+    timer->pprev = NULL;
+    timer->expiry = 0;
+    timer->callback = callback;
+    timer->mqtt_obj = mqtt_obj;
+}
 
-    if( (mqtt_obj == NULL) || (pindex == NULL) )
+/*
+ * mqtt_timer_cancel_locked
+ *
+ * Remove a timer from the timing wheel, if it is armed.
+ */
+/* mqtt_timer_cancel_locked must be protected under mqtt_timer_mutex */
+static void mqtt_timer_cancel_locked( cy_mqtt_timer_t *timer )
+{
+    if( timer->pprev == NULL )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to mqtt_get_next_free_index_for_publish.\n" );
-        return CY_RSLT_MODULE_MQTT_BADARG;
+        return;
     }
 
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_get_next_free_index_for_publish - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
-    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
-    if( result != CY_RSLT_SUCCESS )
+    *(timer->pprev) = timer->next;
+    if( timer->next != NULL )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
-        return result;
+        timer->next->pprev = timer->pprev;
     }
+    timer->next = NULL;
+    timer->pprev = NULL;
+    mqtt_timer_wheel.armed_count--;
+}
 
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_get_next_free_index_for_publish - Acquired Mutex %p \n", mqtt_obj->process_mutex );
+/*
+ * mqtt_timer_arm_locked
+ *
+ * Arm a timer to expire after timeout_ms, rearming it if it is already armed. The wheel must not be empty, i.e. the
+ * caller is either a timer callback or mqtt_timer_arm.
+ */
+/* mqtt_timer_arm_locked must be protected under mqtt_timer_mutex */
+static void mqtt_timer_arm_locked( cy_mqtt_timer_t *timer, uint32_t timeout_ms )
+{
+    uint32_t now = Clock_GetTimeMs();
 
-    for( index = 0; index < CY_MQTT_MAX_OUTGOING_PUBLISHES; index++ )
+    mqtt_timer_cancel_locked( timer );
+
+    /* The remaining part of the current tick is included, so that the timer does not expire early. */
+    timer->expiry = mqtt_timer_wheel.current +
+                    ((timeout_ms + (now - mqtt_timer_wheel.tick_time_ms) + CY_MQTT_TIMER_WHEEL_TICK_MS - 1U) / CY_MQTT_TIMER_WHEEL_TICK_MS);
+    if( timer->expiry == mqtt_timer_wheel.current )
     {
-        /* A free index is marked by the invalid packet ID.
-         * Check if the the index has a free slot. */
-        if( mqtt_obj->outgoing_pub_packets[ index ].packetid == MQTT_PACKET_ID_INVALID )
-        {
-            result = CY_RSLT_SUCCESS;
-            mqtt_obj->outgoing_pub_packets[ index ].packetid = MQTT_GetPacketId( &(mqtt_obj->mqtt_context) );
-            *pindex = index;
-            break;
-        }
+        timer->expiry++;
     }
+    mqtt_timer_wheel_link( timer );
+    mqtt_timer_wheel.armed_count++;
+}
 
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_get_next_free_index_for_publish - Releasing Mutex %p \n", mqtt_obj->process_mutex );
-    result = cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
-    if( result != CY_RSLT_SUCCESS )
-    {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", (unsigned int)result );
+/*
+ * mqtt_timer_arm
+ *
+ * Arm a timer to expire after timeout_ms, rearming it if it is already armed.
+ */
+static void mqtt_timer_arm( cy_mqtt_timer_t *timer, uint32_t timeout_ms )
+{
+    bool wake = false;
 
-        return result;
+    (void)cy_rtos_get_mutex( &mqtt_timer_mutex, CY_RTOS_NEVER_TIMEOUT );
+    mqtt_timer_cancel_locked( timer );
+    if( mqtt_timer_wheel.armed_count == 0 )
+    {
+        /* The wheel is not advanced while it is empty; restart the current tick now. */
+        mqtt_timer_wheel.tick_time_ms = Clock_GetTimeMs();
+        wake = true;
     }
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_get_next_free_index_for_publish - Released Mutex %p \n", mqtt_obj->process_mutex );
+    mqtt_timer_arm_locked( timer, timeout_ms );
+    (void)cy_rtos_set_mutex( &mqtt_timer_mutex );
 
-    if( index >= CY_MQTT_MAX_OUTGOING_PUBLISHES )
+    if( wake == true )
     {
-        result = CY_RSLT_MODULE_MQTT_ERROR;
+        /* The timer thread waits without timeout while the wheel is empty. */
+        (void)cy_rtos_set_semaphore( &mqtt_timer_wake, false );
     }
-
-    return result;
 }
 
-/*----------------------------------------------------------------------------------------------------------*/
-
-static cy_rslt_t mqtt_cleanup_outgoing_publishes( cy_mqtt_object_t *mqtt_obj )
+/*
+ * mqtt_timer_cancel
+ *
+ * Disarm a timer. Once this function returns, the callback of the timer is not called.
+ */
+static void mqtt_timer_cancel( cy_mqtt_timer_t *timer )
 {
-    if( mqtt_obj == NULL )
-    {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to mqtt_cleanup_outgoing_publishes.\n" );
-        return CY_RSLT_MODULE_MQTT_BADARG;
-    }
-
-    /* Clean up all outgoing PUBLISH packets. */
-    ( void ) memset( mqtt_obj->outgoing_pub_packets, 0x00, sizeof( mqtt_obj->outgoing_pub_packets ) );
-    return CY_RSLT_SUCCESS;
+    (void)cy_rtos_get_mutex( &mqtt_timer_mutex, CY_RTOS_NEVER_TIMEOUT );
+    mqtt_timer_cancel_locked( timer );
+    (void)cy_rtos_set_mutex( &mqtt_timer_mutex );
 }
 
-/*----------------------------------------------------------------------------------------------------------*/
-
-static cy_rslt_t mqtt_handle_publish_resend( cy_mqtt_object_t *mqtt_obj )
+/*
+ * mqtt_timer_is_armed
+ *
+ * Check whether a timer is armed.
+ */
+static bool mqtt_timer_is_armed( cy_mqtt_timer_t *timer )
 {
-    cy_rslt_t         result = CY_RSLT_SUCCESS;
-    MQTTStatus_t      mqttStatus = MQTTSuccess;
-    uint8_t           index = 0U;
-    MQTTStateCursor_t cursor = MQTT_STATE_CURSOR_INITIALIZER;
-    uint16_t          packetid_to_resend = MQTT_PACKET_ID_INVALID;
-    bool              found_packetid = false;
-
-    /* MQTT_PublishToResend() provides a packet ID of the next PUBLISH packet
-     * that should be resent. In accordance with the MQTT v3.1.1 spec,
-     * MQTT_PublishToResend() preserves the ordering of when the original
-     * PUBLISH packets were sent. The outgoing_pub_packets array is searched
-     * through for the associated packet ID. */
-    packetid_to_resend = MQTT_PublishToResend( &(mqtt_obj->mqtt_context), &cursor );
-    while( packetid_to_resend != MQTT_PACKET_ID_INVALID )
-    {
-        found_packetid = false;
+    bool armed;
 
-        for( index = 0U; index < CY_MQTT_MAX_OUTGOING_PUBLISHES; index++ )
-        {
-            if( mqtt_obj->outgoing_pub_packets[ index ].packetid == packetid_to_resend )
-            {
-                found_packetid = true;
-                if( mqtt_obj->outgoing_pub_packets[ index ].pubinfo.qos != MQTTQoS0 )
-                {
-                    mqtt_obj->outgoing_pub_packets[ index ].pubinfo.dup = true;
+    (void)cy_rtos_get_mutex( &mqtt_timer_mutex, CY_RTOS_NEVER_TIMEOUT );
+    armed = ( timer->pprev != NULL );
+    (void)cy_rtos_set_mutex( &mqtt_timer_mutex );
 
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nSending duplicate PUBLISH with packet id %u.\n",
-                                     mqtt_obj->outgoing_pub_packets[ index ].packetid );
-                    mqttStatus = MQTT_Publish( &(mqtt_obj->mqtt_context), &(mqtt_obj->outgoing_pub_packets[ index ].pubinfo),
-                                               mqtt_obj->outgoing_pub_packets[ index ].packetid );
-                    if( mqttStatus != MQTTSuccess )
-                    {
-                        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nSending duplicate PUBLISH for packet id %u failed with status %s.\n",
-                                         mqtt_obj->outgoing_pub_packets[ index ].packetid, MQTT_Status_strerror( mqttStatus ) );
-                        result = CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
-                        break;
-                    }
-                    else
-                    {
-                        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nSent duplicate PUBLISH successfully for packet id %u.\n\n",
-                                         mqtt_obj->outgoing_pub_packets[ index ].packetid );
-                    }
-                }
-                else
-                {
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nResending PUBLISH packet id %u. is not required as its having QoS0\n\n",
-                                     mqtt_obj->outgoing_pub_packets[ index ].packetid );
-                }
+    return armed;
+}
 
-            }
-        }
+/*
+ * mqtt_timer_thread_func
+ *
+ * Drive the timing wheel of all the MQTT objects. The thread sleeps until the next tick while timers are armed,
+ * and until mqtt_timer_arm signals mqtt_timer_wake while the wheel is empty, so it does not wake up when idle.
+ */
+static void mqtt_timer_thread_func( cy_thread_arg_t arg )
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t  wait_ms;
 
-        if( found_packetid == false )
-        {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nPacket id %u requires resend, but was not found in outgoing_pub_packets.\n",
-                             packetid_to_resend );
-            result = CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
-            break;
-        }
-        else
-        {
-            /* Get the next packetID to be resent. */
-            packetid_to_resend = MQTT_PublishToResend( &(mqtt_obj->mqtt_context), &cursor );
-        }
+    (void)arg;
+    while( mqtt_timer_thread_exit == false )
+    {
+        wait_ms = mqtt_timer_wheel_run();
+        (void)cy_rtos_get_semaphore( &mqtt_timer_wake, wait_ms, false );
     }
 
-    return result;
+    result = cy_rtos_exit_thread();
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_exit_thread failed with Error :[0x%X]\n", (unsigned int)result );
+    }
 }
 
-/*----------------------------------------------------------------------------------------------------------*/
-
-static void mqtt_awsport_network_disconnect_callback( void *arg )
+/*
+ * mqtt_timer_thread_start
+ *
+ * Start the timer thread driving the timing wheel.
+ */
+static cy_rslt_t mqtt_timer_thread_start( void )
 {
-    cy_rslt_t                result = CY_RSLT_SUCCESS;
-    cy_mqtt_callback_event_t event;
-    cy_mqtt_object_t         *mqtt_obj = NULL;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
 
-    if( arg == NULL )
+    result = cy_rtos_init_semaphore( &mqtt_timer_wake, 1, 0 );
+    if( result != CY_RSLT_SUCCESS )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid argument for mqtt_awsport_network_disconnect_callback, so nothing to do..!\n" );
-        return;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_init_semaphore failed with Error : [0x%X] \n", (unsigned int)result );
+        return result;
     }
 
-    mqtt_obj = ( cy_mqtt_object_t * )arg;
-
-    event.socket_event = CY_MQTT_SOCKET_EVENT_DISCONNECT;
-    event.mqtt_obj = mqtt_obj;
-
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\n Network disconnection notification from socket layer.\n" );
-
-    result = cy_rtos_put_queue( &mqtt_event_queue, (void *)&event, CY_MQTT_EVENT_QUEUE_TIMEOUT_IN_MSEC, false );
+    mqtt_timer_thread_exit = false;
+    result = cy_rtos_create_thread( &mqtt_timer_thread, mqtt_timer_thread_func, "MQTTTimerThread", NULL,
+                                    CY_MQTT_TIMER_THREAD_STACK_SIZE, CY_MQTT_TIMER_THREAD_PRIORITY, NULL );
     if( result != CY_RSLT_SUCCESS )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nPushing disconnect event to the mqtt_event_queue failed with Error : [0x%X] \n", (unsigned int)result );
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_create_thread failed with Error : [0x%X] \n", (unsigned int)result );
+        (void)cy_rtos_deinit_semaphore( &mqtt_timer_wake );
+        mqtt_timer_thread = NULL;
+        return result;
     }
+    return CY_RSLT_SUCCESS;
+}
 
-    return;
+/*
+ * mqtt_timer_thread_stop
+ *
+ * Terminate the timer thread.
+ */
+static void mqtt_timer_thread_stop( void )
+{
+    mqtt_timer_thread_exit = true;
+    (void)cy_rtos_set_semaphore( &mqtt_timer_wake, false );
+    (void)cy_rtos_join_thread( &mqtt_timer_thread );
+    mqtt_timer_thread = NULL;
+    (void)cy_rtos_deinit_semaphore( &mqtt_timer_wake );
 }
 
 /*----------------------------------------------------------------------------------------------------------*/
 
-static void call_registered_event_callbacks(cy_mqtt_t handle, cy_mqtt_event_t event)
+/*
+ * mqtt_keepalive_remaining_ms
+ *
+ * Time in milliseconds until the keepalive interval elapses without any packet sent to the broker. The interval is
+ * measured from the last packet sent, as tracked by the core MQTT library in lastPacketTime, so that every outgoing
+ * packet defers the ping request. Returns 0 when the connection has been idle for the whole interval.
+ */
+static uint32_t mqtt_keepalive_remaining_ms( cy_mqtt_object_t *mqtt_obj )
 {
-    int i = 0;
-    cy_mqtt_object_t *mqtt_obj = ( cy_mqtt_object_t * )handle;
-    cy_mqtt_callback_t event_cb;
+    uint32_t interval_ms = (uint32_t)mqtt_obj->keepAliveSeconds * CY_MQTT_SEC_TO_MSEC_CONVERTOR;
+    uint32_t idle_ms;
 
-    for ( i = 0; i < CY_MQTT_MAX_EVENT_CALLBACKS; i++ )
+    /* lastPacketTime is a single 32-bit word updated by the sending thread; it may be read without the process mutex,
+     * as a stale value only makes the deadline earlier, and the deadline is checked again before the ping is sent. */
+    idle_ms = Clock_GetTimeMs() - mqtt_obj->mqtt_context.lastPacketTime;
+    if( idle_ms >= interval_ms )
     {
-        if( mqtt_obj->mqtt_event_cb[i] != NULL )
-        {
-            event_cb = mqtt_obj->mqtt_event_cb[i];
-            event_cb( handle, event, mqtt_obj->user_data[i] );
-        }
+        return 0;
     }
+    return ( interval_ms - idle_ms );
 }
 
-static void mqtt_event_callback( MQTTContext_t *param_mqtt_context,
-                                 MQTTPacketInfo_t *param_packet_info,
-                                 MQTTDeserializedInfo_t *param_deserialized_info )
+/* stop_timer must be protected under mqtt_obj->process_mutex */
+static cy_rslt_t stop_timer( cy_mqtt_object_t *mqtt_obj )
 {
-    cy_rslt_t         result = CY_RSLT_SUCCESS;
-    uint16_t          packet_id;
-    cy_mqtt_object_t  *mqtt_obj = NULL;
-    cy_mqtt_t         handle = NULL;
-    uint8_t           index = 0;
-    cy_mqtt_event_t   event;
-
-    if( (param_mqtt_context == NULL) || (param_packet_info == NULL) || (param_deserialized_info == NULL) )
+    if( mqtt_obj == NULL )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Bad arguments to mqtt_event_callback.\n" );
-        return;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Bad arguments to stop_timer \n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
     }
-
-    memset( &event, 0x00, sizeof(cy_mqtt_event_t) );
-
-    for( index = 0;index < CY_MQTT_MAX_HANDLE;index++ )
+    if( mqtt_obj->keepAliveSeconds != 0 )
     {
-        if( mqtt_handle_database[index].mqtt_context ==  param_mqtt_context )
-        {
-            handle = mqtt_handle_database[index].mqtt_handle;
-            break;
-        }
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nStopping the timer\n" );
+        mqtt_timer_cancel( &mqtt_obj->mqtt_timer );
     }
+    return CY_RSLT_SUCCESS;
+}
 
-    if( handle == NULL )
+/* start_timer must be protected under mqtt_obj->process_mutex */
+static cy_rslt_t start_timer( cy_mqtt_object_t *mqtt_obj )
+{
+    if( mqtt_obj == NULL )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Invalid MQTT Context..\n" );
-        return;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Bad arguments to start_timer \n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
     }
-
-    mqtt_obj = ( cy_mqtt_object_t * )handle;
-    packet_id = param_deserialized_info->packetIdentifier;
-
-    /* Handle incoming PUBLISH packets. The lower 4 bits of the PUBLISH packet
-     * type is used for the dup, QoS, and retain flags. Therefore, masking
-     * out the lower bits to check whether the packet is a PUBLISH packet. */
-    if( ( param_packet_info->type & 0xF0U ) == MQTT_PACKET_TYPE_PUBLISH )
+    if( mqtt_obj->keepAliveSeconds != 0 )
     {
-        if( param_deserialized_info->pPublishInfo != NULL )
-        {
-            /* Handle incoming PUBLISH packets. */
-            event.type = CY_MQTT_EVENT_TYPE_PUBLISH_RECEIVE;
-            event.data.pub_msg.packet_id = packet_id;
-            event.data.pub_msg.received_message.dup =  param_deserialized_info->pPublishInfo->dup;
-            event.data.pub_msg.received_message.payload = (const char *) (param_deserialized_info->pPublishInfo->pPayload);
-            event.data.pub_msg.received_message.payload_len = param_deserialized_info->pPublishInfo->payloadLength;
-
-            if( param_deserialized_info->pPublishInfo->qos == MQTTQoS0 )
-            {
-                event.data.pub_msg.received_message.qos = CY_MQTT_QOS0;
-            }
-            else if( param_deserialized_info->pPublishInfo->qos == MQTTQoS1 )
-            {
-                event.data.pub_msg.received_message.qos = CY_MQTT_QOS1;
-            }
-            else
-            {
-                event.data.pub_msg.received_message.qos = CY_MQTT_QOS2;
-            }
-            event.data.pub_msg.received_message.retain = param_deserialized_info->pPublishInfo->retain;
-            event.data.pub_msg.received_message.topic = param_deserialized_info->pPublishInfo->pTopicName;
-            event.data.pub_msg.received_message.topic_len = param_deserialized_info->pPublishInfo->topicNameLength;
-
-            call_registered_event_callbacks(handle, event);
-        }
-        else
-        {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Invalid pPublishInfo..\n" );
-            return;
-        }
+        mqtt_timer_arm( &mqtt_obj->mqtt_timer, mqtt_keepalive_remaining_ms( mqtt_obj ) );
     }
-    else
-    {
-        /* Handle other packets. */
-        switch( param_packet_info->type )
-        {
-            case MQTT_PACKET_TYPE_SUBACK:
-
-                /* Make sure that the ACK packet identifier matches with the Request packet identifier. */
-                if( mqtt_obj->sent_packet_id != packet_id )
-                {
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nSUBACK packet identifier does not matches with Request packet identifier.\n" );
-                }
-                else
-                {
-                    /* A SUBACK from the broker, containing the server response to our subscription request, has been received.
-                     * It contains the status code indicating server approval/rejection for the subscription to the single topic
-                     * requested. The SUBACK will be parsed to obtain the status code; this status code will be stored in the MQTT object
-                     * member 'sub_ack_status'. */
-                    result = mqtt_update_suback_status( mqtt_obj, param_packet_info );
-                    if( result != CY_RSLT_SUCCESS )
-                    {
-                        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n mqtt_update_suback_status failed..!\n" );
-                    }
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nSUBACK packet identifier matches with Request packet identifier.\n" );
-                }
-                break;
-
-            case MQTT_PACKET_TYPE_UNSUBACK:
-                /* Make sure that the UNSUBACK packet identifier matches with the Request packet identifier. */
-                if( mqtt_obj->sent_packet_id != packet_id )
-                {
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nUNSUBACK packet identifier does not matches with Request packet identifier.\n" );
-                    mqtt_obj->unsub_ack_received = false;
-                }
-                else
-                {
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nUNSUBACK packet identifier matches with Request packet identifier.\n" );
-                    mqtt_obj->unsub_ack_received = true;
-                }
-                break;
-
-            case MQTT_PACKET_TYPE_PINGRESP:
-                if( param_deserialized_info->deserializationResult != MQTTSuccess )
-                {
-                    memset( &event, 0x00, sizeof(cy_mqtt_event_t) );
-                    event.type = CY_MQTT_EVENT_TYPE_DISCONNECT;
-                    event.data.reason = CY_MQTT_DISCONN_TYPE_BROKER_DOWN;
-
-                    call_registered_event_callbacks(handle, event);
-
-                    mqtt_obj->mqtt_session_established = false;
-                }
-                else
-                {
-                    /* stop response timer */
-                    stop_mqtt_ping_resp_timer(mqtt_obj);
-                }
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nPing response received.\n" );
-                break;
-
-            case MQTT_PACKET_TYPE_PUBREC:
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nPUBREC received for packet id %u.\n\n", packet_id );
-                if( param_deserialized_info->deserializationResult != MQTTSuccess )
-                {
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nPUBREC received with status %s.\n", MQTT_Status_strerror( param_deserialized_info->deserializationResult ) );
-                }
-                else
-                {
-                    if( packet_id == mqtt_obj->pub_ack_status.packetid )
-                    {
-                        mqtt_obj->pub_ack_status.puback_status = true;
-                    }
-                    else
-                    {
-                        mqtt_obj->pub_ack_status.puback_status = false;
-                    }
-                }
-                /* Clean up the PUBLISH packet when a PUBREC is received. */
-                (void)mqtt_cleanup_outgoing_publish_with_packet_id( mqtt_obj, packet_id );
-                break;
-
-            case MQTT_PACKET_TYPE_PUBREL:
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nPUBREL received for packet id %u.\n", packet_id );
-                break;
-
-            case MQTT_PACKET_TYPE_PUBCOMP:
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nPUBCOMP received for packet id %u.\n\n", packet_id );
-                break;
+    return CY_RSLT_SUCCESS;
+}
 
-            case MQTT_PACKET_TYPE_PUBACK:
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nPUBACK received for packet id %u.\n\n", packet_id );
-                if( param_deserialized_info->deserializationResult != MQTTSuccess )
-                {
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nPUBACK received with status %s.\n", MQTT_Status_strerror( param_deserialized_info->deserializationResult ) );
-                }
-                else
-                {
-                    if( packet_id == mqtt_obj->pub_ack_status.packetid )
-                    {
-                        mqtt_obj->pub_ack_status.puback_status = true;
-                    }
-                    else
-                    {
-                        mqtt_obj->pub_ack_status.puback_status = false;
-                    }
-                }
-                /* Clean up the PUBLISH packet when a PUBACK is received. */
-                (void)mqtt_cleanup_outgoing_publish_with_packet_id( mqtt_obj, packet_id );
-                break;
+/*
+ * start_mqtt_ping_resp_timer
+ *
+ * Start reponse timer for mqtt ping response.
+ */
+static cy_rslt_t start_mqtt_ping_resp_timer( cy_mqtt_object_t *mqtt_obj )
+{
+    if( mqtt_obj == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Bad arguments to start_mqtt_ping_resp_timer \n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
 
-            case MQTT_PACKET_TYPE_DISCONNECT:
-                /* Because this is user-initiated disconnection, no need to notify the application.*/
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nDisconnect packet received:(%02x).\n\n", param_packet_info->type );
-                break;
+    mqtt_timer_arm( &mqtt_obj->mqtt_ping_resp_timer, MQTT_PINGRESP_TIMEOUT_MS );
+    return CY_RSLT_SUCCESS;
+}
 
-            /* Any other packet type is invalid. */
-            default:
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nUnknown packet type received:(%02x).\n\n", param_packet_info->type );
-        }
+/*
+ * stop_mqtt_ping_resp_timer
+ *
+ * Stop mqtt ping reponse timer.
+ */
+static cy_rslt_t stop_mqtt_ping_resp_timer( cy_mqtt_object_t *mqtt_obj )
+{
+    if( mqtt_obj == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Bad arguments to stop_mqtt_ping_resp_timer \n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
     }
+    /* stop response timer */
+    mqtt_timer_cancel( &mqtt_obj->mqtt_ping_resp_timer );
+    return CY_RSLT_SUCCESS;
 }
 
-/*----------------------------------------------------------------------------------------------------------*/
-
-static cy_rslt_t mqtt_establish_session( cy_mqtt_object_t *mqtt_obj,
-                                         MQTTConnectInfo_t *connect_info,
-                                         MQTTPublishInfo_t *will_msg,
-                                         bool create_clean_session,
-                                         bool *session_present )
+/*
+ * mqtt_queue_object_event
+ *
+ * Queue an event of an MQTT object to its event loop thread. The queued event holds a reference to the object,
+ * which the event loop thread drops once the event is processed. No event is queued for an object being deleted.
+ * The caller runs while a reference to the object is held, by itself or by the handle (the timer callbacks and
+ * the socket callbacks of a connected object), so the reference taken here is never the last one on failure.
+ */
+static cy_rslt_t mqtt_queue_object_event( cy_mqtt_object_t *mqtt_obj, cy_mqtt_socket_event_t socket_event, uint32_t timeout_ms )
 {
-    cy_rslt_t         result = CY_RSLT_SUCCESS;
-    MQTTStatus_t      mqttStatus = MQTTSuccess;
+    cy_rslt_t                    result = CY_RSLT_SUCCESS;
+    cy_mqtt_callback_event_t     event;
+    cy_mqtt_event_loop_object_t  *loop;
 
-    /* Establish an MQTT session by sending a CONNECT packet. */
-
-    /* Send an MQTT CONNECT packet to the broker. */
-    mqttStatus = MQTT_Connect( &(mqtt_obj->mqtt_context), connect_info, will_msg, CY_MQTT_CONNACK_RECV_TIMEOUT_MS, session_present );
-    if( mqttStatus != MQTTSuccess )
+    /* The event loop is read with queued_events incremented, so that cy_mqtt_set_event_loop cannot change it until the event is processed. */
+    (void)cy_rtos_get_mutex( &(mqtt_obj->ref_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( (is_mqtt_obj_valid( mqtt_obj ) == false) || (mqtt_obj->deleted == true) )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nConnection with MQTT broker failed with status %s.\n", MQTT_Status_strerror( mqttStatus ) );
-        return CY_RSLT_MODULE_MQTT_CONNECT_FAIL;
+        (void)cy_rtos_set_mutex( &(mqtt_obj->ref_mutex) );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
     }
-    else
+    mqtt_obj->ref_count++;
+    mqtt_obj->queued_events++;
+    loop = mqtt_obj->event_loop;
+    (void)cy_rtos_set_mutex( &(mqtt_obj->ref_mutex) );
+
+    event.socket_event = socket_event;
+    event.mqtt_obj = mqtt_obj;
+
+    result = cy_rtos_put_queue( &(loop->queue), (void *)&event, timeout_ms, false );
+    if( result != CY_RSLT_SUCCESS )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nMQTT connection successfully established with broker.\n\n" );
-        mqtt_obj->mqtt_session_established = true;
+        (void)cy_rtos_get_mutex( &(mqtt_obj->ref_mutex), CY_RTOS_NEVER_TIMEOUT );
+        mqtt_obj->ref_count--;
+        mqtt_obj->queued_events--;
+        (void)cy_rtos_set_mutex( &(mqtt_obj->ref_mutex) );
     }
 
     return result;
 }
 
-/*----------------------------------------------------------------------------------------------------------*/
-int32_t mqtt_awsport_network_receive( NetworkContext_t *network_context, void *buffer, size_t bytes_recv )
+/*
+ * mqtt_pingresp_timeout_callback
+ *
+ * Callback if no ping response received in time.
+ */
+static bool mqtt_pingresp_timeout_callback( cy_mqtt_object_t *mqtt_obj )
 {
-    int32_t bytes_received = 0, total_received = 0;
-    size_t entryTimeMs = 0U, exitTimeMs = 0, remainingTimeMs = 0, elapsedTimeMs = 0U;;
-    size_t bytestoread = 0;
-
-    remainingTimeMs = CY_MQTT_MESSAGE_RECEIVE_TIMEOUT_MS;
+    cy_rslt_t                res = CY_RSLT_SUCCESS;
 
-    do
+    /* The mqtt_event_processing_thread is responsible for sending the periodic ping request. If the application sends a
+     * publish message immediately after a ping request(before getting the ping response), the ping reponse will be processed in
+     * the application thread context as the mqtt publish will wait for the pub_ack. Here, ping response will come first followed by pub_ack.
+     * However, this timer is stopped only in the event processing thread context. So the timer callback is triggered after the timeout.
+     * But as part of the processing, Core Mqtt library will set waitingForPingResp to false once ping respnonse is received.
+     * So, check if we are still waiting for a ping response before queuing the disconnect event.
+     */
+    if( mqtt_obj->mqtt_context.waitingForPingResp == false )
     {
-        bytestoread = (size_t)bytes_recv - total_received;
-        entryTimeMs = Clock_GetTimeMs();
-        bytes_received = cy_awsport_network_receive( network_context, (void *)((char *)buffer + total_received), bytestoread );
-        exitTimeMs = Clock_GetTimeMs();
-        elapsedTimeMs = exitTimeMs - entryTimeMs;
-        if( bytes_received < 0 )
-        {
-            return bytes_received;
-        }
-        else if( bytes_received == 0 )
-        {
-            if( total_received == 0 )
-            {
-                /* No data in the socket, so return. */
-                break;
-            }
-        }
-        else
-        {
-            total_received = total_received + bytes_received;
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\n Total Bytes Received = %u\n", (unsigned int)total_received );
-            /* Reset the wait time as some data is received. */
-            elapsedTimeMs = 0;
-            remainingTimeMs = CY_MQTT_MESSAGE_RECEIVE_TIMEOUT_MS;
-        }
-        remainingTimeMs = remainingTimeMs - elapsedTimeMs;
-    } while( (total_received < bytes_recv) && (remainingTimeMs > 0) );
+        return true;
+    }
 
-    return total_received;
-}
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO,
+                    "\nMQTT Keepalive Timeout\n" );
 
-/*----------------------------------------------------------------------------------------------------------*/
+    /* Queue Disconnect event */
+    res = mqtt_queue_object_event( mqtt_obj, CY_MQTT_SOCKET_EVENT_DISCONNECT, 0 );
+    if( res == CY_RSLT_MODULE_MQTT_INVALID_HANDLE )
+    {
+        return true;
+    }
+    if( res != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nPushing to MQTT event to mqtt_event_queue failed with Error : [0x%X] \n",
+                        (unsigned int)res );
+        return false;
+    }
+    return true;
+}
 
-static cy_rslt_t mqtt_initialize_core_lib( MQTTContext_t *param_mqtt_context,
-                                           NetworkContext_t *param_network_context,
-                                           uint8_t *networkbuff, uint32_t buff_len )
+/*
+ * mqtt_keepalive_timeout_callback
+ *
+ * Callback on expiry of the keepalive timer. If a packet was sent to the broker since the timer was armed, the timer is
+ * rearmed for the rest of the keepalive interval; a ping request is queued only once the connection has been idle
+ * for the whole interval.
+ */
+static bool mqtt_keepalive_timeout_callback( cy_mqtt_object_t *mqtt_obj )
 {
-    cy_rslt_t            result = CY_RSLT_SUCCESS;
-    MQTTStatus_t         mqttStatus = MQTTSuccess;
-    MQTTFixedBuffer_t    networkBuffer;
-    TransportInterface_t transport;
+    cy_rslt_t                  result = CY_RSLT_SUCCESS;
+    uint32_t                   remaining_ms;
 
-    if( (param_mqtt_context == NULL) || (param_network_context == NULL) )
+    if( mqtt_obj->keepAliveSeconds == 0 )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Bad arguments to mqtt_initialize_core_lib.\n" );
-        return CY_RSLT_MODULE_MQTT_BADARG;
+        return true;
     }
 
-    memset( &networkBuffer, 0x00, sizeof(MQTTFixedBuffer_t) );
-    memset( &transport, 0x00, sizeof(TransportInterface_t) );
+    remaining_ms = mqtt_keepalive_remaining_ms( mqtt_obj );
+    if( remaining_ms > 0 )
+    {
+        mqtt_timer_arm_locked( &mqtt_obj->mqtt_timer, remaining_ms );
+        return true;
+    }
 
-    /* Fill in TransportInterface send and receive function pointers. */
-    transport.pNetworkContext = param_network_context;
-    transport.send = (TransportSend_t)&cy_awsport_network_send;
-    transport.recv = (TransportRecv_t)&mqtt_awsport_network_receive;
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nPushing mqtt_ping_request event to the mqtt_event_queue. \n" );
+    result = mqtt_queue_object_event( mqtt_obj, CY_MQTT_SOCKET_EVENT_PING_REQ, 0 );
+    return ( (result == CY_RSLT_SUCCESS) || (result == CY_RSLT_MODULE_MQTT_INVALID_HANDLE) );
+}
 
-    /* Fill the values for the network buffer. */
-    networkBuffer.pBuffer = networkbuff;
-    networkBuffer.size = buff_len;
+/*
+ * mqtt_reconnect_timeout_callback
+ *
+ * Callback on expiry of the reconnect timer; hands the next attempt of the automatic reconnection to the reconnect
+ * thread. The object holds a reference while it is in the list of the reconnect thread.
+ */
+static bool mqtt_reconnect_timeout_callback( cy_mqtt_object_t *mqtt_obj )
+{
+    if( (mqtt_obj->reconnect_queued == true) || (mqtt_obj_acquire( mqtt_obj ) == false) )
+    {
+        return true;
+    }
 
-    /* Initialize the MQTT library. */
-    mqttStatus = MQTT_Init( param_mqtt_context, &transport, Clock_GetTimeMs,
-                            mqtt_event_callback, &networkBuffer );
-    if( mqttStatus != MQTTSuccess )
+    mqtt_obj->reconnect_queued = true;
+    mqtt_obj->reconnect_next = NULL;
+    if( mqtt_reconnect_tail == NULL )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n MQTT init failed with Status = %s.\n", MQTT_Status_strerror( mqttStatus ) );
-        result = CY_RSLT_MODULE_MQTT_INIT_FAIL;
+        mqtt_reconnect_head = mqtt_obj;
+    }
+    else
+    {
+        mqtt_reconnect_tail->reconnect_next = mqtt_obj;
     }
+    mqtt_reconnect_tail = mqtt_obj;
+    (void)cy_rtos_set_semaphore( &mqtt_reconnect_wake, false );
 
-    return result;
+    return true;
+}
+
+static void mqtt_ping_request_callback( cy_mqtt_object_t *mqtt_obj )
+{
+    cy_rslt_t                  result = CY_RSLT_SUCCESS;
+
+    if( mqtt_obj == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Bad arguments to mqtt_ping_request_callback \n" );
+        return;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nPushing mqtt_ping_request event to the mqtt_event_queue. \n" );
+
+    result = mqtt_queue_object_event( mqtt_obj, CY_MQTT_SOCKET_EVENT_PING_REQ, CY_MQTT_EVENT_QUEUE_TIMEOUT_IN_MSEC );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nPushing mqtt_ping_request event to the mqtt_event_queue failed with Error : [0x%X] \n", (unsigned int)result );
+    }
+    return;
 }
 
 /*----------------------------------------------------------------------------------------------------------*/
 
-static void mqtt_event_processing_thread( cy_thread_arg_t arg )
+/*
+ * mqtt_queue_async_publish_event_locked
+ *
+ * Queue an event to mqtt_event_processing_thread to report the completion of asynchronous publishes.
+ * At most one such event is kept in the queue for an MQTT object. Returns false if the event could not be queued.
+ */
+/* mqtt_queue_async_publish_event_locked must be protected under mqtt_timer_mutex */
+static bool mqtt_queue_async_publish_event_locked( cy_mqtt_object_t *mqtt_obj )
 {
     cy_rslt_t                  result = CY_RSLT_SUCCESS;
-    cy_mqtt_object_t           *mqtt_obj = NULL;
-    cy_mqtt_event_t            event;
-    cy_mqtt_callback_event_t   socket_event;
-    MQTTStatus_t               mqtt_status = MQTTSuccess;
-    bool                       connect_status = true;
-    bool                       mqtt_ping_resp_wait;
-   (void)arg;
-    int                        index = 0;
 
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nStarting mqtt_event_processing_thread...\n" );
+    if( mqtt_obj->async_event_queued == true )
+    {
+        return true;
+    }
 
-    while( true )
+    result = mqtt_queue_object_event( mqtt_obj, CY_MQTT_SOCKET_EVENT_ASYNC_PUBLISH, 0 );
+    if( result == CY_RSLT_MODULE_MQTT_INVALID_HANDLE )
     {
-        memset( &socket_event, 0x00, sizeof( cy_mqtt_callback_event_t ) );
-        result = cy_rtos_get_queue( &mqtt_event_queue, (void *)&socket_event, CY_RTOS_NEVER_TIMEOUT, false );
-        if( result != CY_RSLT_SUCCESS )
-        {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_queue failed with Error :[0x%X]\n", (unsigned int)result );
-            continue;
-        }
+        /* The MQTT object is being deleted; there is nobody left to report the completions to. */
+        return true;
+    }
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nPushing async publish event to the mqtt_event_queue failed with Error : [0x%X] \n", (unsigned int)result );
+        return false;
+    }
+    mqtt_obj->async_event_queued = true;
+    return true;
+}
 
-        if( socket_event.socket_event == CY_MQTT_SOCKET_EVENT_EXIT_THREAD )
-        {
-            break;
-        }
+/*
+ * mqtt_queue_async_publish_event
+ *
+ * Queue an event to mqtt_event_processing_thread to report the completion of asynchronous publishes.
+ * If the queue stays full for timeout_ms, the event is queued by mqtt_async_ack_timeout_callback, which
+ * retries on every tick of the timing wheel, so that a completion is never left unreported.
+ */
+static void mqtt_queue_async_publish_event( cy_mqtt_object_t *mqtt_obj, uint32_t timeout_ms )
+{
+    cy_rslt_t                  result = CY_RSLT_SUCCESS;
+    bool                       queued = false;
 
-        memset( &event, 0x00, sizeof( cy_mqtt_event_t ) );
-        if( socket_event.mqtt_obj == NULL )
-        {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid mqtt handle...!\n" );
-            continue;
-        }
+    (void)cy_rtos_get_mutex( &mqtt_timer_mutex, CY_RTOS_NEVER_TIMEOUT );
+    queued = mqtt_queue_async_publish_event_locked( mqtt_obj );
+    if( (queued == false) && (timeout_ms > 0) )
+    {
+        /* Claim the event, so that the timer callback does not queue a second one while this thread waits for the queue. */
+        mqtt_obj->async_event_queued = true;
+        (void)cy_rtos_set_mutex( &mqtt_timer_mutex );
 
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Acquiring Mutex %p \n", mqtt_db_mutex );
-        result = cy_rtos_get_mutex( &mqtt_db_mutex, CY_RTOS_NEVER_TIMEOUT );
+        result = mqtt_queue_object_event( mqtt_obj, CY_MQTT_SOCKET_EVENT_ASYNC_PUBLISH, timeout_ms );
+
+        (void)cy_rtos_get_mutex( &mqtt_timer_mutex, CY_RTOS_NEVER_TIMEOUT );
         if( result != CY_RSLT_SUCCESS )
         {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
-            continue;
+            mqtt_obj->async_event_queued = false;
         }
+        queued = ( (result == CY_RSLT_SUCCESS) || (result == CY_RSLT_MODULE_MQTT_INVALID_HANDLE) );
+    }
+    if( queued == false )
+    {
+        mqtt_obj->async_deadline_expired = true;
+    }
+    (void)cy_rtos_set_mutex( &mqtt_timer_mutex );
+
+    if( queued == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nAsync publish event is deferred to the next timer tick.\n" );
+        mqtt_timer_arm( &(mqtt_obj->mqtt_async_ack_timer), 0 );
+    }
+    return;
+}
+
+/*
+ * mqtt_take_async_publish_event
+ *
+ * Mark the asynchronous publish event as taken off the queue by mqtt_event_processing_thread.
+ * Returns true if the acknowledgment deadlines of the asynchronous publishes need to be checked.
+ */
+static bool mqtt_take_async_publish_event( cy_mqtt_object_t *mqtt_obj )
+{
+    bool deadline_expired;
+
+    (void)cy_rtos_get_mutex( &mqtt_timer_mutex, CY_RTOS_NEVER_TIMEOUT );
+    mqtt_obj->async_event_queued = false;
+    deadline_expired = mqtt_obj->async_deadline_expired;
+    mqtt_obj->async_deadline_expired = false;
+    (void)cy_rtos_set_mutex( &mqtt_timer_mutex );
+
+    return deadline_expired;
+}
+
+/*
+ * mqtt_queue_rx_event
+ *
+ * Queue an event to mqtt_event_processing_thread to process the data received in the socket.
+ * At most one such event is kept in the queue for an MQTT object; the receive notifications raised
+ * while it is pending are covered by it, as the event is processed until the socket has no more data.
+ */
+static void mqtt_queue_rx_event( cy_mqtt_object_t *mqtt_obj )
+{
+    cy_rslt_t                  result = CY_RSLT_SUCCESS;
+
+    if( mqtt_obj->rx_event_queued == true )
+    {
+        return;
+    }
+
+    mqtt_obj->rx_event_queued = true;
+    result = mqtt_queue_object_event( mqtt_obj, CY_MQTT_SOCKET_EVENT_DATA_RECEIVE, CY_MQTT_EVENT_QUEUE_TIMEOUT_IN_MSEC );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        mqtt_obj->rx_event_queued = false;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nPushing to MQTT event to mqtt_event_queue failed with Error : [0x%X] \n", (unsigned int)result );
+    }
+    return;
+}
+
+/*
+ * mqtt_async_ack_timeout_callback
+ *
+ * Callback on expiry of the earliest acknowledgment deadline of the asynchronous publishes.
+ */
+static bool mqtt_async_ack_timeout_callback( cy_mqtt_object_t *mqtt_obj )
+{
+    mqtt_obj->async_deadline_expired = true;
+    /* If the event queue is full, the callback is called again on the next tick. */
+    return mqtt_queue_async_publish_event_locked( mqtt_obj );
+}
+
+/* start_async_ack_timer must be protected under mqtt_obj->process_mutex */
+static cy_rslt_t start_async_ack_timer( cy_mqtt_object_t *mqtt_obj, uint32_t timeout_ms, bool restart )
+{
+    if( (restart == false) && (mqtt_timer_is_armed( &mqtt_obj->mqtt_async_ack_timer ) == true) )
+    {
+        /* Timer is already armed for an earlier deadline. */
+        return CY_RSLT_SUCCESS;
+    }
 
-        /* Check if the mqtt_obj is still present in mqtt_handle_database  */
-        for( index = 0;index < CY_MQTT_MAX_HANDLE;index++ )
+    mqtt_timer_arm( &mqtt_obj->mqtt_async_ack_timer, timeout_ms );
+    return CY_RSLT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_free_publish_window
+ *
+ * Free the inflight window of the outgoing PUBLISH packets.
+ */
+static void mqtt_free_publish_window( cy_mqtt_object_t *mqtt_obj )
+{
+    uint16_t index;
+
+    if( mqtt_obj->pub_ack_sems != NULL )
+    {
+        for( index = 0; index < mqtt_obj->pub_window_size; index++ )
         {
-            if( mqtt_handle_database[index].mqtt_handle == (void *)socket_event.mqtt_obj )
-            {
-                /* The mqtt_obj is present in mqtt_handle_database */
-                break;
-            }
+            (void)cy_rtos_deinit_semaphore( &(mqtt_obj->pub_ack_sems[ index ]) );
         }
-        if( index == CY_MQTT_MAX_HANDLE )
+        free( mqtt_obj->pub_ack_sems );
+        mqtt_obj->pub_ack_sems = NULL;
+    }
+    if( mqtt_obj->outgoing_pub_packets != NULL )
+    {
+        for( index = 0; index < mqtt_obj->pub_window_size; index++ )
         {
-            /* The mqtt_obj is no longer available. Hence do not process the events related to this object */
-            result = cy_rtos_set_mutex( &mqtt_db_mutex );
-            if( result != CY_RSLT_SUCCESS )
+            if( mqtt_obj->outgoing_pub_packets[ index ].compressed_payload != NULL )
             {
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
+                free( mqtt_obj->outgoing_pub_packets[ index ].compressed_payload );
             }
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Released Mutex %p \n", mqtt_db_mutex );
-            continue;
         }
+        free( mqtt_obj->outgoing_pub_packets );
+        mqtt_obj->outgoing_pub_packets = NULL;
+    }
+    if( mqtt_obj->pub_hash_buckets != NULL )
+    {
+        free( mqtt_obj->pub_hash_buckets );
+        mqtt_obj->pub_hash_buckets = NULL;
+    }
+    if( mqtt_obj->retransmit_arena != NULL )
+    {
+        free( mqtt_obj->retransmit_arena );
+        mqtt_obj->retransmit_arena = NULL;
+    }
+    mqtt_obj->pub_window_size = 0;
+    mqtt_obj->num_outgoing_pubs = 0;
+}
 
-        switch (socket_event.socket_event)
-        {
-            case CY_MQTT_SOCKET_EVENT_DATA_RECEIVE:
-            {
-                mqtt_obj = (cy_mqtt_object_t *)socket_event.mqtt_obj;
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
-                result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
-                if( result != CY_RSLT_SUCCESS )
-                {
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
-                    result = cy_rtos_set_mutex( &mqtt_db_mutex );
-                    if( result != CY_RSLT_SUCCESS )
-                    {
-                        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
-                    }
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Released Mutex %p \n", mqtt_db_mutex );
-                    continue;
-                }
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Acquired Mutex %p \n", mqtt_obj->process_mutex );
-                /* Stop MQTT Ping Timer */
-                result = stop_timer( mqtt_obj );
-                if( result != CY_RSLT_SUCCESS )
-                {
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nstop_timer failed\n" );
-                }
+/*
+ * mqtt_alloc_publish_window
+ *
+ * Allocate the inflight window of the outgoing PUBLISH packets. The entries are indexed by
+ * packet ID through a power-of-two hash table; since packet IDs are assigned sequentially,
+ * the chains stay short and an acknowledgment is matched in constant time. The semaphore
+ * on which the publisher of an entry waits for its acknowledgment is created with the entry.
+ */
+static cy_rslt_t mqtt_alloc_publish_window( cy_mqtt_object_t *mqtt_obj, uint16_t window_size )
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t  num_of_buckets = 1;
+    uint16_t  index;
 
-                connect_status = mqtt_obj->mqtt_session_established;
-                if( connect_status )
-                {
-                    mqtt_ping_resp_wait = mqtt_obj->mqtt_context.waitingForPingResp;
-                    mqtt_status = MQTT_ProcessLoop( &(mqtt_obj->mqtt_context), CY_MQTT_RECEIVE_DATA_TIMEOUT_MS );
-                    if( mqtt_status != MQTTSuccess )
-                    {
-                        if( (mqtt_status == MQTTRecvFailed)  || (mqtt_status == MQTTSendFailed) ||
-                            (mqtt_status == MQTTBadResponse) || (mqtt_status == MQTTKeepAliveTimeout) ||
-                            (mqtt_status == MQTTIllegalState ) )
-                        {
-                            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nmqtt_event_processing_thread MQTT_ProcessLoop failed with status %s \n", MQTT_Status_strerror(mqtt_status) );
-                            memset( &event, 0x00, sizeof(cy_mqtt_event_t) );
-                            event.type = CY_MQTT_EVENT_TYPE_DISCONNECT;
+    while( num_of_buckets < window_size )
+    {
+        num_of_buckets = num_of_buckets << 1;
+    }
 
-                            if( mqtt_status == MQTTKeepAliveTimeout )
-                            {
-                                event.data.reason = CY_MQTT_DISCONN_TYPE_BROKER_DOWN;
-                            }
-                            else if( (mqtt_status == MQTTRecvFailed) || (mqtt_status == MQTTSendFailed) )
-                            {
-                                event.data.reason = CY_MQTT_DISCONN_TYPE_SND_RCV_FAIL;
-                            }
-                            else
-                            {
-                                event.data.reason = CY_MQTT_DISCONN_TYPE_BAD_RESPONSE;
-                            }
+    mqtt_obj->outgoing_pub_packets = (cy_mqtt_pubpack_t *)malloc( sizeof( cy_mqtt_pubpack_t ) * window_size );
+    mqtt_obj->pub_hash_buckets = (uint16_t *)malloc( sizeof( uint16_t ) * num_of_buckets );
+    if( (mqtt_obj->outgoing_pub_packets == NULL) || (mqtt_obj->pub_hash_buckets == NULL) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to create inflight window of %u publishes..!\n", (unsigned int)window_size );
+        mqtt_free_publish_window( mqtt_obj );
+        return CY_RSLT_MODULE_MQTT_NOMEM;
+    }
 
-                            /* Call registered application callbacks */
-                            call_registered_event_callbacks((cy_mqtt_t)mqtt_obj, event);
+    if( mqtt_obj->retransmit_slot_size > 0 )
+    {
+        /* Each entry of the inflight window owns one slot of the retransmit arena, so the
+         * slot is allocated and freed together with the entry. */
+        mqtt_obj->retransmit_arena = (uint8_t *)malloc( (size_t)mqtt_obj->retransmit_slot_size * window_size );
+        if( mqtt_obj->retransmit_arena == NULL )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to create retransmit arena of %u publishes..!\n", (unsigned int)window_size );
+            mqtt_free_publish_window( mqtt_obj );
+            return CY_RSLT_MODULE_MQTT_NOMEM;
+        }
+    }
 
-                            mqtt_obj->mqtt_session_established = false;
-                        }
-                    }
-                    else
-                    {
-                        if( ( mqtt_ping_resp_wait == true ) && ( mqtt_obj->mqtt_context.waitingForPingResp == false ) )
-                        {
-                            /* we have received the mqtt response. Stop timer */
-                            stop_mqtt_ping_resp_timer( mqtt_obj );
-                        }
-                    }
-                }
+    ( void ) memset( mqtt_obj->outgoing_pub_packets, 0x00, sizeof( cy_mqtt_pubpack_t ) * window_size );
+    for( index = 0; index < window_size; index++ )
+    {
+        mqtt_obj->outgoing_pub_packets[ index ].next = (uint16_t)( index + 1 );
+    }
+    mqtt_obj->outgoing_pub_packets[ window_size - 1 ].next = CY_MQTT_PUB_INDEX_INVALID;
+    for( index = 0; index < num_of_buckets; index++ )
+    {
+        mqtt_obj->pub_hash_buckets[ index ] = CY_MQTT_PUB_INDEX_INVALID;
+    }
 
-                /* Start MQTT Ping Timer */
-                result = start_timer( mqtt_obj );
-                if( result != CY_RSLT_SUCCESS )
-                {
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nstart_timer failed\n" );
-                }
+    mqtt_obj->pub_ack_sems = (cy_semaphore_t *)malloc( sizeof( cy_semaphore_t ) * window_size );
+    if( mqtt_obj->pub_ack_sems == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to create inflight window of %u publishes..!\n", (unsigned int)window_size );
+        mqtt_free_publish_window( mqtt_obj );
+        return CY_RSLT_MODULE_MQTT_NOMEM;
+    }
+    for( index = 0; index < window_size; index++ )
+    {
+        result = cy_rtos_init_semaphore( &(mqtt_obj->pub_ack_sems[ index ]), 1, 0 );
+        if( result != CY_RSLT_SUCCESS )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_init_semaphore failed with Error : [0x%X] \n", (unsigned int)result );
+            /* Only the semaphores created so far are deleted. */
+            mqtt_obj->pub_window_size = index;
+            mqtt_free_publish_window( mqtt_obj );
+            return result;
+        }
+    }
 
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Releasing Mutex %p \n", mqtt_obj->process_mutex );
-                result = cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
-                if( result != CY_RSLT_SUCCESS )
-                {
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", (unsigned int)result );
-                }
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Released Mutex %p \n", mqtt_obj->process_mutex );
+    mqtt_obj->pub_window_size = window_size;
+    mqtt_obj->pub_hash_mask = (uint16_t)( num_of_buckets - 1 );
+    mqtt_obj->pub_free_head = 0;
+    mqtt_obj->num_outgoing_pubs = 0;
+    mqtt_obj->async_completed_head = CY_MQTT_PUB_INDEX_INVALID;
+    mqtt_obj->async_completed_tail = CY_MQTT_PUB_INDEX_INVALID;
 
-                break;
-            }
+    return CY_RSLT_SUCCESS;
+}
 
-            case CY_MQTT_SOCKET_EVENT_DISCONNECT:
-            {
-                mqtt_obj = (cy_mqtt_object_t *)socket_event.mqtt_obj;
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
-                result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
-                if( result != CY_RSLT_SUCCESS )
-                {
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
-                    result = cy_rtos_set_mutex( &mqtt_db_mutex );
-                    if( result != CY_RSLT_SUCCESS )
-                    {
-                        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
-                    }
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Released Mutex %p \n", mqtt_db_mutex );
-                    continue;
-                }
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Acquired Mutex %p \n", mqtt_obj->process_mutex );
+/*----------------------------------------------------------------------------------------------------------*/
 
-                /* Stop MQTT Ping Timer */
-                result = stop_timer( mqtt_obj );
-                if( result != CY_RSLT_SUCCESS )
-                {
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nstop_timer failed\n" );
-                }
-                result = stop_mqtt_ping_resp_timer( mqtt_obj );
-                if( result != CY_RSLT_SUCCESS )
-                {
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nstop mqtt ping resp timer failed\n" );
-                }
+/*
+ * mqtt_copy_to_retransmit_arena
+ *
+ * Copy the topic and payload of an outgoing PUBLISH packet to the retransmit arena slot of its inflight window
+ * entry, and point the packet at the copy. The slot is released when the entry is cleaned up.
+ */
+/* mqtt_copy_to_retransmit_arena must be protected under mqtt_obj->process_mutex */
+static cy_rslt_t mqtt_copy_to_retransmit_arena( cy_mqtt_object_t *mqtt_obj, uint16_t index, cy_mqtt_publish_info_t *pubmsg )
+{
+    cy_mqtt_pubpack_t *pubpack = &(mqtt_obj->outgoing_pub_packets[ index ]);
+    uint8_t           *slot = &(mqtt_obj->retransmit_arena[ (size_t)mqtt_obj->retransmit_slot_size * index ]);
 
-                /* Reset keepAliveSeconds to 0 to avoid timer activity after disconnection */
-                mqtt_obj->keepAliveSeconds = 0;
-                event.type = CY_MQTT_EVENT_TYPE_DISCONNECT;
+    if( ((size_t)pubmsg->topic_len + pubmsg->payload_len) > mqtt_obj->retransmit_slot_size )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMessage of %u bytes does not fit in the retransmit slot of %u bytes..!\n",
+                         (unsigned int)(pubmsg->topic_len + pubmsg->payload_len), (unsigned int)mqtt_obj->retransmit_slot_size );
+        return CY_RSLT_MODULE_MQTT_NOMEM;
+    }
 
-                if( mqtt_obj->mqtt_session_established == true )
-                {
-                    event.data.reason = CY_MQTT_DISCONN_TYPE_NETWORK_DOWN;
+    memcpy( slot, pubmsg->topic, pubmsg->topic_len );
+    if( pubmsg->payload_len > 0 )
+    {
+        memcpy( &(slot[ pubmsg->topic_len ]), pubmsg->payload, pubmsg->payload_len );
+    }
+    pubpack->pubinfo.pTopicName = (const char *)slot;
+    pubpack->pubinfo.pPayload = &(slot[ pubmsg->topic_len ]);
 
-                    call_registered_event_callbacks((cy_mqtt_t)mqtt_obj, event);
+    return CY_RSLT_SUCCESS;
+}
 
-                    mqtt_obj->mqtt_session_established = false;
-                }
+/*----------------------------------------------------------------------------------------------------------*/
 
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Releasing Mutex %p \n", mqtt_obj->process_mutex );
-                result = cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
-                if( result != CY_RSLT_SUCCESS )
-                {
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", (unsigned int)result );
-                }
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Released Mutex %p \n", mqtt_obj->process_mutex );
+/*
+ * mqtt_rate_limit_refill
+ *
+ * Add the credit earned in elapsed milliseconds at rate units per second to a token bucket of burst units.
+ */
+static void mqtt_rate_limit_refill( int64_t *credit, uint64_t earned, uint32_t burst )
+{
+    int64_t full = (int64_t)burst * 1000;
 
-                break;
-            }
+    if( earned >= (uint64_t)(full - *credit) )
+    {
+        *credit = full;
+    }
+    else
+    {
+        *credit += (int64_t)earned;
+    }
+}
 
-            case CY_MQTT_SOCKET_EVENT_PING_REQ:
-            {
-                mqtt_obj = (cy_mqtt_object_t *)socket_event.mqtt_obj;
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
-                result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
-                if( result != CY_RSLT_SUCCESS )
-                {
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
-                    result = cy_rtos_set_mutex( &mqtt_db_mutex );
-                    if( result != CY_RSLT_SUCCESS )
-                    {
-                        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
-                    }
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Released Mutex %p \n", mqtt_db_mutex );
-                    continue;
-                }
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Acquired Mutex %p \n", mqtt_obj->process_mutex );
-                /* Stop MQTT Ping Timer */
-                result = stop_timer( mqtt_obj );
-                if( result != CY_RSLT_SUCCESS )
-                {
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nstop_timer failed\n" );
-                }
+/*----------------------------------------------------------------------------------------------------------*/
 
-                connect_status = mqtt_obj->mqtt_session_established;
-                if( connect_status )
-                {
-                    mqtt_status = MQTT_Ping( &(mqtt_obj->mqtt_context) );
-                    if( mqtt_status != MQTTSuccess )
-                    {
-                        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n MQTT_Ping failed with Error : [0x%X] ", (unsigned int)mqtt_status );
-                        if( mqtt_obj->mqtt_session_established == true )
-                        {
-                            event.data.reason = CY_MQTT_DISCONN_TYPE_NETWORK_DOWN;
+/*
+ * mqtt_rate_limit_take
+ *
+ * Refill the token buckets of the publish rate limiter and take the credit for the given number of messages
+ * and bytes. The full cost is charged, and a credit may become negative: a request larger than the burst size
+ * waits only for a full bucket, and the requests after it wait until the debt is repaid.
+ * If the credit is not available, wait_ms is set to the time after which it will be.
+ */
+/* mqtt_rate_limit_take must be protected under mqtt_obj->process_mutex */
+static cy_rslt_t mqtt_rate_limit_take( cy_mqtt_object_t *mqtt_obj, uint32_t messages, size_t bytes, uint32_t *wait_ms )
+{
+    cy_mqtt_rate_limiter_t *limiter = &(mqtt_obj->rate_limiter);
+    uint32_t               now = Clock_GetTimeMs();
+    uint32_t               elapsed = now - limiter->last_refill_ms;
+    int64_t                message_need = 0;
+    int64_t                byte_need = 0;
+    int64_t                message_wait = 0;
+    int64_t                byte_wait = 0;
+
+    limiter->last_refill_ms = now;
+    if( limiter->config.messages_per_sec > 0 )
+    {
+        mqtt_rate_limit_refill( &(limiter->message_credit), (uint64_t)elapsed * limiter->config.messages_per_sec, limiter->config.message_burst );
+        message_need = (int64_t)((messages < limiter->config.message_burst) ? messages : limiter->config.message_burst) * 1000;
+        if( limiter->message_credit < message_need )
+        {
+            message_wait = ((message_need - limiter->message_credit) + limiter->config.messages_per_sec - 1) / limiter->config.messages_per_sec;
+        }
+    }
+    if( limiter->config.bytes_per_sec > 0 )
+    {
+        mqtt_rate_limit_refill( &(limiter->byte_credit), (uint64_t)elapsed * limiter->config.bytes_per_sec, limiter->config.byte_burst );
+        byte_need = (int64_t)((bytes < limiter->config.byte_burst) ? bytes : limiter->config.byte_burst) * 1000;
+        if( limiter->byte_credit < byte_need )
+        {
+            byte_wait = ((byte_need - limiter->byte_credit) + limiter->config.bytes_per_sec - 1) / limiter->config.bytes_per_sec;
+        }
+    }
 
-                            call_registered_event_callbacks((cy_mqtt_t)mqtt_obj, event);
+    if( (message_wait > 0) || (byte_wait > 0) )
+    {
+        *wait_ms = (uint32_t)((message_wait > byte_wait) ? message_wait : byte_wait);
+        return CY_RSLT_MODULE_MQTT_RATE_LIMITED;
+    }
 
-                            mqtt_obj->mqtt_session_established = false;
-                        }
-                        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Releasing Mutex %p ", mqtt_obj->process_mutex );
-                        result = cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
-                        if( result != CY_RSLT_SUCCESS )
-                        {
-                            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] ", (unsigned int)result );
-                        }
-                        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Released Mutex %p ", mqtt_obj->process_mutex );
+    if( limiter->config.messages_per_sec > 0 )
+    {
+        limiter->message_credit -= (int64_t)messages * 1000;
+    }
+    if( limiter->config.bytes_per_sec > 0 )
+    {
+        limiter->byte_credit -= (int64_t)bytes * 1000;
+    }
+    *wait_ms = 0;
+    return CY_RSLT_SUCCESS;
+}
 
-                        break;
-                    }
-                    else
-                    {
-                        /* Start ping response timer */
-                        start_mqtt_ping_resp_timer(mqtt_obj);
-                    }
-                }
-                /* Start MQTT Ping Timer */
-                result = start_timer( mqtt_obj );
-                if( result != CY_RSLT_SUCCESS )
-                {
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nstart_timer failed\n" );
-                }
+/*----------------------------------------------------------------------------------------------------------*/
 
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Releasing Mutex %p \n", mqtt_obj->process_mutex );
-                result = cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
-                if( result != CY_RSLT_SUCCESS )
-                {
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", (unsigned int)result );
-                }
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Released Mutex %p \n", mqtt_obj->process_mutex );
+/*
+ * mqtt_rate_limit_refund
+ *
+ * Return the credit taken by mqtt_rate_limit_acquire for a message that was not sent.
+ */
+/* mqtt_rate_limit_refund must be protected under mqtt_obj->process_mutex */
+static void mqtt_rate_limit_refund( cy_mqtt_object_t *mqtt_obj, uint32_t messages, size_t bytes )
+{
+    cy_mqtt_rate_limiter_t *limiter = &(mqtt_obj->rate_limiter);
 
-                break;
-            }
-            default:
-            {
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid event type \n" );
-                break;
-            }
+    if( mqtt_obj->rate_limit_enabled == false )
+    {
+        return;
+    }
+    if( limiter->config.messages_per_sec > 0 )
+    {
+        mqtt_rate_limit_refill( &(limiter->message_credit), (uint64_t)messages * 1000U, limiter->config.message_burst );
+    }
+    if( limiter->config.bytes_per_sec > 0 )
+    {
+        mqtt_rate_limit_refill( &(limiter->byte_credit), (uint64_t)bytes * 1000U, limiter->config.byte_burst );
+    }
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_rate_limit_acquire
+ *
+ * Take the credit of the publish rate limiter for the given number of messages and bytes. If wait is true,
+ * wait up to the maximum wait time of the rate limit for the credit to become available; mqtt_obj->process_mutex
+ * is not held while waiting, so that mqtt_event_processing_thread can keep the connection alive.
+ */
+static cy_rslt_t mqtt_rate_limit_acquire( cy_mqtt_object_t *mqtt_obj, uint32_t messages, size_t bytes, bool wait )
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint32_t  start = Clock_GetTimeMs();
+    uint32_t  waited = 0;
+    uint32_t  wait_ms = 0;
+    uint32_t  max_wait_ms = 0;
+
+    if( mqtt_obj->rate_limit_enabled == false )
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    do
+    {
+        result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+        if( result != CY_RSLT_SUCCESS )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+            return result;
         }
-        result = cy_rtos_set_mutex( &mqtt_db_mutex );
+        if( mqtt_obj->rate_limit_enabled == false )
+        {
+            result = CY_RSLT_SUCCESS;
+        }
+        else
+        {
+            result = mqtt_rate_limit_take( mqtt_obj, messages, bytes, &wait_ms );
+            max_wait_ms = (wait == true) ? mqtt_obj->rate_limiter.config.max_wait_ms : 0;
+        }
+        (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+
+        if( result != CY_RSLT_MODULE_MQTT_RATE_LIMITED )
+        {
+            return result;
+        }
+
+        waited = Clock_GetTimeMs() - start;
+        if( waited >= max_wait_ms )
+        {
+            break;
+        }
+        (void)cy_rtos_delay_milliseconds( (wait_ms < (max_wait_ms - waited)) ? wait_ms : (max_wait_ms - waited) );
+    } while( true );
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nPublish rate limit exceeded for %u messages of %u bytes.\n",
+                     (unsigned int)messages, (unsigned int)bytes );
+    return CY_RSLT_MODULE_MQTT_RATE_LIMITED;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_is_valid_topic_name
+ *
+ * Check that the topic name is a well-formed UTF-8 string without the null character and wildcards,
+ * as required for the topic name of an MQTT PUBLISH packet.
+ */
+static bool mqtt_is_valid_topic_name( const char *topic, uint16_t topic_len )
+{
+    const uint8_t *bytes = (const uint8_t *)topic;
+    uint32_t      code_point;
+    uint16_t      i = 0;
+    uint8_t       num_continuation, j;
+
+    if( topic_len == 0 )
+    {
+        return false;
+    }
+
+    while( i < topic_len )
+    {
+        if( bytes[ i ] < 0x80U )
+        {
+            if( (bytes[ i ] == 0U) || (bytes[ i ] == (uint8_t)'+') || (bytes[ i ] == (uint8_t)'#') )
+            {
+                return false;
+            }
+            i++;
+            continue;
+        }
+        else if( (bytes[ i ] >= 0xC2U) && (bytes[ i ] <= 0xDFU) )
+        {
+            num_continuation = 1;
+            code_point = bytes[ i ] & 0x1FU;
+        }
+        else if( (bytes[ i ] >= 0xE0U) && (bytes[ i ] <= 0xEFU) )
+        {
+            num_continuation = 2;
+            code_point = bytes[ i ] & 0x0FU;
+        }
+        else if( (bytes[ i ] >= 0xF0U) && (bytes[ i ] <= 0xF4U) )
+        {
+            num_continuation = 3;
+            code_point = bytes[ i ] & 0x07U;
+        }
+        else
+        {
+            return false;
+        }
+
+        if( ((uint32_t)i + num_continuation) >= topic_len )
+        {
+            return false;
+        }
+        for( j = 1; j <= num_continuation; j++ )
+        {
+            if( (bytes[ i + j ] & 0xC0U) != 0x80U )
+            {
+                return false;
+            }
+            code_point = (code_point << 6) | (bytes[ i + j ] & 0x3FU);
+        }
+
+        /* Reject overlong encodings, surrogates and code points above U+10FFFF. */
+        if( ((num_continuation == 2) && (code_point < 0x800U)) || ((num_continuation == 3) && (code_point < 0x10000U)) ||
+            ((code_point >= 0xD800U) && (code_point <= 0xDFFFU)) || (code_point > 0x10FFFFU) )
+        {
+            return false;
+        }
+        i = (uint16_t)(i + num_continuation + 1);
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_compress_payload
+ *
+ * Compress the payload of an outgoing message with the payload codec, and prefix it with the codec header.
+ * Returns the allocated compressed payload, or NULL if the payload is to be sent uncompressed because it is
+ * below the threshold of the codec or does not get smaller.
+ */
+static uint8_t *mqtt_compress_payload( const cy_mqtt_payload_codec_t *codec, const cy_mqtt_publish_info_t *pubmsg, size_t *compressed_len )
+{
+    uint8_t  *buffer = NULL;
+    size_t   length;
+
+    if( (pubmsg->payload_len < codec->threshold) || (pubmsg->payload_len <= (CY_MQTT_CODEC_HEADER_SIZE + 1U)) ||
+        (pubmsg->payload_len > UINT32_MAX) || (pubmsg->payload == NULL) )
+    {
+        return NULL;
+    }
+
+    buffer = (uint8_t *)malloc( pubmsg->payload_len );
+    if( buffer == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nMemory not available to compress payload. Sending it uncompressed.\n" );
+        return NULL;
+    }
+
+    /* The compressed payload including the header must be smaller than the original payload. */
+    length = codec->compress( (const uint8_t *)pubmsg->payload, pubmsg->payload_len, &(buffer[ CY_MQTT_CODEC_HEADER_SIZE ]),
+                              pubmsg->payload_len - CY_MQTT_CODEC_HEADER_SIZE - 1U, codec->user_data );
+    if( length == 0 )
+    {
+        free( buffer );
+        return NULL;
+    }
+
+    buffer[ 0 ] = CY_MQTT_CODEC_MAGIC_0;
+    buffer[ 1 ] = CY_MQTT_CODEC_MAGIC_1;
+    buffer[ 2 ] = CY_MQTT_CODEC_MAGIC_2;
+    buffer[ 3 ] = codec->codec_id;
+    buffer[ 4 ] = (uint8_t)(pubmsg->payload_len >> 24);
+    buffer[ 5 ] = (uint8_t)(pubmsg->payload_len >> 16);
+    buffer[ 6 ] = (uint8_t)(pubmsg->payload_len >> 8);
+    buffer[ 7 ] = (uint8_t)(pubmsg->payload_len);
+    *compressed_len = CY_MQTT_CODEC_HEADER_SIZE + length;
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nCompressed payload of %u bytes to %u bytes.\n",
+                     (unsigned int)pubmsg->payload_len, (unsigned int)*compressed_len );
+    return buffer;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_decompress_payload
+ *
+ * Undo the compression of a received message whose payload starts with the codec header, and point the
+ * message at the decompressed payload. Returns the allocated decompressed payload, or NULL if the message
+ * is delivered as received.
+ */
+/* mqtt_decompress_payload must be protected under mqtt_obj->process_mutex */
+static uint8_t *mqtt_decompress_payload( cy_mqtt_object_t *mqtt_obj, cy_mqtt_received_msg_info_t *message )
+{
+    const uint8_t  *payload = (const uint8_t *)message->payload;
+    uint8_t        *buffer = NULL;
+    uint32_t       original_len;
+
+    if( (mqtt_obj->codec_enabled == false) || (payload == NULL) || (message->payload_len <= CY_MQTT_CODEC_HEADER_SIZE) ||
+        (payload[ 0 ] != CY_MQTT_CODEC_MAGIC_0) || (payload[ 1 ] != CY_MQTT_CODEC_MAGIC_1) || (payload[ 2 ] != CY_MQTT_CODEC_MAGIC_2) )
+    {
+        return NULL;
+    }
+
+    original_len = ((uint32_t)payload[ 4 ] << 24) | ((uint32_t)payload[ 5 ] << 16) | ((uint32_t)payload[ 6 ] << 8) | (uint32_t)payload[ 7 ];
+    if( (payload[ 3 ] != mqtt_obj->codec.codec_id) || (original_len == 0) || (original_len > CY_MQTT_MAX_DECOMPRESSED_PAYLOAD_SIZE) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nCompressed payload with codec %u and length %u cannot be decompressed. Delivering it as received.\n",
+                         (unsigned int)payload[ 3 ], (unsigned int)original_len );
+        return NULL;
+    }
+
+    buffer = (uint8_t *)malloc( original_len );
+    if( buffer == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to decompress payload. Delivering it as received.\n" );
+        return NULL;
+    }
+
+    if( mqtt_obj->codec.decompress( &(payload[ CY_MQTT_CODEC_HEADER_SIZE ]), message->payload_len - CY_MQTT_CODEC_HEADER_SIZE,
+                                    buffer, original_len, mqtt_obj->codec.user_data ) != original_len )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nDecompression of payload failed. Delivering it as received.\n" );
+        free( buffer );
+        return NULL;
+    }
+
+    message->payload = (const char *)buffer;
+    message->payload_len = original_len;
+    return buffer;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_is_valid_topic_filter
+ *
+ * Check that the wildcards of the topic filter occupy an entire topic level, and that '#' is only used as the last level.
+ */
+static bool mqtt_is_valid_topic_filter( const char *filter, uint16_t filter_len )
+{
+    uint16_t i;
+
+    if( (filter == NULL) || (filter_len == 0) )
+    {
+        return false;
+    }
+
+    for( i = 0; i < filter_len; i++ )
+    {
+        if( (filter[ i ] == '+') || (filter[ i ] == '#') )
+        {
+            if( ((i > 0) && (filter[ i - 1 ] != '/')) || ((i + 1 < filter_len) && (filter[ i + 1 ] != '/')) )
+            {
+                return false;
+            }
+            if( (filter[ i ] == '#') && (i + 1 != filter_len) )
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_route_node_free_if_unused
+ *
+ * Free the node and the ancestors of the node that have no callbacks and no child nodes left.
+ */
+/* mqtt_route_node_free_if_unused must be protected under mqtt_obj->process_mutex */
+static void mqtt_route_node_free_if_unused( cy_mqtt_object_t *mqtt_obj, cy_mqtt_route_node_t *node )
+{
+    cy_mqtt_route_node_t *parent;
+    cy_mqtt_route_node_t **link;
+
+    while( (node != NULL) && (node->routes == NULL) && (node->children == NULL) &&
+           (node->single_level == NULL) && (node->multi_level == NULL) )
+    {
+        parent = node->parent;
+        if( parent == NULL )
+        {
+            mqtt_obj->routes = NULL;
+        }
+        else if( parent->single_level == node )
+        {
+            parent->single_level = NULL;
+        }
+        else if( parent->multi_level == node )
+        {
+            parent->multi_level = NULL;
+        }
+        else
+        {
+            link = &(parent->children);
+            while( *link != node )
+            {
+                link = &((*link)->sibling);
+            }
+            *link = node->sibling;
+        }
+        free( node );
+        node = parent;
+    }
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_route_find_node
+ *
+ * Find the node of the topic filter in the trie. If create is true, the missing nodes are created.
+ * Returns NULL if the node does not exist, or memory is not available to create it.
+ */
+/* mqtt_route_find_node must be protected under mqtt_obj->process_mutex */
+static cy_mqtt_route_node_t *mqtt_route_find_node( cy_mqtt_object_t *mqtt_obj, const char *filter, uint16_t filter_len, bool create )
+{
+    cy_mqtt_route_node_t  *node, *child, *last_created = NULL;
+    cy_mqtt_route_node_t  **link;
+    uint16_t              start = 0, end;
+
+    if( mqtt_obj->routes == NULL )
+    {
+        if( create == false )
+        {
+            return NULL;
+        }
+        mqtt_obj->routes = (cy_mqtt_route_node_t *)calloc( 1, sizeof( cy_mqtt_route_node_t ) );
+        if( mqtt_obj->routes == NULL )
+        {
+            return NULL;
+        }
+        last_created = mqtt_obj->routes;
+    }
+    node = mqtt_obj->routes;
+
+    while( true )
+    {
+        end = start;
+        while( (end < filter_len) && (filter[ end ] != '/') )
+        {
+            end++;
+        }
+
+        if( (end - start == 1) && (filter[ start ] == '+') )
+        {
+            link = &(node->single_level);
+        }
+        else if( (end - start == 1) && (filter[ start ] == '#') )
+        {
+            link = &(node->multi_level);
+        }
+        else
+        {
+            link = &(node->children);
+            while( (*link != NULL) && (((*link)->level_len != end - start) || (memcmp( (*link)->level, &(filter[ start ]), end - start ) != 0)) )
+            {
+                link = &((*link)->sibling);
+            }
+        }
+
+        child = *link;
+        if( child == NULL )
+        {
+            if( create == false )
+            {
+                return NULL;
+            }
+            child = (cy_mqtt_route_node_t *)calloc( 1, sizeof( cy_mqtt_route_node_t ) + (end - start) );
+            if( child == NULL )
+            {
+                mqtt_route_node_free_if_unused( mqtt_obj, ( last_created != NULL ) ? last_created : node );
+                return NULL;
+            }
+            child->parent = node;
+            child->level_len = end - start;
+            child->level = (char *)&(child[ 1 ]);
+            memcpy( child->level, &(filter[ start ]), end - start );
+            *link = child;
+            last_created = child;
+        }
+        node = child;
+
+        if( end >= filter_len )
+        {
+            return node;
+        }
+        start = end + 1;
+    }
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_route_add
+ *
+ * Attach the callback to the topic filter. *added is set to false if the callback is already attached to the topic filter,
+ * in which case only its user data is updated.
+ */
+/* mqtt_route_add must be protected under mqtt_obj->process_mutex */
+static cy_rslt_t mqtt_route_add( cy_mqtt_object_t *mqtt_obj, const char *filter, uint16_t filter_len,
+                                 cy_mqtt_callback_t callback, void *user_data, bool *added )
+{
+    cy_mqtt_route_node_t *node;
+    cy_mqtt_route_t      *route;
+
+    *added = false;
+    node = mqtt_route_find_node( mqtt_obj, filter, filter_len, true );
+    if( node == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to add the topic filter to the router..!\n" );
+        return CY_RSLT_MODULE_MQTT_NOMEM;
+    }
+
+    for( route = node->routes; route != NULL; route = route->next )
+    {
+        if( route->callback == callback )
+        {
+            route->user_data = user_data;
+            return CY_RSLT_SUCCESS;
+        }
+    }
+
+    route = (cy_mqtt_route_t *)malloc( sizeof( cy_mqtt_route_t ) );
+    if( route == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to add the topic filter to the router..!\n" );
+        mqtt_route_node_free_if_unused( mqtt_obj, node );
+        return CY_RSLT_MODULE_MQTT_NOMEM;
+    }
+    route->callback = callback;
+    route->user_data = user_data;
+    route->next = node->routes;
+    node->routes = route;
+    *added = true;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_route_remove
+ *
+ * Detach the callback from the topic filter. If callback is NULL, all the callbacks of the topic filter are detached.
+ */
+/* mqtt_route_remove must be protected under mqtt_obj->process_mutex */
+static void mqtt_route_remove( cy_mqtt_object_t *mqtt_obj, const char *filter, uint16_t filter_len, cy_mqtt_callback_t callback )
+{
+    cy_mqtt_route_node_t *node;
+    cy_mqtt_route_t      **link;
+    cy_mqtt_route_t      *route;
+
+    node = mqtt_route_find_node( mqtt_obj, filter, filter_len, false );
+    if( node == NULL )
+    {
+        return;
+    }
+
+    link = &(node->routes);
+    while( *link != NULL )
+    {
+        route = *link;
+        if( (callback == NULL) || (route->callback == callback) )
+        {
+            *link = route->next;
+            free( route );
+        }
+        else
+        {
+            link = &(route->next);
+        }
+    }
+
+    mqtt_route_node_free_if_unused( mqtt_obj, node );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_route_free_all
+ *
+ * Free the topic filter trie.
+ */
+/* mqtt_route_free_all must be protected under mqtt_obj->process_mutex */
+static void mqtt_route_free_all( cy_mqtt_object_t *mqtt_obj )
+{
+    cy_mqtt_route_node_t *node = mqtt_obj->routes;
+    cy_mqtt_route_t      *route;
+
+    /* Free the leaves first, so that no stack is needed to walk the trie. */
+    while( node != NULL )
+    {
+        if( node->children != NULL )
+        {
+            node = node->children;
+        }
+        else if( node->single_level != NULL )
+        {
+            node = node->single_level;
+        }
+        else if( node->multi_level != NULL )
+        {
+            node = node->multi_level;
+        }
+        else
+        {
+            while( node->routes != NULL )
+            {
+                route = node->routes;
+                node->routes = route->next;
+                free( route );
+            }
+            mqtt_route_node_free_if_unused( mqtt_obj, node );
+            node = mqtt_obj->routes;
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_route_call_visit
+ *
+ * Route visit function calling the callback with the received message.
+ */
+static void mqtt_route_call_visit( const cy_mqtt_route_t *route, void *arg )
+{
+    cy_mqtt_route_call_t *call = (cy_mqtt_route_call_t *)arg;
+
+    route->callback( call->handle, *(call->event), route->user_data );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_route_call_node
+ *
+ * Call visit for the callbacks of the topic filter ending at the node. Returns the number of callbacks visited.
+ */
+static uint32_t mqtt_route_call_node( const cy_mqtt_route_node_t *node, cy_mqtt_route_visit_t visit, void *arg )
+{
+    const cy_mqtt_route_t *route;
+    uint32_t              count = 0;
+
+    if( node == NULL )
+    {
+        return 0;
+    }
+
+    for( route = node->routes; route != NULL; route = route->next )
+    {
+        visit( route, arg );
+        count++;
+    }
+
+    return count;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_route_match
+ *
+ * Call visit for the callbacks of the topic filters below the node that match the topic from the topic level at offset.
+ * Returns the number of callbacks visited.
+ */
+static uint32_t mqtt_route_match( const cy_mqtt_route_node_t *node, const char *topic, uint16_t topic_len,
+                                  uint16_t offset, cy_mqtt_route_visit_t visit, void *arg )
+{
+    const cy_mqtt_route_node_t *child;
+    uint32_t                   count = 0;
+    uint16_t                   end = offset;
+    bool                       wildcards;
+
+    while( (end < topic_len) && (topic[ end ] != '/') )
+    {
+        end++;
+    }
+
+    /* Wildcards at the first level do not match topic names starting with '$'. */
+    wildcards = ( (offset > 0) || (topic_len == 0) || (topic[ 0 ] != '$') );
+
+    if( wildcards == true )
+    {
+        count += mqtt_route_call_node( node->multi_level, visit, arg );
+    }
+
+    for( child = node->children; child != NULL; child = child->sibling )
+    {
+        if( (child->level_len == end - offset) && (memcmp( child->level, &(topic[ offset ]), end - offset ) == 0) )
+        {
+            break;
+        }
+    }
+
+    if( end < topic_len )
+    {
+        if( child != NULL )
+        {
+            count += mqtt_route_match( child, topic, topic_len, end + 1, visit, arg );
+        }
+        if( (wildcards == true) && (node->single_level != NULL) )
+        {
+            count += mqtt_route_match( node->single_level, topic, topic_len, end + 1, visit, arg );
+        }
+    }
+    else
+    {
+        /* "sport/#" also matches "sport". */
+        if( child != NULL )
+        {
+            count += mqtt_route_call_node( child, visit, arg );
+            count += mqtt_route_call_node( child->multi_level, visit, arg );
+        }
+        if( (wildcards == true) && (node->single_level != NULL) )
+        {
+            count += mqtt_route_call_node( node->single_level, visit, arg );
+            count += mqtt_route_call_node( node->single_level->multi_level, visit, arg );
+        }
+    }
+
+    return count;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/* mqtt_find_outgoing_publish must be protected under mqtt_obj->process_mutex */
+static uint16_t mqtt_find_outgoing_publish( cy_mqtt_object_t *mqtt_obj, uint16_t packetid )
+{
+    uint16_t index;
+
+    if( (mqtt_obj->pub_hash_buckets == NULL) || (packetid == MQTT_PACKET_ID_INVALID) )
+    {
+        return CY_MQTT_PUB_INDEX_INVALID;
+    }
+
+    index = mqtt_obj->pub_hash_buckets[ packetid & mqtt_obj->pub_hash_mask ];
+    while( (index != CY_MQTT_PUB_INDEX_INVALID) && (mqtt_obj->outgoing_pub_packets[ index ].packetid != packetid) )
+    {
+        index = mqtt_obj->outgoing_pub_packets[ index ].next;
+    }
+    return index;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_release_publish_state
+ *
+ * Remove the record of an outgoing PUBLISH packet that was never acknowledged from the core library, so that
+ * abandoned packets do not fill the MQTT_STATE_ARRAY_MAX_COUNT records and are not resent on a resumed session.
+ * The records of QoS2 packets acknowledged by PUBREC are kept, as the core library completes the PUBREL flow.
+ * A PUBACK or PUBREC received later for the packet ID is reported as an error by MQTT_ProcessLoop and ignored.
+ */
+/* mqtt_release_publish_state must be protected under mqtt_obj->process_mutex */
+static void mqtt_release_publish_state( cy_mqtt_object_t *mqtt_obj, uint16_t packetid )
+{
+    MQTTPubAckInfo_t *record;
+    size_t           i;
+
+    for( i = 0; i < MQTT_STATE_ARRAY_MAX_COUNT; i++ )
+    {
+        record = &(mqtt_obj->mqtt_context.outgoingPublishRecords[ i ]);
+        if( record->packetId != packetid )
+        {
+            continue;
+        }
+        if( (record->publishState == MQTTPublishSend) || (record->publishState == MQTTPubAckPending) ||
+            (record->publishState == MQTTPubRecPending) )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nReleasing the state of unacknowledged PUBLISH with packet id %u.\n", packetid );
+            record->packetId = MQTT_PACKET_ID_INVALID;
+            record->qos = MQTTQoS0;
+            record->publishState = MQTTStateNull;
+        }
+        break;
+    }
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/* mqtt_cleanup_outgoing_publish must be protected under mqtt_obj->process_mutex */
+static cy_rslt_t mqtt_cleanup_outgoing_publish( cy_mqtt_object_t *mqtt_obj, uint16_t index )
+{
+    uint16_t *link;
+
+    if( (index >= mqtt_obj->pub_window_size) || (mqtt_obj->outgoing_pub_packets[ index ].packetid == MQTT_PACKET_ID_INVALID) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Bad arguments to mqtt_cleanup_outgoing_publish.\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    /* Unlink the entry from its packet ID hash chain. */
+    link = &(mqtt_obj->pub_hash_buckets[ mqtt_obj->outgoing_pub_packets[ index ].packetid & mqtt_obj->pub_hash_mask ]);
+    while( (*link != CY_MQTT_PUB_INDEX_INVALID) && (*link != index) )
+    {
+        link = &(mqtt_obj->outgoing_pub_packets[ *link ].next);
+    }
+    if( *link == index )
+    {
+        *link = mqtt_obj->outgoing_pub_packets[ index ].next;
+    }
+
+    if( mqtt_obj->outgoing_pub_packets[ index ].ack_received == false )
+    {
+        mqtt_release_publish_state( mqtt_obj, mqtt_obj->outgoing_pub_packets[ index ].packetid );
+    }
+
+    if( mqtt_obj->outgoing_pub_packets[ index ].compressed_payload != NULL )
+    {
+        free( mqtt_obj->outgoing_pub_packets[ index ].compressed_payload );
+    }
+
+    /* Clear the outgoing PUBLISH packet and return it to the free list. */
+    ( void ) memset( &( mqtt_obj->outgoing_pub_packets[ index ] ), 0x00, sizeof( mqtt_obj->outgoing_pub_packets[ index ] ) );
+    mqtt_obj->outgoing_pub_packets[ index ].next = mqtt_obj->pub_free_head;
+    mqtt_obj->pub_free_head = index;
+    mqtt_obj->num_outgoing_pubs--;
+    return CY_RSLT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/* mqtt_cleanup_outgoing_publish_with_packet_id must be protected under mqtt_obj->process_mutex */
+static cy_rslt_t mqtt_cleanup_outgoing_publish_with_packet_id( cy_mqtt_object_t *mqtt_obj, uint16_t packetid )
+{
+    cy_rslt_t  result = CY_RSLT_SUCCESS;
+    uint16_t   index;
+
+    if( (mqtt_obj == NULL) || (packetid == MQTT_PACKET_ID_INVALID) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Bad arguments to mqtt_cleanup_outgoing_publish_with_packet_id.\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    index = mqtt_find_outgoing_publish( mqtt_obj, packetid );
+    if( index != CY_MQTT_PUB_INDEX_INVALID )
+    {
+        result = mqtt_cleanup_outgoing_publish( mqtt_obj, index );
+        if( result != CY_RSLT_SUCCESS )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_cleanup_outgoing_publish failed with Error : [0x%X] \n", (unsigned int)result );
+            return result;
+        }
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nCleaned up outgoing PUBLISH packet with packet id %u.\n", packetid );
+    }
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/* mqtt_complete_async_publish must be protected under mqtt_obj->process_mutex */
+static void mqtt_complete_async_publish( cy_mqtt_object_t *mqtt_obj, uint16_t index, cy_mqtt_publish_status_t status )
+{
+    cy_mqtt_pubpack_t *pubpack = &(mqtt_obj->outgoing_pub_packets[ index ]);
+
+    if( pubpack->completed == true )
+    {
+        return;
+    }
+
+    /* Append to the completion list, in the order in which the final status became known. */
+    pubpack->completed = true;
+    pubpack->status = status;
+    pubpack->next_completed = CY_MQTT_PUB_INDEX_INVALID;
+    if( mqtt_obj->async_completed_tail == CY_MQTT_PUB_INDEX_INVALID )
+    {
+        mqtt_obj->async_completed_head = index;
+    }
+    else
+    {
+        mqtt_obj->outgoing_pub_packets[ mqtt_obj->async_completed_tail ].next_completed = index;
+    }
+    mqtt_obj->async_completed_tail = index;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_handle_publish_ack
+ *
+ * Update the outgoing PUBLISH packet on receiving PUBACK, PUBREC or PUBCOMP.
+ * The caller of cy_mqtt_publish is woken up on PUBACK/PUBREC and cleans up its own packet. Packets published by
+ * cy_mqtt_publish_async are kept until PUBACK/PUBCOMP and their completion is reported by mqtt_event_processing_thread.
+ */
+static void mqtt_handle_publish_ack( cy_mqtt_object_t *mqtt_obj, uint16_t packetid, uint8_t ack_type )
+{
+    uint16_t           index;
+    cy_mqtt_pubpack_t  *pubpack = NULL;
+
+    index = mqtt_find_outgoing_publish( mqtt_obj, packetid );
+    if( index == CY_MQTT_PUB_INDEX_INVALID )
+    {
+        return;
+    }
+    pubpack = &(mqtt_obj->outgoing_pub_packets[ index ]);
+
+    if( pubpack->async == false )
+    {
+        if( ack_type != MQTT_PACKET_TYPE_PUBCOMP )
+        {
+            pubpack->ack_received = true;
+            if( pubpack->ack_waiting == true )
+            {
+                (void)cy_rtos_set_semaphore( &(mqtt_obj->pub_ack_sems[ index ]), false );
+            }
+        }
+        return;
+    }
+
+    if( ack_type == MQTT_PACKET_TYPE_PUBREC )
+    {
+        /* QoS2 publish completes on PUBCOMP. PUBREL is sent and resent by the core library. */
+        pubpack->ack_received = true;
+        return;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nAsync PUBLISH with packet id %u acknowledged.\n", packetid );
+    mqtt_complete_async_publish( mqtt_obj, index, CY_MQTT_PUBLISH_STATUS_ACKED );
+    mqtt_queue_async_publish_event( mqtt_obj, 0 );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+static cy_rslt_t mqtt_update_suback_status( cy_mqtt_object_t *mqtt_obj, MQTTPacketInfo_t *packet_info )
+{
+    uint8_t        *payload = NULL, i = 0;
+    size_t         num_of_subscriptions = 0;
+    MQTTStatus_t   mqttStatus = MQTTSuccess;
+
+    mqttStatus = MQTT_GetSubAckStatusCodes( packet_info, &payload, &num_of_subscriptions );
+    if( (mqttStatus != MQTTSuccess) || (num_of_subscriptions != mqtt_obj->num_of_subs_in_req) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n MQTT_GetSubAckStatusCodes failed with status = %s.\n", MQTT_Status_strerror( mqttStatus ) );
+        /* SubAckStatusCodes are not available for outstanding subscription messages waiting for acknowledgment. So Setting num_of_subs_in_req to 0.*/
+        mqtt_obj->num_of_subs_in_req = 0;
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+    ( void ) mqttStatus;
+
+    for( i = 0; i < mqtt_obj->num_of_subs_in_req; i++ )
+    {
+        mqtt_obj->sub_ack_status[i] = (MQTTSubAckStatus_t)payload[ i ];
+    }
+    /* All outstanding subscription message acknowledgment status is updated. So Setting num_of_subs_in_req to 0. */
+    mqtt_obj->num_of_subs_in_req = 0;
+    return CY_RSLT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/* mqtt_reserve_outgoing_publish must be protected under mqtt_obj->process_mutex */
+static uint16_t mqtt_reserve_outgoing_publish( cy_mqtt_object_t *mqtt_obj )
+{
+    uint16_t  index;
+    uint16_t  packetid;
+    uint16_t  *bucket;
+
+    /* A free entry is taken from the head of the free list. */
+    index = mqtt_obj->pub_free_head;
+    if( index != CY_MQTT_PUB_INDEX_INVALID )
+    {
+        mqtt_obj->pub_free_head = mqtt_obj->outgoing_pub_packets[ index ].next;
+
+        /* Skip the packet IDs still held by older entries after the 16-bit packet ID wraps around. */
+        do
+        {
+            packetid = MQTT_GetPacketId( &(mqtt_obj->mqtt_context) );
+        } while( mqtt_find_outgoing_publish( mqtt_obj, packetid ) != CY_MQTT_PUB_INDEX_INVALID );
+
+        bucket = &(mqtt_obj->pub_hash_buckets[ packetid & mqtt_obj->pub_hash_mask ]);
+        mqtt_obj->outgoing_pub_packets[ index ].packetid = packetid;
+        mqtt_obj->outgoing_pub_packets[ index ].next = *bucket;
+        *bucket = index;
+        mqtt_obj->num_outgoing_pubs++;
+    }
+    return index;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+static cy_rslt_t mqtt_get_next_free_index_for_publish( cy_mqtt_object_t *mqtt_obj, uint16_t *pindex )
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint16_t  index  = CY_MQTT_PUB_INDEX_INVALID;
+
+    if( (mqtt_obj == NULL) || (pindex == NULL) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to mqtt_get_next_free_index_for_publish.\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_get_next_free_index_for_publish - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        return result;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_get_next_free_index_for_publish - Acquired Mutex %p \n", mqtt_obj->process_mutex );
+
+    index = mqtt_reserve_outgoing_publish( mqtt_obj );
+    if( index != CY_MQTT_PUB_INDEX_INVALID )
+    {
+        *pindex = index;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_get_next_free_index_for_publish - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+    result = cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", (unsigned int)result );
+
+        return result;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_get_next_free_index_for_publish - Released Mutex %p \n", mqtt_obj->process_mutex );
+
+    if( index == CY_MQTT_PUB_INDEX_INVALID )
+    {
+        result = CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+static cy_rslt_t mqtt_cleanup_outgoing_publishes( cy_mqtt_object_t *mqtt_obj )
+{
+    uint16_t           index;
+    bool               async_pending = false;
+    cy_mqtt_pubpack_t  *pubpack = NULL;
+
+    if( mqtt_obj == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to mqtt_cleanup_outgoing_publishes.\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    /* Clean up all outgoing PUBLISH packets. Asynchronous publishes are kept until
+     * mqtt_event_processing_thread reports the session loss to the application, and
+     * packets of cy_mqtt_publish callers still waiting are cleaned up by those callers. */
+    for( index = 0; index < mqtt_obj->pub_window_size; index++ )
+    {
+        pubpack = &(mqtt_obj->outgoing_pub_packets[ index ]);
+        if( pubpack->packetid == MQTT_PACKET_ID_INVALID )
+        {
+            continue;
+        }
+        if( pubpack->async == true )
+        {
+            mqtt_complete_async_publish( mqtt_obj, index, CY_MQTT_PUBLISH_STATUS_SESSION_LOST );
+            async_pending = true;
+        }
+        else if( pubpack->ack_waiting == false )
+        {
+            (void)mqtt_cleanup_outgoing_publish( mqtt_obj, index );
+        }
+    }
+
+    if( async_pending == true )
+    {
+        mqtt_queue_async_publish_event( mqtt_obj, CY_MQTT_EVENT_QUEUE_TIMEOUT_IN_MSEC );
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/* mqtt_refresh_async_publish_deadlines must be protected under mqtt_obj->process_mutex */
+static void mqtt_refresh_async_publish_deadlines( cy_mqtt_object_t *mqtt_obj )
+{
+    uint16_t index;
+    bool     async_pending = false;
+    uint32_t deadline = Clock_GetTimeMs() + CY_MQTT_ASYNC_PUBLISH_ACK_TIMEOUT_MS;
+
+    /* The acknowledgment timeout is monitored only while the session is established.
+     * So restart the timeout of all the pending asynchronous publishes on session resumption. */
+    for( index = 0; index < mqtt_obj->pub_window_size; index++ )
+    {
+        if( (mqtt_obj->outgoing_pub_packets[ index ].async == true) &&
+            (mqtt_obj->outgoing_pub_packets[ index ].completed == false) &&
+            (mqtt_obj->outgoing_pub_packets[ index ].packetid != MQTT_PACKET_ID_INVALID) )
+        {
+            mqtt_obj->outgoing_pub_packets[ index ].ack_deadline_ms = deadline;
+            async_pending = true;
+        }
+    }
+
+    if( async_pending == true )
+    {
+        (void)start_async_ack_timer( mqtt_obj, CY_MQTT_ASYNC_PUBLISH_ACK_TIMEOUT_MS, true );
+    }
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_transport_send_all
+ *
+ * Send the given buffer with the transport interface of the MQTT context. The transport send is repeated
+ * until all the bytes are sent, or no byte is sent for MQTT_SEND_RETRY_TIMEOUT_MS. mqtt_obj->tx_mutex is held
+ * for the whole write, so that the bytes of another packet are not written in between.
+ */
+/* mqtt_transport_send_all must be protected under mqtt_obj->process_mutex, or mqtt_obj->tx_mutex */
+static MQTTStatus_t mqtt_transport_send_all( cy_mqtt_object_t *mqtt_obj, const uint8_t *buffer, size_t length )
+{
+    MQTTContext_t  *context = &(mqtt_obj->mqtt_context);
+    MQTTStatus_t   mqttStatus = MQTTSuccess;
+    int32_t        bytes_sent = 0;
+    size_t         total_sent = 0;
+    uint32_t       last_send_time = Clock_GetTimeMs();
+
+    (void)cy_rtos_get_mutex( &(mqtt_obj->tx_mutex), CY_RTOS_NEVER_TIMEOUT );
+    while( total_sent < length )
+    {
+        bytes_sent = context->transportInterface.send( context->transportInterface.pNetworkContext,
+                                                       &(buffer[ total_sent ]), length - total_sent );
+        if( bytes_sent < 0 )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nTransport send of %u bytes failed.\n", (unsigned int)length );
+            mqttStatus = MQTTSendFailed;
+            break;
+        }
+        else if( bytes_sent > 0 )
+        {
+            total_sent += (size_t)bytes_sent;
+            last_send_time = Clock_GetTimeMs();
+        }
+        else if( (Clock_GetTimeMs() - last_send_time) > MQTT_SEND_RETRY_TIMEOUT_MS )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nTransport send of %u bytes timed out.\n", (unsigned int)length );
+            mqttStatus = MQTTSendFailed;
+            break;
+        }
+    }
+    (void)cy_rtos_set_mutex( &(mqtt_obj->tx_mutex) );
+
+    return mqttStatus;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_send_serialized_publish
+ *
+ * Send an outgoing PUBLISH packet whose first serialized->length bytes are serialized in mqtt_obj->tx_buffer.
+ * If the topic name did not fit in the transmit buffer, it is sent next directly from its memory, followed by the
+ * packet ID. Unless the payload is part of the serialized bytes, it is sent afterwards directly from the application
+ * memory, segment by segment for cy_mqtt_publish_vectored.
+ *
+ * If pubpack->release_on_send is set, mqtt_obj->process_mutex is released while the packet is written and held
+ * again on return, so that received packets are processed in the meantime; mqtt_obj->tx_mutex keeps the other
+ * writers out. The state of the packet is therefore moved to waiting for the acknowledgment before the write.
+ *
+ * The caller takes mqtt_obj->tx_mutex before serializing into mqtt_obj->tx_buffer, so that no other writer reuses
+ * the buffer before it is sent. It is released here, before mqtt_obj->process_mutex is taken again.
+ */
+/* mqtt_send_serialized_publish must be protected under mqtt_obj->process_mutex and mqtt_obj->tx_mutex */
+static MQTTStatus_t mqtt_send_serialized_publish( cy_mqtt_object_t *mqtt_obj, cy_mqtt_pubpack_t *pubpack,
+                                                  const cy_mqtt_serialized_publish_t *serialized )
+{
+    MQTTContext_t       *context = &(mqtt_obj->mqtt_context);
+    MQTTStatus_t        mqttStatus = MQTTSuccess;
+    MQTTPublishState_t  publish_state = MQTTStateNull;
+    const cy_mqtt_payload_segment_t *segments = pubpack->segments;
+    uint16_t            segment_count = pubpack->segment_count;
+    const void          *payload = pubpack->pubinfo.pPayload;
+    size_t              payload_len = pubpack->pubinfo.payloadLength;
+    bool                release = pubpack->release_on_send;
+    uint8_t             packet_id[ sizeof( uint16_t ) ];
+    size_t              packet_id_len = 0;
+    uint16_t            i;
+
+    pubpack->release_on_send = false;
+
+    if( pubpack->pubinfo.qos != MQTTQoS0 )
+    {
+        /* On a resend, the state of the packet is already reserved in the core library. */
+        mqttStatus = MQTT_ReserveState( context, pubpack->packetid, pubpack->pubinfo.qos );
+        if( mqttStatus == MQTTStateCollision )
+        {
+            mqttStatus = MQTTSuccess;
+        }
+        if( mqttStatus != MQTTSuccess )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT_ReserveState failed with status = %s.\n", MQTT_Status_strerror( mqttStatus ) );
+            (void)cy_rtos_set_mutex( &(mqtt_obj->tx_mutex) );
+            return mqttStatus;
+        }
+
+        /* If the write fails, the connection is closed and the packet is resent as a duplicate on the resumed session. */
+        mqttStatus = MQTT_UpdateStatePublish( context, pubpack->packetid, MQTT_SEND, pubpack->pubinfo.qos, &publish_state );
+        if( mqttStatus != MQTTSuccess )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT_UpdateStatePublish failed with status = %s.\n", MQTT_Status_strerror( mqttStatus ) );
+            (void)cy_rtos_set_mutex( &(mqtt_obj->tx_mutex) );
+            return mqttStatus;
+        }
+
+        packet_id[ 0 ] = (uint8_t)(pubpack->packetid >> 8);
+        packet_id[ 1 ] = (uint8_t)(pubpack->packetid & 0xFFU);
+        packet_id_len = sizeof( packet_id );
+    }
+
+    if( release == true )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_send_serialized_publish - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+        (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    }
+
+    mqttStatus = mqtt_transport_send_all( mqtt_obj, mqtt_obj->tx_buffer, serialized->length );
+    if( (serialized->topic != NULL) && (mqttStatus == MQTTSuccess) )
+    {
+        mqttStatus = mqtt_transport_send_all( mqtt_obj, serialized->topic, serialized->topic_len );
+        if( (packet_id_len > 0) && (mqttStatus == MQTTSuccess) )
+        {
+            mqttStatus = mqtt_transport_send_all( mqtt_obj, packet_id, packet_id_len );
+        }
+    }
+    if( serialized->payload_buffered == false )
+    {
+        if( segments != NULL )
+        {
+            for( i = 0; (i < segment_count) && (mqttStatus == MQTTSuccess); i++ )
+            {
+                mqttStatus = mqtt_transport_send_all( mqtt_obj, (const uint8_t *)segments[ i ].data, segments[ i ].data_len );
+            }
+        }
+        else if( mqttStatus == MQTTSuccess )
+        {
+            mqttStatus = mqtt_transport_send_all( mqtt_obj, (const uint8_t *)payload, payload_len );
+        }
+    }
+
+    /* tx_mutex is released first, as it is never held while waiting for process_mutex. */
+    (void)cy_rtos_set_mutex( &(mqtt_obj->tx_mutex) );
+    if( release == true )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_send_serialized_publish - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+        (void)cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_send_serialized_publish - Acquired Mutex %p \n", mqtt_obj->process_mutex );
+    }
+
+    if( mqttStatus == MQTTSuccess )
+    {
+        context->lastPacketTime = Clock_GetTimeMs();
+    }
+
+    return mqttStatus;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_serialize_fixed_header
+ *
+ * Serialize the header byte and the remaining length of a PUBLISH packet into buffer, which must have room for
+ * CY_MQTT_MAX_FIXED_HEADER_SIZE bytes. Returns the number of bytes serialized.
+ */
+static size_t mqtt_serialize_fixed_header( uint8_t *buffer, uint8_t header, size_t remaining_length )
+{
+    size_t   length = 0;
+    uint8_t  encoded_byte;
+
+    buffer[ length++ ] = header;
+    do
+    {
+        encoded_byte = (uint8_t)(remaining_length % 128U);
+        remaining_length = remaining_length / 128U;
+        if( remaining_length > 0 )
+        {
+            encoded_byte |= 0x80U;
+        }
+        buffer[ length++ ] = encoded_byte;
+    } while( remaining_length > 0 );
+
+    return length;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_serialize_publish_header
+ *
+ * Serialize the header of the PUBLISH packet of a message into the transmit buffer. If the header does not fit
+ * because the topic name is too long, only the fixed header and the topic name length are serialized, and the
+ * topic name is sent from the memory of the message.
+ */
+/* mqtt_serialize_publish_header must be protected under mqtt_obj->process_mutex and mqtt_obj->tx_mutex */
+static MQTTStatus_t mqtt_serialize_publish_header( cy_mqtt_object_t *mqtt_obj, cy_mqtt_pubpack_t *pubpack, size_t remaining_length,
+                                                   cy_mqtt_serialized_publish_t *serialized )
+{
+    MQTTStatus_t        mqttStatus = MQTTSuccess;
+    MQTTFixedBuffer_t   tx_buffer;
+    size_t              header_size = 0;
+    uint8_t             header;
+
+    serialized->topic = NULL;
+    serialized->topic_len = 0;
+    serialized->payload_buffered = false;
+
+    if( (CY_MQTT_MAX_FIXED_HEADER_SIZE + sizeof( uint16_t ) + pubpack->pubinfo.topicNameLength + sizeof( uint16_t )) <= sizeof( mqtt_obj->tx_buffer ) )
+    {
+        tx_buffer.pBuffer = mqtt_obj->tx_buffer;
+        tx_buffer.size = sizeof( mqtt_obj->tx_buffer );
+        mqttStatus = MQTT_SerializePublishHeader( &(pubpack->pubinfo), pubpack->packetid, remaining_length,
+                                                  &tx_buffer, &header_size );
+        if( mqttStatus != MQTTSuccess )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT_SerializePublishHeader failed with status = %s.\n", MQTT_Status_strerror( mqttStatus ) );
+            return mqttStatus;
+        }
+        serialized->length = header_size;
+        return MQTTSuccess;
+    }
+
+    header = (uint8_t)(CY_MQTT_PUBLISH_PACKET_TYPE | ((uint8_t)pubpack->pubinfo.qos << 1));
+    if( pubpack->pubinfo.retain == true )
+    {
+        header |= CY_MQTT_PUBLISH_FLAG_RETAIN;
+    }
+    if( pubpack->pubinfo.dup == true )
+    {
+        header |= CY_MQTT_PUBLISH_FLAG_DUP;
+    }
+    header_size = mqtt_serialize_fixed_header( mqtt_obj->tx_buffer, header, remaining_length );
+    mqtt_obj->tx_buffer[ header_size++ ] = (uint8_t)(pubpack->pubinfo.topicNameLength >> 8);
+    mqtt_obj->tx_buffer[ header_size++ ] = (uint8_t)(pubpack->pubinfo.topicNameLength & 0xFFU);
+
+    serialized->length = header_size;
+    serialized->topic = (const uint8_t *)pubpack->pubinfo.pTopicName;
+    serialized->topic_len = pubpack->pubinfo.topicNameLength;
+    return MQTTSuccess;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_serialize_vectored_publish
+ *
+ * Serialize the PUBLISH packet of cy_mqtt_publish_vectored. Only the packet header is serialized into the transmit
+ * buffer; the payload segments are sent one after the other directly from the application memory.
+ */
+/* mqtt_serialize_vectored_publish must be protected under mqtt_obj->process_mutex and mqtt_obj->tx_mutex */
+static MQTTStatus_t mqtt_serialize_vectored_publish( cy_mqtt_object_t *mqtt_obj, cy_mqtt_pubpack_t *pubpack,
+                                                     cy_mqtt_serialized_publish_t *serialized )
+{
+    MQTTStatus_t        mqttStatus = MQTTSuccess;
+    size_t              remaining_length = 0;
+    size_t              packet_size = 0;
+
+    /* The payload length of pubinfo is the total length of the segments. */
+    mqttStatus = MQTT_GetPublishPacketSize( &(pubpack->pubinfo), &remaining_length, &packet_size );
+    if( mqttStatus != MQTTSuccess )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT_GetPublishPacketSize failed with status = %s.\n", MQTT_Status_strerror( mqttStatus ) );
+        return mqttStatus;
+    }
+
+    return mqtt_serialize_publish_header( mqtt_obj, pubpack, remaining_length, serialized );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_serialize_contiguous_publish
+ *
+ * Serialize the PUBLISH packet of a message with a contiguous payload. The header is serialized into the transmit
+ * buffer, followed by the payload if it fits, so that small messages are sent with a single transport write.
+ */
+/* mqtt_serialize_contiguous_publish must be protected under mqtt_obj->process_mutex and mqtt_obj->tx_mutex */
+static MQTTStatus_t mqtt_serialize_contiguous_publish( cy_mqtt_object_t *mqtt_obj, cy_mqtt_pubpack_t *pubpack,
+                                                       cy_mqtt_serialized_publish_t *serialized )
+{
+    MQTTStatus_t        mqttStatus = MQTTSuccess;
+    size_t              remaining_length = 0;
+    size_t              packet_size = 0;
+
+    mqttStatus = MQTT_GetPublishPacketSize( &(pubpack->pubinfo), &remaining_length, &packet_size );
+    if( mqttStatus != MQTTSuccess )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT_GetPublishPacketSize failed with status = %s.\n", MQTT_Status_strerror( mqttStatus ) );
+        return mqttStatus;
+    }
+
+    mqttStatus = mqtt_serialize_publish_header( mqtt_obj, pubpack, remaining_length, serialized );
+    if( mqttStatus != MQTTSuccess )
+    {
+        return mqttStatus;
+    }
+
+    if( (serialized->topic == NULL) && (packet_size <= sizeof( mqtt_obj->tx_buffer )) )
+    {
+        if( pubpack->pubinfo.payloadLength > 0 )
+        {
+            memcpy( &(mqtt_obj->tx_buffer[ serialized->length ]), pubpack->pubinfo.pPayload, pubpack->pubinfo.payloadLength );
+        }
+        serialized->length = packet_size;
+        serialized->payload_buffered = true;
+    }
+
+    return MQTTSuccess;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_serialize_topic_publish
+ *
+ * Serialize the PUBLISH packet of cy_mqtt_publish_topic. The fixed header byte and the encoded topic name are
+ * copied from the registered topic, so only the remaining length, packet ID and payload are filled in. If the
+ * encoded topic name does not fit in the transmit buffer, it is sent from the registered topic instead.
+ */
+/* mqtt_serialize_topic_publish must be protected under mqtt_obj->process_mutex and mqtt_obj->tx_mutex */
+static MQTTStatus_t mqtt_serialize_topic_publish( cy_mqtt_object_t *mqtt_obj, cy_mqtt_pubpack_t *pubpack,
+                                                  cy_mqtt_serialized_publish_t *serialized )
+{
+    const cy_mqtt_topic_object_t *topic_obj = pubpack->topic_obj;
+    uint8_t                      *buffer = mqtt_obj->tx_buffer;
+    size_t                       remaining_length;
+    size_t                       length = 0;
+    uint8_t                      header;
+
+    remaining_length = topic_obj->encoded_len + pubpack->pubinfo.payloadLength;
+    if( pubpack->pubinfo.qos != MQTTQoS0 )
+    {
+        remaining_length += sizeof( uint16_t );
+    }
+    if( remaining_length > CY_MQTT_MAX_REMAINING_LENGTH )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nPUBLISH packet of %u bytes is too large..!\n", (unsigned int)remaining_length );
+        return MQTTBadParameter;
+    }
+
+    header = (pubpack->pubinfo.dup == true) ? (uint8_t)(topic_obj->header | CY_MQTT_PUBLISH_FLAG_DUP) : topic_obj->header;
+    length = mqtt_serialize_fixed_header( buffer, header, remaining_length );
+    serialized->payload_buffered = false;
+
+    if( (CY_MQTT_MAX_FIXED_HEADER_SIZE + topic_obj->encoded_len + sizeof( uint16_t )) > sizeof( mqtt_obj->tx_buffer ) )
+    {
+        serialized->length = length;
+        serialized->topic = topic_obj->encoded;
+        serialized->topic_len = topic_obj->encoded_len;
+        return MQTTSuccess;
+    }
+
+    memcpy( &(buffer[ length ]), topic_obj->encoded, topic_obj->encoded_len );
+    length += topic_obj->encoded_len;
+    if( pubpack->pubinfo.qos != MQTTQoS0 )
+    {
+        buffer[ length++ ] = (uint8_t)(pubpack->packetid >> 8);
+        buffer[ length++ ] = (uint8_t)(pubpack->packetid & 0xFFU);
+    }
+    serialized->topic = NULL;
+    serialized->topic_len = 0;
+
+    /* Small payloads are sent with the header in a single transport write. */
+    if( (length + pubpack->pubinfo.payloadLength) <= sizeof( mqtt_obj->tx_buffer ) )
+    {
+        if( pubpack->pubinfo.payloadLength > 0 )
+        {
+            memcpy( &(buffer[ length ]), pubpack->pubinfo.pPayload, pubpack->pubinfo.payloadLength );
+            length += pubpack->pubinfo.payloadLength;
+        }
+        serialized->payload_buffered = true;
+    }
+
+    serialized->length = length;
+    return MQTTSuccess;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_send_publish
+ *
+ * Serialize an outgoing PUBLISH packet into mqtt_obj->tx_buffer and send it. mqtt_obj->tx_mutex is taken before
+ * the packet is serialized, as tx_buffer is shared by all the writers of the MQTT object, including the writers
+ * that have released mqtt_obj->process_mutex.
+ */
+/* mqtt_send_publish must be protected under mqtt_obj->process_mutex */
+static MQTTStatus_t mqtt_send_publish( cy_mqtt_object_t *mqtt_obj, cy_mqtt_pubpack_t *pubpack )
+{
+    MQTTStatus_t                  mqttStatus = MQTTSuccess;
+    cy_mqtt_serialized_publish_t  serialized;
+
+    (void)cy_rtos_get_mutex( &(mqtt_obj->tx_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( pubpack->segments != NULL )
+    {
+        mqttStatus = mqtt_serialize_vectored_publish( mqtt_obj, pubpack, &serialized );
+    }
+    else if( pubpack->topic_obj != NULL )
+    {
+        mqttStatus = mqtt_serialize_topic_publish( mqtt_obj, pubpack, &serialized );
+    }
+    else
+    {
+        mqttStatus = mqtt_serialize_contiguous_publish( mqtt_obj, pubpack, &serialized );
+    }
+
+    if( mqttStatus != MQTTSuccess )
+    {
+        pubpack->release_on_send = false;
+        (void)cy_rtos_set_mutex( &(mqtt_obj->tx_mutex) );
+        return mqttStatus;
+    }
+
+    return mqtt_send_serialized_publish( mqtt_obj, pubpack, &serialized );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+static cy_rslt_t mqtt_handle_publish_resend( cy_mqtt_object_t *mqtt_obj )
+{
+    cy_rslt_t         result = CY_RSLT_SUCCESS;
+    MQTTStatus_t      mqttStatus = MQTTSuccess;
+    uint16_t          index = 0U;
+    MQTTStateCursor_t cursor = MQTT_STATE_CURSOR_INITIALIZER;
+    uint16_t          packetid_to_resend = MQTT_PACKET_ID_INVALID;
+
+    /* MQTT_PublishToResend() provides a packet ID of the next PUBLISH packet
+     * that should be resent. In accordance with the MQTT v3.1.1 spec,
+     * MQTT_PublishToResend() preserves the ordering of when the original
+     * PUBLISH packets were sent. The associated packet is looked up in the
+     * inflight window by packet ID. */
+    packetid_to_resend = MQTT_PublishToResend( &(mqtt_obj->mqtt_context), &cursor );
+    while( packetid_to_resend != MQTT_PACKET_ID_INVALID )
+    {
+        index = mqtt_find_outgoing_publish( mqtt_obj, packetid_to_resend );
+        if( index == CY_MQTT_PUB_INDEX_INVALID )
+        {
+            /* The packets are released from the core library when they are removed from the inflight window,
+             * so this is a record without a message to resend. Release it instead of failing the connection. */
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_WARNING, "\nPacket id %u requires resend, but was not found in outgoing_pub_packets. Releasing it.\n",
+                             packetid_to_resend );
+            mqtt_release_publish_state( mqtt_obj, packetid_to_resend );
+        }
+        else if( mqtt_obj->outgoing_pub_packets[ index ].pubinfo.qos != MQTTQoS0 )
+        {
+            mqtt_obj->outgoing_pub_packets[ index ].pubinfo.dup = true;
+
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nSending duplicate PUBLISH with packet id %u.\n",
+                             mqtt_obj->outgoing_pub_packets[ index ].packetid );
+            mqttStatus = mqtt_send_publish( mqtt_obj, &(mqtt_obj->outgoing_pub_packets[ index ]) );
+            if( mqttStatus != MQTTSuccess )
+            {
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nSending duplicate PUBLISH for packet id %u failed with status %s.\n",
+                                 mqtt_obj->outgoing_pub_packets[ index ].packetid, MQTT_Status_strerror( mqttStatus ) );
+                result = CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
+            }
+            else
+            {
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nSent duplicate PUBLISH successfully for packet id %u.\n\n",
+                                 mqtt_obj->outgoing_pub_packets[ index ].packetid );
+            }
+        }
+        else
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nResending PUBLISH packet id %u. is not required as its having QoS0\n\n",
+                             mqtt_obj->outgoing_pub_packets[ index ].packetid );
+        }
+
+        /* Get the next packetID to be resent. */
+        packetid_to_resend = MQTT_PublishToResend( &(mqtt_obj->mqtt_context), &cursor );
+    }
+
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_flush_publish_batch
+ *
+ * Send the PUBLISH packets serialized in the network buffer with a single transport write, and move the
+ * QoS1 and QoS2 packets of the write to the state in which the core library waits for their acknowledgment.
+ * A length of 0 discards the packets marked as batched without sending them.
+ */
+/* mqtt_flush_publish_batch must be protected under mqtt_obj->process_mutex */
+static MQTTStatus_t mqtt_flush_publish_batch( cy_mqtt_object_t *mqtt_obj, size_t length,
+                                              const uint16_t *packet_ids, uint16_t count )
+{
+    MQTTContext_t       *context = &(mqtt_obj->mqtt_context);
+    MQTTStatus_t        mqttStatus = MQTTSuccess;
+    MQTTStatus_t        state_status = MQTTSuccess;
+    MQTTPublishState_t  publish_state = MQTTStateNull;
+    cy_mqtt_pubpack_t   *pubpack = NULL;
+    bool                sent = false;
+    uint16_t            i, index;
+
+    mqttStatus = mqtt_transport_send_all( mqtt_obj, context->networkBuffer.pBuffer, length );
+    sent = ( (mqttStatus == MQTTSuccess) && (length > 0) );
+    if( (mqttStatus == MQTTSuccess) && (length > 0) )
+    {
+        context->lastPacketTime = Clock_GetTimeMs();
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nSent PUBLISH batch of %u bytes.\n", (unsigned int)length );
+    }
+
+    for( i = 0; i < count; i++ )
+    {
+        index = mqtt_find_outgoing_publish( mqtt_obj, packet_ids[ i ] );
+        if( (index == CY_MQTT_PUB_INDEX_INVALID) || (mqtt_obj->outgoing_pub_packets[ index ].batched == false) )
+        {
+            continue;
+        }
+        pubpack = &(mqtt_obj->outgoing_pub_packets[ index ]);
+        pubpack->batched = false;
+        if( length > 0 )
+        {
+            /* The packet may have reached the broker even if the write failed part way. */
+            pubpack->pubinfo.dup = true;
+        }
+        if( sent == true )
+        {
+            state_status = MQTT_UpdateStatePublish( context, packet_ids[ i ], MQTT_SEND, pubpack->pubinfo.qos, &publish_state );
+            if( state_status != MQTTSuccess )
+            {
+                /* The batch is failed, so that the packet is sent again as a duplicate by the next round. */
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT_UpdateStatePublish for packet id %u failed with status = %s.\n",
+                                 packet_ids[ i ], MQTT_Status_strerror( state_status ) );
+                mqttStatus = state_status;
+            }
+        }
+    }
+
+    return mqttStatus;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_send_publish_batch
+ *
+ * Serialize the messages of cy_mqtt_publish_batch back to back into the network buffer and send them with
+ * as few transport writes as the network buffer allows. QoS0 messages are sent only in the first round;
+ * on a resend, only the QoS1 and QoS2 messages not yet acknowledged are sent again.
+ */
+/* mqtt_send_publish_batch must be protected under mqtt_obj->process_mutex */
+static MQTTStatus_t mqtt_send_publish_batch( cy_mqtt_object_t *mqtt_obj, cy_mqtt_publish_info_t *pub_msgs,
+                                             const uint16_t *packet_ids, uint16_t count, bool resend )
+{
+    MQTTContext_t      *context = &(mqtt_obj->mqtt_context);
+    MQTTStatus_t       mqttStatus = MQTTSuccess;
+    MQTTPublishInfo_t  qos0_pubinfo;
+    MQTTPublishInfo_t  *pubinfo = NULL;
+    MQTTFixedBuffer_t  fixed_buffer;
+    size_t             remaining_length = 0;
+    size_t             packet_size = 0;
+    size_t             length = 0;
+    uint16_t           i;
+    uint16_t           index = CY_MQTT_PUB_INDEX_INVALID;
+
+    for( i = 0; (i < count) && (mqttStatus == MQTTSuccess); i++ )
+    {
+        if( packet_ids[ i ] == MQTT_PACKET_ID_INVALID )
+        {
+            if( resend == true )
+            {
+                continue;
+            }
+            memset( &qos0_pubinfo, 0x00, sizeof( qos0_pubinfo ) );
+            qos0_pubinfo.qos = MQTTQoS0;
+            qos0_pubinfo.retain = pub_msgs[ i ].retain;
+            qos0_pubinfo.pTopicName = pub_msgs[ i ].topic;
+            qos0_pubinfo.topicNameLength = pub_msgs[ i ].topic_len;
+            qos0_pubinfo.pPayload = pub_msgs[ i ].payload;
+            qos0_pubinfo.payloadLength = pub_msgs[ i ].payload_len;
+            pubinfo = &qos0_pubinfo;
+            index = CY_MQTT_PUB_INDEX_INVALID;
+        }
+        else
+        {
+            index = mqtt_find_outgoing_publish( mqtt_obj, packet_ids[ i ] );
+            if( (index == CY_MQTT_PUB_INDEX_INVALID) || (mqtt_obj->outgoing_pub_packets[ index ].ack_received == true) )
+            {
+                continue;
+            }
+            pubinfo = &(mqtt_obj->outgoing_pub_packets[ index ].pubinfo);
+        }
+
+        mqttStatus = MQTT_GetPublishPacketSize( pubinfo, &remaining_length, &packet_size );
+        if( mqttStatus != MQTTSuccess )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT_GetPublishPacketSize failed with status = %s.\n", MQTT_Status_strerror( mqttStatus ) );
+            break;
+        }
+
+        if( (length + packet_size) > context->networkBuffer.size )
+        {
+            /* Flush the packets serialized so far to make room in the network buffer. */
+            mqttStatus = mqtt_flush_publish_batch( mqtt_obj, length, packet_ids, count );
+            length = 0;
+            if( mqttStatus != MQTTSuccess )
+            {
+                break;
+            }
+        }
+
+        if( packet_size > context->networkBuffer.size )
+        {
+            /* The packet does not fit in the network buffer, so the core library sends
+             * the payload directly from the application memory. */
+            mqttStatus = MQTT_Publish( context, pubinfo, packet_ids[ i ] );
+            if( index != CY_MQTT_PUB_INDEX_INVALID )
+            {
+                pubinfo->dup = true;
+            }
+            continue;
+        }
+
+        if( index != CY_MQTT_PUB_INDEX_INVALID )
+        {
+            /* On a resend, the state of the packet is already reserved in the core library. */
+            mqttStatus = MQTT_ReserveState( context, packet_ids[ i ], pubinfo->qos );
+            if( mqttStatus == MQTTStateCollision )
+            {
+                mqttStatus = MQTTSuccess;
+            }
+            if( mqttStatus != MQTTSuccess )
+            {
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT_ReserveState failed with status = %s.\n", MQTT_Status_strerror( mqttStatus ) );
+                break;
+            }
+            mqtt_obj->outgoing_pub_packets[ index ].batched = true;
+        }
+
+        fixed_buffer.pBuffer = &(context->networkBuffer.pBuffer[ length ]);
+        fixed_buffer.size = context->networkBuffer.size - length;
+        mqttStatus = MQTT_SerializePublish( pubinfo, packet_ids[ i ], remaining_length, &fixed_buffer );
+        if( mqttStatus != MQTTSuccess )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT_SerializePublish failed with status = %s.\n", MQTT_Status_strerror( mqttStatus ) );
+            break;
+        }
+        length += packet_size;
+    }
+
+    if( mqttStatus == MQTTSuccess )
+    {
+        mqttStatus = mqtt_flush_publish_batch( mqtt_obj, length, packet_ids, count );
+    }
+    else
+    {
+        (void)mqtt_flush_publish_batch( mqtt_obj, 0, packet_ids, count );
+    }
+
+    return mqttStatus;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+static void mqtt_awsport_network_disconnect_callback( void *arg )
+{
+    cy_rslt_t                result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t         *mqtt_obj = NULL;
+
+    if( arg == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid argument for mqtt_awsport_network_disconnect_callback, so nothing to do..!\n" );
+        return;
+    }
+
+    mqtt_obj = ( cy_mqtt_object_t * )arg;
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\n Network disconnection notification from socket layer.\n" );
+
+    result = mqtt_queue_object_event( mqtt_obj, CY_MQTT_SOCKET_EVENT_DISCONNECT, CY_MQTT_EVENT_QUEUE_TIMEOUT_IN_MSEC );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nPushing disconnect event to the mqtt_event_queue failed with Error : [0x%X] \n", (unsigned int)result );
+    }
+
+    return;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+static void call_registered_event_callbacks(cy_mqtt_t handle, cy_mqtt_event_t event)
+{
+    int i = 0;
+    cy_mqtt_object_t *mqtt_obj = ( cy_mqtt_object_t * )handle;
+    cy_mqtt_callback_t event_cb;
+
+    for ( i = 0; i < CY_MQTT_MAX_EVENT_CALLBACKS; i++ )
+    {
+        if( mqtt_obj->mqtt_event_cb[i] != NULL )
+        {
+            event_cb = mqtt_obj->mqtt_event_cb[i];
+            event_cb( handle, event, mqtt_obj->user_data[i] );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_dispatch_collect_visit
+ *
+ * Route visit function collecting the callbacks into the targets of a dispatch message. The target count of the message
+ * is used as the index of the next target.
+ */
+static void mqtt_dispatch_collect_visit( const cy_mqtt_route_t *route, void *arg )
+{
+    cy_mqtt_dispatch_msg_t *msg = (cy_mqtt_dispatch_msg_t *)arg;
+
+    msg->targets[ msg->target_count ].callback = route->callback;
+    msg->targets[ msg->target_count ].user_data = route->user_data;
+    msg->target_count++;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_dispatch_count_visit
+ *
+ * Route visit function doing nothing, used to count the callbacks of the topic filters matching a topic.
+ */
+static void mqtt_dispatch_count_visit( const cy_mqtt_route_t *route, void *arg )
+{
+    (void)route;
+    (void)arg;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_dispatch_free_msg
+ *
+ * Return the buffer of a dispatch message to the pool, or free it if it is allocated from heap.
+ */
+static void mqtt_dispatch_free_msg( cy_mqtt_dispatch_pool_t *pool, cy_mqtt_dispatch_msg_t *msg )
+{
+    if( msg->pooled == false )
+    {
+        free( msg );
+        return;
+    }
+
+    (void)cy_rtos_get_mutex( &(pool->mutex), CY_RTOS_NEVER_TIMEOUT );
+    msg->next = pool->free_list;
+    pool->free_list = msg;
+    (void)cy_rtos_set_mutex( &(pool->mutex) );
+    (void)cy_rtos_set_semaphore( &(pool->free_count), false );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_dispatch_worker_thread
+ *
+ * Hand the messages queued to the worker to their callbacks, until the worker is stopped.
+ */
+static void mqtt_dispatch_worker_thread( cy_thread_arg_t arg )
+{
+    cy_mqtt_dispatch_worker_t  *worker = (cy_mqtt_dispatch_worker_t *)arg;
+    cy_mqtt_dispatch_pool_t    *pool = worker->pool;
+    cy_mqtt_dispatch_msg_t     *msg = NULL;
+    cy_rslt_t                  result = CY_RSLT_SUCCESS;
+    bool                       stop = false;
+    uint16_t                   i;
+
+    while( stop == false )
+    {
+        result = cy_rtos_get_semaphore( &(worker->pending), CY_RTOS_NEVER_TIMEOUT, false );
+        if( result != CY_RSLT_SUCCESS )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_semaphore failed with Error :[0x%X]\n", (unsigned int)result );
+            continue;
+        }
+
+        /* One signal may cover several messages, so the list is emptied on every wake up. */
+        do
+        {
+            (void)cy_rtos_get_mutex( &(pool->mutex), CY_RTOS_NEVER_TIMEOUT );
+            msg = worker->head;
+            if( msg != NULL )
+            {
+                worker->head = msg->next;
+                if( worker->head == NULL )
+                {
+                    worker->tail = NULL;
+                }
+            }
+            stop = worker->stop;
+            (void)cy_rtos_set_mutex( &(pool->mutex) );
+
+            if( msg != NULL )
+            {
+                for( i = 0; i < msg->target_count; i++ )
+                {
+                    msg->targets[ i ].callback( (cy_mqtt_t)pool->mqtt_obj, msg->event, msg->targets[ i ].user_data );
+                }
+                mqtt_dispatch_free_msg( pool, msg );
+            }
+        } while( msg != NULL );
+    }
+
+    result = cy_rtos_exit_thread();
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_exit_thread failed with Error :[0x%X]\n", (unsigned int)result );
+    }
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_dispatch_stop
+ *
+ * Stop the workers of the dispatch pool after they have handed the queued messages to their callbacks, and free the pool.
+ * Must not be called with mqtt_obj->process_mutex held, as the callbacks may call the MQTT library functions.
+ */
+static void mqtt_dispatch_stop( cy_mqtt_dispatch_pool_t *pool )
+{
+    uint8_t i;
+
+    for( i = 0; i < pool->worker_count; i++ )
+    {
+        (void)cy_rtos_get_mutex( &(pool->mutex), CY_RTOS_NEVER_TIMEOUT );
+        pool->workers[ i ].stop = true;
+        (void)cy_rtos_set_mutex( &(pool->mutex) );
+        (void)cy_rtos_set_semaphore( &(pool->workers[ i ].pending), false );
+        (void)cy_rtos_join_thread( &(pool->workers[ i ].thread) );
+        (void)cy_rtos_deinit_semaphore( &(pool->workers[ i ].pending) );
+    }
+
+    (void)cy_rtos_deinit_semaphore( &(pool->free_count) );
+    (void)cy_rtos_deinit_mutex( &(pool->mutex) );
+    free( pool->workers );
+    free( pool->buffers );
+    free( pool );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_dispatch_start
+ *
+ * Allocate a dispatch pool and start its workers.
+ */
+static cy_rslt_t mqtt_dispatch_start( cy_mqtt_object_t *mqtt_obj, const cy_mqtt_dispatch_config_t *config, cy_mqtt_dispatch_pool_t **dispatch )
+{
+    cy_mqtt_dispatch_pool_t  *pool;
+    cy_mqtt_dispatch_msg_t   *msg;
+    cy_rslt_t                result = CY_RSLT_SUCCESS;
+    size_t                   buffer_size;
+    uint16_t                 i;
+
+    /* Keep the pool buffers aligned for the message structure. */
+    buffer_size = (config->buffer_size + sizeof( void * ) - 1U) & ~(sizeof( void * ) - 1U);
+
+    pool = (cy_mqtt_dispatch_pool_t *)calloc( 1, sizeof( cy_mqtt_dispatch_pool_t ) );
+    if( pool == NULL )
+    {
+        return CY_RSLT_MODULE_MQTT_NOMEM;
+    }
+    pool->mqtt_obj = mqtt_obj;
+    memcpy( &(pool->config), config, sizeof( cy_mqtt_dispatch_config_t ) );
+    pool->config.buffer_size = (uint32_t)buffer_size;
+
+    pool->buffers = (uint8_t *)malloc( buffer_size * config->buffer_count );
+    pool->workers = (cy_mqtt_dispatch_worker_t *)calloc( config->worker_count, sizeof( cy_mqtt_dispatch_worker_t ) );
+    if( (pool->buffers == NULL) || (pool->workers == NULL) )
+    {
+        free( pool->buffers );
+        free( pool->workers );
+        free( pool );
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to create the dispatch pool..!\n" );
+        return CY_RSLT_MODULE_MQTT_NOMEM;
+    }
+
+    for( i = 0; i < config->buffer_count; i++ )
+    {
+        msg = (cy_mqtt_dispatch_msg_t *)&(pool->buffers[ i * buffer_size ]);
+        msg->next = pool->free_list;
+        pool->free_list = msg;
+    }
+
+    result = cy_rtos_init_mutex2( &(pool->mutex), false );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        free( pool->buffers );
+        free( pool->workers );
+        free( pool );
+        return result;
+    }
+    result = cy_rtos_init_semaphore( &(pool->free_count), config->buffer_count, config->buffer_count );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        (void)cy_rtos_deinit_mutex( &(pool->mutex) );
+        free( pool->buffers );
+        free( pool->workers );
+        free( pool );
+        return result;
+    }
+
+    for( i = 0; i < config->worker_count; i++ )
+    {
+        pool->workers[ i ].pool = pool;
+        result = cy_rtos_init_semaphore( &(pool->workers[ i ].pending), 1, 0 );
+        if( result != CY_RSLT_SUCCESS )
+        {
+            break;
+        }
+        result = cy_rtos_create_thread( &(pool->workers[ i ].thread), mqtt_dispatch_worker_thread, "MQTTDispatchThread", NULL,
+                                        CY_MQTT_DISPATCH_THREAD_STACK_SIZE, CY_MQTT_DISPATCH_THREAD_PRIORITY, (cy_thread_arg_t)&(pool->workers[ i ]) );
+        if( result != CY_RSLT_SUCCESS )
+        {
+            (void)cy_rtos_deinit_semaphore( &(pool->workers[ i ].pending) );
+            break;
+        }
+        pool->worker_count++;
+    }
+
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nStarting the dispatch workers failed with Error : [0x%X] \n", (unsigned int)result );
+        mqtt_dispatch_stop( pool );
+        return result;
+    }
+
+    *dispatch = pool;
+    return CY_RSLT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_dispatch_publish_event
+ *
+ * Copy a received message, or a fragment of it, with the callbacks to which it is delivered, and queue it to the worker
+ * of its topic. Never waits, as the callbacks of the worker may be waiting for mqtt_obj->process_mutex: the message
+ * is copied to memory allocated from heap if all the pool buffers are in use. The messages are linked into the list of
+ * the worker, which has no length limit, so that an acknowledged QoS1 or QoS2 message is never dropped once copied.
+ */
+/* mqtt_dispatch_publish_event must be protected under mqtt_obj->process_mutex */
+static void mqtt_dispatch_publish_event( cy_mqtt_object_t *mqtt_obj, cy_mqtt_event_t *event, const char *topic, uint16_t topic_len )
+{
+    cy_mqtt_dispatch_pool_t     *pool = mqtt_obj->dispatch;
+    cy_mqtt_dispatch_worker_t   *worker = NULL;
+    cy_mqtt_dispatch_msg_t      *msg = NULL;
+    cy_mqtt_received_msg_info_t *message;
+    uint32_t                    target_count = 0;
+    uint32_t                    hash = 2166136261U;
+    size_t                      size;
+    char                        *data;
+    uint16_t                    i;
+    bool                        routed = false;
+
+    message = ( event->type == CY_MQTT_EVENT_TYPE_PUBLISH_FRAGMENT_RECEIVE ) ? &(event->data.fragment.received_message) :
+                                                                               &(event->data.pub_msg.received_message);
+
+    if( mqtt_obj->routes != NULL )
+    {
+        target_count = mqtt_route_match( mqtt_obj->routes, topic, topic_len, 0, mqtt_dispatch_count_visit, NULL );
+        routed = ( target_count > 0 );
+    }
+    if( routed == false )
+    {
+        for( i = 0; i < CY_MQTT_MAX_EVENT_CALLBACKS; i++ )
+        {
+            if( mqtt_obj->mqtt_event_cb[ i ] != NULL )
+            {
+                target_count++;
+            }
+        }
+    }
+    if( target_count == 0 )
+    {
+        return;
+    }
+
+    size = sizeof( cy_mqtt_dispatch_msg_t ) + (target_count * sizeof( cy_mqtt_dispatch_target_t )) + topic_len + message->payload_len;
+    if( (size <= pool->config.buffer_size) && (cy_rtos_get_semaphore( &(pool->free_count), 0, false ) == CY_RSLT_SUCCESS) )
+    {
+        (void)cy_rtos_get_mutex( &(pool->mutex), CY_RTOS_NEVER_TIMEOUT );
+        msg = pool->free_list;
+        pool->free_list = msg->next;
+        (void)cy_rtos_set_mutex( &(pool->mutex) );
+        msg->pooled = true;
+    }
+    else
+    {
+        msg = (cy_mqtt_dispatch_msg_t *)malloc( size );
+        if( msg == NULL )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to dispatch message of %u bytes. Message dropped..!\n", (unsigned int)size );
+            return;
+        }
+        msg->pooled = false;
+    }
+
+    msg->targets = (cy_mqtt_dispatch_target_t *)&(msg[ 1 ]);
+    msg->target_count = 0;
+    if( routed == true )
+    {
+        (void)mqtt_route_match( mqtt_obj->routes, topic, topic_len, 0, mqtt_dispatch_collect_visit, msg );
+    }
+    else
+    {
+        for( i = 0; i < CY_MQTT_MAX_EVENT_CALLBACKS; i++ )
+        {
+            if( mqtt_obj->mqtt_event_cb[ i ] != NULL )
+            {
+                msg->targets[ msg->target_count ].callback = mqtt_obj->mqtt_event_cb[ i ];
+                msg->targets[ msg->target_count ].user_data = mqtt_obj->user_data[ i ];
+                msg->target_count++;
+            }
+        }
+    }
+
+    /* Copy the message, pointing it at the copies of the topic and the payload. */
+    memcpy( &(msg->event), event, sizeof( cy_mqtt_event_t ) );
+    message = ( event->type == CY_MQTT_EVENT_TYPE_PUBLISH_FRAGMENT_RECEIVE ) ? &(msg->event.data.fragment.received_message) :
+                                                                               &(msg->event.data.pub_msg.received_message);
+    data = (char *)&(msg->targets[ target_count ]);
+    memcpy( data, topic, topic_len );
+    message->topic = data;
+    message->topic_len = topic_len;
+    if( message->payload_len > 0 )
+    {
+        memcpy( &(data[ topic_len ]), message->payload, message->payload_len );
+    }
+    message->payload = &(data[ topic_len ]);
+
+    /* FNV-1a hash of the topic selects the worker. */
+    for( i = 0; i < topic_len; i++ )
+    {
+        hash = (hash ^ (uint8_t)topic[ i ]) * 16777619U;
+    }
+
+    worker = &(pool->workers[ hash % pool->worker_count ]);
+    msg->next = NULL;
+    (void)cy_rtos_get_mutex( &(pool->mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( worker->tail == NULL )
+    {
+        worker->head = msg;
+    }
+    else
+    {
+        worker->tail->next = msg;
+    }
+    worker->tail = msg;
+    (void)cy_rtos_set_mutex( &(pool->mutex) );
+
+    /* The worker may already be signalled for an earlier message; it empties its list on every wake up. */
+    (void)cy_rtos_set_semaphore( &(worker->pending), false );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_deliver_publish_event
+ *
+ * Deliver a received message, or a fragment of it, to the callbacks of the topic filters subscribed with a callback
+ * that match the topic. Messages that match none of them are delivered to the registered event callbacks.
+ */
+/* mqtt_deliver_publish_event must be protected under mqtt_obj->process_mutex */
+static void mqtt_deliver_publish_event( cy_mqtt_object_t *mqtt_obj, cy_mqtt_event_t *event, const char *topic, uint16_t topic_len )
+{
+    cy_mqtt_route_call_t call;
+
+    if( mqtt_obj->dispatch != NULL )
+    {
+        mqtt_dispatch_publish_event( mqtt_obj, event, topic, topic_len );
+        return;
+    }
+
+    call.handle = (cy_mqtt_t)mqtt_obj;
+    call.event = event;
+    if( (mqtt_obj->routes == NULL) ||
+        (mqtt_route_match( mqtt_obj->routes, topic, topic_len, 0, mqtt_route_call_visit, &call ) == 0) )
+    {
+        call_registered_event_callbacks( (cy_mqtt_t)mqtt_obj, *event );
+    }
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_reconnect_report
+ *
+ * Report the outcome of the automatic reconnection to the registered event callbacks.
+ */
+/* mqtt_reconnect_report must be protected under mqtt_obj->process_mutex */
+static void mqtt_reconnect_report( cy_mqtt_object_t *mqtt_obj, cy_rslt_t result )
+{
+    cy_mqtt_event_t event;
+
+    mqtt_obj->reconnect_report_pending = false;
+
+    memset( &event, 0x00, sizeof( cy_mqtt_event_t ) );
+    event.type = CY_MQTT_EVENT_TYPE_RECONNECT;
+    event.data.reconnect.result = result;
+    event.data.reconnect.attempts = mqtt_obj->reconnect_attempts;
+    event.data.reconnect.latency_ms = Clock_GetTimeMs() - mqtt_obj->reconnect_start_ms;
+    event.data.reconnect.session_present = ( (result == CY_RSLT_SUCCESS) && (mqtt_obj->broker_session_present == true) &&
+                                             (mqtt_obj->connect_info.clean_session == false) );
+    event.data.reconnect.rejected_filters = ( result == CY_RSLT_SUCCESS ) ? mqtt_obj->resubscribe_rejected : 0;
+
+    call_registered_event_callbacks( (cy_mqtt_t)mqtt_obj, event );
+}
+
+/*
+ * mqtt_check_resubscribe_ack
+ *
+ * Check the SUBACK of a SUBSCRIBE packet sent by mqtt_resubscribe, and count the topic filters rejected by the broker.
+ * The outcome of the automatic reconnection is reported with the SUBACK of the last of these packets.
+ */
+/* mqtt_check_resubscribe_ack must be protected under mqtt_obj->process_mutex */
+static void mqtt_check_resubscribe_ack( cy_mqtt_object_t *mqtt_obj, const MQTTPacketInfo_t *packet_info )
+{
+    size_t   index;
+    uint32_t rejected = 0;
+
+    mqtt_obj->resubscribe_pending--;
+
+    /* The 2-byte packet identifier is followed by one return code per topic filter. */
+    for( index = 2; index < packet_info->remainingLength; index++ )
+    {
+        if( packet_info->pRemainingData[ index ] == 0x80U )
+        {
+            rejected++;
+        }
+    }
+    if( rejected > 0 )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nMQTT broker rejected %u of the restored subscriptions.\n", (unsigned int)rejected );
+        mqtt_obj->resubscribe_rejected += rejected;
+    }
+
+    if( (mqtt_obj->resubscribe_pending == 0) && (mqtt_obj->reconnect_report_pending == true) )
+    {
+        mqtt_reconnect_report( mqtt_obj, CY_RSLT_SUCCESS );
+    }
+}
+
+/*
+ * mqtt_ack_waiter_init
+ *
+ * Create the mutex and semaphore of a waiter of synchronous requests.
+ */
+static cy_rslt_t mqtt_ack_waiter_init( cy_mqtt_ack_waiter_t *waiter )
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    result = cy_rtos_init_mutex2( &(waiter->req_mutex), false );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nCreating new mutex %p. failed\n", waiter->req_mutex );
+        return result;
+    }
+
+    result = cy_rtos_init_semaphore( &(waiter->semaphore), 1, 0 );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_init_semaphore failed with Error : [0x%X] \n", (unsigned int)result );
+        (void)cy_rtos_deinit_mutex( &(waiter->req_mutex) );
+        return result;
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+/*
+ * mqtt_ack_waiter_deinit
+ *
+ * Delete the mutex and semaphore of a waiter of synchronous requests.
+ */
+static void mqtt_ack_waiter_deinit( cy_mqtt_ack_waiter_t *waiter )
+{
+    (void)cy_rtos_deinit_mutex( &(waiter->req_mutex) );
+    (void)cy_rtos_deinit_semaphore( &(waiter->semaphore) );
+}
+
+/* mqtt_signal_sync_ack must be protected under mqtt_obj->process_mutex */
+static void mqtt_signal_sync_ack( cy_mqtt_ack_waiter_t *waiter )
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    waiter->ack_received = true;
+    result = cy_rtos_set_semaphore( &(waiter->semaphore), false );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_rtos_set_semaphore failed with Error : [0x%X] \n", (unsigned int)result );
+    }
+}
+
+/*
+ * mqtt_wake_ack_waiters
+ *
+ * Wake up all the callers waiting for an acknowledgment, without marking the acknowledgment as received.
+ * Called when the MQTT session is lost or closed and when the MQTT object is deleted, so that the waiters
+ * return immediately instead of waiting for their timeout.
+ */
+/* mqtt_wake_ack_waiters must be protected under mqtt_obj->process_mutex */
+static void mqtt_wake_ack_waiters( cy_mqtt_object_t *mqtt_obj )
+{
+    uint16_t index;
+
+    (void)cy_rtos_set_semaphore( &(mqtt_obj->sub_waiter.semaphore), false );
+    (void)cy_rtos_set_semaphore( &(mqtt_obj->unsub_waiter.semaphore), false );
+    for( index = 0; index < mqtt_obj->pub_window_size; index++ )
+    {
+        if( (mqtt_obj->outgoing_pub_packets[ index ].packetid != MQTT_PACKET_ID_INVALID) &&
+            (mqtt_obj->outgoing_pub_packets[ index ].ack_waiting == true) )
+        {
+            (void)cy_rtos_set_semaphore( &(mqtt_obj->pub_ack_sems[ index ]), false );
+        }
+    }
+}
+
+/*
+ * mqtt_is_event_loop_thread
+ *
+ * Check whether the calling thread is the event loop thread of the MQTT object.
+ */
+static bool mqtt_is_event_loop_thread( cy_mqtt_object_t *mqtt_obj )
+{
+    cy_thread_t current = NULL;
+
+    if( cy_rtos_get_thread_handle( &current ) != CY_RSLT_SUCCESS )
+    {
+        return false;
+    }
+    return ( current == mqtt_obj->event_loop->thread );
+}
+
+/*
+ * mqtt_wait_for_ack
+ *
+ * Wait until *ack_received is set on receiving the acknowledgment of a synchronous request, or timeout_ms elapses.
+ * The caller clears *ack_received before sending the request. Must be called with mqtt_obj->process_mutex held. The mutex is released while waiting so that
+ * mqtt_event_processing_thread can process the acknowledgment, and is held again on return. The wait ends early when the session is lost or the object is
+ * deleted, as mqtt_wake_ack_waiters signals ack_sem. When called from the event loop thread of the object, e.g. from a publish completion callback,
+ * nothing else can process the acknowledgment, so this function receives it instead.
+ */
+static MQTTStatus_t mqtt_wait_for_ack( cy_mqtt_object_t *mqtt_obj, cy_semaphore_t *ack_sem, bool *ack_received, uint32_t timeout_ms )
+{
+    MQTTStatus_t mqttStatus = MQTTSuccess;
+    uint32_t     deadline = Clock_GetTimeMs() + timeout_ms;
+    uint32_t     remaining = timeout_ms;
+    uint32_t     now = 0;
+    bool         event_loop_thread = mqtt_is_event_loop_thread( mqtt_obj );
+
+    /* The acknowledgment cannot be processed before the mutex is released, so clear any stale signal here.
+     * Acknowledgments already recorded in *ack_received are not lost by this. */
+    while( cy_rtos_get_semaphore( ack_sem, 0, false ) == CY_RSLT_SUCCESS )
+    {
+    }
+
+    while( (*ack_received == false) && (remaining > 0) )
+    {
+        if( (mqtt_obj->mqtt_session_established == false) || (mqtt_obj->deleted == true) )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT session lost while waiting for the acknowledgment.\n" );
+            break;
+        }
+
+        if( event_loop_thread == true )
+        {
+            mqttStatus = MQTT_ProcessLoop( &(mqtt_obj->mqtt_context), CY_MQTT_RECEIVE_DATA_TIMEOUT_MS );
+            if( mqttStatus != MQTTSuccess )
+            {
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT_ProcessLoop returned with status = %s.\n", MQTT_Status_strerror( mqttStatus ) );
+                return mqttStatus;
+            }
+        }
+        else
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_wait_for_ack - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+            (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+
+            (void)cy_rtos_get_semaphore( ack_sem, remaining, false );
+
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_wait_for_ack - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+            (void)cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_wait_for_ack - Acquired Mutex %p \n", mqtt_obj->process_mutex );
+        }
+
+        now = Clock_GetTimeMs();
+        remaining = ( (int32_t)(deadline - now) > 0 ) ? (deadline - now) : 0;
+    }
+
+    return ( *ack_received == true ) ? MQTTSuccess : MQTTRecvFailed;
+}
+
+static void mqtt_event_callback( MQTTContext_t *param_mqtt_context,
+                                 MQTTPacketInfo_t *param_packet_info,
+                                 MQTTDeserializedInfo_t *param_deserialized_info )
+{
+    cy_rslt_t         result = CY_RSLT_SUCCESS;
+    uint16_t          packet_id;
+    cy_mqtt_object_t  *mqtt_obj = NULL;
+    cy_mqtt_event_t   event;
+    uint8_t           *decompressed_payload = NULL;
+
+    if( (param_mqtt_context == NULL) || (param_packet_info == NULL) || (param_deserialized_info == NULL) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Bad arguments to mqtt_event_callback.\n" );
+        return;
+    }
+
+    memset( &event, 0x00, sizeof(cy_mqtt_event_t) );
+
+    /* The MQTT context is embedded in the MQTT object. */
+    mqtt_obj = (cy_mqtt_object_t *)( (uint8_t *)param_mqtt_context - offsetof( cy_mqtt_object_t, mqtt_context ) );
+    if( is_mqtt_obj_valid( mqtt_obj ) == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Invalid MQTT Context..\n" );
+        return;
+    }
+
+    packet_id = param_deserialized_info->packetIdentifier;
+
+    /* Handle incoming PUBLISH packets. The lower 4 bits of the PUBLISH packet
+     * type is used for the dup, QoS, and retain flags. Therefore, masking
+     * out the lower bits to check whether the packet is a PUBLISH packet. */
+    if( ( param_packet_info->type & 0xF0U ) == MQTT_PACKET_TYPE_PUBLISH )
+    {
+        if( param_deserialized_info->pPublishInfo != NULL )
+        {
+            /* Handle incoming PUBLISH packets. */
+            event.type = CY_MQTT_EVENT_TYPE_PUBLISH_RECEIVE;
+            event.data.pub_msg.packet_id = packet_id;
+            event.data.pub_msg.received_message.dup =  param_deserialized_info->pPublishInfo->dup;
+            event.data.pub_msg.received_message.payload = (const char *) (param_deserialized_info->pPublishInfo->pPayload);
+            event.data.pub_msg.received_message.payload_len = param_deserialized_info->pPublishInfo->payloadLength;
+
+            if( param_deserialized_info->pPublishInfo->qos == MQTTQoS0 )
+            {
+                event.data.pub_msg.received_message.qos = CY_MQTT_QOS0;
+            }
+            else if( param_deserialized_info->pPublishInfo->qos == MQTTQoS1 )
+            {
+                event.data.pub_msg.received_message.qos = CY_MQTT_QOS1;
+            }
+            else
+            {
+                event.data.pub_msg.received_message.qos = CY_MQTT_QOS2;
+            }
+            event.data.pub_msg.received_message.retain = param_deserialized_info->pPublishInfo->retain;
+            event.data.pub_msg.received_message.topic = param_deserialized_info->pPublishInfo->pTopicName;
+            event.data.pub_msg.received_message.topic_len = param_deserialized_info->pPublishInfo->topicNameLength;
+
+            decompressed_payload = mqtt_decompress_payload( mqtt_obj, &(event.data.pub_msg.received_message) );
+
+            mqtt_deliver_publish_event( mqtt_obj, &event, event.data.pub_msg.received_message.topic,
+                                        event.data.pub_msg.received_message.topic_len );
+            if( decompressed_payload != NULL )
+            {
+                free( decompressed_payload );
+            }
+        }
+        else
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Invalid pPublishInfo..\n" );
+            return;
+        }
+    }
+    else
+    {
+        /* Handle other packets. */
+        switch( param_packet_info->type )
+        {
+            case MQTT_PACKET_TYPE_SUBACK:
+
+                /* Make sure that the ACK packet identifier matches with the Request packet identifier. */
+                if( mqtt_obj->sub_waiter.packet_id != packet_id )
+                {
+                    if( mqtt_obj->resubscribe_pending > 0 )
+                    {
+                        /* SUBACK of the subscriptions restored by the automatic reconnection. */
+                        mqtt_check_resubscribe_ack( mqtt_obj, param_packet_info );
+                    }
+                    else
+                    {
+                        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nSUBACK packet identifier does not matches with Request packet identifier.\n" );
+                    }
+                }
+                else
+                {
+                    /* A SUBACK from the broker, containing the server response to our subscription request, has been received.
+                     * It contains the status code indicating server approval/rejection for the subscription to the single topic
+                     * requested. The SUBACK will be parsed to obtain the status code; this status code will be stored in the MQTT object
+                     * member 'sub_ack_status'. */
+                    result = mqtt_update_suback_status( mqtt_obj, param_packet_info );
+                    if( result != CY_RSLT_SUCCESS )
+                    {
+                        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n mqtt_update_suback_status failed..!\n" );
+                    }
+                    mqtt_signal_sync_ack( &(mqtt_obj->sub_waiter) );
+                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nSUBACK packet identifier matches with Request packet identifier.\n" );
+                }
+                break;
+
+            case MQTT_PACKET_TYPE_UNSUBACK:
+                /* Make sure that the UNSUBACK packet identifier matches with the Request packet identifier. */
+                if( mqtt_obj->unsub_waiter.packet_id != packet_id )
+                {
+                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nUNSUBACK packet identifier does not matches with Request packet identifier.\n" );
+                }
+                else
+                {
+                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nUNSUBACK packet identifier matches with Request packet identifier.\n" );
+                    mqtt_signal_sync_ack( &(mqtt_obj->unsub_waiter) );
+                }
+                break;
+
+            case MQTT_PACKET_TYPE_PINGRESP:
+                if( param_deserialized_info->deserializationResult != MQTTSuccess )
+                {
+                    memset( &event, 0x00, sizeof(cy_mqtt_event_t) );
+                    event.type = CY_MQTT_EVENT_TYPE_DISCONNECT;
+                    event.data.reason = CY_MQTT_DISCONN_TYPE_BROKER_DOWN;
+
+                    call_registered_event_callbacks((cy_mqtt_t)mqtt_obj, event);
+
+                    mqtt_obj->mqtt_session_established = false;
+                    mqtt_wake_ack_waiters( mqtt_obj );
+                }
+                else
+                {
+                    /* stop response timer */
+                    stop_mqtt_ping_resp_timer(mqtt_obj);
+                }
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nPing response received.\n" );
+                break;
+
+            case MQTT_PACKET_TYPE_PUBREC:
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nPUBREC received for packet id %u.\n\n", packet_id );
+                if( param_deserialized_info->deserializationResult != MQTTSuccess )
+                {
+                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nPUBREC received with status %s.\n", MQTT_Status_strerror( param_deserialized_info->deserializationResult ) );
+                }
+                else
+                {
+                    /* Record the acknowledgment in the inflight window entry of the packet ID. */
+                    mqtt_handle_publish_ack( mqtt_obj, packet_id, MQTT_PACKET_TYPE_PUBREC );
+                }
+                break;
+
+            case MQTT_PACKET_TYPE_PUBREL:
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nPUBREL received for packet id %u.\n", packet_id );
+                break;
+
+            case MQTT_PACKET_TYPE_PUBCOMP:
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nPUBCOMP received for packet id %u.\n\n", packet_id );
+                if( param_deserialized_info->deserializationResult == MQTTSuccess )
+                {
+                    mqtt_handle_publish_ack( mqtt_obj, packet_id, MQTT_PACKET_TYPE_PUBCOMP );
+                }
+                break;
+
+            case MQTT_PACKET_TYPE_PUBACK:
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nPUBACK received for packet id %u.\n\n", packet_id );
+                if( param_deserialized_info->deserializationResult != MQTTSuccess )
+                {
+                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nPUBACK received with status %s.\n", MQTT_Status_strerror( param_deserialized_info->deserializationResult ) );
+                }
+                else
+                {
+                    /* Record the acknowledgment in the inflight window entry of the packet ID. */
+                    mqtt_handle_publish_ack( mqtt_obj, packet_id, MQTT_PACKET_TYPE_PUBACK );
+                }
+                break;
+
+            case MQTT_PACKET_TYPE_DISCONNECT:
+                /* Because this is user-initiated disconnection, no need to notify the application.*/
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nDisconnect packet received:(%02x).\n\n", param_packet_info->type );
+                break;
+
+            /* Any other packet type is invalid. */
+            default:
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nUnknown packet type received:(%02x).\n\n", param_packet_info->type );
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_tls_session_clear
+ *
+ * Discard the cached TLS session.
+ */
+/* mqtt_tls_session_clear must be protected under mqtt_obj->process_mutex */
+static void mqtt_tls_session_clear( cy_mqtt_object_t *mqtt_obj )
+{
+    if( mqtt_obj->tls_session != NULL )
+    {
+        memset( mqtt_obj->tls_session, 0x00, CY_MQTT_TLS_SESSION_MAX_SIZE );
+    }
+    mqtt_obj->tls_session_len = 0;
+}
+
+/*
+ * mqtt_tls_session_offer
+ *
+ * Offer the cached TLS session on the socket of a new connection, before the TLS handshake.
+ * Returns true if a session is offered.
+ */
+/* mqtt_tls_session_offer must be protected under mqtt_obj->process_mutex */
+static bool mqtt_tls_session_offer( cy_mqtt_object_t *mqtt_obj )
+{
+    cy_rslt_t result;
+
+    if( (mqtt_obj->mqtt_secure_mode == false) || (mqtt_obj->tls_session_hooks_enabled == false) || (mqtt_obj->tls_session_len == 0) )
+    {
+        return false;
+    }
+
+    result = mqtt_obj->tls_session_hooks.offer( mqtt_obj->network_context.handle, mqtt_obj->tls_session,
+                                                mqtt_obj->tls_session_len, mqtt_obj->tls_session_hooks.user_data );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nOffering the cached TLS session failed with Error : [0x%X]. Performing a full TLS handshake.\n", (unsigned int)result );
+        mqtt_tls_session_clear( mqtt_obj );
+        return false;
+    }
+    return true;
+}
+
+/*
+ * mqtt_tls_session_save
+ *
+ * Cache the TLS session of a connection once the TLS handshake is complete, and record whether it was resumed.
+ */
+/* mqtt_tls_session_save must be protected under mqtt_obj->process_mutex */
+static void mqtt_tls_session_save( cy_mqtt_object_t *mqtt_obj )
+{
+    cy_rslt_t result;
+    size_t    session_len = CY_MQTT_TLS_SESSION_MAX_SIZE;
+    bool      resumed = false;
+
+    mqtt_obj->tls_session_resumed = false;
+    if( (mqtt_obj->mqtt_secure_mode == false) || (mqtt_obj->tls_session_hooks_enabled == false) )
+    {
+        return;
+    }
+
+    result = mqtt_obj->tls_session_hooks.save( mqtt_obj->network_context.handle, mqtt_obj->tls_session,
+                                               &session_len, &resumed, mqtt_obj->tls_session_hooks.user_data );
+    if( (result != CY_RSLT_SUCCESS) || (session_len == 0) || (session_len > CY_MQTT_TLS_SESSION_MAX_SIZE) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nTLS session of the connection is not cached. Result : [0x%X], length : %u\n",
+                         (unsigned int)result, (unsigned int)session_len );
+        mqtt_tls_session_clear( mqtt_obj );
+        return;
+    }
+
+    mqtt_obj->tls_session_len = session_len;
+    mqtt_obj->tls_session_resumed = resumed;
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nTLS session %s. Cached %u bytes of TLS session state.\n",
+                     (resumed == true) ? "resumed" : "established with a full handshake", (unsigned int)session_len );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+static cy_rslt_t mqtt_establish_session( cy_mqtt_object_t *mqtt_obj,
+                                         MQTTConnectInfo_t *connect_info,
+                                         MQTTPublishInfo_t *will_msg,
+                                         bool create_clean_session,
+                                         bool *session_present )
+{
+    cy_rslt_t         result = CY_RSLT_SUCCESS;
+    MQTTStatus_t      mqttStatus = MQTTSuccess;
+
+    /* Establish an MQTT session by sending a CONNECT packet. */
+
+    /* Send an MQTT CONNECT packet to the broker. */
+    mqttStatus = MQTT_Connect( &(mqtt_obj->mqtt_context), connect_info, will_msg, CY_MQTT_CONNACK_RECV_TIMEOUT_MS, session_present );
+    if( mqttStatus != MQTTSuccess )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nConnection with MQTT broker failed with status %s.\n", MQTT_Status_strerror( mqttStatus ) );
+        return CY_RSLT_MODULE_MQTT_CONNECT_FAIL;
+    }
+    else
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nMQTT connection successfully established with broker.\n\n" );
+    }
+
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+/*
+ * mqtt_receive_data
+ *
+ * Read up to bytes_recv bytes, serving the read from read_ahead first. Returns the number of bytes read, which is less than
+ * bytes_recv if no more data is received within CY_MQTT_MESSAGE_RECEIVE_TIMEOUT_MS, or a negative value if the socket read fails.
+ */
+/* mqtt_receive_data must be protected under mqtt_obj->process_mutex */
+static int32_t mqtt_receive_data( cy_mqtt_object_t *mqtt_obj, void *buffer, size_t bytes_recv )
+{
+    NetworkContext_t *network_context = &(mqtt_obj->network_context);
+    int32_t bytes_received = 0, total_received = 0;
+    size_t entryTimeMs = 0U, exitTimeMs = 0, remainingTimeMs = 0, elapsedTimeMs = 0U;;
+    size_t bytestoread = 0;
+    bool read_ahead = false;
+
+    remainingTimeMs = CY_MQTT_MESSAGE_RECEIVE_TIMEOUT_MS;
+
+    do
+    {
+        bytestoread = (size_t)bytes_recv - total_received;
+
+        /* Serve the read from the data read ahead by the previous reads. */
+        if( mqtt_obj->read_ahead_len > 0 )
+        {
+            if( bytestoread > mqtt_obj->read_ahead_len )
+            {
+                bytestoread = mqtt_obj->read_ahead_len;
+            }
+            memcpy( (char *)buffer + total_received, &(mqtt_obj->read_ahead[ mqtt_obj->read_ahead_offset ]), bytestoread );
+            mqtt_obj->read_ahead_offset += (uint16_t)bytestoread;
+            mqtt_obj->read_ahead_len -= (uint16_t)bytestoread;
+            total_received = total_received + (int32_t)bytestoread;
+            mqtt_obj->rx_data_received = true;
+            continue;
+        }
+
+        /* Small reads, such as the packet type and the remaining length, read whatever is available in the socket into
+         * read_ahead, so that the following reads are served from memory instead of the socket. */
+        read_ahead = ( bytestoread < CY_MQTT_RECEIVE_READ_AHEAD_SIZE );
+        entryTimeMs = Clock_GetTimeMs();
+        if( read_ahead == true )
+        {
+            bytes_received = cy_awsport_network_receive( network_context, (void *)mqtt_obj->read_ahead, CY_MQTT_RECEIVE_READ_AHEAD_SIZE );
+        }
+        else
+        {
+            bytes_received = cy_awsport_network_receive( network_context, (void *)((char *)buffer + total_received), bytestoread );
+        }
+        exitTimeMs = Clock_GetTimeMs();
+        elapsedTimeMs = exitTimeMs - entryTimeMs;
+        if( bytes_received < 0 )
+        {
+            return bytes_received;
+        }
+        else if( bytes_received == 0 )
+        {
+            if( total_received == 0 )
+            {
+                /* No data in the socket, so return. */
+                break;
+            }
+        }
+        else
+        {
+            if( read_ahead == true )
+            {
+                mqtt_obj->read_ahead_offset = 0;
+                mqtt_obj->read_ahead_len = (uint16_t)bytes_received;
+            }
+            else
+            {
+                total_received = total_received + bytes_received;
+            }
+            mqtt_obj->rx_data_received = true;
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\n Total Bytes Received = %u\n", (unsigned int)total_received );
+            /* Reset the wait time as some data is received. */
+            elapsedTimeMs = 0;
+            remainingTimeMs = CY_MQTT_MESSAGE_RECEIVE_TIMEOUT_MS;
+        }
+        remainingTimeMs = remainingTimeMs - elapsedTimeMs;
+    } while( (total_received < bytes_recv) && (remainingTimeMs > 0) );
+
+    return total_received;
+}
+
+/*
+ * mqtt_receive_exact
+ *
+ * Read exactly length bytes. Returns false if the data is not received.
+ */
+/* mqtt_receive_exact must be protected under mqtt_obj->process_mutex */
+static bool mqtt_receive_exact( cy_mqtt_object_t *mqtt_obj, void *buffer, size_t length )
+{
+    if( length == 0 )
+    {
+        return true;
+    }
+
+    return ( mqtt_receive_data( mqtt_obj, buffer, length ) == (int32_t)length );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_read_ahead_fill
+ *
+ * Read from the socket until read_ahead holds at least min_len unread bytes, moving the unread bytes to the start of read_ahead first.
+ * Returns false if the data is not received within CY_MQTT_MESSAGE_RECEIVE_TIMEOUT_MS, or the socket read fails.
+ */
+/* mqtt_read_ahead_fill must be protected under mqtt_obj->process_mutex */
+static bool mqtt_read_ahead_fill( cy_mqtt_object_t *mqtt_obj, uint16_t min_len )
+{
+    int32_t   bytes_received;
+    uint32_t  deadline = Clock_GetTimeMs() + CY_MQTT_MESSAGE_RECEIVE_TIMEOUT_MS;
+
+    if( mqtt_obj->read_ahead_offset > 0 )
+    {
+        memmove( mqtt_obj->read_ahead, &(mqtt_obj->read_ahead[ mqtt_obj->read_ahead_offset ]), mqtt_obj->read_ahead_len );
+        mqtt_obj->read_ahead_offset = 0;
+    }
+
+    while( mqtt_obj->read_ahead_len < min_len )
+    {
+        bytes_received = cy_awsport_network_receive( &(mqtt_obj->network_context), (void *)&(mqtt_obj->read_ahead[ mqtt_obj->read_ahead_len ]),
+                                                     CY_MQTT_RECEIVE_READ_AHEAD_SIZE - mqtt_obj->read_ahead_len );
+        if( bytes_received < 0 )
+        {
+            return false;
+        }
+        else if( bytes_received > 0 )
+        {
+            mqtt_obj->read_ahead_len += (uint16_t)bytes_received;
+            mqtt_obj->rx_data_received = true;
+            deadline = Clock_GetTimeMs() + CY_MQTT_MESSAGE_RECEIVE_TIMEOUT_MS;
+        }
+        else if( (int32_t)(deadline - Clock_GetTimeMs()) <= 0 )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_send_ack
+ *
+ * Send a PUBACK, PUBREC, or PUBCOMP packet for a received packet ID.
+ */
+/* mqtt_send_ack must be protected under mqtt_obj->process_mutex */
+static bool mqtt_send_ack( cy_mqtt_object_t *mqtt_obj, uint8_t packet_type, uint16_t packet_id )
+{
+    uint8_t packet[ 4 ];
+
+    packet[ 0 ] = packet_type;
+    packet[ 1 ] = 2U;
+    packet[ 2 ] = (uint8_t)(packet_id >> 8);
+    packet[ 3 ] = (uint8_t)(packet_id & 0xFFU);
+
+    return ( mqtt_transport_send_all( mqtt_obj, packet, sizeof( packet ) ) == MQTTSuccess );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_qos2_mark_received
+ *
+ * Set the bit of a received QoS2 packet ID. Returns false if it is already set, i.e. the message is a duplicate
+ * of a message whose PUBREL is not received yet.
+ */
+/* mqtt_qos2_mark_received must be protected under mqtt_obj->process_mutex */
+static bool mqtt_qos2_mark_received( cy_mqtt_object_t *mqtt_obj, uint16_t packet_id )
+{
+    uint8_t mask = (uint8_t)(1U << (packet_id & 0x07U));
+
+    if( (mqtt_obj->qos2_received[ packet_id >> 3 ] & mask) != 0U )
+    {
+        return false;
+    }
+    mqtt_obj->qos2_received[ packet_id >> 3 ] |= mask;
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_receive_qos2_publish
+ *
+ * Receive a QoS2 PUBLISH packet fitting in the network buffer, after its fixed header, when the incoming QoS2 state is kept in
+ * mqtt_obj->qos2_received. The message is delivered through mqtt_event_callback unless it is a duplicate, and PUBREC is sent.
+ * Returns false if the packet is malformed or cannot be received.
+ */
+/* mqtt_receive_qos2_publish must be protected under mqtt_obj->process_mutex */
+static bool mqtt_receive_qos2_publish( cy_mqtt_object_t *mqtt_obj, uint8_t header, size_t remaining_length )
+{
+    MQTTContext_t           *context = &(mqtt_obj->mqtt_context);
+    uint8_t                 *buffer = context->networkBuffer.pBuffer;
+    MQTTPacketInfo_t        packet_info;
+    MQTTPublishInfo_t       publish_info;
+    MQTTDeserializedInfo_t  deserialized_info;
+    uint16_t                topic_len, packet_id;
+
+    if( (remaining_length < 5U) || (mqtt_receive_exact( mqtt_obj, buffer, remaining_length ) == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nFailed to receive QoS2 PUBLISH packet..!\n" );
+        return false;
+    }
+
+    topic_len = (uint16_t)((buffer[ 0 ] << 8) | buffer[ 1 ]);
+    if( (topic_len == 0) || ((size_t)topic_len + 4U > remaining_length) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid topic length in QoS2 PUBLISH packet..!\n" );
+        return false;
+    }
+    packet_id = (uint16_t)((buffer[ topic_len + 2U ] << 8) | buffer[ topic_len + 3U ]);
+    if( packet_id == 0 )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid packet id 0 in QoS2 PUBLISH packet..!\n" );
+        return false;
+    }
+
+    if( mqtt_qos2_mark_received( mqtt_obj, packet_id ) == true )
+    {
+        memset( &packet_info, 0x00, sizeof( MQTTPacketInfo_t ) );
+        memset( &publish_info, 0x00, sizeof( MQTTPublishInfo_t ) );
+        memset( &deserialized_info, 0x00, sizeof( MQTTDeserializedInfo_t ) );
+
+        packet_info.type = header;
+        packet_info.pRemainingData = buffer;
+        packet_info.remainingLength = remaining_length;
+        publish_info.qos = MQTTQoS2;
+        publish_info.retain = ( (header & CY_MQTT_PUBLISH_FLAG_RETAIN) != 0U );
+        publish_info.dup = ( (header & CY_MQTT_PUBLISH_FLAG_DUP) != 0U );
+        publish_info.pTopicName = (const char *)&(buffer[ 2 ]);
+        publish_info.topicNameLength = topic_len;
+        publish_info.pPayload = &(buffer[ topic_len + 4U ]);
+        publish_info.payloadLength = remaining_length - topic_len - 4U;
+        deserialized_info.packetIdentifier = packet_id;
+        deserialized_info.pPublishInfo = &publish_info;
+        deserialized_info.deserializationResult = MQTTSuccess;
+
+        mqtt_event_callback( context, &packet_info, &deserialized_info );
+    }
+    else
+    {
+        /* Duplicate of a message whose PUBREL is not received yet; it is acknowledged again, but not delivered. */
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nDuplicate QoS2 PUBLISH received for packet id %u.\n", packet_id );
+    }
+
+    if( mqtt_send_ack( mqtt_obj, MQTT_PACKET_TYPE_PUBREC, packet_id ) == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nFailed to send PUBREC for packet id %u..!\n", packet_id );
+        return false;
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_receive_pubrel
+ *
+ * Receive a PUBREL packet, after its fixed header, when the incoming QoS2 state is kept in mqtt_obj->qos2_received.
+ * The bit of the packet ID is cleared, and PUBCOMP is sent. Returns false if the packet is malformed or cannot be received.
+ */
+/* mqtt_receive_pubrel must be protected under mqtt_obj->process_mutex */
+static bool mqtt_receive_pubrel( cy_mqtt_object_t *mqtt_obj, size_t remaining_length )
+{
+    uint8_t   field[ 2 ];
+    uint16_t  packet_id;
+
+    if( (remaining_length != sizeof( field )) || (mqtt_receive_exact( mqtt_obj, field, sizeof( field ) ) == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nFailed to receive PUBREL packet..!\n" );
+        return false;
+    }
+    packet_id = (uint16_t)((field[ 0 ] << 8) | field[ 1 ]);
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nPUBREL received for packet id %u.\n", packet_id );
+
+    /* PUBCOMP is sent even if the packet ID is unknown, as required by the MQTT specification. */
+    mqtt_obj->qos2_received[ packet_id >> 3 ] &= (uint8_t)~(1U << (packet_id & 0x07U));
+    if( mqtt_send_ack( mqtt_obj, MQTT_PACKET_TYPE_PUBCOMP, packet_id ) == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nFailed to send PUBCOMP for packet id %u..!\n", packet_id );
+        return false;
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_receive_fragmented_publish
+ *
+ * Receive the variable header and the payload of a PUBLISH packet larger than the network buffer, after its fixed header.
+ * The topic is kept at the start of the network buffer, which is not used by the MQTT core library between packets, and the
+ * payload is delivered in fragments filling the rest of the network buffer. The acknowledgment of QoS1 and QoS2 messages is
+ * sent here, and the state of QoS2 messages is recorded in mqtt_obj->qos2_received if enabled, or in the MQTT core library, so that
+ * the PUBREL/PUBCOMP exchange is completed. Returns false if the packet is malformed or cannot be received.
+ */
+/* mqtt_receive_fragmented_publish must be protected under mqtt_obj->process_mutex */
+static bool mqtt_receive_fragmented_publish( cy_mqtt_object_t *mqtt_obj, uint8_t header, size_t remaining_length )
+{
+    MQTTContext_t           *context = &(mqtt_obj->mqtt_context);
+    uint8_t                 *buffer = context->networkBuffer.pBuffer;
+    size_t                  buffer_size = context->networkBuffer.size;
+    uint8_t                 field[ 2 ];
+    uint8_t                 qos = (uint8_t)((header >> 1) & 0x03U);
+    uint16_t                topic_len, packet_id = 0;
+    size_t                  variable_header_len, payload_len, offset = 0, chunk_len;
+    MQTTPublishState_t      state;
+    MQTTStatus_t            status;
+    MQTTPubAckType_t        ack_type;
+    bool                    deliver = true;
+    cy_mqtt_event_t         event;
+    cy_mqtt_message_fragment_t *fragment = &(event.data.fragment);
+
+    if( (qos > 2U) || (mqtt_receive_exact( mqtt_obj, field, 2 ) == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nFailed to receive fragmented PUBLISH packet..!\n" );
+        return false;
+    }
+    topic_len = (uint16_t)((field[ 0 ] << 8) | field[ 1 ]);
+    variable_header_len = sizeof( uint16_t ) + topic_len + ((qos > 0U) ? sizeof( uint16_t ) : 0U);
+    if( (topic_len == 0) || (variable_header_len > remaining_length) || (topic_len >= buffer_size) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nTopic of fragmented PUBLISH packet is invalid or larger than the network buffer..!\n" );
+        return false;
+    }
+
+    if( (mqtt_receive_exact( mqtt_obj, buffer, topic_len ) == false) ||
+        ((qos > 0U) && (mqtt_receive_exact( mqtt_obj, field, 2 ) == false)) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nFailed to receive fragmented PUBLISH packet..!\n" );
+        return false;
+    }
+
+    if( (qos == 2U) && (mqtt_obj->qos2_received != NULL) )
+    {
+        packet_id = (uint16_t)((field[ 0 ] << 8) | field[ 1 ]);
+        /* Duplicate of a QoS2 message whose PUBREL is not received yet; it is acknowledged again, but not delivered. */
+        deliver = mqtt_qos2_mark_received( mqtt_obj, packet_id );
+    }
+    else if( qos > 0U )
+    {
+        packet_id = (uint16_t)((field[ 0 ] << 8) | field[ 1 ]);
+        status = MQTT_UpdateStatePublish( context, packet_id, MQTT_RECEIVE, (MQTTQoS_t)qos, &state );
+        if( status == MQTTStateCollision )
+        {
+            /* Duplicate of a QoS2 message whose PUBREL is not received yet; it is acknowledged again, but not delivered. */
+            deliver = false;
+        }
+        else if( status != MQTTSuccess )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT_UpdateStatePublish failed for fragmented PUBLISH with status %s.\n", MQTT_Status_strerror( status ) );
+            return false;
+        }
+    }
+
+    memset( &event, 0x00, sizeof( cy_mqtt_event_t ) );
+    event.type = CY_MQTT_EVENT_TYPE_PUBLISH_FRAGMENT_RECEIVE;
+    fragment->packet_id = packet_id;
+    fragment->received_message.qos = ( qos == 0U ) ? CY_MQTT_QOS0 : (( qos == 1U ) ? CY_MQTT_QOS1 : CY_MQTT_QOS2);
+    fragment->received_message.retain = ( (header & CY_MQTT_PUBLISH_FLAG_RETAIN) != 0U );
+    fragment->received_message.dup = ( (header & CY_MQTT_PUBLISH_FLAG_DUP) != 0U );
+    fragment->received_message.topic = (const char *)buffer;
+    fragment->received_message.topic_len = topic_len;
+    payload_len = remaining_length - variable_header_len;
+    fragment->total_len = payload_len;
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nReceiving PUBLISH of %u bytes on topic %.*s in fragments.\n",
+                     (unsigned int)payload_len, topic_len, (const char *)buffer );
+
+    do
+    {
+        chunk_len = buffer_size - topic_len;
+        if( chunk_len > payload_len - offset )
+        {
+            chunk_len = payload_len - offset;
+        }
+        if( mqtt_receive_exact( mqtt_obj, &(buffer[ topic_len ]), chunk_len ) == false )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nFailed to receive fragment at offset %u of PUBLISH packet..!\n", (unsigned int)offset );
+            return false;
+        }
+
+        if( deliver == true )
+        {
+            fragment->received_message.payload = (const char *)&(buffer[ topic_len ]);
+            fragment->received_message.payload_len = chunk_len;
+            fragment->offset = offset;
+            fragment->first = ( offset == 0 );
+            fragment->last = ( offset + chunk_len == payload_len );
+            mqtt_deliver_publish_event( mqtt_obj, &event, (const char *)buffer, topic_len );
+        }
+        offset += chunk_len;
+    } while( offset < payload_len );
+
+    if( qos > 0U )
+    {
+        ack_type = ( qos == 1U ) ? MQTTPuback : MQTTPubrec;
+        if( mqtt_send_ack( mqtt_obj, ( qos == 1U ) ? MQTT_PACKET_TYPE_PUBACK : MQTT_PACKET_TYPE_PUBREC, packet_id ) == false )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nFailed to send acknowledgment of fragmented PUBLISH..!\n" );
+            return false;
+        }
+        if( (deliver == true) && ((qos == 1U) || (mqtt_obj->qos2_received == NULL)) )
+        {
+            (void)MQTT_UpdateStateAck( context, packet_id, ack_type, MQTT_SEND, &state );
+        }
+    }
+
+    return true;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_receive_packet_header
+ *
+ * Called when the MQTT core library starts reading a new packet. The fixed header of the packet is read into read_ahead to find
+ * the length of the packet. PUBLISH packets larger than the network buffer are received by mqtt_receive_fragmented_publish if
+ * fragmented receive is enabled, and QoS2 PUBLISH and PUBREL packets are received by mqtt_receive_qos2_publish and
+ * mqtt_receive_pubrel if the incoming QoS2 state is kept in mqtt_obj->qos2_received; the next packet is then checked. Returns 0 if no data is available, a negative value on failure,
+ * and 1 if the packet is left to the MQTT core library.
+ */
+/* mqtt_receive_packet_header must be protected under mqtt_obj->process_mutex */
+static int32_t mqtt_receive_packet_header( cy_mqtt_object_t *mqtt_obj )
+{
+    int32_t   bytes_received;
+    size_t    remaining_length;
+    uint16_t  header_len;
+    uint8_t   length_byte;
+    uint8_t   header;
+    bool      received;
+
+    while( true )
+    {
+        if( mqtt_obj->read_ahead_len == 0 )
+        {
+            bytes_received = cy_awsport_network_receive( &(mqtt_obj->network_context), (void *)mqtt_obj->read_ahead, CY_MQTT_RECEIVE_READ_AHEAD_SIZE );
+            if( bytes_received <= 0 )
+            {
+                return bytes_received;
+            }
+            mqtt_obj->read_ahead_offset = 0;
+            mqtt_obj->read_ahead_len = (uint16_t)bytes_received;
+            mqtt_obj->rx_data_received = true;
+        }
+
+        /* Decode the remaining length, reading the rest of the fixed header from the socket if needed. */
+        remaining_length = 0;
+        header_len = 1;
+        do
+        {
+            if( header_len == CY_MQTT_MAX_FIXED_HEADER_SIZE )
+            {
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid remaining length of the received packet..!\n" );
+                return -1;
+            }
+            if( (mqtt_obj->read_ahead_len <= header_len) && (mqtt_read_ahead_fill( mqtt_obj, header_len + 1 ) == false) )
+            {
+                return -1;
+            }
+            length_byte = mqtt_obj->read_ahead[ mqtt_obj->read_ahead_offset + header_len ];
+            remaining_length |= (size_t)(length_byte & 0x7FU) << (7U * (header_len - 1U));
+            header_len++;
+        } while( (length_byte & 0x80U) != 0 );
+
+        header = mqtt_obj->read_ahead[ mqtt_obj->read_ahead_offset ];
+        if( ((header & 0xF0U) == MQTT_PACKET_TYPE_PUBLISH) && (remaining_length > mqtt_obj->mqtt_context.networkBuffer.size) &&
+            (mqtt_obj->fragmented_receive == true) )
+        {
+            mqtt_obj->read_ahead_offset += header_len;
+            mqtt_obj->read_ahead_len -= header_len;
+            received = mqtt_receive_fragmented_publish( mqtt_obj, header, remaining_length );
+        }
+        else if( ((header & 0xF0U) == MQTT_PACKET_TYPE_PUBLISH) && (((header >> 1) & 0x03U) == 2U) &&
+                 (remaining_length <= mqtt_obj->mqtt_context.networkBuffer.size) && (mqtt_obj->qos2_received != NULL) )
+        {
+            mqtt_obj->read_ahead_offset += header_len;
+            mqtt_obj->read_ahead_len -= header_len;
+            received = mqtt_receive_qos2_publish( mqtt_obj, header, remaining_length );
+        }
+        else if( (header == MQTT_PACKET_TYPE_PUBREL) && (mqtt_obj->qos2_received != NULL) )
+        {
+            mqtt_obj->read_ahead_offset += header_len;
+            mqtt_obj->read_ahead_len -= header_len;
+            received = mqtt_receive_pubrel( mqtt_obj, remaining_length );
+        }
+        else
+        {
+            mqtt_obj->rx_packet_remaining = header_len + remaining_length;
+            return 1;
+        }
+
+        if( received == false )
+        {
+            return -1;
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+int32_t mqtt_awsport_network_receive( NetworkContext_t *network_context, void *buffer, size_t bytes_recv )
+{
+    cy_mqtt_object_t *mqtt_obj = (cy_mqtt_object_t *)network_context->receive_info.user_data;
+    int32_t          result;
+
+    if( mqtt_obj->rx_packet_remaining == 0 )
+    {
+        result = mqtt_receive_packet_header( mqtt_obj );
+        if( result <= 0 )
+        {
+            return result;
+        }
+    }
+
+    result = mqtt_receive_data( mqtt_obj, buffer, bytes_recv );
+    if( result > 0 )
+    {
+        mqtt_obj->rx_packet_remaining = ( (size_t)result < mqtt_obj->rx_packet_remaining ) ? (mqtt_obj->rx_packet_remaining - (size_t)result) : 0;
+    }
+
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_awsport_network_send
+ *
+ * Transport send function of the MQTT core library. Holds mqtt_obj->tx_mutex for the write, so that the packets
+ * sent by the core library, such as acknowledgments and ping requests, are not written in the middle of a PUBLISH
+ * packet written without mqtt_obj->process_mutex.
+ */
+static int32_t mqtt_awsport_network_send( NetworkContext_t *network_context, const void *buffer, size_t bytes_send )
+{
+    cy_mqtt_object_t *mqtt_obj = (cy_mqtt_object_t *)network_context->receive_info.user_data;
+    int32_t          result;
+
+    (void)cy_rtos_get_mutex( &(mqtt_obj->tx_mutex), CY_RTOS_NEVER_TIMEOUT );
+    result = cy_awsport_network_send( network_context, buffer, bytes_send );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->tx_mutex) );
+
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+static cy_rslt_t mqtt_initialize_core_lib( MQTTContext_t *param_mqtt_context,
+                                           NetworkContext_t *param_network_context,
+                                           uint8_t *networkbuff, uint32_t buff_len )
+{
+    cy_rslt_t            result = CY_RSLT_SUCCESS;
+    MQTTStatus_t         mqttStatus = MQTTSuccess;
+    MQTTFixedBuffer_t    networkBuffer;
+    TransportInterface_t transport;
+
+    if( (param_mqtt_context == NULL) || (param_network_context == NULL) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Bad arguments to mqtt_initialize_core_lib.\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    memset( &networkBuffer, 0x00, sizeof(MQTTFixedBuffer_t) );
+    memset( &transport, 0x00, sizeof(TransportInterface_t) );
+
+    /* Fill in TransportInterface send and receive function pointers. */
+    transport.pNetworkContext = param_network_context;
+    transport.send = (TransportSend_t)&mqtt_awsport_network_send;
+    transport.recv = (TransportRecv_t)&mqtt_awsport_network_receive;
+
+    /* Fill the values for the network buffer. */
+    networkBuffer.pBuffer = networkbuff;
+    networkBuffer.size = buff_len;
+
+    /* Initialize the MQTT library. */
+    mqttStatus = MQTT_Init( param_mqtt_context, &transport, Clock_GetTimeMs,
+                            mqtt_event_callback, &networkBuffer );
+    if( mqttStatus != MQTTSuccess )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n MQTT init failed with Status = %s.\n", MQTT_Status_strerror( mqttStatus ) );
+        result = CY_RSLT_MODULE_MQTT_INIT_FAIL;
+    }
+
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_spool_storage_access
+ *
+ * Read or write length bytes at the offset pos of the journal data region of the publish spool,
+ * wrapping around the end of the region.
+ */
+static cy_rslt_t mqtt_spool_storage_access( cy_mqtt_spool_t *spool, uint32_t pos, void *buffer, uint32_t length, bool write )
+{
+    cy_rslt_t  result = CY_RSLT_SUCCESS;
+    uint8_t    *data = (uint8_t *)buffer;
+    uint32_t   chunk;
+
+    pos = pos % spool->data_size;
+    while( (length > 0) && (result == CY_RSLT_SUCCESS) )
+    {
+        chunk = spool->data_size - pos;
+        if( chunk > length )
+        {
+            chunk = length;
+        }
+
+        if( write == true )
+        {
+            result = spool->storage.write( spool->storage.storage_ctx, CY_MQTT_SPOOL_DATA_OFFSET + pos, data, chunk );
+        }
+        else
+        {
+            result = spool->storage.read( spool->storage.storage_ctx, CY_MQTT_SPOOL_DATA_OFFSET + pos, data, chunk );
+        }
+
+        data += chunk;
+        length -= chunk;
+        pos = 0;
+    }
+
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nPublish spool storage %s failed with Error : [0x%X] \n", (write == true) ? "write" : "read", (unsigned int)result );
+    }
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+static cy_rslt_t mqtt_spool_storage_sync( cy_mqtt_spool_t *spool )
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if( spool->storage.sync != NULL )
+    {
+        result = spool->storage.sync( spool->storage.storage_ctx );
+        if( result != CY_RSLT_SUCCESS )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nPublish spool storage sync failed with Error : [0x%X] \n", (unsigned int)result );
+        }
+    }
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_spool_header_checksum
+ *
+ * CRC-32 (IEEE 802.3) of the header fields preceding the checksum.
+ */
+static uint32_t mqtt_spool_header_checksum( const cy_mqtt_spool_header_t *header )
+{
+    const uint8_t  *data = (const uint8_t *)header;
+    uint32_t       crc = 0xFFFFFFFFUL;
+    size_t         i;
+    uint8_t        bit;
+
+    for( i = 0; i < offsetof( cy_mqtt_spool_header_t, checksum ); i++ )
+    {
+        crc ^= data[ i ];
+        for( bit = 0; bit < 8; bit++ )
+        {
+            crc = ( crc >> 1 ) ^ ( 0xEDB88320UL & ( 0UL - ( crc & 1UL ) ) );
+        }
+    }
+    return ~crc;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_spool_write_header
+ *
+ * Persist the head and the committed length of the journal. The two header copies are written alternately,
+ * so that a valid copy remains if the write is interrupted.
+ */
+/* mqtt_spool_write_header must be protected under spool->mutex */
+static cy_rslt_t mqtt_spool_write_header( cy_mqtt_spool_t *spool )
+{
+    cy_rslt_t               result = CY_RSLT_SUCCESS;
+    cy_mqtt_spool_header_t  header;
+
+    spool->sequence++;
+    header.magic = CY_MQTT_SPOOL_HEADER_MAGIC;
+    header.sequence = spool->sequence;
+    header.head = spool->head;
+    header.used = spool->used;
+    header.checksum = mqtt_spool_header_checksum( &header );
+
+    result = spool->storage.write( spool->storage.storage_ctx, ( spool->sequence & 1U ) * sizeof( header ), &header, sizeof( header ) );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nPublish spool header write failed with Error : [0x%X] \n", (unsigned int)result );
+        return result;
+    }
+    return mqtt_spool_storage_sync( spool );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+static cy_rslt_t mqtt_spool_load_header( cy_mqtt_spool_t *spool )
+{
+    cy_rslt_t               result = CY_RSLT_SUCCESS;
+    cy_mqtt_spool_header_t  header;
+    bool                    header_found = false;
+    uint32_t                slot;
+
+    for( slot = 0; slot < 2; slot++ )
+    {
+        result = spool->storage.read( spool->storage.storage_ctx, slot * sizeof( header ), &header, sizeof( header ) );
+        if( result != CY_RSLT_SUCCESS )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nPublish spool header read failed with Error : [0x%X] \n", (unsigned int)result );
+            return result;
+        }
+
+        if( (header.magic != CY_MQTT_SPOOL_HEADER_MAGIC) || (header.checksum != mqtt_spool_header_checksum( &header )) ||
+            (header.head >= spool->data_size) || (header.used > spool->data_size) )
+        {
+            continue;
+        }
+
+        if( (header_found == false) || ((int32_t)(header.sequence - spool->sequence) > 0) )
+        {
+            spool->sequence = header.sequence;
+            spool->head = header.head;
+            spool->used = header.used;
+            header_found = true;
+        }
+    }
+
+    if( header_found == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nPublish spool storage is not initialized. Creating an empty spool.\n" );
+        spool->sequence = 0;
+        spool->head = 0;
+        spool->used = 0;
+        return mqtt_spool_write_header( spool );
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nPublish spool resumed with %u bytes of unacknowledged messages.\n", (unsigned int)spool->used );
+    return CY_RSLT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_spool_commit
+ *
+ * Group commit: write the records collected in the commit buffer with a single storage write,
+ * then make them part of the journal by persisting the header.
+ */
+/* mqtt_spool_commit must be protected under spool->mutex */
+static cy_rslt_t mqtt_spool_commit( cy_mqtt_spool_t *spool )
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if( spool->commit_length == 0 )
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    result = mqtt_spool_storage_access( spool, spool->head + spool->used, spool->commit_buffer, spool->commit_length, true );
+    if( result == CY_RSLT_SUCCESS )
+    {
+        result = mqtt_spool_storage_sync( spool );
+    }
+    if( result != CY_RSLT_SUCCESS )
+    {
+        return result;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nCommitted %u bytes to the publish spool.\n", (unsigned int)spool->commit_length );
+    spool->used += spool->commit_length;
+    spool->commit_length = 0;
+    return mqtt_spool_write_header( spool );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+static cy_rslt_t mqtt_spool_append( cy_mqtt_spool_t *spool, cy_mqtt_publish_info_t *pubmsg )
+{
+    cy_rslt_t               result = CY_RSLT_SUCCESS;
+    cy_mqtt_spool_record_t  record;
+    uint32_t                record_length;
+    uint32_t                pos;
+
+    if( ((pubmsg->qos != CY_MQTT_QOS0) && (pubmsg->qos != CY_MQTT_QOS1) && (pubmsg->qos != CY_MQTT_QOS2)) ||
+        (pubmsg->topic == NULL) || (pubmsg->topic_len == 0) || ((pubmsg->payload == NULL) && (pubmsg->payload_len != 0)) ||
+        (pubmsg->payload_len > spool->data_size) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMessage cannot be added to the publish spool..!\n" );
+        return CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
+    }
+
+    record.magic = CY_MQTT_SPOOL_RECORD_MAGIC;
+    record.payload_len = (uint32_t)pubmsg->payload_len;
+    record.topic_len = pubmsg->topic_len;
+    record.qos = (uint8_t)pubmsg->qos;
+    record.retain = ( pubmsg->retain == true ) ? 1U : 0U;
+    record_length = sizeof( record ) + record.topic_len + record.payload_len;
+
+    result = cy_rtos_get_mutex( &(spool->mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", spool->mutex, (unsigned int)result );
+        return result;
+    }
+
+    if( record_length > (spool->data_size - spool->used - spool->commit_length) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nPublish spool is full..!\n" );
+        result = CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
+        goto exit;
+    }
+
+    if( (spool->commit_length + record_length) > CY_MQTT_SPOOL_COMMIT_BUFFER_SIZE )
+    {
+        result = mqtt_spool_commit( spool );
+        if( result != CY_RSLT_SUCCESS )
+        {
+            goto exit;
+        }
+    }
+
+    if( record_length <= CY_MQTT_SPOOL_COMMIT_BUFFER_SIZE )
+    {
+        memcpy( &(spool->commit_buffer[ spool->commit_length ]), &record, sizeof( record ) );
+        memcpy( &(spool->commit_buffer[ spool->commit_length + sizeof( record ) ]), pubmsg->topic, record.topic_len );
+        if( record.payload_len > 0 )
+        {
+            memcpy( &(spool->commit_buffer[ spool->commit_length + sizeof( record ) + record.topic_len ]), pubmsg->payload, record.payload_len );
+        }
+        spool->commit_length += record_length;
+        goto exit;
+    }
+
+    /* The record does not fit in the commit buffer, so it is written to the journal directly. */
+    pos = spool->head + spool->used;
+    result = mqtt_spool_storage_access( spool, pos, &record, sizeof( record ), true );
+    if( result == CY_RSLT_SUCCESS )
+    {
+        result = mqtt_spool_storage_access( spool, pos + sizeof( record ), (void *)pubmsg->topic, record.topic_len, true );
+    }
+    if( result == CY_RSLT_SUCCESS )
+    {
+        result = mqtt_spool_storage_access( spool, pos + sizeof( record ) + record.topic_len, (void *)pubmsg->payload, record.payload_len, true );
+    }
+    if( result == CY_RSLT_SUCCESS )
+    {
+        result = mqtt_spool_storage_sync( spool );
+    }
+    if( result == CY_RSLT_SUCCESS )
+    {
+        spool->used += record_length;
+        result = mqtt_spool_write_header( spool );
+    }
+
+exit :
+    (void)cy_rtos_set_mutex( &(spool->mutex) );
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_spool_release_acked
+ *
+ * Advance the head of the journal over the records acknowledged in journal order, and persist it every
+ * CY_MQTT_SPOOL_ACK_PERSIST_INTERVAL records. Once all the inflight messages are done after a failure,
+ * the records that were not acknowledged are marked to be published again; the acknowledged ones are not.
+ */
+/* mqtt_spool_release_acked must be protected under spool->mutex */
+static void mqtt_spool_release_acked( cy_mqtt_spool_t *spool )
+{
+    cy_mqtt_spool_inflight_t  *entry = NULL;
+    bool                      released = false;
+    uint16_t                  i;
+
+    while( spool->inflight_count > 0 )
+    {
+        entry = &(spool->inflight[ spool->inflight_head ]);
+        if( (entry->done == false) || (entry->acked == false) )
+        {
+            break;
+        }
+        spool->head = ( spool->head + entry->length ) % spool->data_size;
+        spool->used -= entry->length;
+        spool->read_offset -= entry->length;
+        spool->inflight_head = ( spool->inflight_head + 1 ) % MQTT_STATE_ARRAY_MAX_COUNT;
+        spool->inflight_count--;
+        spool->acks_since_persist++;
+        released = true;
+    }
+
+    if( (spool->rewind == true) && (spool->inflight_pending == 0) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nPublishing the unacknowledged spooled messages again.\n" );
+        for( i = 0; i < spool->inflight_count; i++ )
+        {
+            entry = &(spool->inflight[ (spool->inflight_head + i) % MQTT_STATE_ARRAY_MAX_COUNT ]);
+            if( entry->acked == false )
+            {
+                entry->done = false;
+                entry->resend = true;
+            }
+        }
+        spool->rewind = false;
+    }
+
+    if( (released == true) && ((spool->acks_since_persist >= CY_MQTT_SPOOL_ACK_PERSIST_INTERVAL) || (spool->used == 0)) )
+    {
+        if( mqtt_spool_write_header( spool ) == CY_RSLT_SUCCESS )
+        {
+            spool->acks_since_persist = 0;
+        }
+    }
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+static void mqtt_spool_publish_complete( cy_mqtt_t mqtt_handle, cy_mqtt_publish_token_t token, cy_mqtt_publish_status_t status, void *user_data )
+{
+    cy_mqtt_spool_t           *spool = (cy_mqtt_spool_t *)user_data;
+    cy_mqtt_spool_inflight_t  *entry = NULL;
+    uint16_t                  i;
+
+    (void)mqtt_handle;
+
+    if( cy_rtos_get_mutex( &(spool->mutex), CY_RTOS_NEVER_TIMEOUT ) != CY_RSLT_SUCCESS )
+    {
+        return;
+    }
+
+    for( i = 0; i < spool->inflight_count; i++ )
+    {
+        entry = &(spool->inflight[ (spool->inflight_head + i) % MQTT_STATE_ARRAY_MAX_COUNT ]);
+        if( (entry->done == false) && (entry->token == token) )
+        {
+            entry->done = true;
+            entry->acked = ( status == CY_MQTT_PUBLISH_STATUS_ACKED );
+            free( entry->buffer );
+            entry->buffer = NULL;
+            spool->inflight_pending--;
+            if( entry->acked == false )
+            {
+                spool->rewind = true;
+            }
+            break;
+        }
+    }
+
+    mqtt_spool_release_acked( spool );
+    (void)cy_rtos_set_mutex( &(spool->mutex) );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_spool_read_record
+ *
+ * Read and validate the header of the record at the offset from the head of the journal.
+ */
+/* mqtt_spool_read_record must be protected under spool->mutex */
+static bool mqtt_spool_read_record( cy_mqtt_spool_t *spool, uint32_t offset, cy_mqtt_spool_record_t *record )
+{
+    uint32_t record_length;
+
+    if( mqtt_spool_storage_access( spool, spool->head + offset, record, sizeof( cy_mqtt_spool_record_t ), false ) != CY_RSLT_SUCCESS )
+    {
+        return false;
+    }
+    record_length = sizeof( cy_mqtt_spool_record_t ) + record->topic_len + record->payload_len;
+    if( (record->magic != CY_MQTT_SPOOL_RECORD_MAGIC) || (record->qos > CY_MQTT_QOS2) || (record->topic_len == 0) ||
+        (record->payload_len > spool->data_size) || (record_length > (spool->used - offset)) )
+    {
+        return false;
+    }
+    return true;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_spool_publish_record
+ *
+ * Publish the record at the offset from the head of the journal, and track it in the inflight entry.
+ */
+/* mqtt_spool_publish_record must be protected under spool->mutex */
+static cy_rslt_t mqtt_spool_publish_record( cy_mqtt_object_t *mqtt_obj, cy_mqtt_spool_t *spool, uint32_t offset,
+                                            const cy_mqtt_spool_record_t *record, cy_mqtt_spool_inflight_t *entry )
+{
+    cy_rslt_t                 result = CY_RSLT_SUCCESS;
+    cy_mqtt_publish_info_t    pubmsg;
+    uint8_t                   *buffer = NULL;
+
+    buffer = (uint8_t *)malloc( record->topic_len + record->payload_len );
+    if( buffer == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to publish spooled message..!\n" );
+        return CY_RSLT_MODULE_MQTT_NOMEM;
+    }
+    result = mqtt_spool_storage_access( spool, spool->head + offset + sizeof( cy_mqtt_spool_record_t ), buffer,
+                                        record->topic_len + record->payload_len, false );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        free( buffer );
+        return result;
+    }
+
+    memset( &pubmsg, 0x00, sizeof( pubmsg ) );
+    pubmsg.qos = (cy_mqtt_qos_t)record->qos;
+    pubmsg.retain = ( record->retain != 0U );
+    pubmsg.topic = (const char *)buffer;
+    pubmsg.topic_len = record->topic_len;
+    pubmsg.payload = (const char *)&(buffer[ record->topic_len ]);
+    pubmsg.payload_len = record->payload_len;
+
+    result = cy_mqtt_publish_async( (cy_mqtt_t)mqtt_obj, &pubmsg, mqtt_spool_publish_complete, spool, &(entry->token) );
+    if( result == CY_RSLT_MODULE_MQTT_RATE_LIMITED )
+    {
+        /* Draining resumes when the async ack timer fires, even if no completion is pending. */
+        (void)start_async_ack_timer( mqtt_obj, CY_MQTT_RATE_LIMIT_RETRY_INTERVAL_MS, true );
+    }
+    if( result != CY_RSLT_SUCCESS )
+    {
+        /* The inflight window is full or the session is lost. Draining resumes on the next publish completion. */
+        free( buffer );
+        return result;
+    }
+
+    entry->resend = false;
+    if( pubmsg.qos == CY_MQTT_QOS0 )
+    {
+        entry->done = true;
+        entry->acked = true;
+        free( buffer );
+    }
+    else
+    {
+        entry->buffer = buffer;
+        spool->inflight_pending++;
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_spool_drain
+ *
+ * Publish the spooled messages in journal order, keeping as many of them awaiting an acknowledgment
+ * as the inflight window allows. The messages to be published again after a failure are published first.
+ * Invoked from mqtt_event_processing_thread.
+ */
+static void mqtt_spool_drain( cy_mqtt_object_t *mqtt_obj )
+{
+    cy_rslt_t                 result = CY_RSLT_SUCCESS;
+    cy_mqtt_spool_t           *spool = mqtt_obj->spool;
+    cy_mqtt_spool_record_t    record;
+    cy_mqtt_spool_inflight_t  *entry = NULL;
+    uint32_t                  offset = 0;
+    uint16_t                  i;
+
+    if( spool == NULL )
+    {
+        return;
+    }
+
+    if( cy_rtos_get_mutex( &(spool->mutex), CY_RTOS_NEVER_TIMEOUT ) != CY_RSLT_SUCCESS )
+    {
+        return;
+    }
+
+    /* Messages spooled before the session was established are published first. */
+    (void)mqtt_spool_commit( spool );
+    mqtt_spool_release_acked( spool );
+
+    for( i = 0; (i < spool->inflight_count) && (result == CY_RSLT_SUCCESS) && (spool->rewind == false) &&
+                (mqtt_obj->mqtt_session_established == true); i++ )
+    {
+        entry = &(spool->inflight[ (spool->inflight_head + i) % MQTT_STATE_ARRAY_MAX_COUNT ]);
+        if( entry->resend == true )
+        {
+            if( mqtt_spool_read_record( spool, offset, &record ) == false )
+            {
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nPublish spool record at offset %u cannot be read again..!\n", (unsigned int)offset );
+                break;
+            }
+            result = mqtt_spool_publish_record( mqtt_obj, spool, offset, &record, entry );
+        }
+        offset += entry->length;
+    }
+
+    while( (result == CY_RSLT_SUCCESS) && (spool->rewind == false) && (mqtt_obj->mqtt_session_established == true) &&
+           (spool->inflight_count < MQTT_STATE_ARRAY_MAX_COUNT) && (spool->read_offset < spool->used) )
+    {
+        if( mqtt_spool_read_record( spool, spool->read_offset, &record ) == false )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nPublish spool record at offset %u is corrupted. Dropping the rest of the spool..!\n",
+                             (unsigned int)spool->read_offset );
+            spool->used = spool->read_offset;
+            (void)mqtt_spool_write_header( spool );
+            break;
+        }
+
+        entry = &(spool->inflight[ (spool->inflight_head + spool->inflight_count) % MQTT_STATE_ARRAY_MAX_COUNT ]);
+        memset( entry, 0x00, sizeof( cy_mqtt_spool_inflight_t ) );
+        entry->length = sizeof( record ) + record.topic_len + record.payload_len;
+
+        result = mqtt_spool_publish_record( mqtt_obj, spool, spool->read_offset, &record, entry );
+        if( result == CY_RSLT_SUCCESS )
+        {
+            spool->inflight_count++;
+            spool->read_offset += entry->length;
+        }
+    }
+
+    mqtt_spool_release_acked( spool );
+    (void)cy_rtos_set_mutex( &(spool->mutex) );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+static void mqtt_spool_free( cy_mqtt_object_t *mqtt_obj )
+{
+    cy_mqtt_spool_t  *spool = mqtt_obj->spool;
+    uint16_t         i;
+
+    if( spool == NULL )
+    {
+        return;
+    }
+
+    if( cy_rtos_get_mutex( &(spool->mutex), CY_RTOS_NEVER_TIMEOUT ) == CY_RSLT_SUCCESS )
+    {
+        /* Persist the spooled and acknowledged messages, so that the spool can be resumed. */
+        (void)mqtt_spool_commit( spool );
+        if( spool->acks_since_persist > 0 )
+        {
+            (void)mqtt_spool_write_header( spool );
+        }
+        (void)cy_rtos_set_mutex( &(spool->mutex) );
+    }
+
+    for( i = 0; i < MQTT_STATE_ARRAY_MAX_COUNT; i++ )
+    {
+        if( spool->inflight[ i ].buffer != NULL )
+        {
+            free( spool->inflight[ i ].buffer );
+        }
+    }
+    (void)cy_rtos_deinit_mutex( &(spool->mutex) );
+    free( spool->commit_buffer );
+    free( spool );
+    mqtt_obj->spool = NULL;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/* mqtt_check_async_publish_deadlines must be protected under mqtt_obj->process_mutex */
+static void mqtt_check_async_publish_deadlines( cy_mqtt_object_t *mqtt_obj )
+{
+    cy_mqtt_pubpack_t  *pubpack = NULL;
+    uint16_t           index = 0;
+    uint32_t           now = Clock_GetTimeMs();
+    uint32_t           next_timeout = 0;
+    bool               async_pending = false;
+
+    if( mqtt_obj->mqtt_session_established == false )
+    {
+        /* Deadlines are refreshed when the session is resumed. */
+        return;
+    }
+
+    for( index = 0; index < mqtt_obj->pub_window_size; index++ )
+    {
+        pubpack = &(mqtt_obj->outgoing_pub_packets[ index ]);
+        if( (pubpack->async == false) || (pubpack->completed == true) || (pubpack->packetid == MQTT_PACKET_ID_INVALID) )
+        {
+            continue;
+        }
+
+        if( (int32_t)(now - pubpack->ack_deadline_ms) >= 0 )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nAsync PUBLISH with packet id %u timed out.\n", pubpack->packetid );
+            mqtt_complete_async_publish( mqtt_obj, index, CY_MQTT_PUBLISH_STATUS_TIMEOUT );
+        }
+        else if( (async_pending == false) || ((pubpack->ack_deadline_ms - now) < next_timeout) )
+        {
+            next_timeout = pubpack->ack_deadline_ms - now;
+            async_pending = true;
+        }
+    }
+
+    if( async_pending == true )
+    {
+        (void)start_async_ack_timer( mqtt_obj, next_timeout, true );
+    }
+}
+
+/*
+ * mqtt_process_async_publishes
+ *
+ * Report the completed and timed-out asynchronous publishes to the application.
+ * The completion callbacks are invoked after releasing mqtt_obj->process_mutex, so that
+ * cy_mqtt_publish_async can be called from the completion callback.
+ */
+static void mqtt_process_async_publishes( cy_mqtt_object_t *mqtt_obj )
+{
+    cy_rslt_t                  result = CY_RSLT_SUCCESS;
+    cy_mqtt_pub_completion_t   completions[ CY_MQTT_ASYNC_COMPLETION_BATCH_SIZE ];
+    cy_mqtt_pubpack_t          *pubpack = NULL;
+    uint8_t                    num_of_completions = 0;
+    uint8_t                    i = 0;
+    uint16_t                   index = 0;
+    bool                       more_completions = false;
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_process_async_publishes - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        return;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_process_async_publishes - Acquired Mutex %p \n", mqtt_obj->process_mutex );
+
+    if( mqtt_obj->deleted == true )
+    {
+        (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+        return;
+    }
+
+    if( mqtt_take_async_publish_event( mqtt_obj ) == true )
+    {
+        mqtt_check_async_publish_deadlines( mqtt_obj );
+    }
+
+    do
+    {
+        /* Take a batch of entries off the completion list. */
+        num_of_completions = 0;
+        while( (num_of_completions < CY_MQTT_ASYNC_COMPLETION_BATCH_SIZE) && (mqtt_obj->async_completed_head != CY_MQTT_PUB_INDEX_INVALID) )
+        {
+            index = mqtt_obj->async_completed_head;
+            pubpack = &(mqtt_obj->outgoing_pub_packets[ index ]);
+            mqtt_obj->async_completed_head = pubpack->next_completed;
+            if( mqtt_obj->async_completed_head == CY_MQTT_PUB_INDEX_INVALID )
+            {
+                mqtt_obj->async_completed_tail = CY_MQTT_PUB_INDEX_INVALID;
+            }
+
+            completions[ num_of_completions ].complete_cb = pubpack->complete_cb;
+            completions[ num_of_completions ].complete_cb_data = pubpack->complete_cb_data;
+            completions[ num_of_completions ].token = pubpack->packetid;
+            completions[ num_of_completions ].status = pubpack->status;
+            num_of_completions++;
+            (void)mqtt_cleanup_outgoing_publish( mqtt_obj, index );
+        }
+        more_completions = ( mqtt_obj->async_completed_head != CY_MQTT_PUB_INDEX_INVALID );
+
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_process_async_publishes - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+        result = cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+        if( result != CY_RSLT_SUCCESS )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        }
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_process_async_publishes - Released Mutex %p \n", mqtt_obj->process_mutex );
+
+        for( i = 0; i < num_of_completions; i++ )
+        {
+            if( completions[ i ].complete_cb != NULL )
+            {
+                completions[ i ].complete_cb( (cy_mqtt_t)mqtt_obj, completions[ i ].token,
+                                              completions[ i ].status, completions[ i ].complete_cb_data );
+            }
+        }
+
+        if( more_completions == true )
+        {
+            result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+            if( result != CY_RSLT_SUCCESS )
+            {
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+                return;
+            }
+        }
+    } while( more_completions == true );
+
+    /* Publish more spooled messages into the inflight slots released by the completions. */
+    mqtt_spool_drain( mqtt_obj );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_prepare_connect_info
+ *
+ * Fill the core MQTT library connect information and will message from connect_info.
+ */
+static cy_rslt_t mqtt_prepare_connect_info( cy_mqtt_object_t *mqtt_obj, const cy_mqtt_connect_info_t *connect_info,
+                                            MQTTConnectInfo_t *connect_details, MQTTPublishInfo_t *will_msg_details,
+                                            MQTTPublishInfo_t **will_msg_ptr )
+{
+    memset( connect_details, 0x00, sizeof( MQTTConnectInfo_t ) );
+    memset( will_msg_details, 0x00, sizeof( MQTTPublishInfo_t ) );
+
+    /* Connect Information */
+    connect_details->cleanSession = connect_info->clean_session;
+    connect_details->keepAliveSeconds = connect_info->keep_alive_sec;
+    connect_details->pClientIdentifier = connect_info->client_id;
+    connect_details->clientIdentifierLength = connect_info->client_id_len;
+    connect_details->pPassword = connect_info->password;
+    connect_details->passwordLength = connect_info->password_len;
+    connect_details->pUserName = connect_info->username;
+    connect_details->userNameLength = connect_info->username_len;
+
+    /* Store the keepAlivetimeout */
+    mqtt_obj->keepAliveSeconds = connect_info->keep_alive_sec;
+
+    if( connect_info->will_info != NULL )
+    {
+        /* Will information. */
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nWill info is not NULL ..!\n" );
+
+        if( connect_info->will_info->qos > CY_MQTT_QOS2 )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid Will msg QoS..!\n" );
+            return CY_RSLT_MODULE_MQTT_CONNECT_FAIL;
+        }
+        if( (connect_info->will_info->dup != true) && (connect_info->will_info->dup != false) )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid Will msg dup..!\n" );
+            return CY_RSLT_MODULE_MQTT_CONNECT_FAIL;
+        }
+        if( (connect_info->will_info->retain != true) && (connect_info->will_info->retain != false) )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid Will msg retain..!\n" );
+            return CY_RSLT_MODULE_MQTT_CONNECT_FAIL;
+        }
+
+        if( connect_info->will_info->qos == CY_MQTT_QOS0 )
+        {
+            will_msg_details->qos = MQTTQoS0;
+        }
+        else if( connect_info->will_info->qos == CY_MQTT_QOS1 )
+        {
+            will_msg_details->qos = MQTTQoS1;
+        }
+        else
+        {
+            will_msg_details->qos = MQTTQoS2;
+        }
+
+        will_msg_details->dup = connect_info->will_info->dup;
+        will_msg_details->retain = connect_info->will_info->retain;
+        will_msg_details->pTopicName = connect_info->will_info->topic;
+        will_msg_details->topicNameLength = connect_info->will_info->topic_len;
+        will_msg_details->pPayload = connect_info->will_info->payload;
+        will_msg_details->payloadLength = connect_info->will_info->payload_len;
+        *will_msg_ptr = will_msg_details;
+    }
+    else
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nWill info is NULL ..!\n" );
+        *will_msg_ptr = NULL;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*
+ * mqtt_network_open
+ *
+ * Create the socket of a new connection to the MQTT broker and establish the TLS session, in a single attempt.
+ */
+/* mqtt_network_open must be protected under mqtt_obj->process_mutex */
+static cy_rslt_t mqtt_network_open( cy_mqtt_object_t *mqtt_obj )
+{
+    cy_rslt_t                     result = CY_RSLT_SUCCESS;
+    cy_awsport_ssl_credentials_t  *security = NULL;
+    bool                          session_offered = false;
+
+    if( mqtt_obj->mqtt_secure_mode == true )
+    {
+        security = &(mqtt_obj->security);
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nCreating MQTT socket..\n" );
+    result = cy_awsport_network_create( &(mqtt_obj->network_context), &(mqtt_obj->server_info), security, &(mqtt_obj->network_context.disconnect_info), &(mqtt_obj->network_context.receive_info) );
+    if ( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_awsport_network_create failed with Error : [0x%X] \n", (unsigned int)result );
+        return result;
+    }
+
+    /* Discard the data read ahead on the previous connection. */
+    mqtt_obj->read_ahead_offset = 0;
+    mqtt_obj->read_ahead_len = 0;
+    mqtt_obj->rx_packet_remaining = 0;
+
+    /* Offer the TLS session of the last connection, so that the broker can resume it instead of a full handshake. */
+    session_offered = mqtt_tls_session_offer( mqtt_obj );
+
+    /* Establish a TLS session with the MQTT broker. */
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "Establishing a TLS session to %.*s:%d.\n",
+                     strlen(mqtt_obj->server_info.host_name), mqtt_obj->server_info.host_name, mqtt_obj->server_info.port );
+    result = cy_awsport_network_connect( &(mqtt_obj->network_context),
+                                         CY_MQTT_MESSAGE_SEND_TIMEOUT_MS,
+                                         CY_MQTT_SOCKET_RECEIVE_TIMEOUT_MS );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_awsport_network_connect failed with Error : [0x%X] \n", (unsigned int)result );
+        if( session_offered == true )
+        {
+            /* The broker may not accept the session any more; the next attempt performs a full handshake. */
+            mqtt_tls_session_clear( mqtt_obj );
+        }
+        (void)cy_awsport_network_delete( &(mqtt_obj->network_context) );
+        /*
+         * In case of an unexpected network disconnection, the cy_awsport_network_delete API always returns failure. Therefore,
+         * the return value of the cy_awsport_network_delete API is not checked here.
+         */
+        return result;
+    }
+
+    mqtt_tls_session_save( mqtt_obj );
+    return CY_RSLT_SUCCESS;
+}
+
+/*
+ * mqtt_endpoint_is_healthy
+ *
+ * An endpoint is healthy if its last connection succeeded, or if its last failure is older than
+ * CY_MQTT_BROKER_FAILURE_HOLDDOWN_MS, so that a recovered broker is preferred again.
+ */
+static bool mqtt_endpoint_is_healthy( cy_mqtt_endpoint_state_t *state, uint32_t now_ms )
+{
+    if( state->failures == 0 )
+    {
+        return true;
+    }
+    return ( (uint32_t)(now_ms - state->last_failure_ms) >= CY_MQTT_BROKER_FAILURE_HOLDDOWN_MS ) ? true : false;
+}
+
+/*
+ * mqtt_endpoint_precedes
+ *
+ * Returns true if the endpoint a is tried before the endpoint b. Healthy endpoints are tried first, then
+ * the endpoints with the lower priority value; endpoints of the same priority are ordered by their
+ * measured connection time. The order of the endpoint list breaks the remaining ties.
+ */
+static bool mqtt_endpoint_precedes( cy_mqtt_endpoint_state_t *a, cy_mqtt_endpoint_state_t *b, uint32_t now_ms )
+{
+    bool a_healthy = mqtt_endpoint_is_healthy( a, now_ms );
+    bool b_healthy = mqtt_endpoint_is_healthy( b, now_ms );
+
+    if( a_healthy != b_healthy )
+    {
+        return a_healthy;
+    }
+    if( (a_healthy == false) && (a->failures != b->failures) )
+    {
+        return ( a->failures < b->failures ) ? true : false;
+    }
+    if( a->endpoint.priority != b->endpoint.priority )
+    {
+        return ( a->endpoint.priority < b->endpoint.priority ) ? true : false;
+    }
+    if( (a->connect_time_ms != 0) && (b->connect_time_ms != 0) && (a->connect_time_ms != b->connect_time_ms) )
+    {
+        return ( a->connect_time_ms < b->connect_time_ms ) ? true : false;
+    }
+    return false;
+}
+
+/*
+ * mqtt_network_open_endpoints
+ *
+ * Open the network connection to the first reachable broker endpoint. Each endpoint is tried once, in the
+ * order of mqtt_endpoint_precedes, so that an unreachable broker costs a single attempt before the next one
+ * is tried. The outcome of each attempt updates the health of the endpoint.
+ * Without broker endpoints, the broker passed to cy_mqtt_create is used.
+ */
+/* mqtt_network_open_endpoints must be protected under mqtt_obj->process_mutex */
+static cy_rslt_t mqtt_network_open_endpoints( cy_mqtt_object_t *mqtt_obj )
+{
+    cy_rslt_t                 result = CY_RSLT_MODULE_MQTT_CONNECT_FAIL;
+    cy_mqtt_endpoint_state_t  *state;
+    uint8_t                   order[ CY_MQTT_MAX_BROKER_ENDPOINTS ];
+    uint8_t                   index, pos;
+    uint32_t                  now_ms, elapsed_ms;
+
+    if( mqtt_obj->endpoint_count == 0 )
+    {
+        return mqtt_network_open( mqtt_obj );
+    }
+
+    /* Insertion sort of the endpoint indexes; the list is short. */
+    now_ms = Clock_GetTimeMs();
+    for( index = 0; index < mqtt_obj->endpoint_count; index++ )
+    {
+        pos = index;
+        while( (pos > 0) && (mqtt_endpoint_precedes( &(mqtt_obj->endpoints[ index ]), &(mqtt_obj->endpoints[ order[ pos - 1 ] ]), now_ms ) == true) )
+        {
+            order[ pos ] = order[ pos - 1 ];
+            pos--;
+        }
+        order[ pos ] = index;
+    }
+
+    for( pos = 0; pos < mqtt_obj->endpoint_count; pos++ )
+    {
+        index = order[ pos ];
+        state = &(mqtt_obj->endpoints[ index ]);
+
+        if( index != mqtt_obj->endpoint_current )
+        {
+            /* The TLS session of the last connection belongs to another broker. */
+            mqtt_tls_session_clear( mqtt_obj );
+            mqtt_obj->endpoint_current = index;
+        }
+        mqtt_obj->server_info.host_name = state->endpoint.broker_info.hostname;
+        mqtt_obj->server_info.port = state->endpoint.broker_info.port;
+
+        now_ms = Clock_GetTimeMs();
+        result = mqtt_network_open( mqtt_obj );
+        elapsed_ms = Clock_GetTimeMs() - now_ms;
+        if( result == CY_RSLT_SUCCESS )
+        {
+            state->failures = 0;
+            state->connect_time_ms = ( state->connect_time_ms == 0 ) ? elapsed_ms : ( (state->connect_time_ms * 7U) + elapsed_ms ) / 8U;
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nConnected to broker endpoint %u in %u ms.\n", (unsigned int)index, (unsigned int)elapsed_ms );
+            return CY_RSLT_SUCCESS;
+        }
+
+        if( state->failures < UINT16_MAX )
+        {
+            state->failures++;
+        }
+        state->last_failure_ms = Clock_GetTimeMs();
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nConnection to broker endpoint %u failed, trying the next endpoint.\n", (unsigned int)index );
+    }
+
+    return result;
+}
+
+/*
+ * mqtt_session_restore
+ *
+ * Restore the state of the outgoing publishes once the MQTT session is established: they are resent if the broker
+ * resumed the session, and discarded otherwise.
+ */
+/* mqtt_session_restore must be protected under mqtt_obj->process_mutex */
+static cy_rslt_t mqtt_session_restore( cy_mqtt_object_t *mqtt_obj, bool create_clean_session )
+{
+    cy_rslt_t  result = CY_RSLT_SUCCESS;
+
+    if( (mqtt_obj->broker_session_present == true) && (create_clean_session == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nMQTT session with broker is re-established. Resending unacked publishes.\n" );
+        /* Handle all resend of PUBLISH messages. */
+        result = mqtt_handle_publish_resend( mqtt_obj );
+        if( result != CY_RSLT_SUCCESS )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nHandle all the resend of PUBLISH messages failed with Error : [0x%X] \n", (unsigned int)result );
+            return result;
+        }
+        mqtt_refresh_async_publish_deadlines( mqtt_obj );
+    }
+    else
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\n A clean MQTT connection is established. Cleaning up all the stored outgoing publishes.\n" );
+
+        if( mqtt_obj->qos2_received != NULL )
+        {
+            memset( mqtt_obj->qos2_received, 0x00, CY_MQTT_QOS2_BITMAP_SIZE );
+        }
+
+        /* Clean up the outgoing PUBLISH packets and wait for ack because this new
+         * connection does not re-establish an existing session. */
+        result = mqtt_cleanup_outgoing_publishes( mqtt_obj );
+        if( result != CY_RSLT_SUCCESS )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nCleaning of PUBLISH messages failed with Error : [0x%X] \n", (unsigned int)result );
+            return result;
+        }
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*
+ * mqtt_session_open
+ *
+ * Send the MQTT CONNECT packet on the connection opened by mqtt_network_open, and restore the state of the
+ * outgoing publishes with mqtt_session_restore.
+ */
+/* mqtt_session_open must be protected under mqtt_obj->process_mutex */
+static cy_rslt_t mqtt_session_open( cy_mqtt_object_t *mqtt_obj, MQTTConnectInfo_t *connect_details, MQTTPublishInfo_t *will_msg_ptr )
+{
+    cy_rslt_t  result = CY_RSLT_SUCCESS;
+    bool       create_clean_session = false;
+
+    /* The SUBACKs of the subscriptions restored on a previous connection are not received any more. */
+    mqtt_obj->resubscribe_pending = 0;
+
+    create_clean_session = (connect_details->cleanSession == true ) ? true : false;
+    if( create_clean_session == true )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nCreating clean session ..\n" );
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nCreating an MQTT connection to %.*s.\n",
+                     strlen(mqtt_obj->server_info.host_name), mqtt_obj->server_info.host_name );
+
+    /* Sends an MQTT Connect packet using the established TLS session. */
+    result = mqtt_establish_session( mqtt_obj, connect_details, will_msg_ptr, create_clean_session, &(mqtt_obj->broker_session_present) );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nEstablish MQTT session failed with Error : [0x%X] \n", (unsigned int)result );
+        return result;
+    }
+    mqtt_obj->mqtt_session_established = true;
+
+    return mqtt_session_restore( mqtt_obj, create_clean_session );
+}
+
+/*
+ * mqtt_record_connect_info
+ *
+ * Keep a copy of the connect information of a successful cy_mqtt_connect, for the automatic reconnection.
+ * The strings it refers to are maintained by the application until the MQTT object is deleted.
+ */
+/* mqtt_record_connect_info must be protected under mqtt_obj->process_mutex */
+static void mqtt_record_connect_info( cy_mqtt_object_t *mqtt_obj, const cy_mqtt_connect_info_t *connect_info )
+{
+    memcpy( &(mqtt_obj->connect_info), connect_info, sizeof( cy_mqtt_connect_info_t ) );
+    if( connect_info->will_info != NULL )
+    {
+        memcpy( &(mqtt_obj->will_info), connect_info->will_info, sizeof( cy_mqtt_publish_info_t ) );
+        mqtt_obj->connect_info.will_info = &(mqtt_obj->will_info);
+    }
+}
+
+/*
+ * mqtt_subscription_find
+ *
+ * Find the record of a topic filter subscribed while the automatic reconnection is enabled.
+ * Returns the link pointing to the record, or to the end of the list if the topic filter is not recorded.
+ */
+/* mqtt_subscription_find must be protected under mqtt_obj->process_mutex */
+static cy_mqtt_subscription_t **mqtt_subscription_find( cy_mqtt_object_t *mqtt_obj, const char *topic, uint16_t topic_len )
+{
+    cy_mqtt_subscription_t **link = &(mqtt_obj->subscriptions);
+
+    while( *link != NULL )
+    {
+        if( ((*link)->topic_len == topic_len) && (memcmp( (*link)->topic, topic, topic_len ) == 0) )
+        {
+            break;
+        }
+        link = &((*link)->next);
+    }
+    return link;
+}
+
+/*
+ * mqtt_subscription_record
+ *
+ * Record a topic filter subscribed with the given QoS, so that it is subscribed again by the automatic reconnection.
+ */
+/* mqtt_subscription_record must be protected under mqtt_obj->process_mutex */
+static cy_rslt_t mqtt_subscription_record( cy_mqtt_object_t *mqtt_obj, const char *topic, uint16_t topic_len, MQTTQoS_t qos )
+{
+    cy_mqtt_subscription_t **link = mqtt_subscription_find( mqtt_obj, topic, topic_len );
+    cy_mqtt_subscription_t *subscription = *link;
+
+    if( subscription == NULL )
+    {
+        subscription = (cy_mqtt_subscription_t *)malloc( sizeof( cy_mqtt_subscription_t ) + topic_len );
+        if( subscription == NULL )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to record the subscription of %.*s..!\n", topic_len, topic );
+            return CY_RSLT_MODULE_MQTT_NOMEM;
+        }
+        subscription->next = NULL;
+        subscription->topic_len = topic_len;
+        subscription->topic = (char *)&(subscription[ 1 ]);
+        memcpy( subscription->topic, topic, topic_len );
+        *link = subscription;
+    }
+    subscription->qos = qos;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*
+ * mqtt_subscription_forget
+ *
+ * Remove the record of an unsubscribed topic filter.
+ */
+/* mqtt_subscription_forget must be protected under mqtt_obj->process_mutex */
+static void mqtt_subscription_forget( cy_mqtt_object_t *mqtt_obj, const char *topic, uint16_t topic_len )
+{
+    cy_mqtt_subscription_t **link = mqtt_subscription_find( mqtt_obj, topic, topic_len );
+    cy_mqtt_subscription_t *subscription = *link;
+
+    if( subscription != NULL )
+    {
+        *link = subscription->next;
+        free( subscription );
+    }
+}
+
+/*
+ * mqtt_subscription_free_all
+ *
+ * Remove the records of all the subscribed topic filters.
+ */
+/* mqtt_subscription_free_all must be protected under mqtt_obj->process_mutex */
+static void mqtt_subscription_free_all( cy_mqtt_object_t *mqtt_obj )
+{
+    cy_mqtt_subscription_t *subscription;
+
+    while( mqtt_obj->subscriptions != NULL )
+    {
+        subscription = mqtt_obj->subscriptions;
+        mqtt_obj->subscriptions = subscription->next;
+        free( subscription );
+    }
+}
+
+/*
+ * mqtt_resubscribe
+ *
+ * Subscribe again to the recorded topic filters after the automatic reconnection established a new MQTT session.
+ * The SUBSCRIBE packets, of up to CY_MQTT_MAX_OUTGOING_SUBSCRIBES topic filters each, are sent back to back without
+ * waiting for their SUBACKs, which are checked by mqtt_event_callback as they arrive.
+ */
+/* mqtt_resubscribe must be protected under mqtt_obj->process_mutex */
+static void mqtt_resubscribe( cy_mqtt_object_t *mqtt_obj )
+{
+    MQTTSubscribeInfo_t     sub_list[ CY_MQTT_MAX_OUTGOING_SUBSCRIBES ];
+    cy_mqtt_subscription_t  *subscription = mqtt_obj->subscriptions;
+    MQTTStatus_t            mqttStatus = MQTTSuccess;
+    uint16_t                sub_count;
+
+    while( subscription != NULL )
+    {
+        sub_count = 0;
+        while( (subscription != NULL) && (sub_count < CY_MQTT_MAX_OUTGOING_SUBSCRIBES) )
+        {
+            sub_list[ sub_count ].qos = subscription->qos;
+            sub_list[ sub_count ].pTopicFilter = subscription->topic;
+            sub_list[ sub_count ].topicFilterLength = subscription->topic_len;
+            sub_count++;
+            subscription = subscription->next;
+        }
+
+        mqttStatus = MQTT_Subscribe( &(mqtt_obj->mqtt_context), sub_list, sub_count, MQTT_GetPacketId( &(mqtt_obj->mqtt_context) ) );
+        if( mqttStatus != MQTTSuccess )
+        {
+            /* The connection is lost again; it is detected by the event loop, which starts a new reconnection. */
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nFailed to restore subscriptions with error = %s.\n", MQTT_Status_strerror( mqttStatus ) );
+            return;
+        }
+        mqtt_obj->resubscribe_pending++;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nRestoring subscriptions with %u SUBSCRIBE packets.\n", (unsigned int)mqtt_obj->resubscribe_pending );
+}
+
+/*
+ * mqtt_network_close
+ *
+ * Close the connection to the MQTT broker.
+ */
+/* mqtt_network_close must be protected under mqtt_obj->process_mutex */
+static void mqtt_network_close( cy_mqtt_object_t *mqtt_obj )
+{
+    /*
+     * In case of an unexpected network disconnection, the cy_awsport_network_disconnect and cy_awsport_network_delete APIs
+     * always return failure. Therefore, their return values are not checked here.
+     */
+    (void)cy_awsport_network_disconnect( &(mqtt_obj->network_context) );
+    (void)cy_awsport_network_delete( &(mqtt_obj->network_context) );
+}
+
+/*
+ * mqtt_reconnect_seed
+ *
+ * Seed the generator of the reconnect delays with the FNV-1a hash of the client ID mixed with the current time,
+ * so that devices disconnected together draw different delays.
+ */
+/* mqtt_reconnect_seed must be protected under mqtt_obj->process_mutex */
+static void mqtt_reconnect_seed( cy_mqtt_object_t *mqtt_obj )
+{
+    uint32_t hash = 2166136261U;
+    uint16_t index;
+
+    for( index = 0; (mqtt_obj->connect_info.client_id != NULL) && (index < mqtt_obj->connect_info.client_id_len); index++ )
+    {
+        hash = (hash ^ (uint8_t)mqtt_obj->connect_info.client_id[ index ]) * 16777619U;
+    }
+
+    mqtt_obj->reconnect_seed = hash ^ Clock_GetTimeMs();
+    if( mqtt_obj->reconnect_seed == 0 )
+    {
+        mqtt_obj->reconnect_seed = 2166136261U;
+    }
+}
+
+/*
+ * mqtt_reconnect_random
+ *
+ * Next value of the xorshift generator of the reconnect delays.
+ */
+/* mqtt_reconnect_random must be protected under mqtt_obj->process_mutex */
+static uint32_t mqtt_reconnect_random( cy_mqtt_object_t *mqtt_obj )
+{
+    uint32_t x = mqtt_obj->reconnect_seed;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    mqtt_obj->reconnect_seed = x;
+    return x;
+}
+
+/*
+ * mqtt_reconnect_schedule
+ *
+ * Arm the reconnect timer for the next attempt of the automatic reconnection. The delay is drawn between half and all
+ * of the current backoff, so that clients disconnected together do not reconnect together; the backoff is then doubled.
+ */
+/* mqtt_reconnect_schedule must be protected under mqtt_obj->process_mutex */
+static void mqtt_reconnect_schedule( cy_mqtt_object_t *mqtt_obj )
+{
+    uint32_t backoff_ms = mqtt_obj->reconnect_backoff_ms;
+    uint32_t delay_ms;
+
+    delay_ms = (backoff_ms / 2U) + (mqtt_reconnect_random( mqtt_obj ) % ((backoff_ms - (backoff_ms / 2U)) + 1U));
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nReconnecting to the broker in %u ms.\n", (unsigned int)delay_ms );
+    mqtt_timer_arm( &mqtt_obj->reconnect_timer, delay_ms );
+
+    if( backoff_ms > (mqtt_obj->reconnect_config.max_backoff_ms / 2U) )
+    {
+        mqtt_obj->reconnect_backoff_ms = mqtt_obj->reconnect_config.max_backoff_ms;
+    }
+    else
+    {
+        mqtt_obj->reconnect_backoff_ms = backoff_ms * 2U;
+    }
+}
+
+/*
+ * mqtt_reconnect_wait
+ *
+ * Wait until the reconnect thread no longer uses the connection of the MQTT object. process_mutex is released
+ * while waiting, so that the attempt in progress can complete.
+ */
+/* mqtt_reconnect_wait must be protected under mqtt_obj->process_mutex */
+static void mqtt_reconnect_wait( cy_mqtt_object_t *mqtt_obj )
+{
+    while( mqtt_obj->reconnect_connecting == true )
+    {
+        (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+        (void)cy_rtos_get_mutex( &(mqtt_obj->reconnect_mutex), CY_RTOS_NEVER_TIMEOUT );
+        (void)cy_rtos_set_mutex( &(mqtt_obj->reconnect_mutex) );
+        (void)cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+    }
+}
+
+/*
+ * mqtt_reconnect_cancel
+ *
+ * Stop the automatic reconnection in progress. A connection opened meanwhile by the attempt in progress is closed
+ * by mqtt_reconnect_attempt.
+ */
+/* mqtt_reconnect_cancel must be protected under mqtt_obj->process_mutex */
+static void mqtt_reconnect_cancel( cy_mqtt_object_t *mqtt_obj )
+{
+    mqtt_obj->reconnect_active = false;
+    mqtt_obj->reconnect_report_pending = false;
+    mqtt_timer_cancel( &mqtt_obj->reconnect_timer );
+    mqtt_reconnect_wait( mqtt_obj );
+}
+
+/*
+ * mqtt_reconnect_on_link_loss
+ *
+ * Start the automatic reconnection once the event loop has found the MQTT session lost, unless the application has
+ * disconnected. The connection is closed, and the first attempt is scheduled.
+ */
+/* mqtt_reconnect_on_link_loss must be protected under mqtt_obj->process_mutex */
+static void mqtt_reconnect_on_link_loss( cy_mqtt_object_t *mqtt_obj )
+{
+    if( (mqtt_obj->mqtt_session_established == false) && (mqtt_obj->reconnect_report_pending == true) )
+    {
+        /* The SUBACKs of the subscriptions restored by the previous reconnection are not received any more; the topic
+         * filters they acknowledge are not counted as rejected. */
+        mqtt_reconnect_report( mqtt_obj, CY_RSLT_SUCCESS );
+    }
+
+    if( (mqtt_obj->reconnect_enabled == false) || (mqtt_obj->reconnect_active == true) ||
+        (mqtt_obj->mqtt_conn_status == false) || (mqtt_obj->mqtt_session_established == true) )
+    {
+        return;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nMQTT session lost. Starting the automatic reconnection.\n" );
+
+    (void)stop_timer( mqtt_obj );
+    (void)stop_mqtt_ping_resp_timer( mqtt_obj );
+    mqtt_obj->keepAliveSeconds = 0;
+    mqtt_network_close( mqtt_obj );
+    mqtt_obj->mqtt_conn_status = false;
+
+    mqtt_obj->reconnect_active = true;
+    mqtt_obj->reconnect_attempts = 0;
+    mqtt_obj->reconnect_start_ms = Clock_GetTimeMs();
+    mqtt_obj->reconnect_backoff_ms = mqtt_obj->reconnect_config.initial_backoff_ms;
+    if( mqtt_obj->reconnect_seed == 0 )
+    {
+        mqtt_reconnect_seed( mqtt_obj );
+    }
+    mqtt_reconnect_schedule( mqtt_obj );
+}
+
+/*
+ * mqtt_event_loop_lock_object
+ *
+ * Acquire mqtt_obj->process_mutex for an event of mqtt_event_processing_thread or an attempt of the reconnect
+ * thread. Returns false without holding the mutex if the MQTT object is deleted. No global lock is needed for the
+ * check, because the queued event or the list of the reconnect thread holds a reference to the MQTT object.
+ */
+static bool mqtt_event_loop_lock_object( cy_mqtt_object_t *mqtt_obj )
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        return false;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Acquired Mutex %p \n", mqtt_obj->process_mutex );
+
+    if( mqtt_obj->deleted == true )
+    {
+        /* The MQTT object is no longer available. Hence do not process the events related to this object */
+        (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Released Mutex %p \n", mqtt_obj->process_mutex );
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * mqtt_reconnect_attempt
+ *
+ * Make one attempt of the automatic reconnection, on the reconnect thread. The network connection and the MQTT
+ * CONNECT handshake are made without holding process_mutex, so that the event loop and the API calls on the MQTT
+ * object are not blocked meanwhile. While reconnect_connecting is set, the reconnect thread holds reconnect_mutex,
+ * and the callers using the connection wait in mqtt_reconnect_wait. On success, the recorded subscriptions are
+ * restored if the broker did not resume the session; the unacknowledged publishes are resent by mqtt_session_restore
+ * if it did.
+ */
+static void mqtt_reconnect_attempt( cy_mqtt_object_t *mqtt_obj )
+{
+    cy_rslt_t          result = CY_RSLT_SUCCESS;
+    MQTTConnectInfo_t  connect_details;
+    MQTTPublishInfo_t  will_msg_details;
+    MQTTPublishInfo_t  *will_msg_ptr = NULL;
+    bool               session_present = false;
+    bool               session_established = false;
+
+    if( mqtt_event_loop_lock_object( mqtt_obj ) == false )
+    {
+        return;
+    }
+
+    if( mqtt_obj->reconnect_active == false )
+    {
+        (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+        return;
+    }
+
+    mqtt_obj->reconnect_attempts++;
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nReconnection attempt %u to the broker.\n", (unsigned int)mqtt_obj->reconnect_attempts );
+
+    result = mqtt_prepare_connect_info( mqtt_obj, &(mqtt_obj->connect_info), &connect_details, &will_msg_details, &will_msg_ptr );
+    if( result == CY_RSLT_SUCCESS )
+    {
+        /* The SUBACKs of the subscriptions restored on a previous connection are not received any more. */
+        mqtt_obj->resubscribe_pending = 0;
+        mqtt_obj->reconnect_connecting = true;
+        (void)cy_rtos_get_mutex( &(mqtt_obj->reconnect_mutex), CY_RTOS_NEVER_TIMEOUT );
+        (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+
+        result = mqtt_network_open_endpoints( mqtt_obj );
+        if( result == CY_RSLT_SUCCESS )
+        {
+            result = mqtt_establish_session( mqtt_obj, &connect_details, will_msg_ptr, connect_details.cleanSession, &session_present );
+            if( result == CY_RSLT_SUCCESS )
+            {
+                session_established = true;
+            }
+            else
+            {
+                mqtt_network_close( mqtt_obj );
+            }
+        }
+
+        (void)cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+        mqtt_obj->reconnect_connecting = false;
+        (void)cy_rtos_set_mutex( &(mqtt_obj->reconnect_mutex) );
+
+        if( (mqtt_obj->deleted == true) || (mqtt_obj->reconnect_active == false) )
+        {
+            /* The MQTT object was deleted, or the reconnection was stopped by the application meanwhile. */
+            if( session_established == true )
+            {
+                (void)MQTT_Disconnect( &(mqtt_obj->mqtt_context) );
+                mqtt_network_close( mqtt_obj );
+            }
+            (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+            return;
+        }
+
+        if( result == CY_RSLT_SUCCESS )
+        {
+            mqtt_obj->broker_session_present = session_present;
+            mqtt_obj->mqtt_session_established = true;
+            result = mqtt_session_restore( mqtt_obj, connect_details.cleanSession );
+            if( result != CY_RSLT_SUCCESS )
+            {
+                (void)MQTT_Disconnect( &(mqtt_obj->mqtt_context) );
+                mqtt_obj->mqtt_session_established = false;
+                mqtt_network_close( mqtt_obj );
+            }
+        }
+    }
+
+    if( result == CY_RSLT_SUCCESS )
+    {
+        mqtt_obj->reconnect_active = false;
+        mqtt_obj->mqtt_conn_status = true;
+        (void)start_timer( mqtt_obj );
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nReconnected to the broker after %u attempts in %u ms.\n",
+                         (unsigned int)mqtt_obj->reconnect_attempts, (unsigned int)(Clock_GetTimeMs() - mqtt_obj->reconnect_start_ms) );
+
+        mqtt_obj->resubscribe_rejected = 0;
+        if( (mqtt_obj->broker_session_present == false) || (connect_details.cleanSession == true) )
+        {
+            mqtt_resubscribe( mqtt_obj );
+        }
+
+        /* With restored subscriptions, the outcome is reported with the last of their SUBACKs by mqtt_check_resubscribe_ack. */
+        if( mqtt_obj->resubscribe_pending > 0 )
+        {
+            mqtt_obj->reconnect_report_pending = true;
+        }
+        else
+        {
+            mqtt_reconnect_report( mqtt_obj, CY_RSLT_SUCCESS );
+        }
+
+        if( mqtt_obj->spool != NULL )
+        {
+            /* The spooled messages are published by mqtt_event_processing_thread. */
+            mqtt_queue_async_publish_event( mqtt_obj, 0 );
+        }
+        (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+        return;
+    }
+
+    mqtt_obj->keepAliveSeconds = 0;
+    if( (mqtt_obj->reconnect_config.max_attempts != 0) && (mqtt_obj->reconnect_attempts >= mqtt_obj->reconnect_config.max_attempts) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nReconnection to the broker failed, all %u attempts exhausted.\n", (unsigned int)mqtt_obj->reconnect_attempts );
+        mqtt_obj->reconnect_active = false;
+        mqtt_reconnect_report( mqtt_obj, CY_RSLT_MODULE_MQTT_CONNECT_FAIL );
+    }
+    else
+    {
+        mqtt_reconnect_schedule( mqtt_obj );
+    }
+    (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_obj_free
+ *
+ * Release an MQTT object deleted by cy_mqtt_delete, once its last reference is dropped. No other thread can use
+ * the object at this point; the timers armed after the deletion by the API calls then in progress are cancelled here.
+ */
+static void mqtt_obj_free( cy_mqtt_object_t *mqtt_obj )
+{
+    mqtt_timer_cancel( &mqtt_obj->mqtt_timer );
+    mqtt_timer_cancel( &mqtt_obj->mqtt_ping_resp_timer );
+    mqtt_timer_cancel( &mqtt_obj->mqtt_async_ack_timer );
+    mqtt_timer_cancel( &mqtt_obj->reconnect_timer );
+
+    mqtt_spool_free( mqtt_obj );
+    while( mqtt_obj->topics != NULL )
+    {
+        cy_mqtt_topic_object_t *topic_obj = mqtt_obj->topics;
+
+        mqtt_obj->topics = topic_obj->next;
+        topic_obj->magic = 0;
+        free( topic_obj );
+    }
+    mqtt_route_free_all( mqtt_obj );
+    mqtt_subscription_free_all( mqtt_obj );
+    free( mqtt_obj->qos2_received );
+    mqtt_obj->qos2_received = NULL;
+    mqtt_tls_session_clear( mqtt_obj );
+    free( mqtt_obj->tls_session );
+    mqtt_obj->tls_session = NULL;
+    mqtt_free_publish_window( mqtt_obj );
+
+    (void)cy_rtos_deinit_mutex( &(mqtt_obj->process_mutex) );
+    (void)cy_rtos_deinit_mutex( &(mqtt_obj->tx_mutex) );
+    (void)cy_rtos_deinit_mutex( &(mqtt_obj->reconnect_mutex) );
+    (void)cy_rtos_deinit_mutex( &(mqtt_obj->ref_mutex) );
+    mqtt_ack_waiter_deinit( &(mqtt_obj->sub_waiter) );
+    mqtt_ack_waiter_deinit( &(mqtt_obj->unsub_waiter) );
+
+    /* Clear the MQTT handle info. */
+    ( void ) memset( mqtt_obj, 0x00, sizeof( cy_mqtt_object_t ) );
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\n Free mqtt_obj : %p..!\n", mqtt_obj );
+    free( mqtt_obj );
+}
+
+/*
+ * mqtt_obj_release
+ *
+ * Drop a reference taken by mqtt_obj_acquire or held by a queued event, and release the MQTT object with
+ * its last reference. Must be called without holding any lock of the object.
+ */
+static void mqtt_obj_release( cy_mqtt_object_t *mqtt_obj )
+{
+    bool last_reference = false;
+
+    (void)cy_rtos_get_mutex( &(mqtt_obj->ref_mutex), CY_RTOS_NEVER_TIMEOUT );
+    mqtt_obj->ref_count--;
+    last_reference = ( mqtt_obj->ref_count == 0 );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->ref_mutex) );
+
+    if( last_reference == true )
+    {
+        mqtt_obj_free( mqtt_obj );
+    }
+}
+
+/*
+ * mqtt_obj_release_event
+ *
+ * Drop the reference held by an event processed by mqtt_event_processing_thread, like mqtt_obj_release.
+ */
+static void mqtt_obj_release_event( cy_mqtt_object_t *mqtt_obj )
+{
+    bool last_reference = false;
+
+    (void)cy_rtos_get_mutex( &(mqtt_obj->ref_mutex), CY_RTOS_NEVER_TIMEOUT );
+    mqtt_obj->queued_events--;
+    mqtt_obj->ref_count--;
+    last_reference = ( mqtt_obj->ref_count == 0 );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->ref_mutex) );
+
+    if( last_reference == true )
+    {
+        mqtt_obj_free( mqtt_obj );
+    }
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_reconnect_thread_func
+ *
+ * Make the attempts of the automatic reconnection of the MQTT objects queued by mqtt_reconnect_timeout_callback,
+ * so that a slow TLS handshake holds up neither the event loops nor the timing wheel.
+ */
+static void mqtt_reconnect_thread_func( cy_thread_arg_t arg )
+{
+    cy_rslt_t         result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t  *mqtt_obj;
+
+    (void)arg;
+    while( true )
+    {
+        (void)cy_rtos_get_mutex( &mqtt_timer_mutex, CY_RTOS_NEVER_TIMEOUT );
+        mqtt_obj = mqtt_reconnect_head;
+        if( mqtt_obj != NULL )
+        {
+            mqtt_reconnect_head = mqtt_obj->reconnect_next;
+            if( mqtt_reconnect_head == NULL )
+            {
+                mqtt_reconnect_tail = NULL;
+            }
+            mqtt_obj->reconnect_next = NULL;
+            mqtt_obj->reconnect_queued = false;
+        }
+        (void)cy_rtos_set_mutex( &mqtt_timer_mutex );
+
+        if( mqtt_obj != NULL )
+        {
+            mqtt_reconnect_attempt( mqtt_obj );
+            /* Drop the reference taken by mqtt_reconnect_timeout_callback. */
+            mqtt_obj_release( mqtt_obj );
+            continue;
+        }
+
+        if( mqtt_reconnect_thread_exit == true )
+        {
+            break;
+        }
+        (void)cy_rtos_get_semaphore( &mqtt_reconnect_wake, CY_RTOS_NEVER_TIMEOUT, false );
+    }
+
+    result = cy_rtos_exit_thread();
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_exit_thread failed with Error :[0x%X]\n", (unsigned int)result );
+    }
+}
+
+/*
+ * mqtt_reconnect_thread_start
+ *
+ * Start the reconnect thread.
+ */
+/* mqtt_reconnect_thread_start must be protected under mqtt_db_mutex */
+static cy_rslt_t mqtt_reconnect_thread_start( void )
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    result = cy_rtos_init_semaphore( &mqtt_reconnect_wake, 1, 0 );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_init_semaphore failed with Error : [0x%X] \n", (unsigned int)result );
+        return result;
+    }
+
+    mqtt_reconnect_thread_exit = false;
+    result = cy_rtos_create_thread( &mqtt_reconnect_thread, mqtt_reconnect_thread_func, "MQTTReconnectThread", NULL,
+                                    CY_MQTT_RECONNECT_THREAD_STACK_SIZE, CY_MQTT_RECONNECT_THREAD_PRIORITY, NULL );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_create_thread failed with Error : [0x%X] \n", (unsigned int)result );
+        (void)cy_rtos_deinit_semaphore( &mqtt_reconnect_wake );
+        mqtt_reconnect_thread = NULL;
+        return result;
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+/*
+ * mqtt_reconnect_thread_stop
+ *
+ * Terminate the reconnect thread, once the attempts queued to it are made.
+ */
+static void mqtt_reconnect_thread_stop( void )
+{
+    mqtt_reconnect_thread_exit = true;
+    (void)cy_rtos_set_semaphore( &mqtt_reconnect_wake, false );
+    (void)cy_rtos_join_thread( &mqtt_reconnect_thread );
+    mqtt_reconnect_thread = NULL;
+    (void)cy_rtos_deinit_semaphore( &mqtt_reconnect_wake );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+static void mqtt_event_processing_thread( cy_thread_arg_t arg )
+{
+    cy_mqtt_event_loop_object_t *loop = (cy_mqtt_event_loop_object_t *)arg;
+    cy_rslt_t                  result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t           *mqtt_obj = NULL;
+    cy_mqtt_event_t            event;
+    cy_mqtt_callback_event_t   socket_event;
+    MQTTStatus_t               mqtt_status = MQTTSuccess;
+    bool                       connect_status = true;
+    bool                       mqtt_ping_resp_wait;
+    uint32_t                   drain_passes = 0;
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nStarting mqtt_event_processing_thread...\n" );
+
+    while( true )
+    {
+        memset( &socket_event, 0x00, sizeof( cy_mqtt_callback_event_t ) );
+        result = cy_rtos_get_queue( &(loop->queue), (void *)&socket_event, CY_RTOS_NEVER_TIMEOUT, false );
+        if( result != CY_RSLT_SUCCESS )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_queue failed with Error :[0x%X]\n", (unsigned int)result );
+            continue;
+        }
+
+        if( socket_event.socket_event == CY_MQTT_SOCKET_EVENT_EXIT_THREAD )
+        {
+            break;
+        }
+
+        memset( &event, 0x00, sizeof( cy_mqtt_event_t ) );
+        if( socket_event.mqtt_obj == NULL )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid mqtt handle...!\n" );
+            continue;
+        }
+
+        switch (socket_event.socket_event)
+        {
+            case CY_MQTT_SOCKET_EVENT_DATA_RECEIVE:
+            {
+                mqtt_obj = (cy_mqtt_object_t *)socket_event.mqtt_obj;
+                if( mqtt_event_loop_lock_object( mqtt_obj ) == false )
+                {
+                    break;
+                }
+
+                /* Clear the flag before reading the socket, so that a notification for data arriving after the last read queues a new event. */
+                mqtt_obj->rx_event_queued = false;
+
+                connect_status = mqtt_obj->mqtt_session_established;
+                if( connect_status )
+                {
+                    mqtt_ping_resp_wait = mqtt_obj->mqtt_context.waitingForPingResp;
+
+                    /* Process the received packets until the socket has no more data. */
+                    drain_passes = 0;
+                    do
+                    {
+                        mqtt_obj->rx_data_received = false;
+                        mqtt_status = MQTT_ProcessLoop( &(mqtt_obj->mqtt_context), CY_MQTT_RECEIVE_DATA_TIMEOUT_MS );
+                        drain_passes++;
+                    } while( (mqtt_status == MQTTSuccess) && (mqtt_obj->rx_data_received == true) &&
+                             (mqtt_obj->mqtt_session_established == true) && (drain_passes < CY_MQTT_RECEIVE_DRAIN_MAX_PASSES) );
+
+                    if( (mqtt_status == MQTTSuccess) && (mqtt_obj->rx_data_received == true) )
+                    {
+                        mqtt_queue_rx_event( mqtt_obj );
+                    }
+
+                    if( mqtt_status != MQTTSuccess )
+                    {
+                        if( (mqtt_status == MQTTRecvFailed)  || (mqtt_status == MQTTSendFailed) ||
+                            (mqtt_status == MQTTBadResponse) || (mqtt_status == MQTTKeepAliveTimeout) ||
+                            (mqtt_status == MQTTIllegalState ) )
+                        {
+                            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nmqtt_event_processing_thread MQTT_ProcessLoop failed with status %s \n", MQTT_Status_strerror(mqtt_status) );
+                            memset( &event, 0x00, sizeof(cy_mqtt_event_t) );
+                            event.type = CY_MQTT_EVENT_TYPE_DISCONNECT;
+
+                            if( mqtt_status == MQTTKeepAliveTimeout )
+                            {
+                                event.data.reason = CY_MQTT_DISCONN_TYPE_BROKER_DOWN;
+                            }
+                            else if( (mqtt_status == MQTTRecvFailed) || (mqtt_status == MQTTSendFailed) )
+                            {
+                                event.data.reason = CY_MQTT_DISCONN_TYPE_SND_RCV_FAIL;
+                            }
+                            else
+                            {
+                                event.data.reason = CY_MQTT_DISCONN_TYPE_BAD_RESPONSE;
+                            }
+
+                            /* Call registered application callbacks */
+                            call_registered_event_callbacks((cy_mqtt_t)mqtt_obj, event);
+
+                            mqtt_obj->mqtt_session_established = false;
+                            mqtt_wake_ack_waiters( mqtt_obj );
+                        }
+                    }
+                    else
+                    {
+                        if( ( mqtt_ping_resp_wait == true ) && ( mqtt_obj->mqtt_context.waitingForPingResp == false ) )
+                        {
+                            /* we have received the mqtt response. Stop timer */
+                            stop_mqtt_ping_resp_timer( mqtt_obj );
+                        }
+                    }
+                }
+
+                /* Start the automatic reconnection if the MQTT session was lost. */
+                mqtt_reconnect_on_link_loss( mqtt_obj );
+
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+                result = cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+                if( result != CY_RSLT_SUCCESS )
+                {
+                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", (unsigned int)result );
+                }
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Released Mutex %p \n", mqtt_obj->process_mutex );
+
+                break;
+            }
+
+            case CY_MQTT_SOCKET_EVENT_DISCONNECT:
+            {
+                mqtt_obj = (cy_mqtt_object_t *)socket_event.mqtt_obj;
+                if( mqtt_event_loop_lock_object( mqtt_obj ) == false )
+                {
+                    break;
+                }
+
+
+                /* Stop MQTT Ping Timer */
+                result = stop_timer( mqtt_obj );
+                if( result != CY_RSLT_SUCCESS )
+                {
+                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nstop_timer failed\n" );
+                }
+                result = stop_mqtt_ping_resp_timer( mqtt_obj );
+                if( result != CY_RSLT_SUCCESS )
+                {
+                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nstop mqtt ping resp timer failed\n" );
+                }
+
+                /* Reset keepAliveSeconds to 0 to avoid timer activity after disconnection */
+                mqtt_obj->keepAliveSeconds = 0;
+                event.type = CY_MQTT_EVENT_TYPE_DISCONNECT;
+
+                if( mqtt_obj->mqtt_session_established == true )
+                {
+                    event.data.reason = CY_MQTT_DISCONN_TYPE_NETWORK_DOWN;
+
+                    call_registered_event_callbacks((cy_mqtt_t)mqtt_obj, event);
+
+                    mqtt_obj->mqtt_session_established = false;
+                    mqtt_wake_ack_waiters( mqtt_obj );
+                }
+
+                /* Start the automatic reconnection if the MQTT session was lost. */
+                mqtt_reconnect_on_link_loss( mqtt_obj );
+
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+                result = cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+                if( result != CY_RSLT_SUCCESS )
+                {
+                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", (unsigned int)result );
+                }
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Released Mutex %p \n", mqtt_obj->process_mutex );
+
+                break;
+            }
+
+            case CY_MQTT_SOCKET_EVENT_PING_REQ:
+            {
+                mqtt_obj = (cy_mqtt_object_t *)socket_event.mqtt_obj;
+                if( mqtt_event_loop_lock_object( mqtt_obj ) == false )
+                {
+                    break;
+                }
+
+                /* Stop MQTT Ping Timer */
+                result = stop_timer( mqtt_obj );
+                if( result != CY_RSLT_SUCCESS )
+                {
+                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nstop_timer failed\n" );
+                }
+
+                /* Packets sent after the ping request was queued defer the ping; start_timer below rearms the timer for the
+                 * rest of the keepalive interval. */
+                connect_status = mqtt_obj->mqtt_session_established;
+                if( connect_status && ( mqtt_keepalive_remaining_ms( mqtt_obj ) == 0 ) )
+                {
+                    mqtt_status = MQTT_Ping( &(mqtt_obj->mqtt_context) );
+                    if( mqtt_status != MQTTSuccess )
+                    {
+                        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n MQTT_Ping failed with Error : [0x%X] ", (unsigned int)mqtt_status );
+                        if( mqtt_obj->mqtt_session_established == true )
+                        {
+                            event.data.reason = CY_MQTT_DISCONN_TYPE_NETWORK_DOWN;
+
+                            call_registered_event_callbacks((cy_mqtt_t)mqtt_obj, event);
+
+                            mqtt_obj->mqtt_session_established = false;
+                            mqtt_wake_ack_waiters( mqtt_obj );
+                        }
+                        mqtt_reconnect_on_link_loss( mqtt_obj );
+                        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Releasing Mutex %p ", mqtt_obj->process_mutex );
+                        result = cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+                        if( result != CY_RSLT_SUCCESS )
+                        {
+                            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] ", (unsigned int)result );
+                        }
+                        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Released Mutex %p ", mqtt_obj->process_mutex );
+
+                        break;
+                    }
+                    else
+                    {
+                        /* Start ping response timer */
+                        start_mqtt_ping_resp_timer(mqtt_obj);
+                    }
+                }
+                /* Start MQTT Ping Timer */
+                result = start_timer( mqtt_obj );
+                if( result != CY_RSLT_SUCCESS )
+                {
+                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nstart_timer failed\n" );
+                }
+
+                /* Start the automatic reconnection if the MQTT session was lost. */
+                mqtt_reconnect_on_link_loss( mqtt_obj );
+
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+                result = cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+                if( result != CY_RSLT_SUCCESS )
+                {
+                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", (unsigned int)result );
+                }
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Released Mutex %p \n", mqtt_obj->process_mutex );
+
+                break;
+            }
+            case CY_MQTT_SOCKET_EVENT_ASYNC_PUBLISH:
+            {
+                mqtt_obj = (cy_mqtt_object_t *)socket_event.mqtt_obj;
+                mqtt_process_async_publishes( mqtt_obj );
+                break;
+            }
+            default:
+            {
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid event type \n" );
+                break;
+            }
+        }
+
+        /* Drop the reference held by the event; the MQTT object is released here if it was deleted meanwhile. */
+        mqtt_obj_release_event( (cy_mqtt_object_t *)socket_event.mqtt_obj );
+    }
+    result = cy_rtos_exit_thread();
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_exit_thread failed with Error :[0x%X]\n", (unsigned int)result );
+    }
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_event_loop_start
+ *
+ * Create the queue and the thread of an event loop.
+ */
+static cy_rslt_t mqtt_event_loop_start( cy_mqtt_event_loop_object_t *loop, uint16_t queue_size,
+                                        uint32_t stack_size, cy_thread_priority_t priority )
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    result = cy_rtos_init_queue( &(loop->queue), queue_size, sizeof(cy_mqtt_callback_event_t) );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_init_queue failed with Error : [0x%X] \n", (unsigned int)result );
+        return result;
+    }
+
+    result = cy_rtos_create_thread( &(loop->thread), mqtt_event_processing_thread, "MQTTEventProcessingThread", NULL,
+                                    stack_size, priority, (cy_thread_arg_t)loop );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_create_thread failed with Error : [0x%X] \n", (unsigned int)result );
+        (void)cy_rtos_deinit_queue( &(loop->queue) );
+        loop->thread = NULL;
+        return result;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_event_loop_stop
+ *
+ * Terminate the thread of an event loop after it has processed the queued events, and delete its queue.
+ */
+static cy_rslt_t mqtt_event_loop_stop( cy_mqtt_event_loop_object_t *loop )
+{
+    cy_rslt_t                  result = CY_RSLT_SUCCESS;
+    cy_mqtt_callback_event_t   event;
+
+    event.socket_event = CY_MQTT_SOCKET_EVENT_EXIT_THREAD;
+    event.mqtt_obj = NULL;
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nPushing event to terminate mqtt_event_processing_thread \n" );
+
+    result = cy_rtos_put_queue( &(loop->queue), (void *)&event, CY_RTOS_NEVER_TIMEOUT, false );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nPushing event to terminate mqtt_event_processing_thread failed with Error : [0x%X] \n", (unsigned int)result );
+        return result;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nJoining MQTT event process thread %p..!\n", loop->thread );
+    result = cy_rtos_join_thread( &(loop->thread) );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nJoin MQTT event process thread failed with Error : [0x%X] \n", (unsigned int)result );
+        return result;
+    }
+    loop->thread = NULL;
+
+    result = cy_rtos_deinit_queue( &(loop->queue) );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_deinit_queue failed with Error : [0x%X] \n", (unsigned int)result );
+        return result;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+static void mqtt_awsport_network_receive_callback( void *arg )
+{
+    cy_mqtt_object_t         *mqtt_obj = NULL;
+
+    if( arg == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nInvalid handle to mqtt_awsport_network_receive_callback, so nothing to do..!\n" );
+        return;
+    }
+
+    mqtt_obj = ( cy_mqtt_object_t * )arg;
+    mqtt_queue_rx_event( mqtt_obj );
+    return;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_init( void )
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if( mqtt_lib_init_status == true )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nMQTT library is already initialized. Number of MQTT client instance : [%d] \n", mqtt_handle_count );
+        return result;
+    }
+
+    result = cy_rtos_init_mutex2( &mqtt_db_mutex, false );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nCreating new mutex %p. failed\n", mqtt_db_mutex );
+        return result;
+    }
+    mqtt_db_mutex_init_status = true;
+
+    result = cy_rtos_init_mutex2( &mqtt_timer_mutex, false );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nCreating new mutex %p. failed\n", mqtt_timer_mutex );
+        (void)cy_rtos_deinit_mutex( &mqtt_db_mutex );
+        mqtt_db_mutex_init_status = false;
+        return result;
+    }
+    ( void ) memset( &mqtt_timer_wheel, 0x00, sizeof( mqtt_timer_wheel ) );
+
+    result = cy_awsport_network_init();
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_awsport_network_init failed with Error : [0x%X] \n", (unsigned int)result );
+        (void)cy_rtos_deinit_mutex( &mqtt_timer_mutex );
+        (void)cy_rtos_deinit_mutex( &mqtt_db_mutex );
+        mqtt_db_mutex_init_status = false;
+        return result;
+    }
+
+    /*
+     * Start the default event loop, which processes the events of the MQTT objects not assigned to another event loop.
+     */
+    result = mqtt_event_loop_start( &mqtt_default_event_loop, CY_MQTT_EVENT_QUEUE_SIZE, CY_MQTT_EVENT_THREAD_STACK_SIZE, CY_MQTT_EVENT_THREAD_PRIORITY );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        (void)cy_rtos_deinit_mutex( &mqtt_timer_mutex );
+        (void)cy_rtos_deinit_mutex( &mqtt_db_mutex );
+        (void)cy_awsport_network_deinit();
+        mqtt_db_mutex_init_status = false;
+        return result;
+    }
+
+    /*
+     * Start the timer thread, which drives the timers of all the MQTT objects independently of their event loops.
+     */
+    result = mqtt_timer_thread_start();
+    if( result != CY_RSLT_SUCCESS )
+    {
+        (void)mqtt_event_loop_stop( &mqtt_default_event_loop );
+        (void)cy_rtos_deinit_mutex( &mqtt_timer_mutex );
+        (void)cy_rtos_deinit_mutex( &mqtt_db_mutex );
+        (void)cy_awsport_network_deinit();
+        mqtt_db_mutex_init_status = false;
+        return result;
+    }
+
+    mqtt_lib_init_status = true;
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_awsport_network_init successful.\n" );
+
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_create( uint8_t *buffer, uint32_t bufflen,
+                          cy_awsport_ssl_credentials_t *security,
+                          cy_mqtt_broker_info_t *broker_info,
+                          char *descriptor,
+                          cy_mqtt_t *mqtt_handle )
+{
+    cy_rslt_t         result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t  *mqtt_obj = NULL;
+    bool              process_mutex_init_status = false;
+    bool              sub_waiter_init_status = false;
+    bool              tx_mutex_init_status = false;
+    bool              unsub_waiter_init_status = false;
+    bool              reconnect_mutex_init_status = false;
+    bool              ref_mutex_init_status = false;
+    cy_mqtt_t         handle;
+
+    if( (broker_info == NULL) || (mqtt_handle == NULL) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_create()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( buffer == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid network buffer..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( bufflen < CY_MQTT_MIN_NETWORK_BUFFER_SIZE )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBuffer length is less then minimun network buffer size : %u..!\n", (uint16_t)CY_MQTT_MIN_NETWORK_BUFFER_SIZE );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( descriptor == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid descriptor..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( strlen(descriptor) > CY_MQTT_DESCP_MAX_LEN )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Descriptor length is greater than maximum permissible length: %u!\n", (uint16_t)CY_MQTT_DESCP_MAX_LEN );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
+    }
+
+    result = cy_rtos_get_mutex( &mqtt_db_mutex, CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
+        return result;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_create - Acquired Mutex %p \n", mqtt_db_mutex );
+
+    if( mqtt_handle_count >= mqtt_max_handles )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nNumber of created mqtt object exceeds %d..!\n", mqtt_max_handles );
+        (void)cy_rtos_set_mutex( &mqtt_db_mutex );
+        return CY_RSLT_MODULE_MQTT_CREATE_FAIL;
+    }
+
+    result = cy_rtos_set_mutex( &mqtt_db_mutex );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
+        return result;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_create - Released Mutex %p \n", mqtt_db_mutex );
+
+    result = cy_mqtt_get_handle( &handle, descriptor );
+    if( result == CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nDescriptor is not unique. \n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    mqtt_obj = (cy_mqtt_object_t *)malloc( sizeof( cy_mqtt_object_t ) );
+    if( mqtt_obj == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to create MQTT object..!\n" );
+        return CY_RSLT_MODULE_MQTT_NOMEM;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_obj : %p..!\n", mqtt_obj );
+
+    /* Clear the MQTT handle data. */
+    memset( mqtt_obj, 0x00, sizeof( cy_mqtt_object_t ) );
+    mqtt_obj->event_loop = &mqtt_default_event_loop;
+
+    if( security != NULL )
+    {
+        mqtt_obj->security.alpnprotos = security->alpnprotos;
+        mqtt_obj->security.alpnprotoslen = security->alpnprotoslen;
+        mqtt_obj->security.sni_host_name = security->sni_host_name;
+        mqtt_obj->security.sni_host_name_size = security->sni_host_name_size;
+        mqtt_obj->security.username = security->username;
+        mqtt_obj->security.username_size = security->username_size;
+        mqtt_obj->security.password = security->password;
+        mqtt_obj->security.password_size = security->password_size;
+
+        mqtt_obj->security.client_cert = security->client_cert;
+        mqtt_obj->security.client_cert_size = security->client_cert_size;
+        mqtt_obj->security.private_key = security->private_key;
+        mqtt_obj->security.private_key_size = security->private_key_size;
+        mqtt_obj->security.root_ca = security->root_ca;
+        mqtt_obj->security.root_ca_size = security->root_ca_size;
+        mqtt_obj->security.root_ca_verify_mode = security->root_ca_verify_mode;
+        mqtt_obj->security.root_ca_location = security->root_ca_location;
+        mqtt_obj->security.cert_key_location = security->cert_key_location;
+        mqtt_obj->mqtt_secure_mode = true;
+    }
+    else
+    {
+        mqtt_obj->mqtt_secure_mode = false;
+    }
+
+    mqtt_obj->server_info.host_name = broker_info->hostname;
+    mqtt_obj->server_info.port = broker_info->port;
+    mqtt_obj->default_server_info = mqtt_obj->server_info;
+
+    result = cy_rtos_init_mutex2( &(mqtt_obj->process_mutex), false );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nCreating new mutex %p. failed\n", mqtt_obj->process_mutex );
+        goto exit;
+    }
+
+    process_mutex_init_status = true;
+
+    result = mqtt_ack_waiter_init( &(mqtt_obj->sub_waiter) );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        goto exit;
+    }
+
+    sub_waiter_init_status = true;
+
+    result = cy_rtos_init_mutex2( &(mqtt_obj->tx_mutex), true );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nCreating new mutex %p. failed\n", mqtt_obj->tx_mutex );
+        goto exit;
+    }
+
+    tx_mutex_init_status = true;
+
+    result = mqtt_ack_waiter_init( &(mqtt_obj->unsub_waiter) );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        goto exit;
+    }
+
+    unsub_waiter_init_status = true;
+
+    result = cy_rtos_init_mutex2( &(mqtt_obj->reconnect_mutex), false );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nCreating new mutex %p. failed\n", mqtt_obj->reconnect_mutex );
+        goto exit;
+    }
+
+    reconnect_mutex_init_status = true;
+
+    result = cy_rtos_init_mutex2( &(mqtt_obj->ref_mutex), false );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nCreating new mutex %p. failed\n", mqtt_obj->ref_mutex );
+        goto exit;
+    }
+
+    ref_mutex_init_status = true;
+
+    result = mqtt_alloc_publish_window( mqtt_obj, CY_MQTT_MAX_OUTGOING_PUBLISHES );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        goto exit;
+    }
+
+    result = mqtt_initialize_core_lib( &(mqtt_obj->mqtt_context), &(mqtt_obj->network_context), buffer, bufflen );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nmqtt_initialize_core_lib failed with Error : [0x%X] \n", (unsigned int)result );
+        goto exit;
+    }
+    else
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_initialize_core_lib successful.\n" );
+    }
+
+    mqtt_obj->network_context.disconnect_info.cbf = mqtt_awsport_network_disconnect_callback;
+    mqtt_obj->network_context.disconnect_info.user_data = ( void * )mqtt_obj;
+
+    mqtt_obj->network_context.receive_info.cbf = mqtt_awsport_network_receive_callback;
+    mqtt_obj->network_context.receive_info.user_data = ( void * )mqtt_obj;
+
+    result = cy_rtos_get_mutex( &mqtt_db_mutex, CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
+        goto exit;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_create - Acquired Mutex %p \n", mqtt_db_mutex );
+
+    /* Initialize the timers of the MQTT ping request, the ping response timeout, and the asynchronous acknowledgment timeout */
+    mqtt_timer_init( &mqtt_obj->mqtt_timer, mqtt_keepalive_timeout_callback, mqtt_obj );
+    mqtt_timer_init( &mqtt_obj->mqtt_ping_resp_timer, mqtt_pingresp_timeout_callback, mqtt_obj );
+    mqtt_timer_init( &mqtt_obj->mqtt_async_ack_timer, mqtt_async_ack_timeout_callback, mqtt_obj );
+    mqtt_timer_init( &mqtt_obj->reconnect_timer, mqtt_reconnect_timeout_callback, mqtt_obj );
+
+    memcpy(mqtt_obj->mqtt_descriptor, descriptor, strlen(descriptor)+1);
+
+    mqtt_obj->mqtt_magic_header = CY_MQTT_MAGIC_HEADER;
+    mqtt_obj->mqtt_magic_footer = CY_MQTT_MAGIC_FOOTER;
+
+    /* The reference of the handle, dropped by cy_mqtt_delete. */
+    mqtt_obj->ref_count = 1;
+
+    /* The MQTT object is added to the handle table once it is fully initialized, so that the failures above leave no entry behind. */
+    result = mqtt_handle_table_insert( mqtt_obj );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        (void)cy_rtos_set_mutex( &mqtt_db_mutex );
+        goto exit;
+    }
+    *mqtt_handle = (void *)mqtt_obj;
+    mqtt_obj->event_loop->handle_count++;
+
+    result = cy_rtos_set_mutex( &mqtt_db_mutex );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
+        goto exit;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_create - Released Mutex %p \n", mqtt_db_mutex );
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nMQTT object created successfully..\n" );
+
+    return CY_RSLT_SUCCESS;
+
+exit :
+    if( mqtt_obj != NULL )
+    {
+        if( process_mutex_init_status == true )
+        {
+            (void)cy_rtos_deinit_mutex( &(mqtt_obj->process_mutex) );
+            process_mutex_init_status = false;
+        }
+        if( sub_waiter_init_status == true )
+        {
+            mqtt_ack_waiter_deinit( &(mqtt_obj->sub_waiter) );
+            sub_waiter_init_status = false;
+        }
+        if( tx_mutex_init_status == true )
+        {
+            (void)cy_rtos_deinit_mutex( &(mqtt_obj->tx_mutex) );
+            tx_mutex_init_status = false;
+        }
+        if( unsub_waiter_init_status == true )
+        {
+            mqtt_ack_waiter_deinit( &(mqtt_obj->unsub_waiter) );
+            unsub_waiter_init_status = false;
+        }
+        if( reconnect_mutex_init_status == true )
+        {
+            (void)cy_rtos_deinit_mutex( &(mqtt_obj->reconnect_mutex) );
+            reconnect_mutex_init_status = false;
+        }
+        if( ref_mutex_init_status == true )
+        {
+            (void)cy_rtos_deinit_mutex( &(mqtt_obj->ref_mutex) );
+            ref_mutex_init_status = false;
+        }
+        mqtt_free_publish_window( mqtt_obj );
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\n Free mqtt_obj : %p..!\n", mqtt_obj );
+        free( mqtt_obj );
+    }
+
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_connect( cy_mqtt_t mqtt_handle, cy_mqtt_connect_info_t *connect_info )
+{
+    cy_rslt_t                     result = CY_RSLT_SUCCESS;
+    cy_rslt_t                     res = CY_RSLT_SUCCESS;
+    RetryUtilsParams_t            reconnectParams;
+    MQTTStatus_t                  mqttStatus = MQTTSuccess;
+    RetryUtilsStatus_t            retryUtilsStatus = RetryUtilsSuccess;
+    cy_mqtt_object_t              *mqtt_obj;
+    MQTTConnectInfo_t             connect_details;
+    MQTTPublishInfo_t             will_msg_details;
+    MQTTPublishInfo_t             *will_msg_ptr = NULL;
+
+    if( mqtt_handle == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_connect()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
+    }
+
+    mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
+
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_connect - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
+        return result;
+    }
+
+    /* A reconnection in progress is superseded by the application. */
+    mqtt_reconnect_cancel( mqtt_obj );
+
+    result = mqtt_prepare_connect_info( mqtt_obj, connect_info, &connect_details, &will_msg_details, &will_msg_ptr );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        goto exit;
+    }
+
+    /* Initialize the reconnect attempts and interval. */
+    RetryUtils_ParamsReset( &reconnectParams );
+
+    /* Attempt to connect to an MQTT broker. If connection fails, retry after
+     * a timeout. The timeout value will exponentially increase until the maximum
+     * attempts are reached.
+     */
+    do
+    {
+        result = mqtt_network_open_endpoints( mqtt_obj );
+        if( result != CY_RSLT_SUCCESS )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nConnection to the broker failed. Retrying connection with backoff and jitter.\n" );
+            retryUtilsStatus = RetryUtils_BackoffAndSleep( &reconnectParams );
+            if( retryUtilsStatus == RetryUtilsRetriesExhausted )
+            {
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nConnection to the broker failed, all attempts exhausted.\n" );
+                result = CY_RSLT_MODULE_MQTT_CONNECT_FAIL;
+            }
+        }
+    } while( ( result != CY_RSLT_SUCCESS ) && ( retryUtilsStatus == RetryUtilsSuccess ) );
+
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nTLS connection failed with Error : [0x%X] \n", (unsigned int)result );
+        goto exit;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nTLS connection established ..\n" );
+
+    result = mqtt_session_open( mqtt_obj, &connect_details, will_msg_ptr );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        goto exit;
+    }
+
+    /* Keep the connect information for the automatic reconnection. */
+    mqtt_record_connect_info( mqtt_obj, connect_info );
+
+    mqtt_obj->mqtt_conn_status = true;
+
+    result = start_timer( mqtt_obj );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nstart_timer failed with Error : [0x%X] \n", (unsigned int)result );
+        goto exit;
+    }
+
+    result = cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", (unsigned int)result );
+        goto exit;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_connect - Released Mutex %p \n", mqtt_obj->process_mutex );
+
+    if( mqtt_obj->spool != NULL )
+    {
+        /* The spooled messages are published by mqtt_event_processing_thread. */
+        mqtt_queue_async_publish_event( mqtt_obj, CY_MQTT_EVENT_QUEUE_TIMEOUT_IN_MSEC );
+    }
+
+    mqtt_obj_release( mqtt_obj );
+    return result;
+
+exit :
+    if( mqtt_obj->mqtt_session_established == true )
+    {
+        mqttStatus = MQTT_Disconnect( &(mqtt_obj->mqtt_context) );
+        if( mqttStatus != MQTTSuccess )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "Sending MQTT DISCONNECT failed with status=%s.\n",
+                             MQTT_Status_strerror( mqttStatus ) );
+            /*
+             * In case of an unexpected network disconnection, the MQTT_Disconnect API always returns failure. Therefore,
+             * the return value of the MQTT_Disconnect API is not checked here.
+             */
+            /* Fall-through. */
+        }
+        mqtt_obj->mqtt_session_established = false;
+    }
+
+    res = cy_awsport_network_disconnect( &(mqtt_obj->network_context) );
+    if( res != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_awsport_network_disconnect failed with Error : [0x%X] \n", (unsigned int)result );
+        /*
+         * In case of an unexpected network disconnection, the cy_awsport_network_disconnect API always returns failure. Therefore,
+         * the return value of the cy_awsport_network_disconnect API is not checked here.
+         */
+        /* Fall-through. */
+    }
+    res = cy_awsport_network_delete( &(mqtt_obj->network_context) );
+    if( res != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_awsport_network_delete failed with Error : [0x%X] \n", (unsigned int)result );
+        /*
+         * In case of an unexpected network disconnection, the cy_awsport_network_delete API always returns failure. Therefore,
+         * the return value of the cy_awsport_network_delete API is not checked here.
+         */
+        /* Fall-through. */
+    }
+
+    res = cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    if( res != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", (unsigned int)res );
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_connect - Released Mutex %p \n", mqtt_obj->process_mutex );
+
+    mqtt_obj_release( mqtt_obj );
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_publish_message
+ *
+ * Publish a message and wait for its acknowledgment. The payload is either the contiguous payload of pubmsg,
+ * or the payload segments of cy_mqtt_publish_vectored if segments is not NULL. If topic_obj is not NULL, the
+ * packet is serialized from the registered topic of cy_mqtt_publish_topic.
+ */
+static cy_rslt_t mqtt_publish_message( cy_mqtt_t mqtt_handle, cy_mqtt_publish_info_t *pubmsg,
+                                       const cy_mqtt_payload_segment_t *segments, uint16_t segment_count,
+                                       const cy_mqtt_topic_object_t *topic_obj )
+{
+    cy_rslt_t        result = CY_RSLT_SUCCESS;
+    MQTTStatus_t     mqttStatus = MQTTSuccess;
+    uint16_t         publishIndex = CY_MQTT_PUB_INDEX_INVALID;
+    uint16_t         packetid = MQTT_PACKET_ID_INVALID;
+    cy_mqtt_object_t *mqtt_obj;
+    cy_mqtt_pubpack_t *pubpack = NULL;
+    uint8_t          retry = 0;
+    size_t           payload_len = 0;
+    uint16_t         i;
+
+    if( (mqtt_handle == NULL) || (pubmsg == NULL) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_publish()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
+    }
+
+    mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
+
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
+    }
+
+    if( mqtt_obj->mqtt_session_established == false )
+    {
+        if( (mqtt_obj->spool != NULL) && (segments == NULL) )
+        {
+            /* The message is published from the spool once the session is established. */
+            result = mqtt_spool_append( mqtt_obj->spool, pubmsg );
+            mqtt_obj_release( mqtt_obj );
+            return result;
+        }
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT client session not present..!\n" );
+        mqtt_obj_release( mqtt_obj );
+        return CY_RSLT_MODULE_MQTT_NOT_CONNECTED;
+    }
+
+    if( (pubmsg->qos != CY_MQTT_QOS0) && (pubmsg->qos != CY_MQTT_QOS1) && (pubmsg->qos != CY_MQTT_QOS2) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nQoS level not supported..!\n" );
+        mqtt_obj_release( mqtt_obj );
+        return CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
+    }
+
+    if( segments != NULL )
+    {
+        for( i = 0; i < segment_count; i++ )
+        {
+            payload_len += segments[ i ].data_len;
+        }
+    }
+    else
+    {
+        payload_len = pubmsg->payload_len;
+    }
+
+    /* Get the next free index for the outgoing PUBLISH packets. All QoS2 outgoing
+     * PUBLISH packets are stored until a PUBREC is received. These messages are
+     * stored for supporting a resend if a network connection is broken before
+     * receiving a PUBREC. */
+    result = mqtt_get_next_free_index_for_publish( mqtt_obj, &publishIndex );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nUnable to find a free spot for outgoing PUBLISH message.\n" );
+        result = CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
+        goto exit;
+    }
+
+    /* The credit is taken after the inflight window entry is reserved, so that a message which
+     * finds the window full is not charged to the rate limit. */
+    result = mqtt_rate_limit_acquire( mqtt_obj, 1, pubmsg->topic_len + payload_len, true );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        goto exit;
+    }
+
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        goto exit;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_publish - Acquired Mutex %p \n", mqtt_obj->process_mutex );
+
+    pubpack = &(mqtt_obj->outgoing_pub_packets[ publishIndex ]);
+    packetid = pubpack->packetid;
+    pubpack->pubinfo.qos = (MQTTQoS_t)pubmsg->qos;
+    pubpack->pubinfo.pTopicName = pubmsg->topic;
+    pubpack->pubinfo.topicNameLength = pubmsg->topic_len;
+    pubpack->pubinfo.pPayload = (segments == NULL) ? pubmsg->payload : NULL;
+    pubpack->pubinfo.payloadLength = payload_len;
+    pubpack->segments = segments;
+    pubpack->segment_count = segment_count;
+    pubpack->topic_obj = topic_obj;
+    /* Each caller waits for the acknowledgment of its own packet on the semaphore of its inflight window entry,
+     * so that PUBLISH requests from several threads can be in flight at the same time. */
+    pubpack->ack_waiting = ( pubpack->pubinfo.qos != MQTTQoS0 );
+
+    /* Publish retry loop. */
+    do
+    {
+        /* The entry is looked up again after every wait, because the process mutex is released while waiting. */
+        publishIndex = mqtt_find_outgoing_publish( mqtt_obj, packetid );
+        if( publishIndex == CY_MQTT_PUB_INDEX_INVALID )
+        {
+            result = CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
+            break;
+        }
+        pubpack = &(mqtt_obj->outgoing_pub_packets[ publishIndex ]);
+        pubpack->ack_received = false;
+
+        /* Send the PUBLISH packet. The process mutex is released while the packet is written to the socket,
+         * so that received packets are processed and other threads can publish in the meantime. */
+        pubpack->release_on_send = true;
+        mqttStatus = mqtt_send_publish( mqtt_obj, pubpack );
+        publishIndex = mqtt_find_outgoing_publish( mqtt_obj, packetid );
+        if( publishIndex == CY_MQTT_PUB_INDEX_INVALID )
+        {
+            result = CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
+            break;
+        }
+        pubpack = &(mqtt_obj->outgoing_pub_packets[ publishIndex ]);
+        pubpack->release_on_send = false;
+        if( mqttStatus != MQTTSuccess )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to send PUBLISH packet to broker with error = %s.\n",
+                             MQTT_Status_strerror( mqttStatus ) );
+            result = CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
+        }
+        else
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nPUBLISH sent for topic %.*s to broker with packet ID %u.\n",
+                             pubmsg->topic_len, pubmsg->topic, packetid );
+            pubpack->pubinfo.dup = true;
+            /* Wait for the acknowledgment for PUBLISH ( PUBACK/PUBREC ). It is processed by
+             * mqtt_event_processing_thread, which signals the semaphore of this packet. */
+            if( pubpack->pubinfo.qos != MQTTQoS0 )
+            {
+                mqttStatus = mqtt_wait_for_ack( mqtt_obj, &(mqtt_obj->pub_ack_sems[ publishIndex ]), &(pubpack->ack_received), CY_MQTT_ACK_RECEIVE_TIMEOUT_MS );
+                publishIndex = mqtt_find_outgoing_publish( mqtt_obj, packetid );
+                if( (publishIndex != CY_MQTT_PUB_INDEX_INVALID) && (mqtt_obj->outgoing_pub_packets[ publishIndex ].ack_received == true) )
+                {
+                    result = CY_RSLT_SUCCESS;
+                }
+                else
+                {
+                    /* Assign the MQTT Status to an error in case of PUBACK/PUBREC receive failure to retry publish. */
+                    result = CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
+                    mqttStatus = MQTTRecvFailed;
+                }
+            }
+            else
+            {
+                result = CY_RSLT_SUCCESS;
+            }
+        }
+        retry++;
+    } while( (mqttStatus != MQTTSuccess) && (retry < CY_MQTT_MAX_RETRY_VALUE) );
+
+    /* The acknowledgment is already recorded, so the packet is no longer needed for a resend. */
+    (void)mqtt_cleanup_outgoing_publish_with_packet_id( mqtt_obj, packetid );
+
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nFailed to send PUBLISH packet to broker with max retry..!\n " );
+    }
+
+    if( cy_rtos_set_mutex( &(mqtt_obj->process_mutex) ) != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed\n", mqtt_obj->process_mutex );
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_publish - Released Mutex %p \n", mqtt_obj->process_mutex );
+    publishIndex = CY_MQTT_PUB_INDEX_INVALID;
+
+exit :
+    if( publishIndex != CY_MQTT_PUB_INDEX_INVALID )
+    {
+        /* The packet was never sent; return it to the inflight window. */
+        if( cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT ) == CY_RSLT_SUCCESS )
+        {
+            (void)mqtt_cleanup_outgoing_publish( mqtt_obj, publishIndex );
+            (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+        }
+    }
+
+    mqtt_obj_release( mqtt_obj );
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_compress_outgoing_payload
+ *
+ * Compress the payload of an outgoing message if the payload codec of the MQTT handle is enabled. The codec is
+ * copied under mqtt_obj->process_mutex, and the payload is compressed without holding it.
+ * Returns the allocated compressed payload, or NULL if the payload is to be sent uncompressed.
+ */
+/* mqtt_compress_outgoing_payload must be called with a reference to mqtt_obj held */
+static uint8_t *mqtt_compress_outgoing_payload( cy_mqtt_object_t *mqtt_obj, const cy_mqtt_publish_info_t *pubmsg, size_t *compressed_len )
+{
+    cy_mqtt_payload_codec_t codec;
+    bool                    codec_enabled = false;
+
+    if( (mqtt_obj->codec_enabled == true) &&
+        (cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT ) == CY_RSLT_SUCCESS) )
+    {
+        codec_enabled = mqtt_obj->codec_enabled;
+        memcpy( &codec, &(mqtt_obj->codec), sizeof( codec ) );
+        (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    }
+    if( codec_enabled == false )
+    {
+        return NULL;
+    }
+    return mqtt_compress_payload( &codec, pubmsg, compressed_len );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_publish_compressed
+ *
+ * Publish a message with a contiguous payload, compressing the payload first if the payload codec is enabled.
+ */
+static cy_rslt_t mqtt_publish_compressed( cy_mqtt_t mqtt_handle, cy_mqtt_publish_info_t *pubmsg,
+                                          const cy_mqtt_topic_object_t *topic_obj )
+{
+    cy_rslt_t               result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t        *mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
+    cy_mqtt_publish_info_t  compressed_msg;
+    uint8_t                 *compressed = NULL;
+    size_t                  compressed_len = 0;
+
+    if( (mqtt_handle != NULL) && (pubmsg != NULL) && (mqtt_lib_init_status == true) && (mqtt_obj_acquire( mqtt_obj ) == true) )
+    {
+        compressed = mqtt_compress_outgoing_payload( mqtt_obj, pubmsg, &compressed_len );
+        mqtt_obj_release( mqtt_obj );
+    }
+
+    if( compressed == NULL )
+    {
+        return mqtt_publish_message( mqtt_handle, pubmsg, NULL, 0, topic_obj );
+    }
+
+    memcpy( &compressed_msg, pubmsg, sizeof( compressed_msg ) );
+    compressed_msg.payload = (const char *)compressed;
+    compressed_msg.payload_len = compressed_len;
+    result = mqtt_publish_message( mqtt_handle, &compressed_msg, NULL, 0, topic_obj );
+    free( compressed );
+
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_publish( cy_mqtt_t mqtt_handle, cy_mqtt_publish_info_t *pubmsg )
+{
+    return mqtt_publish_compressed( mqtt_handle, pubmsg, NULL );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_publish_vectored( cy_mqtt_t mqtt_handle, cy_mqtt_publish_info_t *pubmsg,
+                                    const cy_mqtt_payload_segment_t *segments, uint16_t segment_count )
+{
+    uint16_t i;
+
+    if( (segments == NULL) || (segment_count == 0) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_publish_vectored()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    for( i = 0; i < segment_count; i++ )
+    {
+        if( (segments[ i ].data == NULL) && (segments[ i ].data_len != 0) )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nPayload segment %u has no data..!\n", (unsigned int)i );
+            return CY_RSLT_MODULE_MQTT_BADARG;
+        }
+    }
+
+    return mqtt_publish_message( mqtt_handle, pubmsg, segments, segment_count, NULL );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_publish_topic( cy_mqtt_t mqtt_handle, cy_mqtt_topic_t topic_handle, const char *payload, size_t payload_len )
+{
+    cy_mqtt_topic_object_t  *topic_obj = (cy_mqtt_topic_object_t *)topic_handle;
+    cy_mqtt_publish_info_t  pubmsg;
+
+    if( (mqtt_handle == NULL) || (topic_handle == NULL) || ((payload == NULL) && (payload_len != 0)) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_publish_topic()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( (topic_obj->magic != CY_MQTT_TOPIC_MAGIC) || (topic_obj->owner != mqtt_handle) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid topic handle..!\n" );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
+    }
+
+    memset( &pubmsg, 0x00, sizeof( pubmsg ) );
+    pubmsg.qos = topic_obj->qos;
+    pubmsg.retain = topic_obj->retain;
+    pubmsg.topic = (const char *)&(topic_obj->encoded[ sizeof( uint16_t ) ]);
+    pubmsg.topic_len = (uint16_t)(topic_obj->encoded_len - sizeof( uint16_t ));
+    pubmsg.payload = payload;
+    pubmsg.payload_len = payload_len;
+
+    return mqtt_publish_compressed( mqtt_handle, &pubmsg, topic_obj );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_publish_async( cy_mqtt_t mqtt_handle, cy_mqtt_publish_info_t *pubmsg,
+                                 cy_mqtt_publish_complete_cb_t complete_cb, void *user_data,
+                                 cy_mqtt_publish_token_t *token )
+{
+    cy_rslt_t               result = CY_RSLT_SUCCESS;
+    MQTTStatus_t            mqttStatus = MQTTSuccess;
+    uint16_t                publishIndex = CY_MQTT_PUB_INDEX_INVALID;
+    cy_mqtt_object_t        *mqtt_obj;
+    cy_mqtt_pubpack_t       *pubpack = NULL;
+    cy_mqtt_publish_info_t  compressed_msg;
+    uint8_t                 *compressed = NULL;
+    size_t                  compressed_len = 0;
+
+    if( (mqtt_handle == NULL) || (pubmsg == NULL) || (token == NULL) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_publish_async()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( (pubmsg->qos != CY_MQTT_QOS0) && (pubmsg->qos != CY_MQTT_QOS1) && (pubmsg->qos != CY_MQTT_QOS2) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nQoS level not supported..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
+    }
+
+    mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
+
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
+    }
+
+    if( mqtt_obj->mqtt_session_established == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT client session not present..!\n" );
+        mqtt_obj_release( mqtt_obj );
+        return CY_RSLT_MODULE_MQTT_NOT_CONNECTED;
+    }
+
+    /* The compressed payload is owned by the inflight window entry until the publish is completed,
+     * so that it can be resent after the MQTT session is resumed. */
+    compressed = mqtt_compress_outgoing_payload( mqtt_obj, pubmsg, &compressed_len );
+    if( compressed != NULL )
+    {
+        memcpy( &compressed_msg, pubmsg, sizeof( compressed_msg ) );
+        compressed_msg.payload = (const char *)compressed;
+        compressed_msg.payload_len = compressed_len;
+        pubmsg = &compressed_msg;
+    }
+
+    /* Get the next free index for the outgoing PUBLISH packets. The QoS1 and QoS2 asynchronous
+     * PUBLISH packets are stored until the completion is reported to the application. */
+    result = mqtt_get_next_free_index_for_publish( mqtt_obj, &publishIndex );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nUnable to find a free spot for outgoing PUBLISH message.\n" );
+        free( compressed );
+        mqtt_obj_release( mqtt_obj );
+        return CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
+    }
+
+    /* Asynchronous publishes do not wait for the rate limit, as they can be called from mqtt_event_processing_thread.
+     * The credit is taken after the inflight window entry is reserved, so that a message which finds the window full
+     * is not charged to the rate limit. */
+    result = mqtt_rate_limit_acquire( mqtt_obj, 1, pubmsg->topic_len + pubmsg->payload_len, false );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        if( cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT ) == CY_RSLT_SUCCESS )
+        {
+            (void)mqtt_cleanup_outgoing_publish( mqtt_obj, publishIndex );
+            (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+        }
+        free( compressed );
+        mqtt_obj_release( mqtt_obj );
+        return result;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_publish_async - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        free( compressed );
+        mqtt_obj_release( mqtt_obj );
+        return result;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_publish_async - Acquired Mutex %p \n", mqtt_obj->process_mutex );
+
+    pubpack = &(mqtt_obj->outgoing_pub_packets[ publishIndex ]);
+    pubpack->pubinfo.qos = (MQTTQoS_t)pubmsg->qos;
+    pubpack->pubinfo.retain = pubmsg->retain;
+    pubpack->pubinfo.pTopicName = pubmsg->topic;
+    pubpack->pubinfo.topicNameLength = pubmsg->topic_len;
+    pubpack->pubinfo.pPayload = pubmsg->payload;
+    pubpack->pubinfo.payloadLength = pubmsg->payload_len;
+    pubpack->async = true;
+    pubpack->completed = false;
+    pubpack->complete_cb = complete_cb;
+    pubpack->complete_cb_data = user_data;
+    pubpack->ack_deadline_ms = Clock_GetTimeMs() + CY_MQTT_ASYNC_PUBLISH_ACK_TIMEOUT_MS;
+    pubpack->compressed_payload = compressed;
+
+    if( (mqtt_obj->retransmit_arena != NULL) && (pubpack->pubinfo.qos != MQTTQoS0) )
+    {
+        /* The message is sent and resent from the retransmit arena, so that the application
+         * can reuse its buffers as soon as this function returns. */
+        result = mqtt_copy_to_retransmit_arena( mqtt_obj, publishIndex, pubmsg );
+        if( result != CY_RSLT_SUCCESS )
+        {
+            mqtt_rate_limit_refund( mqtt_obj, 1, pubmsg->topic_len + pubmsg->payload_len );
+            (void)mqtt_cleanup_outgoing_publish( mqtt_obj, publishIndex );
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_publish_async - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+            (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_publish_async - Released Mutex %p \n", mqtt_obj->process_mutex );
+            mqtt_obj_release( mqtt_obj );
+            return CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
+        }
+        /* The entry no longer refers to the compressed payload. */
+        free( pubpack->compressed_payload );
+        pubpack->compressed_payload = NULL;
+    }
+
+    /* Send the PUBLISH packet. The acknowledgment is processed by mqtt_event_processing_thread. */
+    mqttStatus = mqtt_send_publish( mqtt_obj, pubpack );
+    if( mqttStatus != MQTTSuccess )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to send PUBLISH packet to broker with error = %s.\n",
+                         MQTT_Status_strerror( mqttStatus ) );
+        result = CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
+    }
+    else
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nAsync PUBLISH sent for topic %.*s to broker with packet ID %u.\n",
+                         pubmsg->topic_len, pubmsg->topic, pubpack->packetid );
+        result = CY_RSLT_SUCCESS;
+        pubpack->pubinfo.dup = true;
+        if( pubpack->pubinfo.qos != MQTTQoS0 )
+        {
+            *token = pubpack->packetid;
+            (void)start_async_ack_timer( mqtt_obj, CY_MQTT_ASYNC_PUBLISH_ACK_TIMEOUT_MS, false );
+        }
+        else
+        {
+            *token = 0;
+        }
+    }
+
+    if( (result != CY_RSLT_SUCCESS) || (pubpack->pubinfo.qos == MQTTQoS0) )
+    {
+        /* Clean up outgoing_pub_packets for QoS0 and failed PUBLISH packets. */
+        (void)mqtt_cleanup_outgoing_publish( mqtt_obj, publishIndex );
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_publish_async - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_publish_async - Released Mutex %p \n", mqtt_obj->process_mutex );
+
+    mqtt_obj_release( mqtt_obj );
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_publish_batch( cy_mqtt_t mqtt_handle, cy_mqtt_publish_info_t *pub_msgs, uint16_t count )
+{
+    cy_rslt_t          result = CY_RSLT_SUCCESS;
+    MQTTStatus_t       mqttStatus = MQTTSuccess;
+    cy_mqtt_object_t   *mqtt_obj;
+    cy_mqtt_pubpack_t  *pubpack = NULL;
+    uint16_t           *packet_ids = NULL;
+    uint16_t           first, last, free_entries, slice_acks;
+    uint16_t           i, index;
+    uint32_t           deadline, now;
+    uint8_t            retry = 0;
+    size_t             batch_bytes = 0;
+
+    if( (mqtt_handle == NULL) || (pub_msgs == NULL) || (count == 0) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_publish_batch()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    for( i = 0; i < count; i++ )
+    {
+        if( (pub_msgs[ i ].qos != CY_MQTT_QOS0) && (pub_msgs[ i ].qos != CY_MQTT_QOS1) && (pub_msgs[ i ].qos != CY_MQTT_QOS2) )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nQoS level not supported..!\n" );
+            return CY_RSLT_MODULE_MQTT_BADARG;
+        }
+        batch_bytes += pub_msgs[ i ].topic_len + pub_msgs[ i ].payload_len;
+    }
+
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
+    }
+
+    mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
+
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
+    }
+
+    if( mqtt_obj->mqtt_session_established == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT client session not present..!\n" );
+        mqtt_obj_release( mqtt_obj );
+        return CY_RSLT_MODULE_MQTT_NOT_CONNECTED;
+    }
+
+    result = mqtt_rate_limit_acquire( mqtt_obj, count, batch_bytes, true );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        mqtt_obj_release( mqtt_obj );
+        return result;
+    }
+
+    packet_ids = (uint16_t *)malloc( sizeof( uint16_t ) * count );
+    if( packet_ids == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to create packet_ids..!\n" );
+        mqtt_obj_release( mqtt_obj );
+        return CY_RSLT_MODULE_MQTT_NOMEM;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_publish_batch - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        goto exit;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_publish_batch - Acquired Mutex %p \n", mqtt_obj->process_mutex );
+
+    /* The batch is sent in slices. The QoS1 and QoS2 messages of a slice are limited to the free entries of the inflight
+     * window, and are stored in the window until acknowledged to support a resend if the network connection is broken.
+     * Each slice is acknowledged before the next slice is sent. */
+    first = 0;
+    while( (first < count) && (result == CY_RSLT_SUCCESS) )
+    {
+        free_entries = mqtt_obj->pub_window_size - mqtt_obj->num_outgoing_pubs;
+        slice_acks = 0;
+        for( last = first; last < count; last++ )
+        {
+            packet_ids[ last ] = MQTT_PACKET_ID_INVALID;
+            if( pub_msgs[ last ].qos == CY_MQTT_QOS0 )
+            {
+                continue;
+            }
+            if( slice_acks == free_entries )
+            {
+                break;
+            }
+            index = mqtt_reserve_outgoing_publish( mqtt_obj );
+            pubpack = &(mqtt_obj->outgoing_pub_packets[ index ]);
+            pubpack->pubinfo.qos = (MQTTQoS_t)pub_msgs[ last ].qos;
+            pubpack->pubinfo.retain = pub_msgs[ last ].retain;
+            pubpack->pubinfo.pTopicName = pub_msgs[ last ].topic;
+            pubpack->pubinfo.topicNameLength = pub_msgs[ last ].topic_len;
+            pubpack->pubinfo.pPayload = pub_msgs[ last ].payload;
+            pubpack->pubinfo.payloadLength = pub_msgs[ last ].payload_len;
+            pubpack->ack_waiting = true;
+            packet_ids[ last ] = pubpack->packetid;
+            slice_acks++;
+        }
+
+        if( last == first )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nUnable to find a free spot for outgoing PUBLISH messages.\n" );
+            result = CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
+            break;
+        }
+
+        /* Publish retry loop. Each round resends the messages of the slice not acknowledged in the previous round. */
+        retry = 0;
+        do
+        {
+            mqttStatus = mqtt_send_publish_batch( mqtt_obj, &(pub_msgs[ first ]), &(packet_ids[ first ]), (uint16_t)(last - first), (retry > 0) );
+            if( mqttStatus != MQTTSuccess )
+            {
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to send PUBLISH batch to broker with error = %s.\n",
+                                 MQTT_Status_strerror( mqttStatus ) );
+                result = CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
+            }
+            else
+            {
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nPUBLISH batch of %u messages sent to broker.\n", (unsigned int)(last - first) );
+                /* Wait for the acknowledgments of the whole slice ( PUBACK/PUBREC ) within a single timeout. */
+                result = CY_RSLT_SUCCESS;
+                deadline = Clock_GetTimeMs() + CY_MQTT_ACK_RECEIVE_TIMEOUT_MS;
+                for( i = first; (i < last) && (mqttStatus == MQTTSuccess); i++ )
+                {
+                    index = mqtt_find_outgoing_publish( mqtt_obj, packet_ids[ i ] );
+                    if( index == CY_MQTT_PUB_INDEX_INVALID )
+                    {
+                        continue;
+                    }
+                    now = Clock_GetTimeMs();
+                    mqttStatus = mqtt_wait_for_ack( mqtt_obj, &(mqtt_obj->pub_ack_sems[ index ]), &(mqtt_obj->outgoing_pub_packets[ index ].ack_received),
+                                                    ( (int32_t)(deadline - now) > 0 ) ? (deadline - now) : 0 );
+                }
+                if( mqttStatus != MQTTSuccess )
+                {
+                    /* Assign the MQTT Status to an error in case of PUBACK/PUBREC receive failure to retry publish. */
+                    result = CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
+                    mqttStatus = MQTTRecvFailed;
+                }
+            }
+            retry++;
+        } while( (mqttStatus != MQTTSuccess) && (retry < CY_MQTT_MAX_RETRY_VALUE) && (mqtt_obj->mqtt_session_established == true) );
+
+        for( i = first; i < last; i++ )
+        {
+            if( packet_ids[ i ] != MQTT_PACKET_ID_INVALID )
+            {
+                (void)mqtt_cleanup_outgoing_publish_with_packet_id( mqtt_obj, packet_ids[ i ] );
+            }
+        }
+        first = last;
+    }
+
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nFailed to send PUBLISH batch to broker with max retry..!\n " );
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_publish_batch - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_publish_batch - Released Mutex %p \n", mqtt_obj->process_mutex );
+
+exit :
+    free( packet_ids );
+
+    mqtt_obj_release( mqtt_obj );
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_enable_spool( cy_mqtt_t mqtt_handle, const cy_mqtt_spool_storage_t *storage )
+{
+    cy_rslt_t          result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t   *mqtt_obj;
+    cy_mqtt_spool_t    *spool = NULL;
+
+    if( (mqtt_handle == NULL) || (storage == NULL) || (storage->read == NULL) || (storage->write == NULL) ||
+        (storage->size <= (CY_MQTT_SPOOL_DATA_OFFSET + sizeof( cy_mqtt_spool_record_t ))) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_enable_spool()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
+    }
+
+    mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
+
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
+    }
+
+    if( mqtt_obj->spool != NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nPublish spool is already enabled..!\n" );
+        mqtt_obj_release( mqtt_obj );
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    spool = (cy_mqtt_spool_t *)malloc( sizeof( cy_mqtt_spool_t ) );
+    if( spool == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to create publish spool..!\n" );
+        mqtt_obj_release( mqtt_obj );
+        return CY_RSLT_MODULE_MQTT_NOMEM;
+    }
+    memset( spool, 0x00, sizeof( cy_mqtt_spool_t ) );
+    memcpy( &(spool->storage), storage, sizeof( cy_mqtt_spool_storage_t ) );
+    spool->data_size = storage->size - CY_MQTT_SPOOL_DATA_OFFSET;
+
+    spool->commit_buffer = (uint8_t *)malloc( CY_MQTT_SPOOL_COMMIT_BUFFER_SIZE );
+    if( spool->commit_buffer == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to create publish spool commit buffer..!\n" );
+        free( spool );
+        mqtt_obj_release( mqtt_obj );
+        return CY_RSLT_MODULE_MQTT_NOMEM;
+    }
+
+    result = cy_rtos_init_mutex2( &(spool->mutex), false );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nCreating new mutex %p. failed\n", spool->mutex );
+        free( spool->commit_buffer );
+        free( spool );
+        mqtt_obj_release( mqtt_obj );
+        return result;
+    }
+
+    result = mqtt_spool_load_header( spool );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        goto exit;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_enable_spool - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        goto exit;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_enable_spool - Acquired Mutex %p \n", mqtt_obj->process_mutex );
+
+    mqtt_obj->spool = spool;
+    if( (mqtt_obj->mqtt_session_established == true) && (spool->used > 0) )
+    {
+        mqtt_queue_async_publish_event( mqtt_obj, CY_MQTT_EVENT_QUEUE_TIMEOUT_IN_MSEC );
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_enable_spool - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_enable_spool - Released Mutex %p \n", mqtt_obj->process_mutex );
+
+    mqtt_obj_release( mqtt_obj );
+    return CY_RSLT_SUCCESS;
+
+exit :
+    (void)cy_rtos_deinit_mutex( &(spool->mutex) );
+    free( spool->commit_buffer );
+    free( spool );
+    mqtt_obj_release( mqtt_obj );
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_flush_spool( cy_mqtt_t mqtt_handle )
+{
+    cy_rslt_t          result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t   *mqtt_obj;
+    cy_mqtt_spool_t    *spool = NULL;
+
+    if( mqtt_handle == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_flush_spool()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
+    }
+
+    mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
+
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
+    }
+
+    spool = mqtt_obj->spool;
+    if( spool == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nPublish spool is not enabled..!\n" );
+        mqtt_obj_release( mqtt_obj );
+        return CY_RSLT_MODULE_MQTT_ERROR;
+    }
+
+    result = cy_rtos_get_mutex( &(spool->mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", spool->mutex, (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
+        return result;
+    }
+
+    result = mqtt_spool_commit( spool );
+    if( (result == CY_RSLT_SUCCESS) && (spool->acks_since_persist > 0) )
+    {
+        result = mqtt_spool_write_header( spool );
+        if( result == CY_RSLT_SUCCESS )
+        {
+            spool->acks_since_persist = 0;
+        }
+    }
+
+    (void)cy_rtos_set_mutex( &(spool->mutex) );
+    mqtt_obj_release( mqtt_obj );
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_set_max_inflight_publishes( cy_mqtt_t mqtt_handle, uint16_t max_inflight )
+{
+    cy_rslt_t          result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t   *mqtt_obj;
+
+    if( (mqtt_handle == NULL) || (max_inflight == 0) || (max_inflight > CY_MQTT_MAX_INFLIGHT_WINDOW) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_set_max_inflight_publishes()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
+    }
+
+    mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
+
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
+    }
+
+    if( mqtt_obj->mqtt_session_established == true )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInflight window cannot be changed while connected..!\n" );
+        mqtt_obj_release( mqtt_obj );
+        return CY_RSLT_MODULE_MQTT_ALREADY_CONNECTED;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_max_inflight_publishes - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
+        return result;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_max_inflight_publishes - Acquired Mutex %p \n", mqtt_obj->process_mutex );
+
+    if( mqtt_obj->num_outgoing_pubs != 0 )
+    {
+        /* Messages of the previous session are still stored for a resend or a pending completion. */
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n%u outgoing PUBLISH packets are pending..!\n", (unsigned int)mqtt_obj->num_outgoing_pubs );
+        result = CY_RSLT_MODULE_MQTT_ERROR;
+    }
+    else if( max_inflight != mqtt_obj->pub_window_size )
+    {
+        mqtt_free_publish_window( mqtt_obj );
+        result = mqtt_alloc_publish_window( mqtt_obj, max_inflight );
+        if( result != CY_RSLT_SUCCESS )
+        {
+            /* Fall back to the default window, so that the MQTT instance remains usable. */
+            (void)mqtt_alloc_publish_window( mqtt_obj, CY_MQTT_MAX_OUTGOING_PUBLISHES );
+        }
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_max_inflight_publishes - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_max_inflight_publishes - Released Mutex %p \n", mqtt_obj->process_mutex );
+
+    mqtt_obj_release( mqtt_obj );
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_set_retransmit_buffer_size( cy_mqtt_t mqtt_handle, uint32_t slot_size )
+{
+    cy_rslt_t          result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t   *mqtt_obj;
+
+    if( mqtt_handle == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_set_retransmit_buffer_size()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
+    }
+
+    mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
+
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
+    }
+
+    if( mqtt_obj->mqtt_session_established == true )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nRetransmit arena cannot be changed while connected..!\n" );
+        mqtt_obj_release( mqtt_obj );
+        return CY_RSLT_MODULE_MQTT_ALREADY_CONNECTED;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_retransmit_buffer_size - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
+        return result;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_retransmit_buffer_size - Acquired Mutex %p \n", mqtt_obj->process_mutex );
+
+    if( mqtt_obj->num_outgoing_pubs != 0 )
+    {
+        /* Messages of the previous session may still point into the retransmit arena. */
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n%u outgoing PUBLISH packets are pending..!\n", (unsigned int)mqtt_obj->num_outgoing_pubs );
+        result = CY_RSLT_MODULE_MQTT_ERROR;
+    }
+    else if( slot_size != mqtt_obj->retransmit_slot_size )
+    {
+        uint16_t window_size = mqtt_obj->pub_window_size;
+
+        mqtt_free_publish_window( mqtt_obj );
+        mqtt_obj->retransmit_slot_size = slot_size;
+        result = mqtt_alloc_publish_window( mqtt_obj, window_size );
+        if( result != CY_RSLT_SUCCESS )
+        {
+            /* Fall back to the inflight window without the retransmit arena, so that the MQTT instance remains usable. */
+            mqtt_obj->retransmit_slot_size = 0;
+            (void)mqtt_alloc_publish_window( mqtt_obj, window_size );
+        }
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_retransmit_buffer_size - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_retransmit_buffer_size - Released Mutex %p \n", mqtt_obj->process_mutex );
+
+    mqtt_obj_release( mqtt_obj );
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_set_publish_rate_limit( cy_mqtt_t mqtt_handle, const cy_mqtt_publish_rate_limit_t *rate_limit )
+{
+    cy_rslt_t          result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t   *mqtt_obj;
+
+    if( (mqtt_handle == NULL) ||
+        ((rate_limit != NULL) && (((rate_limit->messages_per_sec > 0) && (rate_limit->message_burst == 0)) ||
+                                  ((rate_limit->bytes_per_sec > 0) && (rate_limit->byte_burst == 0)))) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_set_publish_rate_limit()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
+    }
+
+    mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
+
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_publish_rate_limit - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
+        return result;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_publish_rate_limit - Acquired Mutex %p \n", mqtt_obj->process_mutex );
+
+    memset( &(mqtt_obj->rate_limiter), 0x00, sizeof( cy_mqtt_rate_limiter_t ) );
+    mqtt_obj->rate_limit_enabled = false;
+    if( rate_limit != NULL )
+    {
+        /* The buckets start full, so that the first burst is not delayed. */
+        memcpy( &(mqtt_obj->rate_limiter.config), rate_limit, sizeof( cy_mqtt_publish_rate_limit_t ) );
+        mqtt_obj->rate_limiter.message_credit = (int64_t)rate_limit->message_burst * 1000;
+        mqtt_obj->rate_limiter.byte_credit = (int64_t)rate_limit->byte_burst * 1000;
+        mqtt_obj->rate_limiter.last_refill_ms = Clock_GetTimeMs();
+        mqtt_obj->rate_limit_enabled = true;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_publish_rate_limit - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_publish_rate_limit - Released Mutex %p \n", mqtt_obj->process_mutex );
+
+    mqtt_obj_release( mqtt_obj );
+    return CY_RSLT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_topic_register( cy_mqtt_t mqtt_handle, const char *topic, uint16_t topic_len,
+                                  cy_mqtt_qos_t qos, bool retain, cy_mqtt_topic_t *topic_handle )
+{
+    cy_rslt_t               result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t        *mqtt_obj;
+    cy_mqtt_topic_object_t  *topic_obj = NULL;
+
+    if( (mqtt_handle == NULL) || (topic == NULL) || (topic_handle == NULL) ||
+        ((qos != CY_MQTT_QOS0) && (qos != CY_MQTT_QOS1) && (qos != CY_MQTT_QOS2)) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_topic_register()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( mqtt_is_valid_topic_name( topic, topic_len ) == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid topic name..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
+    }
+
+    mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
+
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
+    }
+
+    topic_obj = (cy_mqtt_topic_object_t *)malloc( sizeof( cy_mqtt_topic_object_t ) + sizeof( uint16_t ) + topic_len );
+    if( topic_obj == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to register topic..!\n" );
+        mqtt_obj_release( mqtt_obj );
+        return CY_RSLT_MODULE_MQTT_NOMEM;
+    }
+    memset( topic_obj, 0x00, sizeof( cy_mqtt_topic_object_t ) );
+    topic_obj->magic = CY_MQTT_TOPIC_MAGIC;
+    topic_obj->owner = mqtt_obj;
+    topic_obj->qos = qos;
+    topic_obj->retain = retain;
+    topic_obj->header = (uint8_t)(CY_MQTT_PUBLISH_PACKET_TYPE | ((uint8_t)qos << 1));
+    if( retain == true )
+    {
+        topic_obj->header |= CY_MQTT_PUBLISH_FLAG_RETAIN;
+    }
+    topic_obj->encoded = (uint8_t *)(topic_obj + 1);
+    topic_obj->encoded[ 0 ] = (uint8_t)(topic_len >> 8);
+    topic_obj->encoded[ 1 ] = (uint8_t)(topic_len & 0xFFU);
+    memcpy( &(topic_obj->encoded[ sizeof( uint16_t ) ]), topic, topic_len );
+    topic_obj->encoded_len = (uint16_t)(sizeof( uint16_t ) + topic_len);
+
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        free( topic_obj );
+        mqtt_obj_release( mqtt_obj );
+        return result;
+    }
+    topic_obj->next = mqtt_obj->topics;
+    mqtt_obj->topics = topic_obj;
+    (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+
+    *topic_handle = (cy_mqtt_topic_t)topic_obj;
+    mqtt_obj_release( mqtt_obj );
+    return CY_RSLT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_topic_deregister( cy_mqtt_t mqtt_handle, cy_mqtt_topic_t topic_handle )
+{
+    cy_rslt_t               result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t        *mqtt_obj;
+    cy_mqtt_topic_object_t  *topic_obj = (cy_mqtt_topic_object_t *)topic_handle;
+    cy_mqtt_topic_object_t  **link;
+
+    if( (mqtt_handle == NULL) || (topic_handle == NULL) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_topic_deregister()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
+    }
+
+    mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
+
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
+    }
+
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
+        return result;
+    }
+
+    link = &(mqtt_obj->topics);
+    while( (*link != NULL) && (*link != topic_obj) )
+    {
+        link = &((*link)->next);
+    }
+    if( *link == NULL )
+    {
+        (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nTopic is not registered with the MQTT handle..!\n" );
+        mqtt_obj_release( mqtt_obj );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
+    }
+    *link = topic_obj->next;
+    (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+
+    topic_obj->magic = 0;
+    free( topic_obj );
+    mqtt_obj_release( mqtt_obj );
+    return CY_RSLT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_set_payload_codec( cy_mqtt_t mqtt_handle, const cy_mqtt_payload_codec_t *codec )
+{
+    cy_rslt_t          result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t   *mqtt_obj;
+
+    if( (mqtt_handle == NULL) || ((codec != NULL) && ((codec->compress == NULL) || (codec->decompress == NULL))) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_set_payload_codec()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
+    }
+
+    mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
+
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_payload_codec - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
+        return result;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_payload_codec - Acquired Mutex %p \n", mqtt_obj->process_mutex );
+
+    if( codec != NULL )
+    {
+        memcpy( &(mqtt_obj->codec), codec, sizeof( cy_mqtt_payload_codec_t ) );
+        mqtt_obj->codec_enabled = true;
+    }
+    else
+    {
+        memset( &(mqtt_obj->codec), 0x00, sizeof( cy_mqtt_payload_codec_t ) );
+        mqtt_obj->codec_enabled = false;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_payload_codec - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_payload_codec - Released Mutex %p \n", mqtt_obj->process_mutex );
+
+    mqtt_obj_release( mqtt_obj );
+    return CY_RSLT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_enable_fragmented_receive( cy_mqtt_t mqtt_handle, bool enable )
+{
+    cy_rslt_t          result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t   *mqtt_obj;
+
+    if( mqtt_handle == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_enable_fragmented_receive()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
+    }
+
+    mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
+
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_enable_fragmented_receive - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
+        return result;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_enable_fragmented_receive - Acquired Mutex %p \n", mqtt_obj->process_mutex );
+
+    mqtt_obj->fragmented_receive = enable;
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_enable_fragmented_receive - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_enable_fragmented_receive - Released Mutex %p \n", mqtt_obj->process_mutex );
+
+    mqtt_obj_release( mqtt_obj );
+    return CY_RSLT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+/*
+ * mqtt_dispatch_detach
+ *
+ * Replace the dispatch pool of the MQTT object with pool, which may be NULL, and stop the previous pool.
+ */
+static cy_rslt_t mqtt_dispatch_detach( cy_mqtt_object_t *mqtt_obj, cy_mqtt_dispatch_pool_t *pool )
+{
+    cy_rslt_t                result = CY_RSLT_SUCCESS;
+    cy_mqtt_dispatch_pool_t  *previous;
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_dispatch_detach - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        return result;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_dispatch_detach - Acquired Mutex %p \n", mqtt_obj->process_mutex );
+
+    previous = mqtt_obj->dispatch;
+    mqtt_obj->dispatch = pool;
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_dispatch_detach - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_dispatch_detach - Released Mutex %p \n", mqtt_obj->process_mutex );
+
+    if( previous != NULL )
+    {
+        mqtt_dispatch_stop( previous );
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_set_dispatch_pool( cy_mqtt_t mqtt_handle, const cy_mqtt_dispatch_config_t *config )
+{
+    cy_rslt_t                result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t         *mqtt_obj;
+    cy_mqtt_dispatch_pool_t  *pool = NULL;
+
+    if( (mqtt_handle == NULL) ||
+        ((config != NULL) && ((config->worker_count == 0) || (config->buffer_count == 0) || (config->buffer_size <= sizeof( cy_mqtt_dispatch_msg_t )))) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_set_dispatch_pool()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
+    }
+
+    mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
+
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
+    }
+
+    if( config != NULL )
+    {
+        result = mqtt_dispatch_start( mqtt_obj, config, &pool );
         if( result != CY_RSLT_SUCCESS )
         {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
+            mqtt_obj_release( mqtt_obj );
+            return result;
         }
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_event_processing_thread - Released Mutex %p \n", mqtt_db_mutex );
     }
-    result = cy_rtos_exit_thread();
-    if( result != CY_RSLT_SUCCESS )
+
+    result = mqtt_dispatch_detach( mqtt_obj, pool );
+    if( (result != CY_RSLT_SUCCESS) && (pool != NULL) )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_exit_thread failed with Error :[0x%X]\n", (unsigned int)result );
+        mqtt_dispatch_stop( pool );
     }
+
+    mqtt_obj_release( mqtt_obj );
+    return result;
 }
 
 /*----------------------------------------------------------------------------------------------------------*/
-static void mqtt_awsport_network_receive_callback( void *arg )
+
+cy_rslt_t cy_mqtt_enable_qos2_bitmap( cy_mqtt_t mqtt_handle, bool enable )
 {
-    cy_rslt_t                res = CY_RSLT_SUCCESS;
-    cy_mqtt_callback_event_t event;
-    cy_mqtt_object_t         *mqtt_obj = NULL;
+    cy_rslt_t          result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t   *mqtt_obj;
+    uint8_t            *bitmap = NULL;
 
-    if( arg == NULL )
+    if( mqtt_handle == NULL )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nInvalid handle to mqtt_awsport_network_receive_callback, so nothing to do..!\n" );
-        return;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_enable_qos2_bitmap()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
     }
 
-    mqtt_obj = ( cy_mqtt_object_t * )arg;
-
-    event.socket_event = CY_MQTT_SOCKET_EVENT_DATA_RECEIVE;
-    event.mqtt_obj = mqtt_obj;
-
-    res = cy_rtos_put_queue( &mqtt_event_queue, (void *)&event, CY_MQTT_EVENT_QUEUE_TIMEOUT_IN_MSEC, false );
-    if( res != CY_RSLT_SUCCESS )
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nPushing to MQTT event to mqtt_event_queue failed with Error : [0x%X] \n", (unsigned int)res );
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
     }
-    return;
-}
-
-/*----------------------------------------------------------------------------------------------------------*/
 
-cy_rslt_t cy_mqtt_init( void )
-{
-    cy_rslt_t result = CY_RSLT_SUCCESS;
+    mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
 
-    if( mqtt_lib_init_status == true )
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nMQTT library is already initialized. Number of MQTT client instance : [%d] \n", mqtt_handle_count );
-        return result;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
     }
 
-    result = cy_rtos_init_mutex2( &mqtt_db_mutex, false );
-    if( result != CY_RSLT_SUCCESS )
+    if( enable == true )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nCreating new mutex %p. failed\n", mqtt_db_mutex );
-        return result;
+        bitmap = (uint8_t *)calloc( 1, CY_MQTT_QOS2_BITMAP_SIZE );
+        if( bitmap == NULL )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to allocate the QoS2 packet ID bitmap..!\n" );
+            mqtt_obj_release( mqtt_obj );
+            return CY_RSLT_MODULE_MQTT_NOMEM;
+        }
     }
-    mqtt_db_mutex_init_status = true;
 
-    result = cy_awsport_network_init();
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_enable_qos2_bitmap - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
     if( result != CY_RSLT_SUCCESS )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_awsport_network_init failed with Error : [0x%X] \n", (unsigned int)result );
-        (void)cy_rtos_deinit_mutex( &mqtt_db_mutex );
-        mqtt_db_mutex_init_status = false;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        free( bitmap );
+        mqtt_obj_release( mqtt_obj );
         return result;
     }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_enable_qos2_bitmap - Acquired Mutex %p \n", mqtt_obj->process_mutex );
 
-    /*
-     * Initialize the queue for mqtt events.
-     */
-    result = cy_rtos_init_queue( &mqtt_event_queue, CY_MQTT_EVENT_QUEUE_SIZE, sizeof(cy_mqtt_callback_event_t) );
-    if( result != CY_RSLT_SUCCESS )
+    /* The state changed below is used by a reconnection attempt in progress. */
+    mqtt_reconnect_wait( mqtt_obj );
+
+    /* The incoming QoS2 state cannot move between the bitmap and the MQTT core library while connected. */
+    if( mqtt_obj->mqtt_conn_status == true )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_init_queue failed with Error : [0x%X] \n", (unsigned int)result );
-        (void)cy_rtos_deinit_mutex( &mqtt_db_mutex );
-        (void)cy_awsport_network_deinit();
-        mqtt_db_mutex_init_status = false;
-        return result;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nQoS2 packet ID bitmap cannot be changed while connected..!\n" );
+        result = CY_RSLT_MODULE_MQTT_ALREADY_CONNECTED;
     }
-
-    result = cy_rtos_create_thread( &mqtt_event_process_thread, mqtt_event_processing_thread, "MQTTEventProcessingThread", NULL,
-                                    CY_MQTT_EVENT_THREAD_STACK_SIZE, CY_MQTT_EVENT_THREAD_PRIORITY, 0 );
-    if( result != CY_RSLT_SUCCESS )
+    else if( (enable == false) || (mqtt_obj->qos2_received == NULL) )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_create_thread failed with Error : [0x%X] \n", (unsigned int)result );
-        (void)cy_rtos_deinit_mutex( &mqtt_db_mutex );
-        (void)cy_awsport_network_deinit();
-        (void)cy_rtos_deinit_queue( &mqtt_event_queue );
-        mqtt_db_mutex_init_status = false;
-        return result;
+        free( mqtt_obj->qos2_received );
+        mqtt_obj->qos2_received = bitmap;
+        bitmap = NULL;
     }
 
-    mqtt_lib_init_status = true;
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_awsport_network_init successful.\n" );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_enable_qos2_bitmap - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_enable_qos2_bitmap - Released Mutex %p \n", mqtt_obj->process_mutex );
 
+    free( bitmap );
+
+    mqtt_obj_release( mqtt_obj );
     return result;
 }
 
 /*----------------------------------------------------------------------------------------------------------*/
 
-cy_rslt_t cy_mqtt_create( uint8_t *buffer, uint32_t bufflen,
-                          cy_awsport_ssl_credentials_t *security,
-                          cy_mqtt_broker_info_t *broker_info,
-                          char *descriptor,
-                          cy_mqtt_t *mqtt_handle )
+cy_rslt_t cy_mqtt_event_loop_create( const cy_mqtt_event_loop_config_t *config, cy_mqtt_event_loop_t *event_loop )
 {
-    cy_rslt_t         result = CY_RSLT_SUCCESS;
-    cy_mqtt_object_t  *mqtt_obj = NULL;
-    uint8_t           slot_index;
-    bool              slot_found;
-    bool              process_mutex_init_status = false;
-    cy_mqtt_t         handle;
+    cy_rslt_t                    result = CY_RSLT_SUCCESS;
+    cy_mqtt_event_loop_object_t  *loop;
 
-    if( (broker_info == NULL) || (mqtt_handle == NULL) )
+    if( (config == NULL) || (event_loop == NULL) || (config->stack_size == 0) )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_create()..!\n" );
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_event_loop_create()..!\n" );
         return CY_RSLT_MODULE_MQTT_BADARG;
     }
 
-    if( buffer == NULL )
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid network buffer..!\n" );
-        return CY_RSLT_MODULE_MQTT_BADARG;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
     }
 
-    if( bufflen < CY_MQTT_MIN_NETWORK_BUFFER_SIZE )
+    loop = (cy_mqtt_event_loop_object_t *)calloc( 1, sizeof( cy_mqtt_event_loop_object_t ) );
+    if( loop == NULL )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBuffer length is less then minimun network buffer size : %u..!\n", (uint16_t)CY_MQTT_MIN_NETWORK_BUFFER_SIZE );
-        return CY_RSLT_MODULE_MQTT_BADARG;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to create the event loop..!\n" );
+        return CY_RSLT_MODULE_MQTT_NOMEM;
     }
 
-    if( descriptor == NULL )
+    result = mqtt_event_loop_start( loop, ( config->queue_size == 0 ) ? CY_MQTT_EVENT_QUEUE_SIZE : config->queue_size,
+                                    config->stack_size, config->priority );
+    if( result != CY_RSLT_SUCCESS )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid descriptor..!\n" );
-        return CY_RSLT_MODULE_MQTT_BADARG;
+        free( loop );
+        return result;
     }
 
-    if( strlen(descriptor) > CY_MQTT_DESCP_MAX_LEN )
+    *event_loop = (cy_mqtt_event_loop_t)loop;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_event_loop_delete( cy_mqtt_event_loop_t event_loop )
+{
+    cy_rslt_t                    result = CY_RSLT_SUCCESS;
+    cy_mqtt_event_loop_object_t  *loop = (cy_mqtt_event_loop_object_t *)event_loop;
+    uint16_t                     handle_count;
+
+    if( (loop == NULL) || (loop == &mqtt_default_event_loop) )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Descriptor length is greater than maximum permissible length: %u!\n", (uint16_t)CY_MQTT_DESCP_MAX_LEN );
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_event_loop_delete()..!\n" );
         return CY_RSLT_MODULE_MQTT_BADARG;
     }
 
@@ -2090,207 +9874,177 @@ cy_rslt_t cy_mqtt_create( uint8_t *buffer, uint32_t bufflen,
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
         return result;
     }
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_create - Acquired Mutex %p \n", mqtt_db_mutex );
+    handle_count = loop->handle_count;
+    (void)cy_rtos_set_mutex( &mqtt_db_mutex );
 
-    if( mqtt_handle_count >= CY_MQTT_MAX_HANDLE )
+    if( handle_count != 0 )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nNumber of created mqtt object exceeds %d..!\n", CY_MQTT_MAX_HANDLE );
-        (void)cy_rtos_set_mutex( &mqtt_db_mutex );
-        return CY_RSLT_MODULE_MQTT_CREATE_FAIL;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nEvent loop cannot be deleted. Number of MQTT client instances assigned : [%d] \n", handle_count );
+        return CY_RSLT_MODULE_MQTT_ERROR;
     }
 
-    result = cy_rtos_set_mutex( &mqtt_db_mutex );
+    result = mqtt_event_loop_stop( loop );
     if( result != CY_RSLT_SUCCESS )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
         return result;
     }
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_create - Released Mutex %p \n", mqtt_db_mutex );
-
-    result = cy_mqtt_get_handle( &handle, descriptor );
-    if( result == CY_RSLT_SUCCESS )
-    {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nDescriptor is not unique. \n" );
-        return CY_RSLT_MODULE_MQTT_BADARG;
-    }
+    free( loop );
 
-    mqtt_obj = (cy_mqtt_object_t *)malloc( sizeof( cy_mqtt_object_t ) );
-    if( mqtt_obj == NULL )
-    {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to create MQTT object..!\n" );
-        return CY_RSLT_MODULE_MQTT_NOMEM;
-    }
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_obj : %p..!\n", mqtt_obj );
+    return CY_RSLT_SUCCESS;
+}
 
-    /* Clear the MQTT handle data. */
-    memset( mqtt_obj, 0x00, sizeof( cy_mqtt_object_t ) );
+/*----------------------------------------------------------------------------------------------------------*/
 
-    if( security != NULL )
-    {
-        mqtt_obj->security.alpnprotos = security->alpnprotos;
-        mqtt_obj->security.alpnprotoslen = security->alpnprotoslen;
-        mqtt_obj->security.sni_host_name = security->sni_host_name;
-        mqtt_obj->security.sni_host_name_size = security->sni_host_name_size;
-        mqtt_obj->security.username = security->username;
-        mqtt_obj->security.username_size = security->username_size;
-        mqtt_obj->security.password = security->password;
-        mqtt_obj->security.password_size = security->password_size;
+cy_rslt_t cy_mqtt_set_event_loop( cy_mqtt_t mqtt_handle, cy_mqtt_event_loop_t event_loop )
+{
+    cy_rslt_t                    result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t             *mqtt_obj;
+    cy_mqtt_event_loop_object_t  *loop = (cy_mqtt_event_loop_object_t *)event_loop;
 
-        mqtt_obj->security.client_cert = security->client_cert;
-        mqtt_obj->security.client_cert_size = security->client_cert_size;
-        mqtt_obj->security.private_key = security->private_key;
-        mqtt_obj->security.private_key_size = security->private_key_size;
-        mqtt_obj->security.root_ca = security->root_ca;
-        mqtt_obj->security.root_ca_size = security->root_ca_size;
-        mqtt_obj->security.root_ca_verify_mode = security->root_ca_verify_mode;
-        mqtt_obj->security.root_ca_location = security->root_ca_location;
-        mqtt_obj->security.cert_key_location = security->cert_key_location;
-        mqtt_obj->mqtt_secure_mode = true;
-    }
-    else
+    if( mqtt_handle == NULL )
     {
-        mqtt_obj->mqtt_secure_mode = false;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_set_event_loop()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
     }
 
-    mqtt_obj->server_info.host_name = broker_info->hostname;
-    mqtt_obj->server_info.port = broker_info->port;
-
-    result = cy_rtos_init_mutex2( &(mqtt_obj->process_mutex), false );
-    if( result != CY_RSLT_SUCCESS )
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nCreating new mutex %p. failed\n", mqtt_obj->process_mutex );
-        goto exit;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
     }
 
-    process_mutex_init_status = true;
+    mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
 
-    result = mqtt_initialize_core_lib( &(mqtt_obj->mqtt_context), &(mqtt_obj->network_context), buffer, bufflen );
-    if( result != CY_RSLT_SUCCESS )
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nmqtt_initialize_core_lib failed with Error : [0x%X] \n", (unsigned int)result );
-        goto exit;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
     }
-    else
+
+    if( loop == NULL )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nmqtt_initialize_core_lib successful.\n" );
+        loop = &mqtt_default_event_loop;
     }
 
-    mqtt_obj->network_context.disconnect_info.cbf = mqtt_awsport_network_disconnect_callback;
-    mqtt_obj->network_context.disconnect_info.user_data = ( void * )mqtt_obj;
-
-    mqtt_obj->network_context.receive_info.cbf = mqtt_awsport_network_receive_callback;
-    mqtt_obj->network_context.receive_info.user_data = ( void * )mqtt_obj;
-
+    /* mqtt_db_mutex protects the handle counts of the event loops. */
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_event_loop - Acquiring Mutex %p \n", mqtt_db_mutex );
     result = cy_rtos_get_mutex( &mqtt_db_mutex, CY_RTOS_NEVER_TIMEOUT );
     if( result != CY_RSLT_SUCCESS )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
-        goto exit;
+        mqtt_obj_release( mqtt_obj );
+        return result;
     }
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_create - Acquired Mutex %p \n", mqtt_db_mutex );
-
-    slot_index = 0;
-    slot_found = false;
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_event_loop - Acquired Mutex %p \n", mqtt_db_mutex );
 
-    while( slot_index < CY_MQTT_MAX_HANDLE )
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_event_loop - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
     {
-        if( mqtt_handle_database[slot_index].mqtt_handle == NULL )
-        {
-            mqtt_handle_database[slot_index].mqtt_handle = (void *)mqtt_obj;
-            mqtt_handle_database[slot_index].mqtt_context = &(mqtt_obj->mqtt_context);
-            slot_found = true;
-            break;
-        }
-        slot_index++;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        (void)cy_rtos_set_mutex( &mqtt_db_mutex );
+        mqtt_obj_release( mqtt_obj );
+        return result;
     }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_event_loop - Acquired Mutex %p \n", mqtt_obj->process_mutex );
 
-    if( slot_found == false )
+    /* The socket and timer events of a connection are queued to its event loop; it cannot change while connected. */
+    if( mqtt_obj->mqtt_conn_status == true )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n Free slot not available for new handle..!\n" );
-        (void)cy_rtos_set_mutex( &mqtt_db_mutex );
-        result = CY_RSLT_MODULE_MQTT_CREATE_FAIL;
-        goto exit;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nEvent loop cannot be changed while connected..!\n" );
+        result = CY_RSLT_MODULE_MQTT_ALREADY_CONNECTED;
     }
-
-    /* Initialize timer to handle MQTT ping timeout events */
-    result = cy_rtos_init_timer( &mqtt_obj->mqtt_timer, CY_TIMER_TYPE_ONCE, ( cy_timer_callback_t )mqtt_ping_request_callback, ( cy_timer_callback_arg_t )mqtt_obj );
-    if( result != CY_RSLT_SUCCESS )
+    else if( mqtt_obj->reconnect_active == true )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_init_timer failed with Error : [0x%X] \n", (unsigned int)result );
-        result = cy_rtos_set_mutex( &mqtt_db_mutex );
-        if( result != CY_RSLT_SUCCESS )
-        {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
-        }
-        goto exit;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nEvent loop cannot be changed while the automatic reconnection is in progress..!\n" );
+        result = CY_RSLT_MODULE_MQTT_BUSY;
     }
-    result = cy_rtos_init_timer( &mqtt_obj->mqtt_ping_resp_timer, CY_TIMER_TYPE_ONCE, ( cy_timer_callback_t )mqtt_pingresp_timeout_callback, ( cy_timer_callback_arg_t )mqtt_obj );
-    if( result != CY_RSLT_SUCCESS )
+    else
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR,
-                "\nPing Resp Timer: cy_rtos_init_timer failed with Error : [0x%X] \n", (unsigned int)result );
-        result = cy_rtos_set_mutex( &mqtt_db_mutex );
-        if( result != CY_RSLT_SUCCESS )
+        /* The events still queued to the old event loop would be processed concurrently with those of the new one.
+         * mqtt_queue_object_event reads the event loop under ref_mutex, so the check and the change are done in
+         * one hold of it: no event can be queued to the old event loop after the check. */
+        (void)cy_rtos_get_mutex( &(mqtt_obj->ref_mutex), CY_RTOS_NEVER_TIMEOUT );
+        if( mqtt_obj->queued_events != 0 )
         {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR,
-                    "\nPing Resp Timer: cy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nEvent loop cannot be changed while %u events are pending..!\n", (unsigned int)mqtt_obj->queued_events );
+            result = CY_RSLT_MODULE_MQTT_BUSY;
         }
-        goto exit;
+        else
+        {
+            mqtt_obj->event_loop->handle_count--;
+            mqtt_obj->event_loop = loop;
+            loop->handle_count++;
+        }
+        (void)cy_rtos_set_mutex( &(mqtt_obj->ref_mutex) );
     }
-    memcpy(mqtt_obj->mqtt_descriptor, descriptor, strlen(descriptor)+1);
 
-    mqtt_obj->mqtt_magic_header = CY_MQTT_MAGIC_HEADER;
-    mqtt_obj->mqtt_magic_footer = CY_MQTT_MAGIC_FOOTER;
-    mqtt_obj->mqtt_obj_index = slot_index;
-    *mqtt_handle = (void *)mqtt_obj;
-    mqtt_handle_count++;
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_event_loop - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_event_loop - Released Mutex %p \n", mqtt_obj->process_mutex );
 
-    result = cy_rtos_set_mutex( &mqtt_db_mutex );
-    if( result != CY_RSLT_SUCCESS )
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_event_loop - Releasing Mutex %p \n", mqtt_db_mutex );
+    (void)cy_rtos_set_mutex( &mqtt_db_mutex );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_event_loop - Released Mutex %p \n", mqtt_db_mutex );
+
+    mqtt_obj_release( mqtt_obj );
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_set_max_handles( uint16_t max_handles )
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    if( (max_handles == 0) || (max_handles == CY_MQTT_HANDLE_INDEX_INVALID) )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
-        goto exit;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_set_max_handles()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
     }
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_create - Released Mutex %p \n", mqtt_db_mutex );
 
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nMQTT object created successfully..\n" );
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
+    }
 
-    return CY_RSLT_SUCCESS;
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_max_handles - Acquiring Mutex %p \n", mqtt_db_mutex );
+    result = cy_rtos_get_mutex( &mqtt_db_mutex, CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
+        return result;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_max_handles - Acquired Mutex %p \n", mqtt_db_mutex );
 
-exit :
-    if( mqtt_obj != NULL )
+    if( max_handles < mqtt_handle_count )
     {
-        if( process_mutex_init_status == true )
-        {
-            (void)cy_rtos_deinit_mutex( &(mqtt_obj->process_mutex) );
-            process_mutex_init_status = false;
-        }
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\n Free mqtt_obj : %p..!\n", mqtt_obj );
-        free( mqtt_obj );
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMaximum number of MQTT instances cannot be less than the number of created instances : [%d] \n", mqtt_handle_count );
+        result = CY_RSLT_MODULE_MQTT_ERROR;
     }
+    else
+    {
+        mqtt_max_handles = max_handles;
+    }
+
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_max_handles - Releasing Mutex %p \n", mqtt_db_mutex );
+    (void)cy_rtos_set_mutex( &mqtt_db_mutex );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_max_handles - Released Mutex %p \n", mqtt_db_mutex );
 
     return result;
 }
 
 /*----------------------------------------------------------------------------------------------------------*/
 
-cy_rslt_t cy_mqtt_connect( cy_mqtt_t mqtt_handle, cy_mqtt_connect_info_t *connect_info )
+cy_rslt_t cy_mqtt_set_tls_session_hooks( cy_mqtt_t mqtt_handle, const cy_mqtt_tls_session_hooks_t *hooks )
 {
-    cy_rslt_t                     result = CY_RSLT_SUCCESS;
-    cy_rslt_t                     res = CY_RSLT_SUCCESS;
-    RetryUtilsParams_t            reconnectParams;
-    MQTTStatus_t                  mqttStatus = MQTTSuccess;
-    RetryUtilsStatus_t            retryUtilsStatus = RetryUtilsSuccess;
-    cy_mqtt_object_t              *mqtt_obj;
-    bool                          create_clean_session = false;
-    MQTTConnectInfo_t             connect_details;
-    MQTTPublishInfo_t             will_msg_details;
-    MQTTPublishInfo_t             *will_msg_ptr = NULL;
-    cy_awsport_ssl_credentials_t  *security = NULL;
+    cy_rslt_t          result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t   *mqtt_obj;
 
-    if( mqtt_handle == NULL )
+    if( (mqtt_handle == NULL) || ((hooks != NULL) && ((hooks->save == NULL) || (hooks->offer == NULL))) )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_connect()..!\n" );
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_set_tls_session_hooks()..!\n" );
         return CY_RSLT_MODULE_MQTT_BADARG;
     }
 
@@ -2302,281 +10056,208 @@ cy_rslt_t cy_mqtt_connect( cy_mqtt_t mqtt_handle, cy_mqtt_connect_info_t *connec
 
     mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
 
-    if( is_mqtt_obj_valid( mqtt_obj ) == false )
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
         return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
     }
 
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_connect - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_tls_session_hooks - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
     result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
     if( result != CY_RSLT_SUCCESS )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
         return result;
     }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_tls_session_hooks - Acquired Mutex %p \n", mqtt_obj->process_mutex );
 
-    memset( &connect_details, 0x00, sizeof( MQTTConnectInfo_t ) );
-    memset( &will_msg_details, 0x00, sizeof( MQTTPublishInfo_t ) );
-
-    /* Connect Information */
-    connect_details.cleanSession = connect_info->clean_session;
-    connect_details.keepAliveSeconds = connect_info->keep_alive_sec;
-    connect_details.pClientIdentifier = connect_info->client_id;
-    connect_details.clientIdentifierLength = connect_info->client_id_len;
-    connect_details.pPassword = connect_info->password;
-    connect_details.passwordLength = connect_info->password_len;
-    connect_details.pUserName = connect_info->username;
-    connect_details.userNameLength = connect_info->username_len;
-
-    /* Store the keepAlivetimeout */
-    mqtt_obj->keepAliveSeconds = connect_info->keep_alive_sec;
+    /* The state changed below is used by a reconnection attempt in progress. */
+    mqtt_reconnect_wait( mqtt_obj );
 
-    if( connect_info->will_info != NULL )
+    mqtt_tls_session_clear( mqtt_obj );
+    mqtt_obj->tls_session_resumed = false;
+    if( hooks != NULL )
     {
-        /* Will information. */
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nWill info is not NULL ..!\n" );
-
-        if( connect_info->will_info->qos > CY_MQTT_QOS2 )
-        {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid Will msg QoS..!\n" );
-            result = CY_RSLT_MODULE_MQTT_CONNECT_FAIL;
-            goto exit;
-        }
-        if( (connect_info->will_info->dup != true) && (connect_info->will_info->dup != false) )
-        {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid Will msg dup..!\n" );
-            result = CY_RSLT_MODULE_MQTT_CONNECT_FAIL;
-            goto exit;
-        }
-        if( (connect_info->will_info->retain != true) && (connect_info->will_info->retain != false) )
-        {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid Will msg retain..!\n" );
-            result = CY_RSLT_MODULE_MQTT_CONNECT_FAIL;
-            goto exit;
-        }
-
-        if( connect_info->will_info->qos == CY_MQTT_QOS0 )
-        {
-            will_msg_details.qos = MQTTQoS0;
-        }
-        else if( connect_info->will_info->qos == CY_MQTT_QOS1 )
+        if( mqtt_obj->tls_session == NULL )
         {
-            will_msg_details.qos = MQTTQoS1;
+            mqtt_obj->tls_session = (uint8_t *)malloc( CY_MQTT_TLS_SESSION_MAX_SIZE );
+            if( mqtt_obj->tls_session == NULL )
+            {
+                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to cache the TLS session..!\n" );
+                result = CY_RSLT_MODULE_MQTT_NOMEM;
+            }
         }
-        else
+        if( result == CY_RSLT_SUCCESS )
         {
-            will_msg_details.qos = MQTTQoS2;
+            memcpy( &(mqtt_obj->tls_session_hooks), hooks, sizeof( cy_mqtt_tls_session_hooks_t ) );
+            mqtt_obj->tls_session_hooks_enabled = true;
         }
-
-        will_msg_details.dup = connect_info->will_info->dup;
-        will_msg_details.retain = connect_info->will_info->retain;
-        will_msg_details.pTopicName = connect_info->will_info->topic;
-        will_msg_details.topicNameLength = connect_info->will_info->topic_len;
-        will_msg_details.pPayload = connect_info->will_info->payload;
-        will_msg_details.payloadLength = connect_info->will_info->payload_len;
-        will_msg_ptr = &will_msg_details;
     }
     else
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nWill info is NULL ..!\n" );
-        will_msg_ptr = NULL;
+        memset( &(mqtt_obj->tls_session_hooks), 0x00, sizeof( cy_mqtt_tls_session_hooks_t ) );
+        mqtt_obj->tls_session_hooks_enabled = false;
+        free( mqtt_obj->tls_session );
+        mqtt_obj->tls_session = NULL;
     }
 
-    /* Initialize the reconnect attempts and interval. */
-    RetryUtils_ParamsReset( &reconnectParams );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_tls_session_hooks - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_tls_session_hooks - Released Mutex %p \n", mqtt_obj->process_mutex );
 
-    if( mqtt_obj->mqtt_secure_mode == true )
+    mqtt_obj_release( mqtt_obj );
+    return result;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_get_tls_session_resumed( cy_mqtt_t mqtt_handle, bool *resumed )
+{
+    cy_mqtt_object_t   *mqtt_obj;
+
+    if( (mqtt_handle == NULL) || (resumed == NULL) )
     {
-        security = &(mqtt_obj->security);
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_get_tls_session_resumed()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
     }
-    else
+
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
     {
-        security = NULL;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
     }
 
-    /* Attempt to connect to an MQTT broker. If connection fails, retry after
-     * a timeout. The timeout value will exponentially increase until the maximum
-     * attempts are reached.
-     */
-    do
+    mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
+
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nCreating MQTT socket..\n" );
-        result = cy_awsport_network_create( &(mqtt_obj->network_context), &(mqtt_obj->server_info), security, &(mqtt_obj->network_context.disconnect_info), &(mqtt_obj->network_context.receive_info) );
-        if ( result != CY_RSLT_SUCCESS )
-        {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_awsport_network_create failed with Error : [0x%X] \n", (unsigned int)result );
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nConnection to the broker failed. Retrying connection with backoff and jitter.\n" );
-            retryUtilsStatus = RetryUtils_BackoffAndSleep( &reconnectParams );
-        }
-        else
-        {
-            /* Establish a TLS session with the MQTT broker. */
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "Establishing a TLS session to %.*s:%d.\n",
-                             strlen(mqtt_obj->server_info.host_name), mqtt_obj->server_info.host_name, mqtt_obj->server_info.port );
-            result = cy_awsport_network_connect( &(mqtt_obj->network_context),
-                                                 CY_MQTT_MESSAGE_SEND_TIMEOUT_MS,
-                                                 CY_MQTT_SOCKET_RECEIVE_TIMEOUT_MS );
-            if( result != CY_RSLT_SUCCESS )
-            {
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nConnection to the broker failed. Retrying connection with backoff and jitter.\n" );
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
+    }
 
-                retryUtilsStatus = RetryUtils_BackoffAndSleep( &reconnectParams );
-                (void)cy_awsport_network_delete( &(mqtt_obj->network_context) );
-                /*
-                 * In case of an unexpected network disconnection, the cy_awsport_network_delete API always returns failure. Therefore,
-                 * the return value of the cy_awsport_network_delete API is not checked here.
-                 */
-                /* Fall-through. */
-            }
+    *resumed = mqtt_obj->tls_session_resumed;
 
-            if( retryUtilsStatus == RetryUtilsRetriesExhausted )
-            {
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nConnection to the broker failed, all attempts exhausted.\n" );
-                result = CY_RSLT_MODULE_MQTT_CONNECT_FAIL;
-            }
-        }
+    mqtt_obj_release( mqtt_obj );
+    return CY_RSLT_SUCCESS;
+}
 
-    } while( ( result != CY_RSLT_SUCCESS ) && ( retryUtilsStatus == RetryUtilsSuccess ) );
+/*----------------------------------------------------------------------------------------------------------*/
 
-    if( result != CY_RSLT_SUCCESS )
+cy_rslt_t cy_mqtt_enable_auto_reconnect( cy_mqtt_t mqtt_handle, const cy_mqtt_reconnect_config_t *config )
+{
+    cy_rslt_t          result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t   *mqtt_obj;
+
+    if( (mqtt_handle == NULL) ||
+        ((config != NULL) && (config->max_backoff_ms != 0) && (config->initial_backoff_ms > config->max_backoff_ms)) )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nTLS connection failed with Error : [0x%X] \n", (unsigned int)result );
-        goto exit;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_enable_auto_reconnect()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
     }
 
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nTLS connection established ..\n" );
-
-    create_clean_session = (connect_details.cleanSession == true ) ? true : false;
-    if( create_clean_session == true )
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nCreating clean session ..\n" );
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
     }
 
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nCreating an MQTT connection to %.*s.\n",
-                     strlen(mqtt_obj->server_info.host_name), mqtt_obj->server_info.host_name );
+    mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
 
-    /* Sends an MQTT Connect packet using the established TLS session. */
-    result = mqtt_establish_session( mqtt_obj, &connect_details, will_msg_ptr, create_clean_session, &(mqtt_obj->broker_session_present) );
-    if( result != CY_RSLT_SUCCESS )
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nEstablish MQTT session failed with Error : [0x%X] \n", (unsigned int)result );
-        goto exit;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
     }
-    else
-    {
 
-        if( (mqtt_obj->broker_session_present == true) && (create_clean_session == false) )
+    if( config != NULL )
+    {
+        /* The attempts of the automatic reconnection are made by the reconnect thread, started with the first use. */
+        result = cy_rtos_get_mutex( &mqtt_db_mutex, CY_RTOS_NEVER_TIMEOUT );
+        if( result != CY_RSLT_SUCCESS )
         {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nMQTT session with broker is re-established. Resending unacked publishes.\n" );
-            /* Handle all resend of PUBLISH messages. */
-            result = mqtt_handle_publish_resend( mqtt_obj );
-            if( result != CY_RSLT_SUCCESS )
-            {
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nHandle all the resend of PUBLISH messages failed with Error : [0x%X] \n", (unsigned int)result );
-                goto exit;
-            }
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
+            mqtt_obj_release( mqtt_obj );
+            return result;
         }
-        else
+        if( mqtt_reconnect_thread == NULL )
         {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\n A clean MQTT connection is established. Cleaning up all the stored outgoing publishes.\n" );
-
-            /* Clean up the outgoing PUBLISH packets and wait for ack because this new
-             * connection does not re-establish an existing session. */
-            result = mqtt_cleanup_outgoing_publishes( mqtt_obj );
-            if( result != CY_RSLT_SUCCESS )
-            {
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nCleaning of PUBLISH messages failed with Error : [0x%X] \n", (unsigned int)result );
-                goto exit;
-            }
+            result = mqtt_reconnect_thread_start();
+        }
+        (void)cy_rtos_set_mutex( &mqtt_db_mutex );
+        if( result != CY_RSLT_SUCCESS )
+        {
+            mqtt_obj_release( mqtt_obj );
+            return result;
         }
     }
 
-    mqtt_obj->mqtt_conn_status = true;
-
-    result = start_timer( mqtt_obj );
-    if( result != CY_RSLT_SUCCESS )
-    {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nstart_timer failed with Error : [0x%X] \n", (unsigned int)result );
-        goto exit;
-    }
-
-    result = cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_enable_auto_reconnect - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
     if( result != CY_RSLT_SUCCESS )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", (unsigned int)result );
-        goto exit;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
+        return result;
     }
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_connect - Released Mutex %p \n", mqtt_obj->process_mutex );
-
-    return result;
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_enable_auto_reconnect - Acquired Mutex %p \n", mqtt_obj->process_mutex );
 
-exit :
-    if( mqtt_obj->mqtt_session_established == true )
+    if( config != NULL )
     {
-        mqttStatus = MQTT_Disconnect( &(mqtt_obj->mqtt_context) );
-        if( mqttStatus != MQTTSuccess )
+        memcpy( &(mqtt_obj->reconnect_config), config, sizeof( cy_mqtt_reconnect_config_t ) );
+        if( mqtt_obj->reconnect_config.initial_backoff_ms == 0 )
         {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "Sending MQTT DISCONNECT failed with status=%s.\n",
-                             MQTT_Status_strerror( mqttStatus ) );
-            /*
-             * In case of an unexpected network disconnection, the MQTT_Disconnect API always returns failure. Therefore,
-             * the return value of the MQTT_Disconnect API is not checked here.
-             */
-            /* Fall-through. */
+            mqtt_obj->reconnect_config.initial_backoff_ms = CY_MQTT_RECONNECT_INITIAL_BACKOFF_MS;
         }
-        mqtt_obj->mqtt_session_established = false;
-    }
-
-    res = cy_awsport_network_disconnect( &(mqtt_obj->network_context) );
-    if( res != CY_RSLT_SUCCESS )
-    {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_awsport_network_disconnect failed with Error : [0x%X] \n", (unsigned int)result );
-        /*
-         * In case of an unexpected network disconnection, the cy_awsport_network_disconnect API always returns failure. Therefore,
-         * the return value of the cy_awsport_network_disconnect API is not checked here.
-         */
-        /* Fall-through. */
+        if( mqtt_obj->reconnect_config.max_backoff_ms == 0 )
+        {
+            mqtt_obj->reconnect_config.max_backoff_ms = CY_MQTT_RECONNECT_MAX_BACKOFF_MS;
+        }
+        if( mqtt_obj->reconnect_config.initial_backoff_ms > mqtt_obj->reconnect_config.max_backoff_ms )
+        {
+            mqtt_obj->reconnect_config.initial_backoff_ms = mqtt_obj->reconnect_config.max_backoff_ms;
+        }
+        mqtt_obj->reconnect_enabled = true;
     }
-    res = cy_awsport_network_delete( &(mqtt_obj->network_context) );
-    if( res != CY_RSLT_SUCCESS )
+    else
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_awsport_network_delete failed with Error : [0x%X] \n", (unsigned int)result );
-        /*
-         * In case of an unexpected network disconnection, the cy_awsport_network_delete API always returns failure. Therefore,
-         * the return value of the cy_awsport_network_delete API is not checked here.
-         */
-        /* Fall-through. */
+        mqtt_reconnect_cancel( mqtt_obj );
+        mqtt_subscription_free_all( mqtt_obj );
+        memset( &(mqtt_obj->reconnect_config), 0x00, sizeof( cy_mqtt_reconnect_config_t ) );
+        mqtt_obj->reconnect_enabled = false;
     }
 
-    res = cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
-    if( res != CY_RSLT_SUCCESS )
-    {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", (unsigned int)res );
-    }
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_connect - Released Mutex %p \n", mqtt_obj->process_mutex );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_enable_auto_reconnect - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_enable_auto_reconnect - Released Mutex %p \n", mqtt_obj->process_mutex );
 
-    return result;
+    mqtt_obj_release( mqtt_obj );
+    return CY_RSLT_SUCCESS;
 }
 
 /*----------------------------------------------------------------------------------------------------------*/
 
-cy_rslt_t cy_mqtt_publish( cy_mqtt_t mqtt_handle, cy_mqtt_publish_info_t *pubmsg )
+cy_rslt_t cy_mqtt_set_broker_endpoints( cy_mqtt_t mqtt_handle, const cy_mqtt_broker_endpoint_t *endpoints, uint8_t count )
 {
-    cy_rslt_t        result = CY_RSLT_SUCCESS;
-    cy_rslt_t        timer_result = CY_RSLT_SUCCESS;
-    MQTTStatus_t     mqttStatus = MQTTSuccess;
-    uint8_t          publishIndex = CY_MQTT_MAX_OUTGOING_PUBLISHES;
-    cy_mqtt_object_t *mqtt_obj;
-    uint8_t          retry = 0;
-    uint32_t         timeout = 0;
+    cy_rslt_t          result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t   *mqtt_obj;
+    uint8_t            index;
 
-    if( (mqtt_handle == NULL) || (pubmsg == NULL) )
+    if( (mqtt_handle == NULL) || (count > CY_MQTT_MAX_BROKER_ENDPOINTS) || ((count > 0) && (endpoints == NULL)) )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_publish()..!\n" );
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_set_broker_endpoints()..!\n" );
         return CY_RSLT_MODULE_MQTT_BADARG;
     }
 
+    for( index = 0; index < count; index++ )
+    {
+        if( endpoints[ index ].broker_info.hostname == NULL )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBroker endpoint %u has no host name..!\n", (unsigned int)index );
+            return CY_RSLT_MODULE_MQTT_BADARG;
+        }
+    }
+
     if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
@@ -2585,171 +10266,119 @@ cy_rslt_t cy_mqtt_publish( cy_mqtt_t mqtt_handle, cy_mqtt_publish_info_t *pubmsg
 
     mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
 
-    if( is_mqtt_obj_valid( mqtt_obj ) == false )
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
         return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
     }
 
-    if( mqtt_obj->mqtt_session_established == false )
-    {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT client session not present..!\n" );
-        return CY_RSLT_MODULE_MQTT_NOT_CONNECTED;
-    }
-
-    /* Get the next free index for the outgoing PUBLISH packets. All QoS2 outgoing
-     * PUBLISH packets are stored until a PUBREC is received. These messages are
-     * stored for supporting a resend if a network connection is broken before
-     * receiving a PUBREC. */
-    result = mqtt_get_next_free_index_for_publish( mqtt_obj, &publishIndex );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_broker_endpoints - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
     if( result != CY_RSLT_SUCCESS )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nUnable to find a free spot for outgoing PUBLISH message.\n" );
-        return CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
-    }
-    else
-    {
-        if( (pubmsg->qos == CY_MQTT_QOS0) || (pubmsg->qos == CY_MQTT_QOS1) || (pubmsg->qos == CY_MQTT_QOS2) )
-        {
-            mqtt_obj->outgoing_pub_packets[ publishIndex ].pubinfo.qos = (MQTTQoS_t)pubmsg->qos;
-        }
-        else
-        {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nQoS level not supported..!\n" );
-            return CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
-        }
-        mqtt_obj->outgoing_pub_packets[ publishIndex ].pubinfo.pTopicName = pubmsg->topic;
-        mqtt_obj->outgoing_pub_packets[ publishIndex ].pubinfo.topicNameLength = pubmsg->topic_len;
-        mqtt_obj->outgoing_pub_packets[ publishIndex ].pubinfo.pPayload = pubmsg->payload;
-        mqtt_obj->outgoing_pub_packets[ publishIndex ].pubinfo.payloadLength = pubmsg->payload_len;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
+        return result;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_broker_endpoints - Acquired Mutex %p \n", mqtt_obj->process_mutex );
 
-        result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
-        if( result != CY_RSLT_SUCCESS )
-        {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
-            return result;
-        }
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_publish - Acquired Mutex %p \n", mqtt_obj->process_mutex );
+    /* The state changed below is used by a reconnection attempt in progress. */
+    mqtt_reconnect_wait( mqtt_obj );
 
-        /* Get a new packet ID. */
-        mqtt_obj->pub_ack_status.packetid = mqtt_obj->outgoing_pub_packets[ publishIndex ].packetid;
+    /* The endpoints are used from the next connection; the health of the previous endpoints is discarded.
+     * The cached TLS session belongs to the broker of the last connection, which may not be the new endpoint 0. */
+    mqtt_tls_session_clear( mqtt_obj );
+    memset( mqtt_obj->endpoints, 0x00, sizeof( mqtt_obj->endpoints ) );
+    for( index = 0; index < count; index++ )
+    {
+        mqtt_obj->endpoints[ index ].endpoint = endpoints[ index ];
+    }
+    mqtt_obj->endpoint_count = count;
+    mqtt_obj->endpoint_current = 0;
+    if( (count == 0) && (mqtt_obj->mqtt_conn_status == false) )
+    {
+        mqtt_obj->server_info = mqtt_obj->default_server_info;
+    }
 
-        /* Stop MQTT Ping Timer */
-        result = stop_timer( mqtt_obj );
-        if( result != CY_RSLT_SUCCESS )
-        {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nstop_timer failed\n" );
-        }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_broker_endpoints - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_set_broker_endpoints - Released Mutex %p \n", mqtt_obj->process_mutex );
 
-        /* Publish retry loop. */
-        do
-        {
-            mqtt_obj->pub_ack_status.puback_status = false;
-            timeout = CY_MQTT_ACK_RECEIVE_TIMEOUT_MS;
+    mqtt_obj_release( mqtt_obj );
+    return CY_RSLT_SUCCESS;
+}
 
-            /* Send the PUBLISH packet. */
-            mqttStatus = MQTT_Publish( &(mqtt_obj->mqtt_context),
-                                       &(mqtt_obj->outgoing_pub_packets[ publishIndex ].pubinfo),
-                                       mqtt_obj->outgoing_pub_packets[ publishIndex ].packetid );
-            if( mqttStatus != MQTTSuccess )
-            {
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to send PUBLISH packet to broker with error = %s.\n",
-                                 MQTT_Status_strerror( mqttStatus ) );
-                result = CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
-            }
-            else
-            {
-                cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nPUBLISH sent for topic %.*s to broker with packet ID %u.\n",
-                                 pubmsg->topic_len, pubmsg->topic, mqtt_obj->outgoing_pub_packets[ publishIndex ].packetid );
-                /* Process the incoming packet from the broker.
-                 * Acknowledgment for PUBLISH ( PUBACK ) will be received here. */
-                if( mqtt_obj->outgoing_pub_packets[ publishIndex ].pubinfo.qos != MQTTQoS0 )
-                {
-                    do
-                    {
-                        mqttStatus = MQTT_ProcessLoop( &(mqtt_obj->mqtt_context), CY_MQTT_RECEIVE_DATA_TIMEOUT_MS );
-                        if( (mqttStatus != MQTTSuccess) && (mqttStatus != MQTTNoDataAvailable) )
-                        {
-                            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT_ProcessLoop returned with status = %s.\n", MQTT_Status_strerror( mqttStatus ) );
-                            result = CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
-                            break;
-                        }
-                        else
-                        {
-                            if( mqtt_obj->pub_ack_status.puback_status == true )
-                            {
-                                result = CY_RSLT_SUCCESS;
-                                break;
-                            }
-                        }
+/*----------------------------------------------------------------------------------------------------------*/
 
-                        timeout = timeout - CY_MQTT_SOCKET_RECEIVE_TIMEOUT_MS;
+cy_rslt_t cy_mqtt_get_broker_endpoint( cy_mqtt_t mqtt_handle, uint8_t *index )
+{
+    cy_rslt_t          result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t   *mqtt_obj;
 
-                    } while( timeout > 0 );
+    if( (mqtt_handle == NULL) || (index == NULL) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_get_broker_endpoint()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
 
-                    /* Assign the MQTT Status to an error in case of PUBACK/PUBREC receive failure to retry publish. */
-                    if( mqtt_obj->pub_ack_status.puback_status == false )
-                    {
-                        result = CY_RSLT_MODULE_MQTT_PUBLISH_FAIL;
-                        mqttStatus = MQTTRecvFailed;
-                    }
-                }
-                else
-                {
-                    result = CY_RSLT_SUCCESS;
-                }
-                mqtt_obj->outgoing_pub_packets[ publishIndex ].pubinfo.dup = true;
-            }
-            retry++;
-        } while( (mqttStatus != MQTTSuccess) && (retry < CY_MQTT_MAX_RETRY_VALUE) );
+    if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nLibrary init is not done/Global mutex is not initialized..!\n " );
+        return CY_RSLT_MODULE_MQTT_NOT_INITIALIZED;
+    }
 
-        /* Start MQTT Ping Timer */
-        timer_result = start_timer( mqtt_obj );
-        if( timer_result != CY_RSLT_SUCCESS )
-        {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nstart_timer failed with Error : [0x%X] \n", (unsigned int)timer_result );
-            mqtt_cleanup_outgoing_publish( mqtt_obj, publishIndex );
-            (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
-            return timer_result;
-        }
+    mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
 
-        if( result != CY_RSLT_SUCCESS )
-        {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nFailed to send PUBLISH packet to broker with max retry..!\n " );
-            mqtt_cleanup_outgoing_publish( mqtt_obj, publishIndex );
-            (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
-            return result;
-        }
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
+    }
 
-        if( mqtt_obj->outgoing_pub_packets[ publishIndex ].pubinfo.qos == MQTTQoS0 )
-        {
-            /* Clean up outgoing_pub_packets for QoS0 PUBLISH packets.*/
-            (void)mqtt_cleanup_outgoing_publish( mqtt_obj, publishIndex );
-        }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_get_broker_endpoint - Acquiring Mutex %p \n", mqtt_obj->process_mutex );
+    result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
+        return result;
+    }
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_get_broker_endpoint - Acquired Mutex %p \n", mqtt_obj->process_mutex );
 
-        result = cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
-        if( result != CY_RSLT_SUCCESS )
-        {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", (unsigned int)result );
-            return result;
-        }
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_publish - Released Mutex %p \n", mqtt_obj->process_mutex );
+    if( mqtt_obj->mqtt_conn_status == false )
+    {
+        result = CY_RSLT_MODULE_MQTT_NOT_CONNECTED;
+    }
+    else
+    {
+        *index = mqtt_obj->endpoint_current;
     }
 
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_get_broker_endpoint - Releasing Mutex %p \n", mqtt_obj->process_mutex );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_get_broker_endpoint - Released Mutex %p \n", mqtt_obj->process_mutex );
+
+    mqtt_obj_release( mqtt_obj );
     return result;
 }
 
 /*----------------------------------------------------------------------------------------------------------*/
 
-cy_rslt_t cy_mqtt_subscribe( cy_mqtt_t mqtt_handle, cy_mqtt_subscribe_info_t *sub_info, uint8_t sub_count  )
+/*
+ * mqtt_subscribe
+ *
+ * Subscribe to the topic filters in sub_info. If callback is not NULL, it is attached to the topic filters
+ * that are subscribed, and the messages received on topics matching them are delivered to it.
+ */
+static cy_rslt_t mqtt_subscribe( cy_mqtt_t mqtt_handle, cy_mqtt_subscribe_info_t *sub_info, uint8_t sub_count,
+                                 cy_mqtt_callback_t callback, void *user_data )
 {
     cy_rslt_t              result = CY_RSLT_SUCCESS;
-    cy_rslt_t              timer_result = CY_RSLT_SUCCESS;
     MQTTStatus_t           mqttStatus;
     cy_mqtt_object_t       *mqtt_obj;
     uint8_t                index = 0, retry = 0;
     MQTTSubscribeInfo_t    *sub_list = NULL;
-    uint32_t               timeout = 0;
+    bool                   route_added[ CY_MQTT_MAX_OUTGOING_SUBSCRIBES ] = { false };
 
     if( (mqtt_handle == NULL) || (sub_info == NULL) || (sub_count < 1) )
     {
@@ -2765,7 +10394,7 @@ cy_rslt_t cy_mqtt_subscribe( cy_mqtt_t mqtt_handle, cy_mqtt_subscribe_info_t *su
 
     mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
 
-    if( is_mqtt_obj_valid( mqtt_obj ) == false )
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
         return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
@@ -2774,12 +10403,14 @@ cy_rslt_t cy_mqtt_subscribe( cy_mqtt_t mqtt_handle, cy_mqtt_subscribe_info_t *su
     if( mqtt_obj->mqtt_session_established == false )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT client session not present..!\n" );
+        mqtt_obj_release( mqtt_obj );
         return CY_RSLT_MODULE_MQTT_NOT_CONNECTED;
     }
 
     if( sub_count > CY_MQTT_MAX_OUTGOING_SUBSCRIBES )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMax number of supported subscription count in single request is %d\n", (int)CY_MQTT_MAX_OUTGOING_SUBSCRIBES );
+        mqtt_obj_release( mqtt_obj );
         return CY_RSLT_MODULE_MQTT_SUBSCRIBE_FAIL;
     }
 
@@ -2787,6 +10418,7 @@ cy_rslt_t cy_mqtt_subscribe( cy_mqtt_t mqtt_handle, cy_mqtt_subscribe_info_t *su
     if( sub_list == NULL )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to create sub_list..!\n" );
+        mqtt_obj_release( mqtt_obj );
         return CY_RSLT_MODULE_MQTT_NOMEM;
     }
     cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nsub_list : %p..!\n", sub_list );
@@ -2809,6 +10441,14 @@ cy_rslt_t cy_mqtt_subscribe( cy_mqtt_t mqtt_handle, cy_mqtt_subscribe_info_t *su
         {
             cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nQoS not supported..!\n" );
             free( sub_list );
+            mqtt_obj_release( mqtt_obj );
+            return CY_RSLT_MODULE_MQTT_SUBSCRIBE_FAIL;
+        }
+        if( (callback != NULL) && (mqtt_is_valid_topic_filter( sub_info[index].topic, sub_info[index].topic_len ) == false) )
+        {
+            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid topic filter %.*s..!\n", sub_info[index].topic_len, sub_info[index].topic );
+            free( sub_list );
+            mqtt_obj_release( mqtt_obj );
             return CY_RSLT_MODULE_MQTT_SUBSCRIBE_FAIL;
         }
         sub_info[ index ].allocated_qos = CY_MQTT_QOS_INVALID;
@@ -2816,30 +10456,58 @@ cy_rslt_t cy_mqtt_subscribe( cy_mqtt_t mqtt_handle, cy_mqtt_subscribe_info_t *su
         sub_list[ index ].topicFilterLength = sub_info[index].topic_len;
     }
 
+    /* Only one synchronous subscribe request waits for an acknowledgment at a time. */
+    result = cy_rtos_get_mutex( &(mqtt_obj->sub_waiter.req_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->sub_waiter.req_mutex, (unsigned int)result );
+        free( sub_list );
+        mqtt_obj_release( mqtt_obj );
+        return result;
+    }
+
     result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
     if( result != CY_RSLT_SUCCESS )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        (void)cy_rtos_set_mutex( &(mqtt_obj->sub_waiter.req_mutex) );
         free( sub_list );
+        mqtt_obj_release( mqtt_obj );
         return result;
     }
 
     /* Generate the packet identifier for the SUBSCRIBE packet. */
-    mqtt_obj->sent_packet_id = MQTT_GetPacketId( &(mqtt_obj->mqtt_context) );
+    mqtt_obj->sub_waiter.packet_id = MQTT_GetPacketId( &(mqtt_obj->mqtt_context) );
     cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_subscribe - Acquired Mutex %p \n", mqtt_obj->process_mutex );
 
-    /* Stop MQTT Ping Timer */
-    result = stop_timer( mqtt_obj );
-    if( result != CY_RSLT_SUCCESS )
+    /* Attach the callbacks before sending the SUBSCRIBE packet, as the retained messages may follow the SUBACK before this function gets the mutex back. */
+    for( index = 0; (callback != NULL) && (index < sub_count); index++ )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nstop_timer failed\n" );
+        result = mqtt_route_add( mqtt_obj, sub_info[index].topic, sub_info[index].topic_len,
+                                 callback, user_data, &(route_added[index]) );
+        if( result != CY_RSLT_SUCCESS )
+        {
+            while( index > 0 )
+            {
+                index--;
+                if( route_added[index] == true )
+                {
+                    mqtt_route_remove( mqtt_obj, sub_info[index].topic, sub_info[index].topic_len, callback );
+                }
+            }
+            (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+            (void)cy_rtos_set_mutex( &(mqtt_obj->sub_waiter.req_mutex) );
+            free( sub_list );
+            mqtt_obj_release( mqtt_obj );
+            return result;
+        }
     }
 
     do
     {
-        timeout = CY_MQTT_ACK_RECEIVE_TIMEOUT_MS;
         result = CY_RSLT_MODULE_MQTT_SUBSCRIBE_FAIL;
         memset( &mqtt_obj->sub_ack_status, 0x00, sizeof(mqtt_obj->sub_ack_status) );
+        mqtt_obj->sub_waiter.ack_received = false;
 
         /*
          * num_of_subs_in_req is initialized with number of subscribe messages in one MQTT subscribe request.
@@ -2851,7 +10519,7 @@ cy_rslt_t cy_mqtt_subscribe( cy_mqtt_t mqtt_handle, cy_mqtt_subscribe_info_t *su
         mqttStatus = MQTT_Subscribe( &(mqtt_obj->mqtt_context),
                                      sub_list,
                                      sub_count,
-                                     mqtt_obj->sent_packet_id );
+                                     mqtt_obj->sub_waiter.packet_id );
         if( mqttStatus != MQTTSuccess )
         {
             cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nFailed to send SUBSCRIBE packet to broker with error = %s.\n",
@@ -2867,55 +10535,44 @@ cy_rslt_t cy_mqtt_subscribe( cy_mqtt_t mqtt_handle, cy_mqtt_subscribe_info_t *su
                                  sub_list[ index ].topicFilterLength,
                                  sub_list[ index ].pTopicFilter );
             }
-            do
-            {
-                /* Process the incoming packet from the broker.
-                 * Acknowledgment for subscription ( SUBACK ) will be received here. */
-                mqttStatus = MQTT_ProcessLoop( &(mqtt_obj->mqtt_context), CY_MQTT_RECEIVE_DATA_TIMEOUT_MS );
-                if( mqttStatus != MQTTSuccess )
-                {
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT_ProcessLoop returned with status = %s.\n", MQTT_Status_strerror( mqttStatus ) );
-                    result = CY_RSLT_MODULE_MQTT_SUBSCRIBE_FAIL;
-                    break;
-                }
+            /* Wait for the acknowledgment for subscription ( SUBACK ). It is processed by
+             * mqtt_event_processing_thread, which signals mqtt_obj->sub_waiter. */
+            mqttStatus = mqtt_wait_for_ack( mqtt_obj, &(mqtt_obj->sub_waiter.semaphore), &(mqtt_obj->sub_waiter.ack_received), CY_MQTT_ACK_RECEIVE_TIMEOUT_MS );
 
-                /* if suback status is updated then num_of_subs_in_req will be set to 0 in mqtt_event_callback.*/
-                if( mqtt_obj->num_of_subs_in_req == 0 )
+            /* if suback status is updated then num_of_subs_in_req will be set to 0 in mqtt_event_callback.*/
+            if( mqtt_obj->num_of_subs_in_req == 0 )
+            {
+                result = CY_RSLT_MODULE_MQTT_SUBSCRIBE_FAIL; /* Initialize result with failure. */
+                for( index = 0; index < sub_count; index++ )
                 {
-                    result = CY_RSLT_MODULE_MQTT_SUBSCRIBE_FAIL; /* Initialize result with failure. */
-                    for( index = 0; index < sub_count; index++ )
+                    if( mqtt_obj->sub_ack_status[index] == MQTTSubAckFailure )
                     {
-                        if( mqtt_obj->sub_ack_status[index] == MQTTSubAckFailure )
+                        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nMQTT broker rejected SUBSCRIBE request for topic %.*s .\n",
+                                         sub_list[ index ].topicFilterLength,
+                                         sub_list[ index ].pTopicFilter );
+                        sub_info[ index ].allocated_qos = CY_MQTT_QOS_INVALID;
+                    }
+                    else
+                    {
+                        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nSUBSCRIBE accepted for topic %.*s with QoS %d .\n",
+                                         sub_list[ index ].topicFilterLength,
+                                         sub_list[ index ].pTopicFilter, mqtt_obj->sub_ack_status[index] );
+                        if( mqtt_obj->sub_ack_status[index] == MQTTSubAckSuccessQos0 )
+                        {
+                            sub_info[ index ].allocated_qos = CY_MQTT_QOS0;
+                        }
+                        else if( mqtt_obj->sub_ack_status[index] == MQTTSubAckSuccessQos1 )
                         {
-                            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nMQTT broker rejected SUBSCRIBE request for topic %.*s .\n",
-                                             sub_list[ index ].topicFilterLength,
-                                             sub_list[ index ].pTopicFilter );
-                            sub_info[ index ].allocated_qos = CY_MQTT_QOS_INVALID;
+                            sub_info[ index ].allocated_qos = CY_MQTT_QOS1;
                         }
                         else
                         {
-                            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nSUBSCRIBE accepted for topic %.*s with QoS %d .\n",
-                                             sub_list[ index ].topicFilterLength,
-                                             sub_list[ index ].pTopicFilter, mqtt_obj->sub_ack_status[index] );
-                            if( mqtt_obj->sub_ack_status[index] == MQTTSubAckSuccessQos0 )
-                            {
-                                sub_info[ index ].allocated_qos = CY_MQTT_QOS0;
-                            }
-                            else if( mqtt_obj->sub_ack_status[index] == MQTTSubAckSuccessQos1 )
-                            {
-                                sub_info[ index ].allocated_qos = CY_MQTT_QOS1;
-                            }
-                            else
-                            {
-                                sub_info[ index ].allocated_qos = CY_MQTT_QOS2;
-                            }
-                            result = CY_RSLT_SUCCESS; /* Update with success if at least one subscription is successful. */
+                            sub_info[ index ].allocated_qos = CY_MQTT_QOS2;
                         }
+                        result = CY_RSLT_SUCCESS; /* Update with success if at least one subscription is successful. */
                     }
-                    break; /* Received the ack. So exit timeout do loop */
                 }
-                timeout = timeout - CY_MQTT_SOCKET_RECEIVE_TIMEOUT_MS;
-            } while( timeout > 0 );
+            }
 
             if( mqtt_obj->num_of_subs_in_req != 0 )
             {
@@ -2926,12 +10583,13 @@ cy_rslt_t cy_mqtt_subscribe( cy_mqtt_t mqtt_handle, cy_mqtt_subscribe_info_t *su
         retry++;
     } while( (mqttStatus != MQTTSuccess) && (retry < CY_MQTT_MAX_RETRY_VALUE) );
 
-    /* Start MQTT Ping Timer */
-    timer_result = start_timer( mqtt_obj );
-    if( timer_result != CY_RSLT_SUCCESS )
+    /* Detach the callbacks of the topic filters that are not subscribed. */
+    for( index = 0; index < sub_count; index++ )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nstart_timer failed with Error : [0x%X] \n", (unsigned int)timer_result );
-        goto exit;
+        if( (route_added[index] == true) && ((result != CY_RSLT_SUCCESS) || (sub_info[index].allocated_qos == CY_MQTT_QOS_INVALID)) )
+        {
+            mqtt_route_remove( mqtt_obj, sub_info[index].topic, sub_info[index].topic_len, callback );
+        }
     }
 
     if( result != CY_RSLT_SUCCESS )
@@ -2940,40 +10598,77 @@ cy_rslt_t cy_mqtt_subscribe( cy_mqtt_t mqtt_handle, cy_mqtt_subscribe_info_t *su
         goto exit;
     }
 
+    if( mqtt_obj->reconnect_enabled == true )
+    {
+        /* Record the subscribed topic filters, to restore them after an automatic reconnection. */
+        for( index = 0; index < sub_count; index++ )
+        {
+            if( sub_info[index].allocated_qos != CY_MQTT_QOS_INVALID )
+            {
+                (void)mqtt_subscription_record( mqtt_obj, sub_info[index].topic, sub_info[index].topic_len, sub_list[index].qos );
+            }
+        }
+    }
+
     result = cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
     if( result != CY_RSLT_SUCCESS )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", (unsigned int)result );
+        (void)cy_rtos_set_mutex( &(mqtt_obj->sub_waiter.req_mutex) );
         free( sub_list );
+        mqtt_obj_release( mqtt_obj );
         return result;
     }
 
     cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_subscribe - Released Mutex %p \n", mqtt_obj->process_mutex );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->sub_waiter.req_mutex) );
     free( sub_list );
+    mqtt_obj_release( mqtt_obj );
     return CY_RSLT_SUCCESS;
 
 exit :
     (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->sub_waiter.req_mutex) );
     /* Free sub_list */
     if( sub_list != NULL )
     {
         free( sub_list );
     }
 
+    mqtt_obj_release( mqtt_obj );
     return result;
 }
 
 /*----------------------------------------------------------------------------------------------------------*/
 
+cy_rslt_t cy_mqtt_subscribe( cy_mqtt_t mqtt_handle, cy_mqtt_subscribe_info_t *sub_info, uint8_t sub_count )
+{
+    return mqtt_subscribe( mqtt_handle, sub_info, sub_count, NULL, NULL );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+cy_rslt_t cy_mqtt_subscribe_with_callback( cy_mqtt_t mqtt_handle, cy_mqtt_subscribe_info_t *sub_info, uint8_t sub_count,
+                                           cy_mqtt_callback_t callback, void *user_data )
+{
+    if( callback == NULL )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nBad arguments to cy_mqtt_subscribe_with_callback()..!\n" );
+        return CY_RSLT_MODULE_MQTT_BADARG;
+    }
+
+    return mqtt_subscribe( mqtt_handle, sub_info, sub_count, callback, user_data );
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
 cy_rslt_t cy_mqtt_unsubscribe( cy_mqtt_t mqtt_handle, cy_mqtt_unsubscribe_info_t *unsub_info, uint8_t unsub_count )
 {
     cy_rslt_t              result = CY_RSLT_SUCCESS;
-    cy_rslt_t              timer_result = CY_RSLT_SUCCESS;
     cy_mqtt_object_t       *mqtt_obj;
     MQTTStatus_t           mqttStatus;
     uint8_t                index = 0, retry = 0;
     MQTTSubscribeInfo_t    *unsub_list = NULL;
-    uint32_t               timeout = 0;
 
     if( (mqtt_handle == NULL) || (unsub_info == NULL) || (unsub_count < 1) )
     {
@@ -2989,7 +10684,7 @@ cy_rslt_t cy_mqtt_unsubscribe( cy_mqtt_t mqtt_handle, cy_mqtt_unsubscribe_info_t
 
     mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
 
-    if( is_mqtt_obj_valid( mqtt_obj ) == false )
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
         return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
@@ -2998,12 +10693,14 @@ cy_rslt_t cy_mqtt_unsubscribe( cy_mqtt_t mqtt_handle, cy_mqtt_unsubscribe_info_t
     if( mqtt_obj->mqtt_session_established == false )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT client session not present..!\n" );
+        mqtt_obj_release( mqtt_obj );
         return CY_RSLT_MODULE_MQTT_NOT_CONNECTED;
     }
 
     if( unsub_count > CY_MQTT_MAX_OUTGOING_SUBSCRIBES )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMax number of supported unsubscription count in single request is %d\n", (int)CY_MQTT_MAX_OUTGOING_SUBSCRIBES );
+        mqtt_obj_release( mqtt_obj );
         return CY_RSLT_MODULE_MQTT_UNSUBSCRIBE_FAIL;
     }
 
@@ -3011,6 +10708,7 @@ cy_rslt_t cy_mqtt_unsubscribe( cy_mqtt_t mqtt_handle, cy_mqtt_unsubscribe_info_t
     if( unsub_list == NULL )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMemory not available to create unsub_list..!\n" );
+        mqtt_obj_release( mqtt_obj );
         return CY_RSLT_MODULE_MQTT_NOMEM;
     }
     cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nsub_list : %p..!\n", unsub_list );
@@ -3033,41 +10731,46 @@ cy_rslt_t cy_mqtt_unsubscribe( cy_mqtt_t mqtt_handle, cy_mqtt_unsubscribe_info_t
         {
             cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nQoS level not supported...\n" );
             free( unsub_list );
+            mqtt_obj_release( mqtt_obj );
             return CY_RSLT_MODULE_MQTT_UNSUBSCRIBE_FAIL;
         }
         unsub_list[ index ].pTopicFilter = unsub_info[index].topic;
         unsub_list[ index ].topicFilterLength = unsub_info[index].topic_len;
     }
 
+    /* Only one synchronous unsubscribe request waits for an acknowledgment at a time. */
+    result = cy_rtos_get_mutex( &(mqtt_obj->unsub_waiter.req_mutex), CY_RTOS_NEVER_TIMEOUT );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->unsub_waiter.req_mutex, (unsigned int)result );
+        free( unsub_list );
+        mqtt_obj_release( mqtt_obj );
+        return result;
+    }
+
     result = cy_rtos_get_mutex( &(mqtt_obj->process_mutex), CY_RTOS_NEVER_TIMEOUT );
     if( result != CY_RSLT_SUCCESS )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        (void)cy_rtos_set_mutex( &(mqtt_obj->unsub_waiter.req_mutex) );
         free( unsub_list );
+        mqtt_obj_release( mqtt_obj );
         return result;
     }
     cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_unsubscribe - Acquired Mutex %p \n", mqtt_obj->process_mutex );
 
     /* Generate the packet identifier for the UNSUBSCRIBE packet. */
-    mqtt_obj->sent_packet_id = MQTT_GetPacketId( &(mqtt_obj->mqtt_context) );
-
-    /* Stop MQTT Ping Timer */
-    result = stop_timer( mqtt_obj );
-    if( result != CY_RSLT_SUCCESS )
-    {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nstop_timer failed" );
-    }
+    mqtt_obj->unsub_waiter.packet_id = MQTT_GetPacketId( &(mqtt_obj->mqtt_context) );
 
     do
     {
-        timeout = CY_MQTT_ACK_RECEIVE_TIMEOUT_MS;
-        mqtt_obj->unsub_ack_received = false;
+        mqtt_obj->unsub_waiter.ack_received = false;
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "UNSUBSCRIBE sent for topic %.*s to broker.\n\n", unsub_info->topic_len, unsub_info->topic );
         /* Send the UNSUBSCRIBE packet. */
         mqttStatus = MQTT_Unsubscribe( &(mqtt_obj->mqtt_context),
                                        unsub_list,
                                        unsub_count,
-                                       mqtt_obj->sent_packet_id );
+                                       mqtt_obj->unsub_waiter.packet_id );
         if( mqttStatus != MQTTSuccess )
         {
             cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to send UNSUBSCRIBE packet to broker with error = %s.\n",
@@ -3076,26 +10779,14 @@ cy_rslt_t cy_mqtt_unsubscribe( cy_mqtt_t mqtt_handle, cy_mqtt_unsubscribe_info_t
         }
         else
         {
-            do
+            /* Wait for the acknowledgment for UNSUBSCRIBE ( UNSUBACK ). It is processed by
+             * mqtt_event_processing_thread, which signals mqtt_obj->unsub_waiter. */
+            mqttStatus = mqtt_wait_for_ack( mqtt_obj, &(mqtt_obj->unsub_waiter.semaphore), &(mqtt_obj->unsub_waiter.ack_received), CY_MQTT_ACK_RECEIVE_TIMEOUT_MS );
+            if( mqtt_obj->unsub_waiter.ack_received == true )
             {
-                /* Process the  incoming packet from the broker.
-                 * Acknowledgment for UNSUBSCRIBE ( UNSUBACK ) will be received here. */
-                mqttStatus = MQTT_ProcessLoop( &(mqtt_obj->mqtt_context), CY_MQTT_RECEIVE_DATA_TIMEOUT_MS );
-                if( mqttStatus != MQTTSuccess )
-                {
-                    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT_ProcessLoop returned with status = %s.\n", MQTT_Status_strerror( mqttStatus ) );
-                    result = CY_RSLT_MODULE_MQTT_UNSUBSCRIBE_FAIL;
-                    break;
-                }
-                if( mqtt_obj->unsub_ack_received == true )
-                {
-                    result = CY_RSLT_SUCCESS;
-                    break;
-                }
-                timeout = timeout - CY_MQTT_SOCKET_RECEIVE_TIMEOUT_MS;
-            } while( timeout > 0 );
-
-            if( mqtt_obj->unsub_ack_received == false )
+                result = CY_RSLT_SUCCESS;
+            }
+            else
             {
                 cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nNot received unsuback before timeout %u millisecond \n", (unsigned int)CY_MQTT_ACK_RECEIVE_TIMEOUT_MS );
                 result = CY_RSLT_MODULE_MQTT_UNSUBSCRIBE_FAIL;
@@ -3105,12 +10796,13 @@ cy_rslt_t cy_mqtt_unsubscribe( cy_mqtt_t mqtt_handle, cy_mqtt_unsubscribe_info_t
         retry++;
     } while( (mqttStatus != MQTTSuccess) && (retry < CY_MQTT_MAX_RETRY_VALUE) );
 
-    /* Start MQTT Ping Timer */
-    timer_result = start_timer( mqtt_obj );
-    if( timer_result != CY_RSLT_SUCCESS )
+    if( result == CY_RSLT_SUCCESS )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nstart_timer failed with Error : [0x%X] \n", (unsigned int)timer_result );
-        goto exit;
+        for( index = 0; index < unsub_count; index++ )
+        {
+            mqtt_route_remove( mqtt_obj, unsub_info[index].topic, unsub_info[index].topic_len, NULL );
+            mqtt_subscription_forget( mqtt_obj, unsub_info[index].topic, unsub_info[index].topic_len );
+        }
     }
 
     if( result != CY_RSLT_SUCCESS )
@@ -3123,23 +10815,29 @@ cy_rslt_t cy_mqtt_unsubscribe( cy_mqtt_t mqtt_handle, cy_mqtt_unsubscribe_info_t
     if( result != CY_RSLT_SUCCESS )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", (unsigned int)result );
+        (void)cy_rtos_set_mutex( &(mqtt_obj->unsub_waiter.req_mutex) );
         free( unsub_list );
+        mqtt_obj_release( mqtt_obj );
         return result;
     }
     cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_unsubscribe - Released Mutex %p \n", mqtt_obj->process_mutex );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->unsub_waiter.req_mutex) );
 
     /* Free unsub_list. */
     free( unsub_list );
+    mqtt_obj_release( mqtt_obj );
     return CY_RSLT_SUCCESS;
 
 exit :
     (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+    (void)cy_rtos_set_mutex( &(mqtt_obj->unsub_waiter.req_mutex) );
     /* Free unsub_list. */
     if( unsub_list != NULL )
     {
         free( unsub_list );
     }
 
+    mqtt_obj_release( mqtt_obj );
     return result;
 }
 
@@ -3165,7 +10863,7 @@ cy_rslt_t cy_mqtt_disconnect( cy_mqtt_t mqtt_handle )
 
     mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
 
-    if( is_mqtt_obj_valid( mqtt_obj ) == false )
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
         return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
@@ -3176,10 +10874,14 @@ cy_rslt_t cy_mqtt_disconnect( cy_mqtt_t mqtt_handle )
     if( result != CY_RSLT_SUCCESS )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
         return result;
     }
     cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_disconnect - Acquired Mutex %p \n", mqtt_obj->process_mutex );
 
+    /* A reconnection in progress is stopped; its network connection is already closed. */
+    mqtt_reconnect_cancel( mqtt_obj );
+
     result = stop_timer( mqtt_obj );
     if( result != CY_RSLT_SUCCESS )
     {
@@ -3200,8 +10902,10 @@ cy_rslt_t cy_mqtt_disconnect( cy_mqtt_t mqtt_handle )
         if( result != CY_RSLT_SUCCESS )
         {
             cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", (unsigned int)result );
+            mqtt_obj_release( mqtt_obj );
             return result;
         }
+        mqtt_obj_release( mqtt_obj );
         return CY_RSLT_MODULE_MQTT_NOT_CONNECTED;
     }
 
@@ -3219,6 +10923,7 @@ cy_rslt_t cy_mqtt_disconnect( cy_mqtt_t mqtt_handle )
     }
 
     mqtt_obj->mqtt_session_established = false;
+    mqtt_wake_ack_waiters( mqtt_obj );
     result = cy_awsport_network_disconnect( &(mqtt_obj->network_context) );
     if( result != CY_RSLT_SUCCESS )
     {
@@ -3250,10 +10955,12 @@ cy_rslt_t cy_mqtt_disconnect( cy_mqtt_t mqtt_handle )
     if( result != CY_RSLT_SUCCESS )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
         return result;
     }
     cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_disconnect - Released Mutex %p \n", mqtt_obj->process_mutex );
 
+    mqtt_obj_release( mqtt_obj );
     return result;
 }
 
@@ -3261,8 +10968,8 @@ cy_rslt_t cy_mqtt_disconnect( cy_mqtt_t mqtt_handle )
 
 cy_rslt_t cy_mqtt_delete( cy_mqtt_t mqtt_handle )
 {
-    cy_rslt_t         result = CY_RSLT_SUCCESS;
-    cy_mqtt_object_t  *mqtt_obj;
+    cy_rslt_t                  result = CY_RSLT_SUCCESS;
+    cy_mqtt_object_t           *mqtt_obj;
 
     if( mqtt_handle == NULL )
     {
@@ -3278,16 +10985,20 @@ cy_rslt_t cy_mqtt_delete( cy_mqtt_t mqtt_handle )
 
     mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
 
-    if( is_mqtt_obj_valid( mqtt_obj ) == false )
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
         return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
     }
 
+    /* Stop the dispatch pool first, as its callbacks may call the MQTT library functions. */
+    (void)mqtt_dispatch_detach( mqtt_obj, NULL );
+
     result = cy_rtos_get_mutex( &mqtt_db_mutex, CY_RTOS_NEVER_TIMEOUT );
     if( result != CY_RSLT_SUCCESS )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
         return result;
     }
     cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_delete - Acquired Mutex %p \n", mqtt_db_mutex );
@@ -3302,27 +11013,32 @@ cy_rslt_t cy_mqtt_delete( cy_mqtt_t mqtt_handle )
         {
             cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
         }
+        mqtt_obj_release( mqtt_obj );
         return result;
     }
 
-    /* Stop the MQTT Ping timer if still running and deinit timer */
-    result = stop_timer( mqtt_obj );
-    if( result != CY_RSLT_SUCCESS )
+    if( mqtt_obj->deleted == true )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nstop_timer failed\n" );
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nMQTT handle is already deleted..!\n" );
+        (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+        (void)cy_rtos_set_mutex( &mqtt_db_mutex );
+        mqtt_obj_release( mqtt_obj );
+        return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
     }
 
-    result = cy_rtos_deinit_timer( &mqtt_obj->mqtt_timer );
-    if( result != CY_RSLT_SUCCESS )
-    {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_deinit_timer failed with Error : [0x%X] \n", (unsigned int)result );
-    }
-    result = cy_rtos_deinit_timer( &mqtt_obj->mqtt_ping_resp_timer );
-    if( result != CY_RSLT_SUCCESS )
-    {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_deinit_timer failed with Error : [0x%X] \n", (unsigned int)result );
-    }
+    /* From here on, no new reference to the MQTT object can be taken, and the events queued for it are dropped by its event loop thread. */
+    (void)cy_rtos_get_mutex( &(mqtt_obj->ref_mutex), CY_RTOS_NEVER_TIMEOUT );
+    mqtt_obj->deleted = true;
+    mqtt_obj->mqtt_magic_header = 0;
+    mqtt_obj->mqtt_magic_footer = 0;
+    (void)cy_rtos_set_mutex( &(mqtt_obj->ref_mutex) );
+    mqtt_wake_ack_waiters( mqtt_obj );
 
+    /* Remove the timers of the MQTT object from the timing wheel; their callbacks are not called after this. */
+    mqtt_timer_cancel( &mqtt_obj->mqtt_timer );
+    mqtt_timer_cancel( &mqtt_obj->mqtt_ping_resp_timer );
+    mqtt_timer_cancel( &mqtt_obj->mqtt_async_ack_timer );
+    mqtt_timer_cancel( &mqtt_obj->reconnect_timer );
 
     result = cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
     if( result != CY_RSLT_SUCCESS )
@@ -3333,32 +11049,29 @@ cy_rslt_t cy_mqtt_delete( cy_mqtt_t mqtt_handle )
         {
             cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
         }
+        mqtt_obj_release( mqtt_obj );
         return result;
     }
     cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_delete - Released Mutex %p \n", mqtt_obj->process_mutex );
 
-    (void)cy_rtos_deinit_mutex( &(mqtt_obj->process_mutex) );
-
-    /* Clear entry in THE MQTT object-mqtt context table. */
-    mqtt_handle_database[mqtt_obj->mqtt_obj_index].mqtt_handle = NULL;
-    mqtt_handle_database[mqtt_obj->mqtt_obj_index].mqtt_context = NULL;
-    mqtt_handle_count--;
-
-    /* Clear the MQTT handle info. */
-    ( void ) memset( mqtt_obj, 0x00, sizeof( cy_mqtt_object_t ) );
-
-    cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\n Free mqtt_obj : %p..!\n", mqtt_obj );
-    free( mqtt_obj );
+    /* Clear entry in the MQTT handle table. */
+    mqtt_handle_table_remove( mqtt_obj );
+    mqtt_obj->event_loop->handle_count--;
     mqtt_handle = NULL;
 
     result = cy_rtos_set_mutex( &mqtt_db_mutex );
     if( result != CY_RSLT_SUCCESS )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_db_mutex, (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
         return result;
     }
     cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_delete - Released Mutex %p \n", mqtt_db_mutex );
 
+    /* Drop the reference of the handle and the one taken above. The MQTT object is released here, or by the API call
+     * in progress or the event loop thread holding the last reference to it. */
+    mqtt_obj_release( mqtt_obj );
+    mqtt_obj_release( mqtt_obj );
     return CY_RSLT_SUCCESS;
 }
 
@@ -3367,7 +11080,6 @@ cy_rslt_t cy_mqtt_delete( cy_mqtt_t mqtt_handle )
 cy_rslt_t cy_mqtt_deinit( void )
 {
     cy_rslt_t                  result = CY_RSLT_SUCCESS;
-    cy_mqtt_callback_event_t   event;
 
     if( (mqtt_lib_init_status == false) || (mqtt_db_mutex_init_status == false) )
     {
@@ -3392,47 +11104,36 @@ cy_rslt_t cy_mqtt_deinit( void )
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_awsport_network_deinit successful.\n" );
     }
 
-    if( mqtt_event_process_thread != NULL )
+    if( mqtt_reconnect_thread != NULL )
     {
-        event.socket_event = CY_MQTT_SOCKET_EVENT_EXIT_THREAD;
-        event.mqtt_obj = NULL;
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_INFO, "\nPushing event to terminate mqtt_event_processing_thread \n" );
-
-        result = cy_rtos_put_queue( &mqtt_event_queue, (void *)&event, CY_MQTT_EVENT_QUEUE_TIMEOUT_IN_MSEC, false );
-        if( result != CY_RSLT_SUCCESS )
-        {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nPushing event to terminate mqtt_event_processing_thread failed with Error : [0x%X] \n", (unsigned int)result );
-        }
+        mqtt_reconnect_thread_stop();
+    }
 
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nJoining MQTT event process thread %p..!\n", mqtt_event_process_thread );
-        result = cy_rtos_join_thread( &mqtt_event_process_thread );
+    if( mqtt_default_event_loop.thread != NULL )
+    {
+        result = mqtt_event_loop_stop( &mqtt_default_event_loop );
         if( result != CY_RSLT_SUCCESS )
         {
-            cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nJoin MQTT event process thread failed with Error : [0x%X] \n", (unsigned int)result );
             return result;
         }
-        mqtt_event_process_thread = NULL;
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_rtos_deinit_queue successful.\n" );
     }
 
-    result = cy_rtos_deinit_mutex( &mqtt_db_mutex );
-    if( result != CY_RSLT_SUCCESS )
+    if( mqtt_timer_thread != NULL )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_deinit_mutex failed with Error : [0x%X] \n", (unsigned int)result );
-        return result;
+        mqtt_timer_thread_stop();
     }
 
-    mqtt_db_mutex_init_status = false;
+    (void)cy_rtos_deinit_mutex( &mqtt_timer_mutex );
 
-    result = cy_rtos_deinit_queue( &mqtt_event_queue );
+    result = cy_rtos_deinit_mutex( &mqtt_db_mutex );
     if( result != CY_RSLT_SUCCESS )
     {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_deinit_queue failed with Error : [0x%X] \n", (unsigned int)result );
+        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_deinit_mutex failed with Error : [0x%X] \n", (unsigned int)result );
         return result;
     }
-    else
-    {
-        cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_rtos_deinit_queue successful.\n" );
-    }
+
+    mqtt_db_mutex_init_status = false;
 
     mqtt_lib_init_status = false;
     return CY_RSLT_SUCCESS;
@@ -3467,7 +11168,7 @@ cy_rslt_t cy_mqtt_register_event_callback( cy_mqtt_t mqtt_handle,
 
     mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
 
-    if( is_mqtt_obj_valid( mqtt_obj ) == false )
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
         return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
@@ -3478,6 +11179,7 @@ cy_rslt_t cy_mqtt_register_event_callback( cy_mqtt_t mqtt_handle,
     if( result != CY_RSLT_SUCCESS )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
         return result;
     }
     cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_register_event_callback - Acquired Mutex %p \n", mqtt_obj->process_mutex );
@@ -3495,6 +11197,7 @@ cy_rslt_t cy_mqtt_register_event_callback( cy_mqtt_t mqtt_handle,
     {
         cy_mqtt_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Maximum number of callbacks already registered! \r\n");
         (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+        mqtt_obj_release( mqtt_obj );
         return CY_RSLT_MODULE_MQTT_NOMEM;
     }
 
@@ -3503,10 +11206,12 @@ cy_rslt_t cy_mqtt_register_event_callback( cy_mqtt_t mqtt_handle,
     if( result != CY_RSLT_SUCCESS )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
         return result;
     }
     cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_register_event_callback - Released Mutex %p \n", mqtt_obj->process_mutex );
 
+    mqtt_obj_release( mqtt_obj );
     return CY_RSLT_SUCCESS;
 }
 
@@ -3533,7 +11238,7 @@ cy_rslt_t cy_mqtt_deregister_event_callback( cy_mqtt_t mqtt_handle,
 
     mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
 
-    if( is_mqtt_obj_valid( mqtt_obj ) == false )
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT handle..!\n" );
         return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
@@ -3544,6 +11249,7 @@ cy_rslt_t cy_mqtt_deregister_event_callback( cy_mqtt_t mqtt_handle,
     if( result != CY_RSLT_SUCCESS )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] \n", mqtt_obj->process_mutex, (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
         return result;
     }
     cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_deregister_event_callback - Acquired Mutex %p \n", mqtt_obj->process_mutex );
@@ -3561,6 +11267,7 @@ cy_rslt_t cy_mqtt_deregister_event_callback( cy_mqtt_t mqtt_handle,
     {
         cy_mqtt_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Event callback not found! \r\n");
         (void)cy_rtos_set_mutex( &(mqtt_obj->process_mutex) );
+        mqtt_obj_release( mqtt_obj );
         return CY_RSLT_MODULE_MQTT_NOMEM;
     }
 
@@ -3569,10 +11276,12 @@ cy_rslt_t cy_mqtt_deregister_event_callback( cy_mqtt_t mqtt_handle,
     if( result != CY_RSLT_SUCCESS )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
         return result;
     }
     cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_deregister_event_callback - Released Mutex %p \n", mqtt_obj->process_mutex );
 
+    mqtt_obj_release( mqtt_obj );
     return CY_RSLT_SUCCESS;
 }
 
@@ -3581,9 +11290,7 @@ cy_rslt_t cy_mqtt_deregister_event_callback( cy_mqtt_t mqtt_handle,
 cy_rslt_t cy_mqtt_get_handle( cy_mqtt_t *mqtt_handle, char *descriptor )
 {
     cy_rslt_t result;
-    int handle_index = 0;
-    bool handle_found = false;
-    cy_mqtt_object_t  *mqtt_obj = NULL;
+    uint16_t  handle_index;
 
     if( mqtt_handle == NULL || descriptor == NULL )
     {
@@ -3599,22 +11306,12 @@ cy_rslt_t cy_mqtt_get_handle( cy_mqtt_t *mqtt_handle, char *descriptor )
     }
     cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\ncy_mqtt_get_handle - Acquired Mutex %p \n", mqtt_db_mutex );
 
-    while( handle_index < mqtt_handle_count )
+    handle_index = mqtt_handle_table_find( descriptor );
+    if( handle_index != CY_MQTT_HANDLE_INDEX_INVALID )
     {
-        mqtt_obj = (cy_mqtt_object_t*)mqtt_handle_database[handle_index].mqtt_handle;
-        if( mqtt_obj != NULL )
-        {
-            if( strcmp(mqtt_obj->mqtt_descriptor, descriptor) == 0 )
-            {
-                *mqtt_handle = (void*)mqtt_obj;
-                handle_found = true;
-                break;
-            }
-        }
-        handle_index++;
+        *mqtt_handle = (void *)mqtt_handle_database[ handle_index ].mqtt_handle;
     }
-
-    if( handle_found == false )
+    else
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\n MQTT handle for descriptor: %s not found..!\n", descriptor );
         (void)cy_rtos_set_mutex( &mqtt_db_mutex );
@@ -3645,7 +11342,7 @@ cy_rslt_t cy_mqtt_stop_keepalive( cy_mqtt_t mqtt_handle )
 
     mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
 
-    if( is_mqtt_obj_valid( mqtt_obj ) == false )
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT object..!\n" );
         return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
@@ -3656,6 +11353,7 @@ cy_rslt_t cy_mqtt_stop_keepalive( cy_mqtt_t mqtt_handle )
     if( result != CY_RSLT_SUCCESS )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] ", mqtt_obj->process_mutex, (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
         return result;
     }
 
@@ -3666,7 +11364,7 @@ cy_rslt_t cy_mqtt_stop_keepalive( cy_mqtt_t mqtt_handle )
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nstop_timer failed" );
     }
 
-    result = cy_rtos_stop_timer( &mqtt_obj->mqtt_ping_resp_timer );
+    result = stop_mqtt_ping_resp_timer( mqtt_obj );
     if( result != CY_RSLT_SUCCESS )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nPing response timer stop failed\n" );
@@ -3676,10 +11374,12 @@ cy_rslt_t cy_mqtt_stop_keepalive( cy_mqtt_t mqtt_handle )
     if( result != CY_RSLT_SUCCESS )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] \n", (unsigned int)result );
+        mqtt_obj_release( mqtt_obj );
         return result;
     }
     cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\nncy_mqtt_stop_keepalive - Released Mutex %p ", mqtt_obj->process_mutex );
 
+    mqtt_obj_release( mqtt_obj );
     return CY_RSLT_SUCCESS;
 }
 
@@ -3695,7 +11395,7 @@ cy_rslt_t cy_mqtt_start_keepalive( cy_mqtt_t mqtt_handle )
 
     mqtt_obj = (cy_mqtt_object_t *)mqtt_handle;
 
-    if( is_mqtt_obj_valid( mqtt_obj ) == false )
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT object..!\n" );
         return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
@@ -3703,6 +11403,7 @@ cy_rslt_t cy_mqtt_start_keepalive( cy_mqtt_t mqtt_handle )
 
     mqtt_ping_request_callback(mqtt_obj);
 
+    mqtt_obj_release( mqtt_obj );
     return CY_RSLT_SUCCESS;
 }
 
@@ -3716,7 +11417,7 @@ cy_rslt_t cy_mqtt_get_socket(cy_mqtt_t mqtt_handle, cy_socket_t *socket)
         return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
     }
 
-    if( is_mqtt_obj_valid( mqtt_obj ) == false )
+    if( mqtt_obj_acquire( mqtt_obj ) == false )
     {
         cy_mqtt_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\nInvalid MQTT object..!\n" );
         return CY_RSLT_MODULE_MQTT_INVALID_HANDLE;
@@ -3724,6 +11425,7 @@ cy_rslt_t cy_mqtt_get_socket(cy_mqtt_t mqtt_handle, cy_socket_t *socket)
 
     *socket = mqtt_obj->network_context.handle;
 
+    mqtt_obj_release( mqtt_obj );
     return CY_RSLT_SUCCESS;
 }
 
@@ -0,0 +1,297 @@
+/*
+ * Copyright 2025, Cypress Semiconductor Corporation (an Infineon company) or
+ * an affiliate of Cypress Semiconductor Corporation.  All rights reserved.
+ *
+ * This software, including source code, documentation and related
+ * materials ("Software") is owned by Cypress Semiconductor Corporation
+ * or one of its affiliates ("Cypress") and is protected by and subject to
+ * worldwide patent protection (United States and foreign),
+ * United States copyright laws and international treaty provisions.
+ * Therefore, you may use this Software only as provided in the license
+ * agreement accompanying the software package from which you
+ * obtained this Software ("EULA").
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software
+ * source code solely for use in connection with Cypress's
+ * integrated circuit products.  Any reproduction, modification, translation,
+ * compilation, or representation of this Software except as specified
+ * above is prohibited without the express written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer
+ * of such system or application assumes all risk of such use and in doing
+ * so agrees to indemnify Cypress against all liability.
+ */
+
+/** @file
+ *  Implements the built-in LZ4 block format payload codec of the MQTT library.
+ *
+ */
+#include <string.h>
+#include <stdlib.h>
+#include "cy_mqtt_api.h"
+
+/******************************************************
+ *                      Macros
+ ******************************************************/
+/* Minimum length of a match. */
+#define CY_MQTT_LZ4_MIN_MATCH                                ( 4U )
+
+/* The last 5 bytes of the input are always literals, and the last match starts at least 12 bytes before the end. */
+#define CY_MQTT_LZ4_LAST_LITERALS                            ( 5U )
+#define CY_MQTT_LZ4_MATCH_FIND_LIMIT                         ( 12U )
+
+/* Maximum distance of a match, limited by the 2-byte offset. */
+#define CY_MQTT_LZ4_MAX_DISTANCE                             ( 65535U )
+
+/* Number of bits of the hash of the match finder. */
+#define CY_MQTT_LZ4_HASH_LOG                                 ( 10U )
+
+/* Length value in a token nibble that indicates additional length bytes. */
+#define CY_MQTT_LZ4_RUN_MASK                                 ( 15U )
+
+/******************************************************
+ *               Static Function Definitions
+ ******************************************************/
+static uint32_t lz4_read32( const uint8_t *ptr )
+{
+    uint32_t value;
+
+    memcpy( &value, ptr, sizeof( value ) );
+    return value;
+}
+
+static uint32_t lz4_hash( uint32_t sequence )
+{
+    return ( (sequence * 2654435761U) >> (32U - CY_MQTT_LZ4_HASH_LOG) );
+}
+
+/* Write a length that overflows the 4-bit token field as a run of 255 bytes and a remainder byte. */
+static bool lz4_write_length( uint8_t *dst, size_t dst_len, size_t *op, size_t length )
+{
+    while( length >= 255U )
+    {
+        if( *op >= dst_len )
+        {
+            return false;
+        }
+        dst[ (*op)++ ] = 255U;
+        length -= 255U;
+    }
+    if( *op >= dst_len )
+    {
+        return false;
+    }
+    dst[ (*op)++ ] = (uint8_t)length;
+    return true;
+}
+
+/* Write a sequence of literals followed by a match. A match_len of 0 writes the final literals-only sequence. */
+static bool lz4_write_sequence( uint8_t *dst, size_t dst_len, size_t *op, const uint8_t *literals, size_t literal_len,
+                                size_t offset, size_t match_len )
+{
+    size_t   token_pos = *op;
+    uint8_t  token;
+
+    if( *op >= dst_len )
+    {
+        return false;
+    }
+    (*op)++;
+
+    token = (uint8_t)(((literal_len < CY_MQTT_LZ4_RUN_MASK) ? literal_len : CY_MQTT_LZ4_RUN_MASK) << 4);
+    if( (literal_len >= CY_MQTT_LZ4_RUN_MASK) && (lz4_write_length( dst, dst_len, op, literal_len - CY_MQTT_LZ4_RUN_MASK ) == false) )
+    {
+        return false;
+    }
+    if( (dst_len - *op) < literal_len )
+    {
+        return false;
+    }
+    memcpy( &(dst[ *op ]), literals, literal_len );
+    *op += literal_len;
+
+    if( match_len > 0 )
+    {
+        if( (dst_len - *op) < 2U )
+        {
+            return false;
+        }
+        dst[ (*op)++ ] = (uint8_t)(offset & 0xFFU);
+        dst[ (*op)++ ] = (uint8_t)(offset >> 8);
+
+        match_len -= CY_MQTT_LZ4_MIN_MATCH;
+        token |= (uint8_t)((match_len < CY_MQTT_LZ4_RUN_MASK) ? match_len : CY_MQTT_LZ4_RUN_MASK);
+        if( (match_len >= CY_MQTT_LZ4_RUN_MASK) && (lz4_write_length( dst, dst_len, op, match_len - CY_MQTT_LZ4_RUN_MASK ) == false) )
+        {
+            return false;
+        }
+    }
+
+    dst[ token_pos ] = token;
+    return true;
+}
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+size_t cy_mqtt_lz4_compress( const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len, void *user_data )
+{
+    uint32_t  *table = NULL;
+    size_t    ip = 0;
+    size_t    anchor = 0;
+    size_t    op = 0;
+    size_t    ref, match_len;
+    uint32_t  hash;
+
+    (void)user_data;
+
+    if( (src == NULL) || (dst == NULL) )
+    {
+        return 0;
+    }
+
+    /* The table stores positions plus one, so that 0 marks an empty slot. */
+    table = (uint32_t *)calloc( (size_t)1U << CY_MQTT_LZ4_HASH_LOG, sizeof( uint32_t ) );
+    if( table == NULL )
+    {
+        return 0;
+    }
+
+    while( (ip + CY_MQTT_LZ4_MATCH_FIND_LIMIT) < src_len )
+    {
+        hash = lz4_hash( lz4_read32( &(src[ ip ]) ) );
+        ref = table[ hash ];
+        table[ hash ] = (uint32_t)(ip + 1U);
+
+        if( (ref == 0) || ((ip - (ref - 1U)) > CY_MQTT_LZ4_MAX_DISTANCE) ||
+            (lz4_read32( &(src[ ref - 1U ]) ) != lz4_read32( &(src[ ip ]) )) )
+        {
+            ip++;
+            continue;
+        }
+        ref--;
+
+        match_len = CY_MQTT_LZ4_MIN_MATCH;
+        while( ((ip + match_len) < (src_len - CY_MQTT_LZ4_LAST_LITERALS)) && (src[ ref + match_len ] == src[ ip + match_len ]) )
+        {
+            match_len++;
+        }
+
+        if( lz4_write_sequence( dst, dst_len, &op, &(src[ anchor ]), ip - anchor, ip - ref, match_len ) == false )
+        {
+            free( table );
+            return 0;
+        }
+        ip += match_len;
+        anchor = ip;
+    }
+
+    free( table );
+
+    if( lz4_write_sequence( dst, dst_len, &op, &(src[ anchor ]), src_len - anchor, 0, 0 ) == false )
+    {
+        return 0;
+    }
+
+    return op;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/
+
+size_t cy_mqtt_lz4_decompress( const uint8_t *src, size_t src_len, uint8_t *dst, size_t dst_len, void *user_data )
+{
+    size_t   ip = 0;
+    size_t   op = 0;
+    size_t   literal_len, match_len, offset;
+    uint8_t  token, byte;
+
+    (void)user_data;
+
+    if( (src == NULL) || (dst == NULL) )
+    {
+        return 0;
+    }
+
+    while( ip < src_len )
+    {
+        token = src[ ip++ ];
+
+        literal_len = token >> 4;
+        if( literal_len == CY_MQTT_LZ4_RUN_MASK )
+        {
+            do
+            {
+                if( ip >= src_len )
+                {
+                    return 0;
+                }
+                byte = src[ ip++ ];
+                literal_len += byte;
+            } while( byte == 255U );
+        }
+        if( ((src_len - ip) < literal_len) || ((dst_len - op) < literal_len) )
+        {
+            return 0;
+        }
+        memcpy( &(dst[ op ]), &(src[ ip ]), literal_len );
+        ip += literal_len;
+        op += literal_len;
+
+        if( ip == src_len )
+        {
+            /* The last sequence has no match. */
+            break;
+        }
+
+        if( (src_len - ip) < 2U )
+        {
+            return 0;
+        }
+        offset = (size_t)src[ ip ] | ((size_t)src[ ip + 1U ] << 8);
+        ip += 2U;
+        if( (offset == 0) || (offset > op) )
+        {
+            return 0;
+        }
+
+        match_len = token & CY_MQTT_LZ4_RUN_MASK;
+        if( match_len == CY_MQTT_LZ4_RUN_MASK )
+        {
+            do
+            {
+                if( ip >= src_len )
+                {
+                    return 0;
+                }
+                byte = src[ ip++ ];
+                match_len += byte;
+            } while( byte == 255U );
+        }
+        match_len += CY_MQTT_LZ4_MIN_MATCH;
+        if( (dst_len - op) < match_len )
+        {
+            return 0;
+        }
+
+        /* The match may overlap the bytes it produces, so it is copied byte by byte. */
+        while( match_len > 0 )
+        {
+            dst[ op ] = dst[ op - offset ];
+            op++;
+            match_len--;
+        }
+    }
+
+    return op;
+}
+
+/*----------------------------------------------------------------------------------------------------------*/